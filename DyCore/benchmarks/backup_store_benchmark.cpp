@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "backupStore.h"
+#include "format/dyn.h"
+#include "project.h"
+
+// Measures backing up a project that is saved many times with a few edits
+// between saves, as autosaves do, and restoring its versions.
+// Options: --notes N (default 100000), --saves N (default 100),
+// --edits N notes changed per save (default 20), --level L (default 3).
+
+namespace {
+
+struct BackupBenchmarkOptions {
+    size_t noteCount = 100000;
+    size_t saveCount = 100;
+    size_t editCount = 20;
+    int level = 3;
+};
+
+BackupBenchmarkOptions parse_backup_options(int argc, char** argv) {
+    BackupBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const std::string value = argv[++i];
+        if (name == "--notes") {
+            options.noteCount = std::stoull(value);
+        } else if (name == "--saves") {
+            options.saveCount = std::max<size_t>(1, std::stoull(value));
+        } else if (name == "--edits") {
+            options.editCount = std::stoull(value);
+        } else if (name == "--level") {
+            options.level = std::stoi(value);
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+NoteRecord make_random_note(std::mt19937& random, double maxTime) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    NoteRecord note{};
+    note.side = static_cast<int>(random() % 3);
+    note.type = random() % 11 == 0 ? 2 : static_cast<int>(random() % 2);
+    note.time = unit(random) * maxTime;
+    note.width = 0.5 + static_cast<double>(random() % 13) * 0.25;
+    note.position = unit(random) * 5.0;
+    note.lastTime = note.type == 2 ? 100.0 + unit(random) * 900.0 : 0.0;
+    return note;
+}
+
+void write_project(const std::filesystem::path& path,
+                   const ProjectSnapshot& project, int level) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    project_export_dyn(project, {.level = level},
+                       [&](const char* data, size_t size) {
+                           file.write(data,
+                                      static_cast<std::streamsize>(size));
+                       });
+    if (!file) {
+        throw std::runtime_error("Write failed");
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    try {
+        const auto options = parse_backup_options(argc, argv);
+        const fs::path dir =
+            fs::temp_directory_path() / "dycore_backup_bench";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        const fs::path path = dir / "bench.dyn";
+
+        // A fixed seed keeps runs comparable.
+        std::mt19937 random(20240601);
+        const double maxTime = options.noteCount * 60.0;
+        ProjectSnapshot project{.version = "v0.2.0"};
+        auto& chart = project.charts.emplace_back();
+        chart.metadata = {.title = "Bench", .sideType = {"MIXER", "PAD"}};
+        chart.timingPoints = {{0.0, 400.0, 4}};
+        for (size_t i = 0; i < options.noteCount; ++i) {
+            chart.notes.push_back(make_random_note(random, maxTime));
+        }
+        const auto byTime = [](const NoteRecord& a, const NoteRecord& b) {
+            return a.time < b.time;
+        };
+        std::sort(chart.notes.begin(), chart.notes.end(), byTime);
+
+        Milliseconds addTime{0};
+        uint64_t fileBytes = 0;
+        for (size_t save = 0; save < options.saveCount; ++save) {
+            // Replaces some notes and adds one, keeping them in time order.
+            for (size_t e = 0; e < options.editCount; ++e) {
+                chart.notes[random() % chart.notes.size()] =
+                    make_random_note(random, maxTime);
+            }
+            chart.notes.push_back(make_random_note(random, maxTime));
+            std::sort(chart.notes.begin(), chart.notes.end(), byTime);
+
+            write_project(path, project, options.level);
+            fileBytes += fs::file_size(path);
+            const auto start = Clock::now();
+            backup_existing_project_file(path);
+            addTime += Clock::now() - start;
+        }
+
+        const ProjectBackupStore store(path);
+        const auto versions = store.versions();
+        const fs::path restored = dir / "restored.dyn";
+        auto start = Clock::now();
+        store.restore(versions.front().id, restored);
+        const Milliseconds restoreOldest = Clock::now() - start;
+        start = Clock::now();
+        store.restore(versions.back().id, restored);
+        const Milliseconds restoreNewest = Clock::now() - start;
+
+        const double averageFile =
+            static_cast<double>(fileBytes) / options.saveCount;
+        std::cout << std::fixed << std::setprecision(2)
+                  << "notes=" << options.noteCount
+                  << " saves=" << options.saveCount
+                  << " edits=" << options.editCount
+                  << " level=" << options.level << '\n'
+                  << "versions=" << versions.size()
+                  << " file_bytes=" << static_cast<uint64_t>(averageFile)
+                  << " stored_bytes=" << store.stored_size()
+                  << " full_copies=" << store.stored_size() / averageFile
+                  << '\n'
+                  << "add_ms=" << addTime.count() / options.saveCount
+                  << " restore_oldest_ms=" << restoreOldest.count()
+                  << " restore_newest_ms=" << restoreNewest.count() << '\n';
+        fs::remove_all(dir);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Backup store benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compress.h"
+#include "format/dyn.h"
+#include "format/dynb.h"
+#include "project.h"
+
+// Compares save compression settings across project sizes. Every
+// combination of the options below is exported to memory and the best of
+// --runs timings is reported:
+//   --notes 10000,100000,400000   notes in the single chart
+//   --levels 1,3,9,19             zstd levels
+//   --threads 0,2,4               zstd workers (0 compresses on the caller)
+//   --formats dyn,dynb            containers
+//   --ldm 0,1                     long-distance matching
+//   --runs 3
+
+namespace {
+
+struct CompressionBenchmarkOptions {
+    std::vector<int> noteCounts = {10000, 100000, 400000};
+    std::vector<int> levels = {1, 3, 9, 19};
+    std::vector<int> threads = {0, 2, 4};
+    std::vector<std::string> formats = {"dyn", "dynb"};
+    std::vector<int> ldm = {0};
+    int runs = 3;
+};
+
+template <typename T>
+std::vector<T> parse_list(const std::string& value) {
+    std::vector<T> items;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            items.push_back(item);
+        } else {
+            items.push_back(std::stoi(item));
+        }
+    }
+    if (items.empty()) {
+        throw std::invalid_argument("Empty list " + value);
+    }
+    return items;
+}
+
+CompressionBenchmarkOptions parse_compression_options(int argc,
+                                                      char** argv) {
+    CompressionBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const std::string value = argv[++i];
+        if (name == "--notes") {
+            options.noteCounts = parse_list<int>(value);
+        } else if (name == "--levels") {
+            options.levels = parse_list<int>(value);
+        } else if (name == "--threads") {
+            options.threads = parse_list<int>(value);
+        } else if (name == "--formats") {
+            options.formats = parse_list<std::string>(value);
+            for (const auto& format : options.formats) {
+                if (format != "dyn" && format != "dynb") {
+                    throw std::invalid_argument("Unknown format " + format);
+                }
+            }
+        } else if (name == "--ldm") {
+            options.ldm = parse_list<int>(value);
+        } else if (name == "--runs") {
+            options.runs = std::max(1, std::stoi(value));
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+ProjectSnapshot make_benchmark_project(int noteCount) {
+    ChartSnapshot chart{.metadata = {.title = "Benchmark",
+                                     .artist = "artist",
+                                     .charter = "charter",
+                                     .sideType = {"MIXER", "PAD"},
+                                     .difficulty = 3},
+                        .path = {.music = "music.ogg"}};
+    for (int i = 0; i < 64; ++i) {
+        chart.timingPoints.push_back(
+            {i * 8000.0, 60000.0 / (120.0 + (i % 5) * 20.0), 4});
+    }
+
+    // Same generator as the save benchmark, so sizes are comparable.
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    double time = 0.0;
+    chart.notes.reserve(noteCount);
+    for (int i = 0; i < noteCount; ++i) {
+        NoteRecord note{};
+        note.side = static_cast<int>(random() % 3);
+        note.type = random() % 11 == 0 ? 2 : static_cast<int>(random() % 2);
+        time += 60000.0 / 150.0 / (1 << (random() % 4)) * (random() % 3);
+        note.time = time + jitter(random);
+        note.width = 0.5 + static_cast<double>(random() % 13) * 0.25;
+        note.position = jitter(random) * 5.0;
+        note.lastTime = note.type == 2 ? 100.0 + jitter(random) * 900.0 : 0.0;
+        chart.notes.push_back(note);
+    }
+
+    ProjectSnapshot project{.version = "v0.2.0",
+                            .metadata = {{"stats", {{"projectTime", 0}}}}};
+    project.charts.push_back(std::move(chart));
+    return project;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = parse_compression_options(argc, argv);
+        std::cout << std::fixed << std::setprecision(2);
+        for (const int noteCount : options.noteCounts) {
+            const auto project = make_benchmark_project(noteCount);
+            for (const auto& format : options.formats) {
+                const auto exporter = format == "dynb" ? project_export_dynb
+                                                       : project_export_dyn;
+                for (const int level : options.levels) {
+                    for (const int threads : options.threads) {
+                        for (const int ldm : options.ldm) {
+                            const ZstdCompressOptions compressOptions{
+                                .level = level,
+                                .workers = threads,
+                                .longDistanceMatching = ldm != 0};
+                            DynExportResult result;
+                            double bestMs = 0.0;
+                            for (int run = 0; run < options.runs; ++run) {
+                                const auto start =
+                                    std::chrono::steady_clock::now();
+                                result = exporter(project, compressOptions,
+                                                  [](const char*, size_t) {});
+                                const std::chrono::duration<double,
+                                                            std::milli>
+                                    elapsed = std::chrono::steady_clock::now() -
+                                              start;
+                                if (run == 0 || elapsed.count() < bestMs) {
+                                    bestMs = elapsed.count();
+                                }
+                            }
+                            std::cout
+                                << "format=" << format
+                                << " notes=" << noteCount
+                                << " level=" << level
+                                << " threads=" << threads << " ldm=" << ldm
+                                << " raw_bytes=" << result.contentSize
+                                << " file_bytes=" << result.fileSize
+                                << " ratio="
+                                << static_cast<double>(result.contentSize) /
+                                       std::max<size_t>(result.fileSize, 1)
+                                << " ms=" << bestMs << " mb_per_s="
+                                << result.contentSize / (1024.0 * 1024.0) /
+                                       (bestMs / 1000.0)
+                                << '\n';
+                        }
+                    }
+                }
+            }
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Compression benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
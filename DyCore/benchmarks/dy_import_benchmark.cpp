@@ -0,0 +1,191 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+// windows.h must come first.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "format/dy.h"
+#include "note.h"
+#include "project.h"
+#include "timing.h"
+#include "utils.h"
+
+// Measures importing a large .dy remix: a chart with many notes and the
+// music embedded in its remix part as base64. Run it in its own process for
+// each size, as the peak resident size only ever grows.
+// Options: --notes N (default 300000), --remix-mb N (default 32),
+// --repeat N (default 3).
+
+namespace {
+
+struct DyImportBenchmarkOptions {
+    size_t noteCount = 300000;
+    size_t remixMegabytes = 32;
+    int repeat = 3;
+};
+
+DyImportBenchmarkOptions parse_dy_import_options(int argc, char** argv) {
+    DyImportBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const std::string value = argv[++i];
+        if (name == "--notes") {
+            options.noteCount = std::stoull(value);
+        } else if (name == "--remix-mb") {
+            options.remixMegabytes = std::stoull(value);
+        } else if (name == "--repeat") {
+            options.repeat = std::max(1, std::stoi(value));
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+double peak_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return 0.0;
+    }
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+// Writes a chart the way Dynamix remixes store it, numbers as strings,
+// spreading the notes over the three sides with a hold every eleventh note.
+void write_dy_chart(const std::filesystem::path& path,
+                    const DyImportBenchmarkOptions& options) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << R"({"CMap":{"m_path":"bench","m_barPerMin":"40",)"
+           R"("m_timeOffset":"0.25","m_leftRegion":"PAD",)"
+           R"("m_rightRegion":"MIXER","m_mapID":"_map_bench_G")";
+
+    // A fixed seed keeps runs comparable.
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    const size_t barCount = std::max<size_t>(options.noteCount / 8, 1);
+    const auto fdwp = [](double value) {
+        return format_double_with_precision(value, 6);
+    };
+    size_t id = 0;
+    const char* sides[] = {"m_notes", "m_notesLeft", "m_notesRight"};
+    for (int side = 0; side < 3; ++side) {
+        out << ",\"" << sides[side] << R"(":{"m_notes":{"CMapNoteAsset":[)";
+        const size_t count =
+            options.noteCount / 3 + (side == 0 ? options.noteCount % 3 : 0);
+        for (size_t i = 0; i < count; ++i) {
+            const double bar = static_cast<double>(i) * barCount / count +
+                               jitter(random) * 0.01;
+            const double width = 0.5 + (random() % 13) * 0.25;
+            const double position = jitter(random) * 5.0 - width / 2;
+            const bool hold = i % 11 == 0;
+            const size_t noteId = id++;
+            out << (i == 0 ? "" : ",") << R"({"m_id":")" << noteId
+                << R"(","m_type":")"
+                << (hold ? "HOLD" : random() % 2 ? "CHAIN" : "NORMAL")
+                << R"(","m_time":")" << fdwp(bar) << R"(","m_position":")"
+                << fdwp(position) << R"(","m_width":")" << fdwp(width)
+                << R"(","m_subId":")"
+                << (hold ? static_cast<long long>(id) : -1) << "\"}";
+            if (hold) {
+                out << R"(,{"m_id":")" << id++
+                    << R"(","m_type":"SUB","m_time":")"
+                    << fdwp(bar + 0.25 + jitter(random))
+                    << R"(","m_position":")" << fdwp(position)
+                    << R"(","m_width":")" << fdwp(width)
+                    << R"(","m_subId":"-1"})";
+            }
+        }
+        out << "]}}";
+    }
+    out << R"(,"m_argument":{"m_bpmchange":{"CBpmchange":[)"
+           R"({"m_time":"0","m_value":"40"}]}}},"remix":{"music":")";
+    const std::string block(1024 * 1024, 'A');
+    for (size_t i = 0; i < options.remixMegabytes; ++i) {
+        out << block;
+    }
+    out << R"(","bg":""}})";
+    if (!out) {
+        throw std::runtime_error("Write failed");
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = parse_dy_import_options(argc, argv);
+        // The project manager resets the chart when first used.
+        (void)chart_get_metadata();
+
+        const auto path =
+            std::filesystem::temp_directory_path() / "dycore_dy_bench.dy";
+        write_dy_chart(path, options);
+        const double setupPeak = peak_rss_mb();
+
+        double bestMs = 0.0;
+        for (int run = 0; run < options.repeat; ++run) {
+            clear_notes();
+            get_timing_manager().clear();
+            const auto start = std::chrono::steady_clock::now();
+            if (chart_import_dy(path.string().c_str(), true, true) !=
+                IMPORT_DY_RESULT_STATES::SUCCESS) {
+                throw std::runtime_error("Import failed");
+            }
+            const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < bestMs) {
+                bestMs = elapsed.count();
+            }
+        }
+        const double importPeak = peak_rss_mb();
+
+        std::vector<Note> notes;
+        get_notes_array(notes);
+        std::error_code ec;
+        const auto fileSize = std::filesystem::file_size(path, ec);
+        std::filesystem::remove(path, ec);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "notes=" << options.noteCount
+                  << " remix_mb=" << options.remixMegabytes
+                  << " file_bytes=" << fileSize << '\n'
+                  << "import_ms=" << bestMs
+                  << " imported_notes=" << notes.size()
+                  << " remix_bytes=" << get_dy_remix().size() << '\n'
+                  << "setup_peak_rss_mb=" << setupPeak
+                  << " import_peak_rss_mb=" << importPeak << '\n';
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "DY import benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
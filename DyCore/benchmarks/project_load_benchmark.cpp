@@ -0,0 +1,259 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+// windows.h must come first.
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "format/dyn.h"
+#include "format/dynb.h"
+#include "note.h"
+#include "project.h"
+
+// Measures opening a project with several charts: importing it and filling
+// the note pool from the first chart. Run each mode in its own process, as
+// the peak resident size only ever grows:
+//   --mode eager  parse every chart on import
+//   --mode lazy   parse the first chart only, the others when selected
+// Options: --format dyn|dynb (default dyn), --charts N (default 10),
+// --notes N per chart (default 100000), --level L (default 3),
+// --cache warm|cold (default warm): whether the file is read once before
+// the import, or dropped from the system file cache so it comes from disk.
+
+namespace {
+
+struct LoadBenchmarkOptions {
+    std::string mode = "lazy";
+    std::string format = "dyn";
+    std::string cache = "warm";
+    size_t chartCount = 10;
+    size_t noteCount = 100000;
+    int level = 3;
+};
+
+LoadBenchmarkOptions parse_load_options(int argc, char** argv) {
+    LoadBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const std::string value = argv[++i];
+        if (name == "--mode") {
+            if (value != "eager" && value != "lazy") {
+                throw std::invalid_argument("Unknown mode " + value);
+            }
+            options.mode = value;
+        } else if (name == "--format") {
+            if (value != "dyn" && value != "dynb") {
+                throw std::invalid_argument("Unknown format " + value);
+            }
+            options.format = value;
+        } else if (name == "--cache") {
+            if (value != "warm" && value != "cold") {
+                throw std::invalid_argument("Unknown cache state " + value);
+            }
+            options.cache = value;
+        } else if (name == "--charts") {
+            options.chartCount = std::stoull(value);
+        } else if (name == "--notes") {
+            options.noteCount = std::stoull(value);
+        } else if (name == "--level") {
+            options.level = std::stoi(value);
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+double peak_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return 0.0;
+    }
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+double current_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return 0.0;
+    }
+    return counters.WorkingSetSize / (1024.0 * 1024.0);
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0));
+#endif
+}
+
+// Reads the whole file so it is cached, or drops it from the cache.
+void prepare_file_cache(const std::filesystem::path& path, bool cold) {
+    if (!cold) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> chunk(1 << 20);
+        while (file.read(chunk.data(), static_cast<std::streamsize>(
+                                           chunk.size()))) {
+        }
+        return;
+    }
+#ifdef _WIN32
+    // Opening a file without buffering drops its cached pages.
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_NO_BUFFERING, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open the file to drop its cache");
+    }
+    CloseHandle(file);
+#elif defined(POSIX_FADV_DONTNEED)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open the file to drop its cache");
+    }
+    // Pages still waiting to be written cannot be dropped.
+    ::fdatasync(fd);
+    const int result = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    if (result != 0) {
+        throw std::runtime_error("Cannot drop the file from the cache");
+    }
+#else
+    throw std::runtime_error("Dropping the file cache is not supported");
+#endif
+}
+
+// Generates and saves the project. Its memory is returned before the load is
+// measured.
+void write_project(const std::filesystem::path& path,
+                   const LoadBenchmarkOptions& options) {
+    ProjectSnapshot project{.version = "v0.2.0"};
+    // A fixed seed keeps runs comparable.
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    for (size_t c = 0; c < options.chartCount; ++c) {
+        auto& chart = project.charts.emplace_back();
+        chart.metadata = {.title = "Chart " + std::to_string(c),
+                          .sideType = {"MIXER", "MIXER"},
+                          .difficulty = static_cast<int>(c % 5)};
+        for (int i = 0; i < 64; ++i) {
+            chart.timingPoints.push_back(
+                {i * 8000.0, 60000.0 / (120.0 + (i % 5) * 20.0), 4});
+        }
+        double time = 0.0;
+        chart.notes.reserve(options.noteCount);
+        for (size_t i = 0; i < options.noteCount; ++i) {
+            NoteRecord note{};
+            note.side = static_cast<int>(random() % 3);
+            note.type =
+                random() % 11 == 0 ? 2 : static_cast<int>(random() % 2);
+            time += 60000.0 / 150.0 / (1 << (random() % 4)) * (random() % 3);
+            note.time = time + jitter(random);
+            note.width = 0.5 + static_cast<double>(random() % 13) * 0.25;
+            note.position = jitter(random) * 5.0;
+            note.lastTime =
+                note.type == 2 ? 100.0 + jitter(random) * 900.0 : 0.0;
+            chart.notes.push_back(note);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const auto exporter =
+        options.format == "dynb" ? project_export_dynb : project_export_dyn;
+    exporter(project, {.level = options.level},
+             [&](const char* data, size_t size) {
+                 file.write(data, static_cast<std::streamsize>(size));
+             });
+    if (!file) {
+        throw std::runtime_error("Write failed");
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = parse_load_options(argc, argv);
+        const auto path = std::filesystem::temp_directory_path() /
+                          ("dycore_load_bench." + options.format);
+        write_project(path, options);
+        prepare_file_cache(path, options.cache == "cold");
+        const double setupPeak = peak_rss_mb();
+        const double setupRss = current_rss_mb();
+
+        const auto start = std::chrono::steady_clock::now();
+        Project project;
+        if (project_import_dyn(path.string().c_str(), project,
+                               options.mode == "lazy") != 0) {
+            throw std::runtime_error("Import failed");
+        }
+        const std::chrono::duration<double, std::milli> importElapsed =
+            std::chrono::steady_clock::now() - start;
+
+        // Selecting the first chart, as opening the project does.
+        auto& chart = project.charts.at(0);
+        if (chart.lazyContent) {
+            for (const auto& record : chart.lazyContent->get().notes) {
+                chart.notes.push_back(make_note(record));
+            }
+            chart.lazyContent.reset();
+        }
+        clear_notes();
+        create_notes(chart.notes);
+        const std::chrono::duration<double, std::milli> openElapsed =
+            std::chrono::steady_clock::now() - start;
+        const double openPeak = peak_rss_mb();
+        const double openRss = current_rss_mb();
+
+        std::error_code ec;
+        const auto fileSize = std::filesystem::file_size(path, ec);
+        std::filesystem::remove(path, ec);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "mode=" << options.mode << " format=" << options.format
+                  << " cache=" << options.cache
+                  << " charts=" << options.chartCount
+                  << " notes=" << options.noteCount
+                  << " level=" << options.level << '\n'
+                  << "import_ms=" << importElapsed.count()
+                  << " open_ms=" << openElapsed.count()
+                  << " file_bytes=" << fileSize << '\n'
+                  << "setup_peak_rss_mb=" << setupPeak
+                  << " open_peak_rss_mb=" << openPeak
+                  << " open_rss_delta_mb=" << openRss - setupRss << '\n';
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Load benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -17,6 +17,7 @@
 #include "layout.h"
 #include "note.h"
 #include "notePoolManager.h"
+#include "offline.h"
 #include "project.h"
 #include "render.h"
 #include "render_benchmark_options.h"
@@ -267,6 +268,124 @@ BenchmarkContext initialize_chart_notes(const BenchmarkOptions& options) {
     return context;
 }
 
+void print_schedule(std::string_view name, const RenderScheduleStats& stats) {
+    std::cout << std::fixed << std::setprecision(1) << name
+              << ".schedule=" << (stats.parallel ? "parallel" : "serial")
+              << " chunks=" << stats.chunkCount << " items=" << stats.itemCount
+              << " serial_item_ns=" << stats.serialItemNs
+              << " parallel_item_ns=" << stats.parallelItemNs
+              << " serial_runs=" << stats.serialRuns
+              << " parallel_runs=" << stats.parallelRuns
+              << " shared_runs=" << stats.sharedRuns << '\n';
+}
+
+void print_lod(std::string_view name, const RenderLodStats& stats) {
+    std::cout << std::fixed << std::setprecision(3) << name
+              << ".lod=" << (stats.active ? "on" : "off")
+              << " density=" << stats.density
+              << " row_px=" << stats.rowPixels
+              << " items=" << stats.inputItems << "->" << stats.outputItems
+              << " dropped=" << stats.droppedItems
+              << " bytes=" << stats.renderedBytes << '\n';
+}
+
+void run_schedule(RENDER_SCHEDULE_MODE schedule,
+                  const BenchmarkOptions& options,
+                  const BenchmarkContext& context,
+                  std::vector<char>& vertexBuffer,
+                  const std::array<size_t, 3>& outputSizes,
+                  const std::array<uint64_t, 3>& outputHashes) {
+    set_render_schedule_mode(schedule);
+    reset_render_schedule_stats();
+    std::cout << "schedule="
+              << (schedule == RENDER_SCHEDULE_MODE::AUTO ? "auto" : "static")
+              << '\n';
+
+    for (size_t iteration = 0; iteration < options.warmupIterations;
+         ++iteration) {
+        for (const int state : {1, 0, 2}) {
+            render_active_notes(vertexBuffer.data(), context.nowTime,
+                                context.noteSpeed, state);
+        }
+    }
+
+    std::array<std::vector<double>, 3> samples;
+    std::vector<double> totalSamples;
+    for (auto& stateSamples : samples) {
+        stateSamples.reserve(options.iterations);
+    }
+    totalSamples.reserve(options.iterations);
+
+    using Clock = std::chrono::steady_clock;
+    for (size_t iteration = 0; iteration < options.iterations; ++iteration) {
+        double totalMs = 0.0;
+        for (const int state : {1, 0, 2}) {
+            const auto begin = Clock::now();
+            const size_t outputSize =
+                render_active_notes(vertexBuffer.data(), context.nowTime,
+                                    context.noteSpeed, state);
+            const auto end = Clock::now();
+            if (outputSize != outputSizes[state]) {
+                throw std::runtime_error(
+                    "Rendering output size changed during benchmark");
+            }
+            // Scheduling must never change the output.
+            if (iteration + 1 == options.iterations &&
+                fnv1a64(std::span(vertexBuffer.data(), outputSize)) !=
+                    outputHashes[state]) {
+                throw std::runtime_error(
+                    "Rendering output changed during benchmark");
+            }
+            const double elapsedMs =
+                std::chrono::duration<double, std::milli>(end - begin).count();
+            samples[state].push_back(elapsedMs);
+            totalMs += elapsedMs;
+        }
+        totalSamples.push_back(totalMs);
+    }
+
+    // The schedule that ended up being used after warmup and tuning.
+    print_schedule("state0", get_render_schedule_stats(0));
+    print_schedule("state1", get_render_schedule_stats(1));
+    print_schedule("state2", get_render_schedule_stats(2));
+    print_schedule("resolve",
+                   get_render_schedule_stats(RENDER_SCHEDULE_RESOLVE_SLOT));
+    print_lod("state0", get_render_lod_stats(0));
+    print_lod("state1", get_render_lod_stats(1));
+    print_lod("state2", get_render_lod_stats(2));
+    print_stats("state0", calculate_stats(samples[0]));
+    print_stats("state1", calculate_stats(samples[1]));
+    print_stats("state2", calculate_stats(samples[2]));
+    print_stats("total", calculate_stats(totalSamples));
+}
+
+// Steps the headless video path with a flat grey atlas and discards the
+// frames, so the result is render plus rasterization throughput.
+void run_offline(const BenchmarkOptions& options,
+                 const BenchmarkContext& context) {
+    constexpr int atlasSize = 64;
+    set_offline_render_atlas(
+        atlasSize, atlasSize,
+        std::vector<uint8_t>(atlasSize * atlasSize * 4, 0xC0));
+
+    constexpr int fps = 60;
+    OfflineChartRenderer renderer(
+        {.startTime = context.nowTime,
+         .endTime = context.nowTime +
+                    static_cast<double>(options.offlineFrames - 1) * 1000.0 /
+                        fps,
+         .fps = fps,
+         .noteSpeed = context.noteSpeed},
+        [](std::span<const uint8_t>) { return 0; });
+    renderer.run();
+
+    const auto stats = renderer.get_stats();
+    std::cout << std::fixed << std::setprecision(4)
+              << "offline.frames=" << stats.framesDelivered
+              << " elapsed_ms=" << stats.elapsedMs
+              << " fps=" << stats.framesPerSecond << '\n';
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -274,6 +393,9 @@ int main(int argc, char** argv) {
         NotePoolCleanup cleanup;
         const BenchmarkOptions options = parse_options(argc, argv);
         set_render_worker_count_override(options.workerCount);
+        set_render_lod_mode(options.lod == "always" ? RENDER_LOD_MODE::ALWAYS
+                            : options.lod == "auto" ? RENDER_LOD_MODE::AUTO
+                                                    : RENDER_LOD_MODE::OFF);
         initialize_sprites();
         const BenchmarkContext context =
             options.chartPath.empty() ? initialize_synthetic_notes(options)
@@ -305,44 +427,6 @@ int main(int argc, char** argv) {
                 vertexBuffer.data(), static_cast<size_t>(outputSizes[state])));
         }
 
-        for (size_t iteration = 0; iteration < options.warmupIterations;
-             ++iteration) {
-            for (const int state : {1, 0, 2}) {
-                render_active_notes(vertexBuffer.data(), context.nowTime,
-                                    context.noteSpeed, state);
-            }
-        }
-
-        std::array<std::vector<double>, 3> samples;
-        std::vector<double> totalSamples;
-        for (auto& stateSamples : samples) {
-            stateSamples.reserve(options.iterations);
-        }
-        totalSamples.reserve(options.iterations);
-
-        using Clock = std::chrono::steady_clock;
-        for (size_t iteration = 0; iteration < options.iterations;
-             ++iteration) {
-            double totalMs = 0.0;
-            for (const int state : {1, 0, 2}) {
-                const auto begin = Clock::now();
-                const size_t outputSize =
-                    render_active_notes(vertexBuffer.data(), context.nowTime,
-                                        context.noteSpeed, state);
-                const auto end = Clock::now();
-                if (outputSize != outputSizes[state]) {
-                    throw std::runtime_error(
-                        "Rendering output size changed during benchmark");
-                }
-                const double elapsedMs =
-                    std::chrono::duration<double, std::milli>(end - begin)
-                        .count();
-                samples[state].push_back(elapsedMs);
-                totalMs += elapsedMs;
-            }
-            totalSamples.push_back(totalMs);
-        }
-
         const auto& activation = get_note_activation_manager();
         const size_t availableWorkerCount =
             static_cast<size_t>(std::max(1, hardware_concurrency()));
@@ -359,16 +443,28 @@ int main(int argc, char** argv) {
                   << " now_time=" << context.nowTime
                   << " note_speed=" << context.noteSpeed
                   << " workers=" << configuredWorkerCount
-                  << " iterations=" << options.iterations << '\n';
+                  << " iterations=" << options.iterations
+                  << " lod=" << options.lod << '\n';
         for (const int state : {0, 1, 2}) {
             std::cout << "state" << state << ".bytes=" << outputSizes[state]
                       << " hash=0x" << std::hex << outputHashes[state]
                       << std::dec << '\n';
         }
-        print_stats("state0", calculate_stats(samples[0]));
-        print_stats("state1", calculate_stats(samples[1]));
-        print_stats("state2", calculate_stats(samples[2]));
-        print_stats("total", calculate_stats(totalSamples));
+
+        std::vector<RENDER_SCHEDULE_MODE> schedules;
+        if (options.schedule != "auto") {
+            schedules.push_back(RENDER_SCHEDULE_MODE::STATIC);
+        }
+        if (options.schedule != "static") {
+            schedules.push_back(RENDER_SCHEDULE_MODE::AUTO);
+        }
+        for (const auto schedule : schedules) {
+            run_schedule(schedule, options, context, vertexBuffer,
+                         outputSizes, outputHashes);
+        }
+        if (options.offlineFrames > 0) {
+            run_offline(options, context);
+        }
         return 0;
     } catch (const std::exception& exception) {
         std::cerr << "render benchmark failed: " << exception.what() << '\n';
@@ -51,7 +51,19 @@ void set_worker_count(BenchmarkOptions& options, std::string_view value) {
     options.workerCount = parse_size_value(value);
 }
 
-constexpr std::array<OptionSpec, 7> OPTION_SPECS{{
+void set_schedule(BenchmarkOptions& options, std::string_view value) {
+    options.schedule = value;
+}
+
+void set_lod(BenchmarkOptions& options, std::string_view value) {
+    options.lod = value;
+}
+
+void set_offline_frames(BenchmarkOptions& options, std::string_view value) {
+    options.offlineFrames = parse_size_value(value);
+}
+
+constexpr std::array<OptionSpec, 10> OPTION_SPECS{{
     {"--notes", set_note_count},
     {"--iterations", set_iterations},
     {"--warmup", set_warmup_iterations},
@@ -59,6 +71,9 @@ constexpr std::array<OptionSpec, 7> OPTION_SPECS{{
     {"--chart", set_chart_path},
     {"--speed", set_note_speed},
     {"--workers", set_worker_count},
+    {"--schedule", set_schedule},
+    {"--lod", set_lod},
+    {"--offline-frames", set_offline_frames},
 }};
 
 const OptionSpec* find_option(std::string_view argument) {
@@ -75,6 +90,14 @@ bool is_supported_scenario(std::string_view scenario) {
            scenario == "clustered";
 }
 
+bool is_supported_schedule(std::string_view schedule) {
+    return schedule == "static" || schedule == "auto" || schedule == "both";
+}
+
+bool is_supported_lod(std::string_view lod) {
+    return lod == "off" || lod == "auto" || lod == "always";
+}
+
 void validate_options(const BenchmarkOptions& options) {
     if (options.noteCount == 0 || options.iterations == 0) {
         throw std::invalid_argument("notes and iterations must be positive");
@@ -83,6 +106,12 @@ void validate_options(const BenchmarkOptions& options) {
         throw std::invalid_argument(
             "scenario must be normal, holds, mixed, or clustered");
     }
+    if (!is_supported_schedule(options.schedule)) {
+        throw std::invalid_argument("schedule must be static, auto, or both");
+    }
+    if (!is_supported_lod(options.lod)) {
+        throw std::invalid_argument("lod must be off, auto, or always");
+    }
 }
 
 }  // namespace
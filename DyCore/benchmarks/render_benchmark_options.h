@@ -13,6 +13,13 @@ struct BenchmarkOptions {
     std::string chartPath;
     double noteSpeed = 0.0;
     std::size_t workerCount = 0;
+    // static, auto, or both (static first, then auto on the same notes).
+    std::string schedule = "static";
+    // off, auto, or always; see RENDER_LOD_MODE.
+    std::string lod = "off";
+    // Frames of the headless video path to render after the render
+    // benchmark, stepping at 60 fps from the benchmark time. Zero skips it.
+    std::size_t offlineFrames = 0;
 };
 
 BenchmarkOptions parse_options(int argc, char** argv);
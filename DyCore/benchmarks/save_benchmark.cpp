@@ -0,0 +1,231 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+// windows.h must come first.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "compress.h"
+#include "format/dyn.h"
+#include "format/dynb.h"
+#include "mappedFile.h"
+#include "note.h"
+#include "project.h"
+#include "projectManager.h"
+#include "timing.h"
+
+// Measures saving, verifying and reopening a large project, and filling the
+// note pool from the reopened chart. Run each mode in its own
+// process, as the peak resident size only ever grows:
+//   --mode stream  the streaming serializer used by the save path
+//   --mode legacy  a JSON dump, one-shot compression and a single write
+//   --mode binary  the DYNB container
+// Options: --notes N (default 200000), --level L (default 3).
+
+namespace {
+
+struct SaveBenchmarkOptions {
+    std::string mode = "stream";
+    size_t noteCount = 200000;
+    int level = 3;
+};
+
+SaveBenchmarkOptions parse_save_options(int argc, char** argv) {
+    SaveBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const std::string value = argv[++i];
+        if (name == "--mode") {
+            if (value != "stream" && value != "legacy" && value != "binary") {
+                throw std::invalid_argument("Unknown mode " + value);
+            }
+            options.mode = value;
+        } else if (name == "--notes") {
+            options.noteCount = std::stoull(value);
+        } else if (name == "--level") {
+            options.level = std::stoi(value);
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+double peak_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return 0.0;
+    }
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+void initialize_project(const SaveBenchmarkOptions& options) {
+    // The project manager resets the chart when first used.
+    (void)chart_get_metadata();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    for (int i = 0; i < 64; ++i) {
+        timing.add_timing_point(
+            {i * 8000.0, 60000.0 / (120.0 + (i % 5) * 20.0), 4});
+    }
+
+    // A fixed seed keeps runs comparable; periodic data would compress far
+    // better than real charts.
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    clear_notes();
+    double time = 0.0;
+    for (size_t i = 0; i < options.noteCount; ++i) {
+        Note note{};
+        note.side = static_cast<int>(random() % 3);
+        note.type = random() % 11 == 0 ? 2 : static_cast<int>(random() % 2);
+        time += 60000.0 / 150.0 / (1 << (random() % 4)) * (random() % 3);
+        note.time = time + jitter(random);
+        note.width = 0.5 + static_cast<double>(random() % 13) * 0.25;
+        note.position = jitter(random) * 5.0;
+        note.lastTime = note.type == 2 ? 100.0 + jitter(random) * 900.0 : 0.0;
+        create_note(note);
+    }
+}
+
+size_t save_legacy(const std::filesystem::path& path, int level) {
+    ProjectManager::inst().update_current_chart();
+    const std::string projectString = ProjectManager::inst().dump();
+    auto buffer =
+        std::make_unique<char[]>(compress_bound(projectString.size()));
+    const double size =
+        DyCore_compress_string(projectString.c_str(), buffer.get(), level);
+    if (size < 0) {
+        throw std::runtime_error("Compression failed");
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.get(), static_cast<std::streamsize>(size));
+    if (!file) {
+        throw std::runtime_error("Write failed");
+    }
+    return static_cast<size_t>(size);
+}
+
+DynExportResult save_stream(const std::filesystem::path& path, int level,
+                            bool binary) {
+    const auto snapshot = ProjectManager::inst().snapshot();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const auto exporter = binary ? project_export_dynb : project_export_dyn;
+    const auto result = exporter(
+        snapshot, {.level = level}, [&](const char* data, size_t size) {
+            file.write(data, static_cast<std::streamsize>(size));
+        });
+    if (!file) {
+        throw std::runtime_error("Write failed");
+    }
+    return result;
+}
+
+// Checks the saved file the way a save does: legacy reads it whole and
+// parses it, the streaming modes check the embedded checksums.
+void verify_saved(const std::filesystem::path& path, const std::string& mode,
+                  const DynExportResult& written) {
+    const MappedFile file(path);
+    if (mode == "legacy") {
+        const auto project = nlohmann::json::parse(
+            decompress_string(file.data().data(), file.size()));
+        if (!project.contains("version")) {
+            throw std::runtime_error("Verify failed");
+        }
+    } else if (mode == "binary") {
+        verify_dynb_file(file.data(), written);
+    } else {
+        verify_dyn_file(file.data(), written);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = parse_save_options(argc, argv);
+        initialize_project(options);
+        const double setupPeak = peak_rss_mb();
+
+        const auto path =
+            std::filesystem::temp_directory_path() / "dycore_save_bench.dyn";
+        auto start = std::chrono::steady_clock::now();
+        DynExportResult written;
+        if (options.mode == "legacy") {
+            written.fileSize = save_legacy(path, options.level);
+        } else {
+            written =
+                save_stream(path, options.level, options.mode == "binary");
+        }
+        const size_t fileSize = written.fileSize;
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        const double savePeak = peak_rss_mb();
+
+        start = std::chrono::steady_clock::now();
+        verify_saved(path, options.mode, written);
+        const std::chrono::duration<double, std::milli> verifyElapsed =
+            std::chrono::steady_clock::now() - start;
+        const double verifyPeak = peak_rss_mb();
+
+        start = std::chrono::steady_clock::now();
+        Project project;
+        if (project_import_dyn(path.string().c_str(), project) != 0) {
+            throw std::runtime_error("Import failed");
+        }
+        const std::chrono::duration<double, std::milli> loadElapsed =
+            std::chrono::steady_clock::now() - start;
+
+        // Filling the note pool, as opening the chart does.
+        clear_notes();
+        start = std::chrono::steady_clock::now();
+        create_notes(project.charts[0].notes);
+        const std::chrono::duration<double, std::milli> poolElapsed =
+            std::chrono::steady_clock::now() - start;
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "mode=" << options.mode << " notes=" << options.noteCount
+                  << " level=" << options.level << '\n'
+                  << "save_ms=" << elapsed.count()
+                  << " file_bytes=" << fileSize
+                  << " setup_peak_rss_mb=" << setupPeak
+                  << " peak_rss_mb=" << savePeak << '\n'
+                  << "verify_ms=" << verifyElapsed.count()
+                  << " verify_peak_rss_mb=" << verifyPeak << '\n'
+                  << "load_ms=" << loadElapsed.count()
+                  << " pool_ms=" << poolElapsed.count() << '\n';
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Save benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "format/xml.h"
+#include "note.h"
+#include "project.h"
+#include "timing.h"
+
+// Measures time/beat/bar conversion and DYM XML import/export on a chart with
+// many BPM changes. The legacy rows walk every timing point for every note,
+// as the converters did before the timing index.
+
+namespace {
+
+struct TimingBenchmarkOptions {
+    size_t timingPointCount = 2000;
+    size_t noteCount = 20000;
+    size_t iterations = 5;
+};
+
+TimingBenchmarkOptions parse_timing_options(int argc, char** argv) {
+    TimingBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const size_t value = std::stoull(argv[++i]);
+        if (value == 0) {
+            throw std::invalid_argument(std::string(name) +
+                                        " must be positive");
+        }
+        if (name == "--timing-points") {
+            options.timingPointCount = value;
+        } else if (name == "--notes") {
+            options.noteCount = value;
+        } else if (name == "--iterations") {
+            options.iterations = value;
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+template <typename Fn>
+double measure_ms(size_t iterations, Fn&& fn) {
+    double best = 0.0;
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+double legacy_time_to_beat(const std::vector<TimingPoint>& points,
+                           double time) {
+    double beat = 0.0;
+    double lastTime = points[0].time;
+    double lastBeatLength = points[0].beatLength;
+    for (const auto& point : points) {
+        if (time < point.time) {
+            break;
+        }
+        beat += (point.time - lastTime) / lastBeatLength;
+        lastTime = point.time;
+        lastBeatLength = point.beatLength;
+    }
+    return beat + (time - lastTime) / lastBeatLength;
+}
+
+double legacy_beat_to_time(const std::vector<TimingPoint>& points,
+                           double beat) {
+    double time = points[0].time;
+    double lastBeat = 0.0;
+    double beatLength = points[0].beatLength;
+    for (size_t i = 1; i < points.size(); ++i) {
+        const double segmentBeats =
+            (points[i].time - points[i - 1].time) / points[i - 1].beatLength;
+        if (lastBeat + segmentBeats > beat) {
+            break;
+        }
+        lastBeat += segmentBeats;
+        time = points[i].time;
+        beatLength = points[i].beatLength;
+    }
+    return time + (beat - lastBeat) * beatLength;
+}
+
+void initialize_chart(const TimingBenchmarkOptions& options) {
+    // The project manager resets the chart when first used.
+    (void)chart_get_metadata();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    std::vector<TimingPoint> points;
+    double time = 0.0;
+    for (size_t i = 0; i < options.timingPointCount; ++i) {
+        const double bpm = 120.0 + static_cast<double>(i % 7) * 15.0;
+        points.push_back({time, 60000.0 / bpm, 4});
+        time += 60000.0 / bpm * 4;
+    }
+    timing.append_timing_points(points);
+
+    clear_notes();
+    const double step = time / static_cast<double>(options.noteCount);
+    for (size_t i = 0; i < options.noteCount; ++i) {
+        Note note{};
+        note.side = static_cast<int>(i % 3);
+        note.type = 0;
+        note.time = static_cast<double>(i) * step;
+        note.width = 1.0;
+        note.position = 2.5;
+        create_note(note);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = parse_timing_options(argc, argv);
+        initialize_chart(options);
+
+        auto& timing = get_timing_manager();
+        std::vector<TimingPoint> points;
+        timing.get_timing_points(points);
+        std::vector<Note> notes;
+        get_notes_array(notes);
+        std::vector<double> times(notes.size());
+        std::transform(notes.begin(), notes.end(), times.begin(),
+                       [](const Note& note) { return note.time; });
+        std::sort(times.begin(), times.end());
+        std::vector<double> beats(times.size());
+        std::vector<double> checkTimes(times.size());
+
+        std::cout << std::fixed << std::setprecision(4)
+                  << "timing_points=" << points.size()
+                  << " notes=" << times.size()
+                  << " iterations=" << options.iterations << '\n';
+
+        double maxError = 0.0;
+        const double legacyToBeat = measure_ms(options.iterations, [&] {
+            for (size_t i = 0; i < times.size(); ++i) {
+                beats[i] = legacy_time_to_beat(points, times[i]);
+            }
+        });
+        const double legacyToTime = measure_ms(options.iterations, [&] {
+            for (size_t i = 0; i < beats.size(); ++i) {
+                checkTimes[i] = legacy_beat_to_time(points, beats[i]);
+            }
+        });
+        const double indexToBeat = measure_ms(options.iterations, [&] {
+            timing.get_index().convert(times, beats, TIMING_UNIT::MS,
+                                       TIMING_UNIT::BEAT);
+        });
+        const double indexToTime = measure_ms(options.iterations, [&] {
+            timing.get_index().convert(beats, checkTimes, TIMING_UNIT::BEAT,
+                                       TIMING_UNIT::MS);
+        });
+        for (size_t i = 0; i < times.size(); ++i) {
+            maxError = std::max(maxError, std::abs(checkTimes[i] - times[i]));
+        }
+        std::cout << "legacy.time_to_beat_ms=" << legacyToBeat
+                  << " beat_to_time_ms=" << legacyToTime << '\n'
+                  << "index.time_to_beat_ms=" << indexToBeat
+                  << " beat_to_time_ms=" << indexToTime
+                  << " round_trip_max_error_ms=" << maxError << '\n';
+
+        const auto path =
+            std::filesystem::temp_directory_path() / "dycore_timing_bench.xml";
+        const std::string pathString = path.string();
+        const double exportMs = measure_ms(options.iterations, [&] {
+            chart_export_xml(pathString.c_str(), true, 0.0);
+        });
+        const double importMs = measure_ms(options.iterations, [&] {
+            clear_notes();
+            if (chart_import_xml(pathString.c_str(), false, true) !=
+                IMPORT_XML_RESULT_STATES::SUCCESS) {
+                throw std::runtime_error("XML import failed");
+            }
+        });
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        std::cout << "xml.export_ms=" << exportMs << " import_ms=" << importMs
+                  << '\n';
+
+        clear_notes();
+        timing.clear();
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Timing benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
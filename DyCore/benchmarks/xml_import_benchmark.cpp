@@ -0,0 +1,204 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+// windows.h must come first.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "format/xml.h"
+#include "note.h"
+#include "project.h"
+#include "timing.h"
+#include "utils.h"
+
+// Measures importing a large Dynamix XML chart with many speed changes.
+// Run it in its own process for each size, as the peak resident size only
+// ever grows.
+// Options: --notes N (default 300000), --bpm-changes N (default 20000),
+// --repeat N (default 3).
+
+namespace {
+
+struct XmlImportBenchmarkOptions {
+    size_t noteCount = 300000;
+    size_t bpmChangeCount = 20000;
+    int repeat = 3;
+};
+
+XmlImportBenchmarkOptions parse_xml_import_options(int argc, char** argv) {
+    XmlImportBenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view name = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " +
+                                        std::string(name));
+        }
+        const std::string value = argv[++i];
+        if (name == "--notes") {
+            options.noteCount = std::stoull(value);
+        } else if (name == "--bpm-changes") {
+            options.bpmChangeCount = std::stoull(value);
+        } else if (name == "--repeat") {
+            options.repeat = std::max(1, std::stoi(value));
+        } else {
+            throw std::invalid_argument("Unknown option " + std::string(name));
+        }
+    }
+    return options;
+}
+
+double peak_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return 0.0;
+    }
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+// Writes a chart in the current CMap format, spreading the notes over the
+// three sides with a hold every eleventh note.
+void write_xml_chart(const std::filesystem::path& path,
+                     const XmlImportBenchmarkOptions& options) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "<?xml version=\"1.0\"?>\n"
+           "<CMap xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">\n"
+           "  <m_path>bench</m_path>\n"
+           "  <m_barPerMin>40</m_barPerMin>\n"
+           "  <m_timeOffset>0.25</m_timeOffset>\n"
+           "  <m_leftRegion>PAD</m_leftRegion>\n"
+           "  <m_rightRegion>MIXER</m_rightRegion>\n"
+           "  <m_mapID>_map_bench_G</m_mapID>\n";
+
+    // A fixed seed keeps runs comparable.
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    const size_t barCount = std::max<size_t>(options.noteCount / 8, 1);
+    const auto fdwp = [](double value) {
+        return format_double_with_precision(value, XML_EXPORT_EPS);
+    };
+    size_t id = 0;
+    const char* sides[] = {"m_notes", "m_notesLeft", "m_notesRight"};
+    for (int side = 0; side < 3; ++side) {
+        out << "  <" << sides[side] << ">\n    <m_notes>\n";
+        const size_t count =
+            options.noteCount / 3 + (side == 0 ? options.noteCount % 3 : 0);
+        for (size_t i = 0; i < count; ++i) {
+            const double bar = static_cast<double>(i) * barCount / count +
+                               jitter(random) * 0.01;
+            const double width = 0.5 + (random() % 13) * 0.25;
+            const double position = jitter(random) * 5.0 - width / 2;
+            const bool hold = i % 11 == 0;
+            const size_t noteId = id++;
+            out << "      <CMapNoteAsset>\n        <m_id>" << noteId
+                << "</m_id>\n        <m_type>"
+                << (hold ? "HOLD" : random() % 2 ? "CHAIN" : "NORMAL")
+                << "</m_type>\n        <m_time>" << fdwp(bar)
+                << "</m_time>\n        <m_position>" << fdwp(position)
+                << "</m_position>\n        <m_width>" << fdwp(width)
+                << "</m_width>\n        <m_subId>"
+                << (hold ? static_cast<long long>(id) : -1)
+                << "</m_subId>\n      </CMapNoteAsset>\n";
+            if (hold) {
+                out << "      <CMapNoteAsset>\n        <m_id>" << id++
+                    << "</m_id>\n        <m_type>SUB</m_type>\n"
+                       "        <m_time>"
+                    << fdwp(bar + 0.25 + jitter(random))
+                    << "</m_time>\n        <m_position>" << fdwp(position)
+                    << "</m_position>\n        <m_width>" << fdwp(width)
+                    << "</m_width>\n        <m_subId>-1</m_subId>\n"
+                       "      </CMapNoteAsset>\n";
+            }
+        }
+        out << "    </m_notes>\n  </" << sides[side] << ">\n";
+    }
+
+    out << "  <m_argument>\n    <m_bpmchange>\n";
+    for (size_t i = 0; i < options.bpmChangeCount; ++i) {
+        const double bar = static_cast<double>(i) * barCount /
+                           std::max<size_t>(options.bpmChangeCount, 1);
+        out << "      <CBpmchange>\n        <m_time>" << fdwp(bar)
+            << "</m_time>\n        <m_value>"
+            << fdwp(30.0 + jitter(random) * 20.0)
+            << "</m_value>\n      </CBpmchange>\n";
+    }
+    out << "    </m_bpmchange>\n  </m_argument>\n</CMap>\n";
+    if (!out) {
+        throw std::runtime_error("Write failed");
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = parse_xml_import_options(argc, argv);
+        // The project manager resets the chart when first used.
+        (void)chart_get_metadata();
+
+        const auto path =
+            std::filesystem::temp_directory_path() / "dycore_xml_bench.xml";
+        write_xml_chart(path, options);
+        const double setupPeak = peak_rss_mb();
+
+        double bestMs = 0.0;
+        for (int run = 0; run < options.repeat; ++run) {
+            clear_notes();
+            get_timing_manager().clear();
+            const auto start = std::chrono::steady_clock::now();
+            if (chart_import_xml(path.string().c_str(), true, true) !=
+                IMPORT_XML_RESULT_STATES::SUCCESS) {
+                throw std::runtime_error("Import failed");
+            }
+            const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < bestMs) {
+                bestMs = elapsed.count();
+            }
+        }
+        const double importPeak = peak_rss_mb();
+
+        std::vector<Note> notes;
+        get_notes_array(notes);
+        std::error_code ec;
+        const auto fileSize = std::filesystem::file_size(path, ec);
+        std::filesystem::remove(path, ec);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "notes=" << options.noteCount
+                  << " bpm_changes=" << options.bpmChangeCount
+                  << " file_bytes=" << fileSize << '\n'
+                  << "import_ms=" << bestMs
+                  << " imported_notes=" << notes.size()
+                  << " timing_points=" << get_timing_manager().count() << '\n'
+                  << "setup_peak_rss_mb=" << setupPeak
+                  << " import_peak_rss_mb=" << importPeak << '\n';
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "XML import benchmark failed: " << e.what() << '\n';
+        return 1;
+    }
+}
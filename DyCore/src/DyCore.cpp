@@ -11,6 +11,7 @@
 #include "api.h"
 #include "config.h"
 #include "ffmpeg/base.h"
+#include "journal.h"
 #include "utils.h"
 #include "version.h"
 #include "window.h"
@@ -75,6 +76,9 @@ DYCORE_API const char* DyCore_init(const char* hwnd, const char* programPath) {
 
     hwndParent = hwndHandle;
 
+    // Log edits to the open project so they survive a crash.
+    install_project_journal();
+
     // Check FFmpeg availability
     if (is_FFmpeg_available()) {
         print_debug_message("FFmpeg is available.");
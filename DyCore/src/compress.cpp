@@ -5,8 +5,12 @@
 #include <zstd.h>
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "api.h"
 #include "gm.h"
@@ -14,6 +18,102 @@
 
 using std::string;
 
+/*! CHECK
+ * Check that the condition holds. If it doesn't print a message and die.
+ */
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d CHECK(%s) failed: ", __FILE__, __LINE__, \
+                    #cond);                                                 \
+            fprintf(stderr, "" __VA_ARGS__);                                \
+            fprintf(stderr, "\n");                                          \
+            throw;                                                          \
+        }                                                                   \
+    } while (0)
+
+/*! CHECK_ZSTD
+ * Check the zstd error code and die if an error occurred after printing a
+ * message.
+ */
+#define CHECK_ZSTD(fn)                                           \
+    do {                                                         \
+        size_t const err = (fn);                                 \
+        CHECK(!ZSTD_isError(err), "%s", ZSTD_getErrorName(err)); \
+    } while (0)
+
+namespace {
+
+// Inputs below this size compress on the calling thread; zstd hands out
+// jobs of a few megabytes, so smaller inputs would not keep a worker busy.
+constexpr size_t ZSTD_MULTITHREAD_MIN_SIZE = 4 * 1024 * 1024;
+constexpr int ZSTD_MAX_AUTO_WORKERS = 4;
+// Inputs from this size on look for repeats beyond the regular window.
+constexpr size_t ZSTD_LONG_DISTANCE_MIN_SIZE = 32 * 1024 * 1024;
+
+// A thread's decompression context is recreated rather than kept once a
+// stream has grown its window past this.
+constexpr size_t ZSTD_KEPT_DCTX_SIZE = 16 * 1024 * 1024;
+
+void check_compress_parameter(size_t result) {
+    if (ZSTD_isError(result)) {
+        throw std::runtime_error(
+            string("Error configuring compression: ") +
+            ZSTD_getErrorName(result));
+    }
+}
+
+[[noreturn]] void throw_decompress_error(size_t result) {
+    throw std::runtime_error(string("Error decompressing: ") +
+                             ZSTD_getErrorName(result));
+}
+
+}  // namespace
+
+ZstdCompressLease acquire_compress_context(const ZstdCompressOptions& options,
+                                           size_t contentSize) {
+    static std::mutex mtx;
+    static std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(
+        nullptr, &ZSTD_freeCCtx);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    if (!cctx) {
+        cctx.reset(ZSTD_createCCtx());
+        if (!cctx) {
+            throw std::runtime_error("Error creating the compression context.");
+        }
+    }
+    // Parameters go back to their defaults; the worker pool stays.
+    ZSTD_CCtx_reset(cctx.get(), ZSTD_reset_session_and_parameters);
+
+    const int level = std::clamp(options.level, 1, ZSTD_maxCLevel());
+    check_compress_parameter(
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, level));
+
+    // Builds without multithreading support allow no workers at all.
+    const auto workerBounds = ZSTD_cParam_getBounds(ZSTD_c_nbWorkers);
+    int workers = options.workers.value_or(
+        contentSize >= ZSTD_MULTITHREAD_MIN_SIZE
+            ? std::clamp(hardware_concurrency() - 1, 0, ZSTD_MAX_AUTO_WORKERS)
+            : 0);
+    if (ZSTD_isError(workerBounds.error)) {
+        workers = 0;
+    } else {
+        workers = std::clamp(workers, 0, workerBounds.upperBound);
+    }
+    if (workers > 0) {
+        check_compress_parameter(
+            ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_nbWorkers, workers));
+    }
+
+    if (options.longDistanceMatching.value_or(contentSize >=
+                                              ZSTD_LONG_DISTANCE_MIN_SIZE)) {
+        check_compress_parameter(ZSTD_CCtx_setParameter(
+            cctx.get(), ZSTD_c_enableLongDistanceMatching, 1));
+    }
+    return {std::move(lock), cctx.get()};
+}
+
 // Compresses a string using Zstandard (zstd) algorithm.
 //
 // @param str The input string to compress.
@@ -38,17 +138,19 @@ DYCORE_API double DyCore_compress_string(const char* str, char* targetBuffer,
     }
 
     size_t fSize = strlen(str);
-    size_t cBuffSize = ZSTD_compressBound(fSize);
-
-    auto fBuff = std::make_unique<char[]>(fSize);
-    auto cBuff = std::make_unique<char[]>(cBuffSize);
-
-    memcpy(fBuff.get(), str, fSize);
 
     std::cout << "[DyCore] Start compressing..." << std::endl;
 
-    size_t const cSize = ZSTD_compress(cBuff.get(), cBuffSize, fBuff.get(),
-                                       fSize, (int)compressionLevel);
+    size_t cSize;
+    try {
+        auto lease = acquire_compress_context(
+            {.level = (int)compressionLevel}, fSize);
+        cSize = ZSTD_compress2(lease.get(), targetBuffer,
+                               ZSTD_compressBound(fSize), str, fSize);
+    } catch (const std::exception& e) {
+        print_debug_message(e.what());
+        return -1;
+    }
 
     std::cout << "[DyCore] Finish compressing, checking..." << std::endl;
 
@@ -61,9 +163,6 @@ DYCORE_API double DyCore_compress_string(const char* str, char* targetBuffer,
     std::cout << "[DyCore] No error found. Success. " << fSize << "->" << cSize
               << "(" << ((double)cSize / fSize * 100.0) << "%)" << std::endl;
 
-    // Success
-    memcpy(targetBuffer, cBuff.get(), cSize);
-
     return (double)cSize;
 }
 
@@ -71,11 +170,12 @@ DYCORE_API double DyCore_compress_string(const char* str, char* targetBuffer,
 //
 // @param str A pointer to the data buffer.
 // @param _sSize The size of the data buffer.
-// @return True if the data is likely zstd-compressed, false otherwise.
+// @return True if the data is likely zstd-compressed, false otherwise. Frames
+// written by a stream, which do not record their content size, count too.
 bool check_compressed(const char* str, double _sSize) {
     size_t sSize = (size_t)_sSize;
     unsigned long long const rSize = ZSTD_getFrameContentSize(str, sSize);
-    return rSize != ZSTD_CONTENTSIZE_ERROR && rSize != ZSTD_CONTENTSIZE_UNKNOWN;
+    return rSize != ZSTD_CONTENTSIZE_ERROR;
 }
 
 // Checks if a data buffer is compressed using zstd.
@@ -88,6 +188,84 @@ DYCORE_API double DyCore_is_compressed(const char* str, double _sSize) {
     return check_compressed(str, sSize) ? 0.0 : -1.0;
 }
 
+ZSTD_DCtx* thread_decompress_context() {
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(
+        nullptr, &ZSTD_freeDCtx);
+    if (dctx && ZSTD_sizeof_DCtx(dctx.get()) > ZSTD_KEPT_DCTX_SIZE) {
+        dctx.reset();
+    }
+    if (!dctx) {
+        dctx.reset(ZSTD_createDCtx());
+        if (!dctx) {
+            throw std::runtime_error(
+                "Error creating the decompression context.");
+        }
+    }
+    ZSTD_DCtx_reset(dctx.get(), ZSTD_reset_session_only);
+    return dctx.get();
+}
+
+size_t decompress_into(std::span<const char> src, char* dst,
+                       size_t capacity) {
+    const size_t result = ZSTD_decompressDCtx(
+        thread_decompress_context(), dst, capacity, src.data(), src.size());
+    if (ZSTD_getErrorCode(result) == ZSTD_error_dstSize_tooSmall) {
+        throw std::length_error("Decompressed data does not fit the buffer.");
+    }
+    if (ZSTD_isError(result)) {
+        throw_decompress_error(result);
+    }
+    return result;
+}
+
+size_t decompress_stream(std::span<const char> src,
+                         const ZstdChunkConsumer& consume) {
+    ZSTD_DCtx* dctx = thread_decompress_context();
+    std::vector<char> output(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer in{src.data(), src.size(), 0};
+    size_t contentSize = 0;
+    size_t remaining = 1;
+    // zstd keeps the last byte of a frame until all of it is flushed.
+    while (in.pos < in.size) {
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        remaining = ZSTD_decompressStream(dctx, &out, &in);
+        if (ZSTD_isError(remaining)) {
+            throw_decompress_error(remaining);
+        }
+        if (out.pos > 0) {
+            consume(output.data(), out.pos);
+            contentSize += out.pos;
+        }
+    }
+    if (remaining != 0) {
+        throw std::runtime_error("Error decompressing: data ends early.");
+    }
+    return contentSize;
+}
+
+string decompress_to_string(std::span<const char> src) {
+    // Sized by the first frame, which holds all of the content of the files
+    // written here; anything more is read by streaming.
+    const auto size = ZSTD_getFrameContentSize(src.data(), src.size());
+    if (size == ZSTD_CONTENTSIZE_ERROR) {
+        throw std::runtime_error("Error decompressing: not zstd data.");
+    }
+    if (size != ZSTD_CONTENTSIZE_UNKNOWN) {
+        string content(size, '\0');
+        try {
+            content.resize(
+                decompress_into(src, content.data(), content.size()));
+            return content;
+        } catch (const std::length_error&) {
+        }
+    }
+    string content;
+    decompress_stream(src, [&](const char* data, size_t size) {
+        content.append(data, size);
+    });
+    return content;
+}
+
 // Decompresses a zstd-compressed string.
 //
 // @param str A pointer to the compressed data.
@@ -101,18 +279,12 @@ string decompress_string(const char* str, double _sSize) {
         return "failed";
     }
 
-    std::cout << "[DyCore] Start decompressing..." << std::endl;
-
-    size_t const rSize = ZSTD_getFrameContentSize(str, sSize);
-    auto rBuff = std::make_unique<char[]>(rSize);
-    size_t const dSize = ZSTD_decompress(rBuff.get(), rSize, str, sSize);
-
-    if (dSize != rSize)
+    try {
+        return decompress_to_string({str, sSize});
+    } catch (const std::exception& e) {
+        print_debug_message(e.what());
         return "failed";
-
-    // Success
-    print_debug_message("Decompression success.");
-    return std::string(rBuff.get(), rSize);
+    }
 }
 
 // Decompresses a zstd-compressed string.
@@ -140,6 +312,65 @@ DYCORE_API const char* DyCore_decompress_string(const char* str,
     return returnBuffer.c_str();
 }
 
+// Returns the size of the content of zstd-compressed data, for sizing the
+// buffer passed to DyCore_decompress_to_buffer.
+//
+// @param src A pointer to the compressed data.
+// @param srcSize The size of the compressed data.
+// @return The content size, -1 if the data is not zstd-compressed, or -2 if
+// a frame does not record its size.
+DYCORE_API double DyCore_get_decompressed_size(const char* src,
+                                               double srcSize) {
+    if (!src) {
+        return -1;
+    }
+    const char* frame = src;
+    size_t left = (size_t)srcSize;
+    double contentSize = 0;
+    do {
+        const auto size = ZSTD_getFrameContentSize(frame, left);
+        if (size == ZSTD_CONTENTSIZE_ERROR) {
+            return -1;
+        }
+        if (size == ZSTD_CONTENTSIZE_UNKNOWN) {
+            return -2;
+        }
+        const size_t frameSize = ZSTD_findFrameCompressedSize(frame, left);
+        if (ZSTD_isError(frameSize)) {
+            return -1;
+        }
+        contentSize += (double)size;
+        frame += frameSize;
+        left -= frameSize;
+    } while (left > 0);
+    return contentSize;
+}
+
+// Decompresses zstd-compressed data straight into a buffer.
+//
+// @param src A pointer to the compressed data.
+// @param srcSize The size of the compressed data.
+// @param dst The buffer to store the decompressed data.
+// @param dstCapacity The size of the buffer.
+// @return The size of the decompressed data, -1 on error, or -2 if it does
+// not fit the buffer.
+DYCORE_API double DyCore_decompress_to_buffer(const char* src, double srcSize,
+                                              char* dst, double dstCapacity) {
+    if (!src || !dst) {
+        print_debug_message("Error: Null pointer passed to decompress.");
+        return -1;
+    }
+    try {
+        return (double)decompress_into({src, (size_t)srcSize}, dst,
+                                       (size_t)dstCapacity);
+    } catch (const std::length_error&) {
+        return -2;
+    } catch (const std::exception& e) {
+        print_debug_message(e.what());
+        return -1;
+    }
+}
+
 // Returns the maximum compressed size in the worst-case scenario for a given
 // input size.
 size_t compress_bound(size_t size) {
@@ -1,35 +1,19 @@
+#pragma once
+
+#include <zstd.h>
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <utility>
 
 #include "api.h"
 
 using std::string;
 
-/// ZSTD Stuff
-
-/*! CHECK
- * Check that the condition holds. If it doesn't print a message and die.
- */
-#define CHECK(cond, ...)                                                    \
-    do {                                                                    \
-        if (!(cond)) {                                                      \
-            fprintf(stderr, "%s:%d CHECK(%s) failed: ", __FILE__, __LINE__, \
-                    #cond);                                                 \
-            fprintf(stderr, "" __VA_ARGS__);                                \
-            fprintf(stderr, "\n");                                          \
-            throw;                                                          \
-        }                                                                   \
-    } while (0)
-
-/*! CHECK_ZSTD
- * Check the zstd error code and die if an error occurred after printing a
- * message.
- */
-#define CHECK_ZSTD(fn)                                           \
-    do {                                                         \
-        size_t const err = (fn);                                 \
-        CHECK(!ZSTD_isError(err), "%s", ZSTD_getErrorName(err)); \
-    } while (0)
-
 DYCORE_API double DyCore_get_project_buffer(const char *projectProp,
                                             char *targetBuffer,
                                             double compressionLevel);
@@ -44,4 +28,62 @@ string decompress_string(string str);
 bool check_compressed(const char *str, double _sSize);
 size_t compress_bound(size_t srcSize);
 
-DYCORE_API const char *DyCore_decompress_string(const char *str, double _sSize);
\ No newline at end of file
+DYCORE_API const char *DyCore_decompress_string(const char *str, double _sSize);
+
+DYCORE_API double DyCore_get_decompressed_size(const char *src, double srcSize);
+DYCORE_API double DyCore_decompress_to_buffer(const char *src, double srcSize,
+                                              char *dst, double dstCapacity);
+
+// Receives decompressed data in order. The data is only valid during the
+// call.
+using ZstdChunkConsumer = std::function<void(const char *data, size_t size)>;
+
+// The decompression context of the calling thread, reset for a new frame.
+// It keeps its window and tables between uses, so importing many files
+// allocates them once per thread.
+ZSTD_DCtx *thread_decompress_context();
+
+// Decompresses the frames in src into dst, which must hold all of their
+// content; frames need not record their content size. Returns the size of
+// the content. Throws if the data is damaged or dst is too small.
+size_t decompress_into(std::span<const char> src, char *dst, size_t capacity);
+// Decompresses the frames in src piece by piece into consume, so frames
+// without a recorded content size are read too. Returns the size of the
+// content. Throws if the data is damaged or ends within a frame.
+size_t decompress_stream(std::span<const char> src,
+                         const ZstdChunkConsumer &consume);
+// Decompresses the frames in src into a string of the content size, or a
+// growing one if a frame does not record it. Throws like the above.
+string decompress_to_string(std::span<const char> src);
+
+struct ZstdCompressOptions {
+    int level = 3;
+    // Worker threads. Unset picks a count from the input size.
+    std::optional<int> workers;
+    // Unset enables long-distance matching for large inputs only.
+    std::optional<bool> longDistanceMatching;
+    // Lets small sections of binary projects use the built-in dictionary.
+    bool smallDataDictionary = true;
+};
+
+// Exclusive use of the compression context shared by project saves, which
+// keeps its tables and worker threads between saves.
+class ZstdCompressLease {
+   public:
+    ZstdCompressLease(std::unique_lock<std::mutex> lock, ZSTD_CCtx *cctx)
+        : lock(std::move(lock)), cctx(cctx) {
+    }
+
+    ZSTD_CCtx *get() const {
+        return cctx;
+    }
+
+   private:
+    std::unique_lock<std::mutex> lock;
+    ZSTD_CCtx *cctx;
+};
+
+// Resets the shared context and applies the options for compressing about
+// contentSize bytes. Throws if the options are rejected.
+ZstdCompressLease acquire_compress_context(const ZstdCompressOptions &options,
+                                           size_t contentSize);
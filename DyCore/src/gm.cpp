@@ -30,13 +30,21 @@ DYCORE_API double DyCore_has_async_event() {
 // The event is removed from the queue after retrieval.
 // Returns an empty string if no events are available.
 DYCORE_API const char* DyCore_get_async_event() {
-    std::lock_guard<std::mutex> lock(mtxAsyncEvents);
-    if (asyncEventQueue.empty())
-        return "";
+    AsyncEvent event;
+    {
+        std::lock_guard<std::mutex> lock(mtxAsyncEvents);
+        if (asyncEventQueue.empty())
+            return "";
+        event = std::move(asyncEventQueue.front());
+        asyncEventQueue.pop();
+    }
     static string result = "";
     try {
-        json j = asyncEventQueue.front();
-        asyncEventQueue.pop();
+        // Outside the lock, as it may push events of its own.
+        if (event.onTaken) {
+            event.onTaken(event);
+        }
+        json j = event;
         result = nlohmann::to_string(j);
         return result.c_str();
     } catch (json::exception& e) {
@@ -6,6 +6,7 @@
 // and notify GameMaker upon completion.
 
 #pragma once
+#include <functional>
 #include <json.hpp>
 #include <mutex>
 #include <queue>
@@ -20,17 +21,23 @@ using std::string;
 // GENERAL_ERROR: Called when an error occurs.
 // GM_ANNOUNCEMENT: Call GM announcement function.
 // ON_FILES_DROPPED: Called when files are dropped into the window.
+// CHART_IMPORT_BATCH: Called when a batch chart import is done.
 enum ASYNC_EVENT_TYPE {
     PROJECT_SAVING,
     GENERAL_ERROR,
     GM_ANNOUNCEMENT,
-    ON_FILES_DROPPED
+    ON_FILES_DROPPED,
+    PROJECT_SAVE_PROGRESS,
+    CHART_IMPORT_BATCH
 };
 
 struct AsyncEvent {
     ASYNC_EVENT_TYPE type;
     int status;
     string content;
+    // Runs on the GameMaker thread when the event is taken, before it is
+    // passed on, for results that must not race the GameMaker thread.
+    std::function<void(AsyncEvent &)> onTaken;
 };
 inline void to_json(json &j, const AsyncEvent &a) {
     j = json{{"type", a.type}, {"status", a.status}, {"content", a.content}};
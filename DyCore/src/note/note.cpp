@@ -63,6 +63,12 @@ int create_note(const Note& note, bool randomID, bool createSub) {
     return 0;
 }
 
+// Creates many notes at once, each as create_note() would with random IDs
+// and sub notes. Returns the number of notes added, sub notes included.
+size_t create_notes(std::span<const Note> notes) {
+    return get_note_pool_manager().bulk_load(notes);
+}
+
 // Deletes a note from the note map.
 // Returns 0 on success, -1 if the note does not exist.
 int delete_note(const Note& note) {
@@ -2,7 +2,9 @@
 
 #include <xxhash/xxhash.h>
 
+#include <span>
 #include <string>
+#include <vector>
 
 #include "bitio.h"
 #include "json.hpp"
@@ -21,6 +23,7 @@ bool note_exists(const string &noteID);
 void clear_notes();
 int insert_note(const Note &note);
 int create_note(const Note &note, bool randomID = true, bool createSub = true);
+size_t create_notes(std::span<const Note> notes);
 int delete_note(const Note &note);
 int delete_note(const std::string &noteID);
 int modify_note(const Note &note);
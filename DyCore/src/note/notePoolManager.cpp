@@ -5,6 +5,7 @@
 #include <mutex>
 #include <shared_mutex>
 #include <stdexcept>
+#include <tuple>
 #include <taskflow/algorithm/for_each.hpp>
 #include <taskflow/algorithm/sort.hpp>
 #include <taskflow/taskflow.hpp>
@@ -67,7 +68,9 @@ bool NotePoolManager::create_note(const Note& note) {
             holdArray.push_back(ptr);
 
         set_ooo();
+        mark_modified();
         noteCount++;
+        notify_changed(nullptr, ptr.get());
 
         return true;
     } catch (const std::bad_alloc& e) {
@@ -76,6 +79,116 @@ bool NotePoolManager::create_note(const Note& note) {
     }
 }
 
+size_t NotePoolManager::bulk_load(std::span<const Note> notes) {
+    PROFILE_SCOPE("Note Pool Manager Bulk Load");
+    if (notes.empty()) {
+        return 0;
+    }
+    const size_t holdCount = std::count_if(
+        notes.begin(), notes.end(), [](const Note& note) {
+            return note.get_note_type() == NOTE_TYPE::HOLD;
+        });
+    const size_t total = notes.size() + holdCount;
+
+    std::lock_guard<std::shared_mutex> lock(mtxNoteOps);
+    // An empty pool can take the batch in time order without a full sort.
+    const bool appendInOrder = noteArray.empty();
+    noteArray.reserve(noteArray.size() + total);
+    holdArray.reserve(holdArray.size() + holdCount);
+    noteInfoMap.reserve(noteInfoMap.size() + total);
+
+    std::pmr::polymorphic_allocator<Note> alloc(&pool_res);
+    std::vector<std::pair<nptr, NoteMemoryInfo*>> added;
+    added.reserve(total);
+    auto add = [&](Note& note) {
+        auto [it, inserted] = noteInfoMap.try_emplace(note.noteID);
+        while (!inserted) {
+            note.noteID = generate_note_id();
+            std::tie(it, inserted) = noteInfoMap.try_emplace(note.noteID);
+        }
+        auto ptr = std::allocate_shared<Note>(alloc, std::move(note));
+        noteMemoryList.emplace_back(ptr);
+        // Indexes are assigned once the batch is in order.
+        it->second = {--noteMemoryList.end(), ptr, -1, -1};
+        added.emplace_back(ptr, &it->second);
+        return ptr;
+    };
+
+    for (const auto& note : notes) {
+        Note head(note);
+        head.noteID = generate_note_id();
+        if (head.get_note_type() != NOTE_TYPE::HOLD) {
+            add(head);
+            continue;
+        }
+        Note sub(head);
+        sub.noteID = generate_note_id();
+        sub.time = head.time + head.lastTime;
+        sub.lastTime = 0;
+        sub.beginTime = head.time;
+        sub.type = static_cast<int>(NOTE_TYPE::SUB);
+        // IDs may change on a collision, so link the pair once both are in.
+        auto subPtr = add(sub);
+        auto headPtr = add(head);
+        headPtr->subNoteID = subPtr->noteID;
+        subPtr->subNoteID = headPtr->noteID;
+    }
+    noteCount += static_cast<int>(total);
+    mark_modified();
+    if (auto* listener = changeListener.load(std::memory_order_acquire)) {
+        std::vector<Note> loaded;
+        loaded.reserve(notes.size());
+        for (const auto& [ptr, info] : added) {
+            if (ptr->get_note_type() != NOTE_TYPE::SUB) {
+                loaded.push_back(*ptr);
+            }
+        }
+        listener->notes_loaded(loaded);
+    }
+
+    if (appendInOrder) {
+        auto added_cmp = [](const auto& a, const auto& b) {
+            return a.first->time < b.first->time;
+        };
+        if (added.size() >= NOTES_ARRAY_PARALLEL_SORT_THRESHOLD &&
+            hardware_concurrency() > 1) {
+            tf::Taskflow taskflow;
+            tf::Executor tfexecutor;
+            taskflow.sort(added.begin(), added.end(), added_cmp);
+            tfexecutor.run(taskflow).wait();
+        } else {
+            std::sort(added.begin(), added.end(), added_cmp);
+        }
+    }
+
+    std::vector<std::pair<nptr, NoteMemoryInfo*>> holds;
+    holds.reserve(holdCount);
+    for (auto& [ptr, info] : added) {
+        info->index = static_cast<int>(noteArray.size());
+        noteArray.push_back(ptr);
+        if (ptr->get_note_type() == NOTE_TYPE::HOLD) {
+            holds.emplace_back(std::move(ptr), info);
+        }
+    }
+    if (appendInOrder) {
+        std::sort(holds.begin(), holds.end(), [](const auto& a, const auto& b) {
+            return a.first->lastTime > b.first->lastTime;
+        });
+    }
+    for (const auto& [ptr, info] : holds) {
+        info->holdIndex = static_cast<int>(holdArray.size());
+        holdArray.push_back(ptr);
+    }
+
+    if (appendInOrder) {
+        unset_ooo();
+    } else {
+        array_sort();
+        unset_ooo();
+    }
+    return total;
+}
+
 const Note& NotePoolManager::get_note(const std::string& noteID) {
     nptr note_ptr;
     {
@@ -103,6 +216,41 @@ void NotePoolManager::get_notes(std::vector<Note>& outNotes,
     }
 }
 
+size_t NotePoolManager::access_notes(
+    std::span<const std::string> noteIDs,
+    const std::function<void(Note&, size_t)>& executor) {
+    std::lock_guard<std::shared_mutex> lock(mtxNoteOps);
+    mark_modified();
+    size_t edited = 0;
+    for (size_t i = 0; i < noteIDs.size(); ++i) {
+        auto it = noteInfoMap.find(noteIDs[i]);
+        if (it == noteInfoMap.end()) {
+            continue;
+        }
+        const nptr note_ptr = it->second.pointer;
+        const auto before = copy_for_listener(*note_ptr);
+        double origTime = note_ptr->time;
+        executor(*note_ptr, i);
+        if (origTime != note_ptr->time)
+            set_ooo();
+        sync_head_note_to_sub(*note_ptr);
+        sync_hold_note_length(*note_ptr);
+        notify_changed(before, *note_ptr);
+        ++edited;
+    }
+    return edited;
+}
+
+void NotePoolManager::for_each_note(
+    const std::function<void(const Note&)>& visitor) const {
+    std::shared_lock<std::shared_mutex> lock(mtxNoteOps);
+    for (const auto& note_ptr : noteArray) {
+        if (note_ptr) {
+            visitor(*note_ptr);
+        }
+    }
+}
+
 const Note& NotePoolManager::get_note_direct(int index) {
     std::shared_lock<std::shared_mutex> lock(mtxNoteOps);
     if (index < 0 || index >= static_cast<int>(noteArray.size())) {
@@ -120,12 +268,15 @@ void NotePoolManager::set_note(const Note& note) {
         }
         note_ptr = get_note_pointer(note.noteID);
     }  // Release the manager lock
+    const auto before = copy_for_listener(*note_ptr);
     if (note_ptr->time != note.time)
         set_ooo();
     *note_ptr = note;
+    mark_modified();
 
     sync_head_note_to_sub(*note_ptr);
     sync_hold_note_length(*note_ptr);
+    notify_changed(before, *note_ptr);
 }
 
 void NotePoolManager::set_note_bitwise(const char* prop) {
@@ -145,26 +296,32 @@ void NotePoolManager::access_note(const std::string& noteID,
         note_ptr = get_note_pointer(noteID);
     }  // Release the manager lock
 
+    const auto before = copy_for_listener(*note_ptr);
     double origTime = note_ptr->time;
     executor(*note_ptr);
     if (origTime != note_ptr->time)
         set_ooo();
+    mark_modified();
     sync_head_note_to_sub(*note_ptr);
     sync_hold_note_length(*note_ptr);
+    notify_changed(before, *note_ptr);
 }
 
 // This function is unsafe (DEADLOCK RISK). Do not access notePoolManager in
 // your executor.
 void NotePoolManager::access_all_notes(std::function<void(Note&)> executor) {
     std::lock_guard<std::shared_mutex> lock(mtxNoteOps);
+    mark_modified();
     for (const auto& note_ptr : noteArray) {
         if (note_ptr) {
+            const auto before = copy_for_listener(*note_ptr);
             double origTime = note_ptr->time;
             executor(*note_ptr);
             if (origTime != note_ptr->time)
                 set_ooo();
             sync_head_note_to_sub(*note_ptr);
             sync_hold_note_length(*note_ptr);
+            notify_changed(before, *note_ptr);
         }
     }
 }
@@ -175,6 +332,7 @@ void NotePoolManager::access_all_notes_safe(
     std::vector<nptr> notes;
     {
         std::lock_guard<std::shared_mutex> lock(mtxNoteOps);
+        mark_modified();
         notes.reserve(get_note_count());
         for (const auto& note_ptr : noteArray) {
             if (note_ptr) {
@@ -183,12 +341,14 @@ void NotePoolManager::access_all_notes_safe(
         }
     }
     for (const auto& note_ptr : notes) {
+        const auto before = copy_for_listener(*note_ptr);
         double origTime = note_ptr->time;
         executor(*note_ptr);
         if (origTime != note_ptr->time)
             set_ooo();
         sync_head_note_to_sub(*note_ptr);
         sync_hold_note_length(*note_ptr);
+        notify_changed(before, *note_ptr);
     }
 }
 
@@ -197,16 +357,19 @@ void NotePoolManager::access_all_notes_safe(
 void NotePoolManager::access_all_notes_parallel(
     std::function<void(Note&)> executor) {
     std::lock_guard<std::shared_mutex> lock(mtxNoteOps);
+    mark_modified();
     tf::Executor tfexecutor;
     tf::Taskflow taskflow;
     taskflow.for_each(noteArray.begin(), noteArray.end(), [&](nptr note_ptr) {
         if (note_ptr) {
+            const auto before = copy_for_listener(*note_ptr);
             double origTime = note_ptr->time;
             executor(*note_ptr);
             if (origTime != note_ptr->time)
                 set_ooo();
             sync_head_note_to_sub(*note_ptr);
             sync_hold_note_length(*note_ptr);
+            notify_changed(before, *note_ptr);
         }
     });
     tfexecutor.run(taskflow).wait();
@@ -217,6 +380,7 @@ void NotePoolManager::access_all_notes_parallel_safe(
     std::vector<nptr> notes;
     {
         std::lock_guard<std::shared_mutex> lock(mtxNoteOps);
+        mark_modified();
         notes.reserve(get_note_count());
         for (const auto& note_ptr : noteArray) {
             if (note_ptr) {
@@ -227,12 +391,14 @@ void NotePoolManager::access_all_notes_parallel_safe(
     tf::Executor tfexecutor;
     tf::Taskflow taskflow;
     taskflow.for_each(notes.begin(), notes.end(), [&](nptr note_ptr) {
+        const auto before = copy_for_listener(*note_ptr);
         double origTime = note_ptr->time;
         executor(*note_ptr);
         if (origTime != note_ptr->time)
             set_ooo();
         sync_head_note_to_sub(*note_ptr);
         sync_hold_note_length(*note_ptr);
+        notify_changed(before, *note_ptr);
     });
     tfexecutor.run(taskflow).wait();
 }
@@ -273,6 +439,9 @@ void NotePoolManager::clear_notes() {
     noteInfoMap.rehash(0);
 
     noteCount = 0;
+    mark_modified();
+    if (auto* listener = changeListener.load(std::memory_order_acquire))
+        listener->notes_cleared();
     get_note_activation_manager().clear();
     reclaim_memory();
     return;
@@ -307,7 +476,9 @@ bool NotePoolManager::release_note(std::string noteID) {
     noteInfoMap.erase(it);
 
     set_ooo();
+    mark_modified();
     noteCount--;
+    notify_changed(info.pointer.get(), nullptr);
     return true;
 }
 
@@ -434,6 +605,29 @@ int NotePoolManager::get_index_lowerbound(double time) {
     return static_cast<int>(it - noteArray.begin());
 }
 
+void NotePoolManager::set_change_listener(NoteChangeListener* listener) {
+    changeListener.store(listener, std::memory_order_release);
+}
+
+std::optional<Note> NotePoolManager::copy_for_listener(const Note& note) const {
+    if (!changeListener.load(std::memory_order_acquire))
+        return std::nullopt;
+    return note;
+}
+
+void NotePoolManager::notify_changed(const Note* before, const Note* after) {
+    if (auto* listener = changeListener.load(std::memory_order_acquire))
+        listener->note_changed(before, after);
+}
+
+void NotePoolManager::notify_changed(const std::optional<Note>& before,
+                                     const Note& after) {
+    if (!before)
+        return;
+    if (auto* listener = changeListener.load(std::memory_order_acquire))
+        listener->note_changed(&*before, &after);
+}
+
 // Thread unsafe function.
 void NotePoolManager::reclaim_memory() {
     pool_res.release();
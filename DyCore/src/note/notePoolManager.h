@@ -1,6 +1,10 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <memory_resource>
+#include <optional>
 #include <shared_mutex>
+#include <span>
 #include <string>
 
 #include "activation.h"
@@ -8,6 +12,21 @@
 
 inline constexpr int NOTES_ARRAY_PARALLEL_SORT_THRESHOLD = 10000;
 
+// Told about every note added, edited or removed. Calls can come from any
+// thread, some with the pool locked, so a listener must not call back into
+// the pool.
+class NoteChangeListener {
+   public:
+    virtual ~NoteChangeListener() = default;
+    // before is null for an added note and after for a removed one. Sub
+    // notes kept in step with their hold are not reported.
+    virtual void note_changed(const Note *before, const Note *after) = 0;
+    virtual void notes_cleared() = 0;
+    // A bulk_load, as one call. Holds come with the IDs of the sub notes
+    // created for them; the sub notes themselves are not listed.
+    virtual void notes_loaded(std::span<const Note> notes) = 0;
+};
+
 class NotePoolManager {
     friend NoteActivationManager;
 
@@ -21,6 +40,10 @@ class NotePoolManager {
 
     bool note_exists(const std::string &noteID);
     bool create_note(const Note &note);
+    // Adds new notes in one pass, the way create_note() with random IDs and
+    // sub notes would, but reserving, sorting and indexing only once.
+    // Returns the number of notes added, sub notes included.
+    size_t bulk_load(std::span<const Note> notes);
     const Note &get_note(const std::string &noteID);
     const Note &get_note(int index) {
         return operator[](index);
@@ -41,8 +64,18 @@ class NotePoolManager {
     void access_all_notes_safe(std::function<void(Note &)> executor);
     void access_all_notes_parallel(std::function<void(Note &)> executor);
     void access_all_notes_parallel_safe(std::function<void(Note &)> executor);
+    // Edits the listed notes under one lock as a single modification. The
+    // executor also receives the position in noteIDs; missing notes are
+    // skipped. Returns the number of notes edited.
+    size_t access_notes(std::span<const std::string> noteIDs,
+                        const std::function<void(Note &, size_t)> &executor);
+    // Visits every note under a shared lock without marking the pool as
+    // modified. The visitor must not call back into the pool.
+    void for_each_note(const std::function<void(const Note &)> &visitor) const;
     void sync_head_note_to_sub(const Note &note);
     void sync_hold_note_length(const Note &note);
+    // Only one listener at a time; null removes it.
+    void set_change_listener(NoteChangeListener *listener);
 
     int get_index(const std::string &noteID);
     bool release_note(std::string noteID);
@@ -66,10 +99,16 @@ class NotePoolManager {
 
     void set_ooo();
     void unset_ooo();
+    void mark_modified() {
+        lastModifiedTime.fetch_add(1, std::memory_order_relaxed);
+    }
     void array_markdel_index(const NoteMemoryInfo &info);
     void array_sort();
     void reclaim_memory();
     nptr get_note_pointer(const std::string &noteID);
+    std::optional<Note> copy_for_listener(const Note &note) const;
+    void notify_changed(const Note *before, const Note *after);
+    void notify_changed(const std::optional<Note> &before, const Note &after);
 
     std::array<std::byte, 64 * 1024 * 1024> initial_buffer;
     std::pmr::monotonic_buffer_resource monotonic_res;
@@ -80,6 +119,10 @@ class NotePoolManager {
     mutable std::shared_mutex mtxNoteOps;
     bool arrayOutOfOrder = false;
     int noteCount = 0;
+    // Bumped on every note mutation so cached derived data (e.g. pipelined
+    // render frames) can detect edits cheaply.
+    std::atomic<uint64_t> lastModifiedTime{0};
+    std::atomic<NoteChangeListener *> changeListener{nullptr};
 
    public:
     bool is_ooo() {
@@ -91,6 +134,9 @@ class NotePoolManager {
     int get_note_count() {
         return noteCount;
     }
+    uint64_t get_last_modified_time() const {
+        return lastModifiedTime.load(std::memory_order_relaxed);
+    }
 };
 
 NotePoolManager &get_note_pool_manager();
@@ -0,0 +1,862 @@
+#include "backupStore.h"
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+#include "compress.h"
+#include "durableFile.h"
+#include "format/dyn.h"
+#include "format/dynb.h"
+#include "mappedFile.h"
+#include "utils.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+enum BACKUP_CONTENT_KIND : uint32_t {
+    BACKUP_CONTENT_FILE,
+    // The JSON of a zstd compressed .dyn file.
+    BACKUP_CONTENT_DYN_JSON,
+    // A .dynb file with its sections decompressed.
+    BACKUP_CONTENT_DYNB_STORED
+};
+
+// Copies kept by saves before the store, at backups/<stem>.bak.<N><ext>.
+constexpr int LEGACY_BACKUP_SLOT_COUNT = 3;
+
+constexpr char PACK_SEGMENT_MAGIC[4] = {'D', 'Y', 'B', 'S'};
+constexpr char VERSION_MAGIC[4] = {'D', 'Y', 'B', 'V'};
+constexpr char PACK_INDEX_MAGIC[4] = {'D', 'Y', 'B', 'I'};
+
+// Followed by the chunk table and the zstd frame of the chunks.
+struct PackSegmentHeader {
+    char magic[4];
+    uint32_t chunkCount;
+    uint64_t rawSize;
+    uint64_t compressedSize;
+    XXH64_hash_t checksum;  // XXH3 of the chunk table and the frame.
+};
+static_assert(sizeof(PackSegmentHeader) == 32);
+
+struct PackChunkEntry {
+    XXH128_hash_t hash;
+    uint32_t size;
+    uint32_t reserved;
+};
+static_assert(sizeof(PackChunkEntry) == 24);
+
+// A segment of the pack, followed by its chunk table.
+struct PackIndexRecord {
+    char magic[4];
+    uint32_t chunkCount;
+    uint64_t offset;
+    uint64_t rawSize;
+    uint64_t compressedSize;
+    XXH64_hash_t segmentChecksum;  // As in the segment header.
+    XXH64_hash_t checksum;  // XXH3 of the fields above and the table.
+};
+static_assert(sizeof(PackIndexRecord) == 48);
+
+// Followed by the hashes of the version's chunks, in order.
+struct VersionHeader {
+    char magic[4];
+    uint32_t chunkCount;
+    uint64_t id;
+    int64_t time;
+    uint64_t size;
+    XXH64_hash_t contentChecksum;
+    uint32_t kind;
+    uint32_t formatVersion;
+    XXH64_hash_t checksum;  // XXH3 of the fields above and the hashes.
+};
+static_assert(sizeof(VersionHeader) == 56);
+
+constexpr std::array<uint64_t, 256> make_gear_table() {
+    // splitmix64, so the table is the same in every build.
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0;
+    for (auto &value : table) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr auto GEAR_TABLE = make_gear_table();
+
+// Masks on the top bits of the gear hash, which depend on the last 64
+// bytes. Cuts are harder to make before the average size and easier after,
+// which keeps chunk sizes close to it.
+constexpr int AVERAGE_CHUNK_BITS =
+    std::countr_zero(PROJECT_BACKUP_AVERAGE_CHUNK_SIZE);
+constexpr uint64_t STRICT_CUT_MASK = ~0ull << (64 - AVERAGE_CHUNK_BITS - 2);
+constexpr uint64_t LOOSE_CUT_MASK = ~0ull << (64 - AVERAGE_CHUNK_BITS + 2);
+static_assert(std::has_single_bit(PROJECT_BACKUP_AVERAGE_CHUNK_SIZE));
+
+size_t next_chunk_size(std::span<const char> data) {
+    if (data.size() <= PROJECT_BACKUP_MIN_CHUNK_SIZE) {
+        return data.size();
+    }
+    const size_t normal =
+        std::min(data.size(), PROJECT_BACKUP_AVERAGE_CHUNK_SIZE);
+    const size_t end = std::min(data.size(), PROJECT_BACKUP_MAX_CHUNK_SIZE);
+    const auto *bytes = reinterpret_cast<const unsigned char *>(data.data());
+    uint64_t hash = 0;
+    size_t i = PROJECT_BACKUP_MIN_CHUNK_SIZE;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + GEAR_TABLE[bytes[i]];
+        if ((hash & STRICT_CUT_MASK) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < end; ++i) {
+        hash = (hash << 1) + GEAR_TABLE[bytes[i]];
+        if ((hash & LOOSE_CUT_MASK) == 0) {
+            return i + 1;
+        }
+    }
+    return end;
+}
+
+// The JSON of a zstd compressed .dyn file, or nothing if it does not
+// decompress. The checksum frame saves end with is skipped.
+std::optional<std::string> decompress_dyn_content(
+    std::span<const char> file) {
+    try {
+        return decompress_to_string(file);
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+}
+
+// A .dynb file with every section stored uncompressed, or nothing if it is
+// damaged.
+std::optional<std::string> decompress_dynb_content(
+    std::span<const char> file) {
+    try {
+        std::string content;
+        project_export_dynb_content(file, {.level = 0},
+                                    [&](const char *data, size_t size) {
+                                        content.append(data, size);
+                                    });
+        return content;
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+}
+
+int64_t seconds_since_epoch(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               time.time_since_epoch())
+        .count();
+}
+
+std::string read_file_bytes(const fs::path &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return {};
+    }
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+// Appends what fill writes to the file after its first size bytes,
+// dropping what follows them. Throws if any write fails.
+void append_to_file(const fs::path &path, uint64_t size,
+                    const std::function<void(const DynChunkWriter &)> &fill) {
+    if (fs::exists(path) && fs::file_size(path) != size) {
+        fs::resize_file(path, size);
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    if (!out) {
+        throw std::runtime_error("Error opening the backup store.");
+    }
+    fill([&out](const char *data, size_t size) {
+        out.write(data, static_cast<std::streamsize>(size));
+    });
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Error writing the backup store.");
+    }
+}
+
+// Writes what fill writes as the new content of the file, through a
+// temporary file that then replaces it, flushed to disk. Leaves the file as
+// it was if any write fails.
+void rewrite_file(const fs::path &path,
+                  const std::function<void(const DynChunkWriter &)> &fill) {
+    fs::path tempName = path.filename();
+    tempName += random_string(8);
+    tempName += ".tmp";
+    const fs::path tempPath = path.parent_path() / tempName;
+    try {
+        {
+            DurableFileWriter out(tempPath);
+            fill([&out](const char *data, size_t size) {
+                out.write(data, size);
+            });
+            out.close();
+        }
+        replace_file_durably(tempPath, path);
+    } catch (const std::exception &) {
+        std::error_code ec;
+        fs::remove(tempPath, ec);
+        throw;
+    }
+}
+
+XXH64_hash_t segment_checksum(std::span<const PackChunkEntry> entries,
+                              std::string_view frame) {
+    XXH3_state_t *state = XXH3_createState();
+    if (!state) {
+        throw std::runtime_error("Error creating the checksum state.");
+    }
+    XXH3_64bits_reset(state);
+    XXH3_64bits_update(state, entries.data(), entries.size_bytes());
+    XXH3_64bits_update(state, frame.data(), frame.size());
+    const auto checksum = XXH3_64bits_digest(state);
+    XXH3_freeState(state);
+    return checksum;
+}
+
+XXH64_hash_t index_record_checksum(const PackIndexRecord &record,
+                                   std::span<const PackChunkEntry> entries) {
+    std::string bytes(reinterpret_cast<const char *>(&record),
+                      offsetof(PackIndexRecord, checksum));
+    bytes.append(reinterpret_cast<const char *>(entries.data()),
+                 entries.size_bytes());
+    return XXH3_64bits(bytes.data(), bytes.size());
+}
+
+// Returns the offset of the first magic at or after from, or fileSize if
+// there is none.
+uint64_t find_magic(std::istream &in, const char (&magic)[4], uint64_t from,
+                    uint64_t fileSize) {
+    constexpr size_t BLOCK_SIZE = 64 * 1024;
+    const std::string_view pattern(magic, sizeof(magic));
+    std::string block;
+    while (fileSize - from >= pattern.size()) {
+        const auto size = static_cast<size_t>(
+            std::min<uint64_t>(BLOCK_SIZE, fileSize - from));
+        block.resize(size);
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(from));
+        in.read(block.data(), static_cast<std::streamsize>(size));
+        if (!in) {
+            break;
+        }
+        const size_t found = std::string_view(block).find(pattern);
+        if (found != std::string_view::npos) {
+            return from + found;
+        }
+        // Keeps the bytes a magic across blocks would start with.
+        from += size - (pattern.size() - 1);
+    }
+    return fileSize;
+}
+
+XXH64_hash_t version_checksum(const VersionHeader &header,
+                              std::span<const XXH128_hash_t> chunks) {
+    std::string bytes(reinterpret_cast<const char *>(&header),
+                      offsetof(VersionHeader, checksum));
+    bytes.append(reinterpret_cast<const char *>(chunks.data()),
+                 chunks.size_bytes());
+    return XXH3_64bits(bytes.data(), bytes.size());
+}
+
+// Compresses raw, the chunks of entries in order, and writes them as a
+// segment. Returns its header.
+PackSegmentHeader write_pack_segment(const DynChunkWriter &write,
+                                     const std::vector<PackChunkEntry> &entries,
+                                     std::string_view raw) {
+    std::string frame(ZSTD_compressBound(raw.size()), '\0');
+    const size_t compressedSize =
+        ZSTD_compress(frame.data(), frame.size(), raw.data(), raw.size(),
+                      PROJECT_BACKUP_COMPRESSION_LEVEL);
+    if (ZSTD_isError(compressedSize)) {
+        throw std::runtime_error(
+            std::string("Error compressing backup chunks: ") +
+            ZSTD_getErrorName(compressedSize));
+    }
+    frame.resize(compressedSize);
+
+    PackSegmentHeader header{.chunkCount =
+                                 static_cast<uint32_t>(entries.size()),
+                             .rawSize = raw.size(),
+                             .compressedSize = compressedSize,
+                             .checksum = segment_checksum(entries, frame)};
+    std::memcpy(header.magic, PACK_SEGMENT_MAGIC, sizeof(header.magic));
+    write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write(reinterpret_cast<const char *>(entries.data()),
+          entries.size() * sizeof(PackChunkEntry));
+    write(frame.data(), frame.size());
+    return header;
+}
+
+void write_version_record(const DynChunkWriter &write,
+                          const VersionHeader &header,
+                          std::span<const XXH128_hash_t> chunks) {
+    write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write(reinterpret_cast<const char *>(chunks.data()), chunks.size_bytes());
+}
+
+}  // namespace
+
+std::vector<size_t> split_backup_chunks(std::span<const char> data) {
+    std::vector<size_t> sizes;
+    while (!data.empty()) {
+        const size_t size = next_chunk_size(data);
+        sizes.push_back(size);
+        data = data.subspan(size);
+    }
+    return sizes;
+}
+
+ProjectBackupStore::ProjectBackupStore(const fs::path &projectPath)
+    : projectPath(projectPath) {
+    fs::path storeName = projectPath.filename();
+    storeName += PROJECT_BACKUP_STORE_EXTENSION;
+    storeDir = projectPath.parent_path() / "backups" / storeName;
+    packPath = storeDir / "pack";
+    versionsPath = storeDir / "versions";
+    indexPath = storeDir / "index";
+    load_pack();
+    load_versions();
+}
+
+void ProjectBackupStore::load_pack() {
+    std::ifstream in(packPath, std::ios::binary);
+    if (!in) {
+        return;
+    }
+    const uint64_t fileSize = fs::file_size(packPath);
+    uint64_t offset = load_pack_index(in, fileSize);
+    packSize = offset;
+    while (fileSize - offset >= sizeof(PackSegmentHeader)) {
+        if (const auto end = scan_segment(in, offset, fileSize)) {
+            offset = packSize = *end;
+            indexStale = true;
+        } else {
+            // A damaged segment is skipped, so no new version refers to its
+            // chunks; they are stored again when next seen. The segments
+            // after it are kept.
+            offset = find_magic(in, PACK_SEGMENT_MAGIC, offset + 1, fileSize);
+        }
+    }
+}
+
+uint64_t ProjectBackupStore::load_pack_index(std::istream &pack,
+                                             uint64_t packFileSize) {
+    const std::string file = read_file_bytes(indexPath);
+    size_t offset = 0;
+    uint64_t packEnd = 0;
+    while (file.size() - offset >= sizeof(PackIndexRecord)) {
+        PackIndexRecord record;
+        std::memcpy(&record, file.data() + offset, sizeof(record));
+        const uint64_t tableSize =
+            uint64_t(record.chunkCount) * sizeof(PackChunkEntry);
+        if (std::memcmp(record.magic, PACK_INDEX_MAGIC,
+                        sizeof(record.magic)) != 0 ||
+            tableSize > file.size() - offset - sizeof(record)) {
+            break;
+        }
+        std::vector<PackChunkEntry> entries(record.chunkCount);
+        std::memcpy(entries.data(), file.data() + offset + sizeof(record),
+                    tableSize);
+        if (index_record_checksum(record, entries) != record.checksum ||
+            record.offset < packEnd || record.offset > packFileSize ||
+            record.compressedSize > packFileSize ||
+            tableSize > packFileSize) {
+            break;
+        }
+        const uint64_t end = record.offset + sizeof(PackSegmentHeader) +
+                             tableSize + record.compressedSize;
+        if (end > packFileSize) {
+            break;
+        }
+        // The pack may have been compacted or damaged since.
+        PackSegmentHeader header;
+        pack.clear();
+        pack.seekg(static_cast<std::streamoff>(record.offset));
+        pack.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!pack ||
+            std::memcmp(header.magic, PACK_SEGMENT_MAGIC,
+                        sizeof(header.magic)) != 0 ||
+            header.chunkCount != record.chunkCount ||
+            header.rawSize != record.rawSize ||
+            header.compressedSize != record.compressedSize ||
+            header.checksum != record.segmentChecksum) {
+            break;
+        }
+
+        Segment segment{.offset = record.offset,
+                        .rawSize = record.rawSize,
+                        .compressedSize = record.compressedSize,
+                        .checksum = record.segmentChecksum};
+        for (const auto &entry : entries) {
+            segment.chunks.push_back(entry.hash);
+            segment.chunkSizes.push_back(entry.size);
+        }
+        index_segment(std::move(segment));
+        packEnd = end;
+        offset += sizeof(record) + tableSize;
+    }
+    indexSize = offset;
+    indexStale = offset != file.size();
+    return packEnd;
+}
+
+std::optional<uint64_t> ProjectBackupStore::scan_segment(
+    std::istream &pack, uint64_t offset, uint64_t packFileSize) {
+    PackSegmentHeader header;
+    pack.clear();
+    pack.seekg(static_cast<std::streamoff>(offset));
+    pack.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!pack || std::memcmp(header.magic, PACK_SEGMENT_MAGIC,
+                             sizeof(header.magic)) != 0) {
+        return std::nullopt;
+    }
+    const uint64_t tableSize =
+        uint64_t(header.chunkCount) * sizeof(PackChunkEntry);
+    if (header.compressedSize > packFileSize || tableSize > packFileSize ||
+        offset + sizeof(header) + tableSize + header.compressedSize >
+            packFileSize) {
+        return std::nullopt;
+    }
+
+    std::vector<PackChunkEntry> entries(header.chunkCount);
+    std::string frame(header.compressedSize, '\0');
+    pack.read(reinterpret_cast<char *>(entries.data()),
+              static_cast<std::streamsize>(tableSize));
+    pack.read(frame.data(), static_cast<std::streamsize>(frame.size()));
+    if (!pack || segment_checksum(entries, frame) != header.checksum) {
+        return std::nullopt;
+    }
+    Segment segment{.offset = offset,
+                    .rawSize = header.rawSize,
+                    .compressedSize = header.compressedSize,
+                    .checksum = header.checksum};
+    for (const auto &entry : entries) {
+        segment.chunks.push_back(entry.hash);
+        segment.chunkSizes.push_back(entry.size);
+    }
+    index_segment(std::move(segment));
+    return offset + sizeof(header) + tableSize + header.compressedSize;
+}
+
+void ProjectBackupStore::load_versions() {
+    const std::string file = read_file_bytes(versionsPath);
+    const std::string_view magic(VERSION_MAGIC, sizeof(VERSION_MAGIC));
+    size_t offset = 0;
+    while (file.size() - offset >= sizeof(VersionHeader)) {
+        VersionHeader header;
+        std::memcpy(&header, file.data() + offset, sizeof(header));
+        const uint64_t listSize =
+            uint64_t(header.chunkCount) * sizeof(XXH128_hash_t);
+        Version version{.info = {.id = header.id,
+                                 .time = header.time,
+                                 .size = header.size},
+                        .kind = header.kind,
+                        .checksum = header.contentChecksum};
+        const bool framed =
+            std::memcmp(header.magic, VERSION_MAGIC, sizeof(header.magic)) ==
+                0 &&
+            listSize <= file.size() - offset - sizeof(header);
+        if (framed) {
+            version.chunks.resize(header.chunkCount);
+            std::memcpy(version.chunks.data(),
+                        file.data() + offset + sizeof(header), listSize);
+        }
+        if (!framed ||
+            header.formatVersion != PROJECT_BACKUP_STORE_FORMAT_VERSION ||
+            version_checksum(header, version.chunks) != header.checksum) {
+            // Skips to the next record, so that the versions after a
+            // damaged one are kept.
+            offset = std::min(file.find(magic, offset + 1), file.size());
+            continue;
+        }
+        versionList.push_back(std::move(version));
+        offset += sizeof(header) + listSize;
+        versionsSize = offset;
+    }
+}
+
+void ProjectBackupStore::index_segment(Segment segment) {
+    uint64_t rawOffset = 0;
+    for (size_t i = 0; i < segment.chunks.size(); ++i) {
+        chunks.try_emplace(
+            segment.chunks[i],
+            ChunkLocation{segment.offset, rawOffset, segment.chunkSizes[i]});
+        rawOffset += segment.chunkSizes[i];
+    }
+    segments.push_back(std::move(segment));
+}
+
+bool ProjectBackupStore::add(const fs::path &file) {
+    if (!fs::exists(storeDir)) {
+        import_legacy_backups();
+    }
+    return add_version(file,
+                       seconds_since_epoch(std::chrono::system_clock::now()));
+}
+
+void ProjectBackupStore::import_legacy_backups() {
+    for (int slot = LEGACY_BACKUP_SLOT_COUNT - 1; slot >= 0; --slot) {
+        fs::path name = projectPath.stem();
+        name += ".bak." + std::to_string(slot);
+        name += projectPath.extension();
+        const fs::path legacyPath = projectPath.parent_path() / "backups" / name;
+        try {
+            if (!fs::is_regular_file(legacyPath)) {
+                continue;
+            }
+            add_version(legacyPath,
+                        seconds_since_epoch(std::chrono::file_clock::to_sys(
+                            fs::last_write_time(legacyPath))));
+        } catch (const std::exception &e) {
+            print_debug_message("Skipping old backup " + legacyPath.string() +
+                                ": " + e.what());
+        }
+    }
+}
+
+bool ProjectBackupStore::add_version(const fs::path &file, int64_t time) {
+    const MappedFile mapped(file);
+    std::span<const char> content = mapped.data();
+    Version version;
+    // Compressed content is stored decompressed, so that it chunks.
+    std::optional<std::string> decompressed;
+    if (is_dynb_data(content) &&
+        (decompressed = decompress_dynb_content(content))) {
+        content = *decompressed;
+        version.kind = BACKUP_CONTENT_DYNB_STORED;
+    } else if (check_compressed(content.data(), content.size()) &&
+               (decompressed = decompress_dyn_content(content))) {
+        content = *decompressed;
+        version.kind = BACKUP_CONTENT_DYN_JSON;
+    }
+    version.info.size = content.size();
+    version.checksum = XXH3_64bits(content.data(), content.size());
+    if (!versionList.empty()) {
+        const auto &newest = versionList.back();
+        if (newest.kind == version.kind &&
+            newest.info.size == version.info.size &&
+            newest.checksum == version.checksum) {
+            return false;
+        }
+    }
+
+    // The chunks the store lacks go into one new segment.
+    Segment segment{.offset = packSize};
+    std::vector<PackChunkEntry> entries;
+    std::string raw;
+    ChunkSet added;
+    size_t offset = 0;
+    for (const size_t size : split_backup_chunks(content)) {
+        const auto hash = XXH3_128bits(content.data() + offset, size);
+        version.chunks.push_back(hash);
+        if (!chunks.contains(hash) && added.insert(hash).second) {
+            entries.push_back({hash, static_cast<uint32_t>(size), 0});
+            segment.chunks.push_back(hash);
+            segment.chunkSizes.push_back(static_cast<uint32_t>(size));
+            raw.append(content.data() + offset, size);
+        }
+        offset += size;
+    }
+
+    fs::create_directories(storeDir);
+    if (!entries.empty()) {
+        PackSegmentHeader header;
+        append_to_file(packPath, packSize, [&](const DynChunkWriter &write) {
+            header = write_pack_segment(write, entries, raw);
+        });
+        segment.rawSize = header.rawSize;
+        segment.compressedSize = header.compressedSize;
+        segment.checksum = header.checksum;
+        index_segment(std::move(segment));
+        packSize += sizeof(header) + entries.size() * sizeof(PackChunkEntry) +
+                    header.compressedSize;
+        append_to_pack_index();
+    }
+
+    version.info.id = versionList.empty() ? 1 : versionList.back().info.id + 1;
+    version.info.time = time;
+    VersionHeader header{
+        .chunkCount = static_cast<uint32_t>(version.chunks.size()),
+        .id = version.info.id,
+        .time = version.info.time,
+        .size = version.info.size,
+        .contentChecksum = version.checksum,
+        .kind = version.kind,
+        .formatVersion = PROJECT_BACKUP_STORE_FORMAT_VERSION};
+    std::memcpy(header.magic, VERSION_MAGIC, sizeof(header.magic));
+    header.checksum = version_checksum(header, version.chunks);
+    append_to_file(versionsPath, versionsSize,
+                   [&](const DynChunkWriter &write) {
+                       write_version_record(write, header, version.chunks);
+                   });
+    versionsSize +=
+        sizeof(header) + version.chunks.size() * sizeof(XXH128_hash_t);
+    versionList.push_back(std::move(version));
+
+    prune();
+    return true;
+}
+
+std::vector<ProjectBackupVersion> ProjectBackupStore::versions() const {
+    std::vector<ProjectBackupVersion> result;
+    result.reserve(versionList.size());
+    for (const auto &version : versionList) {
+        result.push_back(version.info);
+    }
+    return result;
+}
+
+const ProjectBackupStore::Version &ProjectBackupStore::find_version(
+    uint64_t id) const {
+    for (const auto &version : versionList) {
+        if (version.info.id == id) {
+            return version;
+        }
+    }
+    throw std::out_of_range("No backup version " + std::to_string(id) + ".");
+}
+
+std::string ProjectBackupStore::read_segment(const Segment &segment) const {
+    std::ifstream in(packPath, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(segment.offset));
+    PackSegmentHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    std::vector<PackChunkEntry> entries(header.chunkCount);
+    std::string frame(segment.compressedSize, '\0');
+    if (in) {
+        in.read(reinterpret_cast<char *>(entries.data()),
+                static_cast<std::streamsize>(entries.size() *
+                                             sizeof(PackChunkEntry)));
+        in.read(frame.data(), static_cast<std::streamsize>(frame.size()));
+    }
+    if (!in || segment_checksum(entries, frame) != header.checksum) {
+        throw std::runtime_error("Backup chunks are damaged.");
+    }
+
+    std::string raw(segment.rawSize, '\0');
+    try {
+        if (decompress_into(frame, raw.data(), raw.size()) == raw.size()) {
+            return raw;
+        }
+    } catch (const std::exception &) {
+    }
+    throw std::runtime_error("Backup chunks are damaged.");
+}
+
+std::string ProjectBackupStore::read_content(const Version &version) const {
+    std::string content;
+    content.reserve(version.info.size);
+    // Each segment is decompressed once, however many chunks it holds.
+    std::unordered_map<uint64_t, std::string> rawSegments;
+    for (const auto &hash : version.chunks) {
+        const auto location = chunks.find(hash);
+        if (location == chunks.end()) {
+            throw std::runtime_error("Backup chunks are missing.");
+        }
+        const auto &[segmentOffset, rawOffset, size] = location->second;
+        auto raw = rawSegments.find(segmentOffset);
+        if (raw == rawSegments.end()) {
+            const auto segment = std::lower_bound(
+                segments.begin(), segments.end(), segmentOffset,
+                [](const Segment &s, uint64_t offset) {
+                    return s.offset < offset;
+                });
+            raw = rawSegments.emplace(segmentOffset, read_segment(*segment))
+                      .first;
+        }
+        content.append(raw->second, rawOffset, size);
+    }
+    if (content.size() != version.info.size ||
+        XXH3_64bits(content.data(), content.size()) != version.checksum) {
+        throw std::runtime_error("Backup version does not match its checksum.");
+    }
+    return content;
+}
+
+void ProjectBackupStore::restore(uint64_t id, const fs::path &target) const {
+    const auto &version = find_version(id);
+    const std::string content = read_content(version);
+
+    rewrite_file(target, [&](const DynChunkWriter &write) {
+        if (version.kind == BACKUP_CONTENT_DYN_JSON) {
+            project_export_dyn_content(content, {}, write);
+        } else if (version.kind == BACKUP_CONTENT_DYNB_STORED) {
+            project_export_dynb_content(content, {}, write);
+        } else {
+            write(content.data(), content.size());
+        }
+    });
+}
+
+uint64_t ProjectBackupStore::stored_size() const {
+    return packSize + versionsSize + indexSize;
+}
+
+void ProjectBackupStore::write_versions() {
+    uint64_t size = 0;
+    rewrite_file(versionsPath, [&](const DynChunkWriter &write) {
+        for (const auto &version : versionList) {
+            VersionHeader header{
+                .chunkCount = static_cast<uint32_t>(version.chunks.size()),
+                .id = version.info.id,
+                .time = version.info.time,
+                .size = version.info.size,
+                .contentChecksum = version.checksum,
+                .kind = version.kind,
+                .formatVersion = PROJECT_BACKUP_STORE_FORMAT_VERSION};
+            std::memcpy(header.magic, VERSION_MAGIC, sizeof(header.magic));
+            header.checksum = version_checksum(header, version.chunks);
+            write_version_record(write, header, version.chunks);
+            size += sizeof(header) +
+                    version.chunks.size() * sizeof(XXH128_hash_t);
+        }
+    });
+    versionsSize = size;
+}
+
+void ProjectBackupStore::prune() {
+    if (versionList.size() <= PROJECT_BACKUP_VERSION_LIMIT) {
+        return;
+    }
+    versionList.erase(versionList.begin(),
+                      versionList.end() - PROJECT_BACKUP_VERSION_LIMIT);
+    write_versions();
+
+    ChunkSet live;
+    for (const auto &version : versionList) {
+        live.insert(version.chunks.begin(), version.chunks.end());
+    }
+    // Estimates the compressed size of the chunks still used.
+    double liveSize = 0.0;
+    for (const auto &segment : segments) {
+        uint64_t liveRaw = 0;
+        for (size_t i = 0; i < segment.chunks.size(); ++i) {
+            if (live.contains(segment.chunks[i])) {
+                liveRaw += segment.chunkSizes[i];
+            }
+        }
+        if (segment.rawSize > 0) {
+            liveSize += static_cast<double>(segment.compressedSize) *
+                        liveRaw / segment.rawSize;
+        }
+    }
+    if (packSize > 2 * liveSize) {
+        compact_pack(live);
+    }
+}
+
+void ProjectBackupStore::compact_pack(const ChunkSet &live) {
+    std::vector<Segment> kept;
+    uint64_t size = 0;
+    rewrite_file(packPath, [&](const DynChunkWriter &write) {
+        for (const auto &segment : segments) {
+            Segment compacted{.offset = size};
+            std::vector<PackChunkEntry> entries;
+            std::string raw;
+            std::optional<std::string> oldRaw;
+            uint64_t rawOffset = 0;
+            for (size_t i = 0; i < segment.chunks.size(); ++i) {
+                const auto &hash = segment.chunks[i];
+                const uint32_t chunkSize = segment.chunkSizes[i];
+                if (live.contains(hash)) {
+                    if (!oldRaw) {
+                        oldRaw = read_segment(segment);
+                    }
+                    entries.push_back({hash, chunkSize, 0});
+                    compacted.chunks.push_back(hash);
+                    compacted.chunkSizes.push_back(chunkSize);
+                    raw.append(*oldRaw, rawOffset, chunkSize);
+                }
+                rawOffset += chunkSize;
+            }
+            if (entries.empty()) {
+                continue;
+            }
+            const auto header = write_pack_segment(write, entries, raw);
+            compacted.rawSize = header.rawSize;
+            compacted.compressedSize = header.compressedSize;
+            compacted.checksum = header.checksum;
+            kept.push_back(std::move(compacted));
+            size += sizeof(header) + entries.size() * sizeof(PackChunkEntry) +
+                    header.compressedSize;
+        }
+    });
+
+    segments.clear();
+    chunks.clear();
+    for (auto &segment : kept) {
+        index_segment(std::move(segment));
+    }
+    packSize = size;
+    // The index lists the old segments until it is written.
+    indexStale = true;
+    write_pack_index();
+}
+
+std::string ProjectBackupStore::pack_index_record(const Segment &segment) {
+    std::vector<PackChunkEntry> entries;
+    entries.reserve(segment.chunks.size());
+    for (size_t i = 0; i < segment.chunks.size(); ++i) {
+        entries.push_back({segment.chunks[i], segment.chunkSizes[i], 0});
+    }
+    PackIndexRecord record{
+        .chunkCount = static_cast<uint32_t>(entries.size()),
+        .offset = segment.offset,
+        .rawSize = segment.rawSize,
+        .compressedSize = segment.compressedSize,
+        .segmentChecksum = segment.checksum};
+    std::memcpy(record.magic, PACK_INDEX_MAGIC, sizeof(record.magic));
+    record.checksum = index_record_checksum(record, entries);
+
+    std::string bytes(reinterpret_cast<const char *>(&record),
+                      sizeof(record));
+    bytes.append(reinterpret_cast<const char *>(entries.data()),
+                 entries.size() * sizeof(PackChunkEntry));
+    return bytes;
+}
+
+void ProjectBackupStore::append_to_pack_index() {
+    if (indexStale) {
+        write_pack_index();
+        return;
+    }
+    const std::string record = pack_index_record(segments.back());
+    append_to_file(indexPath, indexSize, [&](const DynChunkWriter &write) {
+        write(record.data(), record.size());
+    });
+    indexSize += record.size();
+}
+
+void ProjectBackupStore::write_pack_index() {
+    uint64_t size = 0;
+    rewrite_file(indexPath, [&](const DynChunkWriter &write) {
+        for (const auto &segment : segments) {
+            const std::string record = pack_index_record(segment);
+            write(record.data(), record.size());
+            size += record.size();
+        }
+    });
+    indexSize = size;
+    indexStale = false;
+}
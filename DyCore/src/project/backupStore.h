@@ -0,0 +1,151 @@
+#pragma once
+
+#include <xxhash/xxhash.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Versions of a project file kept in its backups folder, as
+// backups/<project file name><PROJECT_BACKUP_STORE_EXTENSION>/.
+//
+// The content of each version is split into chunks at content-defined
+// boundaries, so an edit only changes the chunks around it. Chunks are
+// stored once, by their XXH128: each version appends the chunks the store
+// lacks as one zstd frame to the pack file, and its list of chunks to the
+// versions file. Both files are append-only and end at the last complete
+// record, so a crash loses at most the version being added. Damaged records
+// are skipped, and the ones after them kept.
+//
+// The index file lists the segments of the pack with their chunk tables,
+// so opening the store does not read the whole pack. Segments it misses,
+// after a crash or in stores without an index, are found by scanning the
+// pack past the last one it lists.
+//
+// Zstd compressed .dyn files are stored by their JSON, which chunks well,
+// and restored through project_export_dyn_content(). .dynb files are stored
+// with their sections decompressed and restored through
+// project_export_dynb_content(). Other files are stored as they are.
+//
+// Saves used to keep up to three copies as backups/<stem>.bak.<N><ext>,
+// 0 being the newest. The first version added to a new store imports them
+// first, oldest first, dated by their modification times.
+inline constexpr int PROJECT_BACKUP_STORE_FORMAT_VERSION = 1;
+inline constexpr const char *PROJECT_BACKUP_STORE_EXTENSION = ".store";
+// Chunks are cut between the minimum and maximum size, around the average.
+inline constexpr size_t PROJECT_BACKUP_MIN_CHUNK_SIZE = 2 * 1024;
+inline constexpr size_t PROJECT_BACKUP_AVERAGE_CHUNK_SIZE = 8 * 1024;
+inline constexpr size_t PROJECT_BACKUP_MAX_CHUNK_SIZE = 64 * 1024;
+inline constexpr int PROJECT_BACKUP_COMPRESSION_LEVEL = 6;
+// The oldest versions are dropped beyond this many. The pack is rewritten
+// without their chunks once most of it is no longer used.
+inline constexpr size_t PROJECT_BACKUP_VERSION_LIMIT = 256;
+
+struct ProjectBackupVersion {
+    uint64_t id = 0;    // Counts up from 1 in each store.
+    int64_t time = 0;   // Seconds since the epoch.
+    uint64_t size = 0;  // Bytes of content.
+};
+
+// Splits data into content-defined chunks, returning the size of each.
+std::vector<size_t> split_backup_chunks(std::span<const char> data);
+
+class ProjectBackupStore {
+   public:
+    // Reads the store of the project at projectPath. Nothing is created
+    // until a version is added. Throws if the store cannot be read.
+    explicit ProjectBackupStore(const std::filesystem::path &projectPath);
+
+    // Adds the content of the file as the newest version, unless it is the
+    // same as the newest version. Returns whether it was added.
+    bool add(const std::filesystem::path &file);
+
+    // Oldest first.
+    std::vector<ProjectBackupVersion> versions() const;
+    // Writes the version as a project file at target, through a temporary
+    // file that then replaces it. Throws if there is no such version or its
+    // chunks are damaged, leaving target as it was.
+    void restore(uint64_t id, const std::filesystem::path &target) const;
+    // Bytes the store takes on disk.
+    uint64_t stored_size() const;
+
+   private:
+    struct ChunkHash {
+        size_t operator()(const XXH128_hash_t &hash) const {
+            return static_cast<size_t>(hash.low64);
+        }
+    };
+    struct ChunkEqual {
+        bool operator()(const XXH128_hash_t &a, const XXH128_hash_t &b) const {
+            return XXH128_isEqual(a, b);
+        }
+    };
+    using ChunkSet = std::unordered_set<XXH128_hash_t, ChunkHash, ChunkEqual>;
+    struct ChunkLocation {
+        uint64_t segmentOffset = 0;  // Of the frame holding it in the pack.
+        uint64_t rawOffset = 0;      // In the decompressed frame.
+        uint32_t size = 0;
+    };
+    struct Segment {
+        uint64_t offset = 0;  // Of its header in the pack.
+        uint64_t rawSize = 0;
+        uint64_t compressedSize = 0;
+        XXH64_hash_t checksum = 0;  // As in its header.
+        std::vector<XXH128_hash_t> chunks;
+        std::vector<uint32_t> chunkSizes;
+    };
+    struct Version {
+        ProjectBackupVersion info;
+        uint32_t kind = 0;
+        XXH64_hash_t checksum = 0;  // XXH3 of the content.
+        std::vector<XXH128_hash_t> chunks;
+    };
+
+    void load_pack();
+    // Takes the segments the index lists while their headers match the
+    // pack. Returns the end of the last one.
+    uint64_t load_pack_index(std::istream &pack, uint64_t packFileSize);
+    // Reads and checks the segment at offset, and indexes it. Returns its
+    // end, or nothing if no valid segment starts there.
+    std::optional<uint64_t> scan_segment(std::istream &pack, uint64_t offset,
+                                         uint64_t packFileSize);
+    void load_versions();
+    // Adds the old .bak.<N> copies of the project. Copies that cannot be
+    // read are skipped.
+    void import_legacy_backups();
+    bool add_version(const std::filesystem::path &file, int64_t time);
+    void index_segment(Segment segment);
+    const Version &find_version(uint64_t id) const;
+    // Throws if the frame does not match its checksum.
+    std::string read_segment(const Segment &segment) const;
+    std::string read_content(const Version &version) const;
+    void write_versions();
+    // Appends the record of the newest segment to the index, or rewrites
+    // the index if it lacks others.
+    void append_to_pack_index();
+    void write_pack_index();
+    static std::string pack_index_record(const Segment &segment);
+    // Drops the versions over the limit, then the chunks no version uses
+    // once they fill most of the pack.
+    void prune();
+    void compact_pack(const ChunkSet &live);
+
+    std::filesystem::path projectPath, storeDir, packPath, versionsPath,
+        indexPath;
+    // Bytes up to the end of the last valid record in each file; anything
+    // after holds none and is discarded.
+    uint64_t packSize = 0, versionsSize = 0, indexSize = 0;
+    // Set when the index does not list every segment.
+    bool indexStale = false;
+    std::vector<Segment> segments;
+    std::unordered_map<XXH128_hash_t, ChunkLocation, ChunkHash, ChunkEqual>
+        chunks;
+    std::vector<Version> versionList;
+};
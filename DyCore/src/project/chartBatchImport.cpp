@@ -0,0 +1,121 @@
+#include "chartBatchImport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <exception>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <taskflow/taskflow.hpp>
+
+#include "format/dy.h"
+#include "format/dyn.h"
+#include "format/xml.h"
+#include "render.h"
+#include "utils.h"
+
+namespace {
+
+Chart read_chart_file(const std::string &path) {
+    std::string extension =
+        convert_char_to_path(path.c_str()).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char ch) { return std::tolower(ch); });
+    if (extension == ".xml") {
+        return read_xml_chart(path.c_str());
+    }
+    if (extension == ".dy") {
+        return read_dy_chart(path.c_str());
+    }
+    // read_dyn_chart tells the two apart by the content.
+    if (extension == ".dyn" || extension == ".dynb") {
+        return read_dyn_chart(path.c_str());
+    }
+    throw std::runtime_error("Unsupported chart format: " + extension);
+}
+
+}  // namespace
+
+ChartImportStats compute_chart_import_stats(const Chart &chart) {
+    ChartImportStats stats;
+    for (const auto &note : chart.notes) {
+        if (note.get_note_type() == NOTE_TYPE::SUB) {
+            continue;
+        }
+        ++stats.noteCount;
+        if (note.get_note_type() == NOTE_TYPE::HOLD) {
+            ++stats.holdCount;
+        }
+        stats.duration = std::max(stats.duration, note.time + note.lastTime);
+    }
+    for (size_t i = 0; i < chart.timingPoints.size(); ++i) {
+        const double bpm = chart.timingPoints[i].get_bpm();
+        stats.minBpm = i == 0 ? bpm : std::min(stats.minBpm, bpm);
+        stats.maxBpm = i == 0 ? bpm : std::max(stats.maxBpm, bpm);
+    }
+    return stats;
+}
+
+void import_chart_files_async(
+    std::vector<std::string> paths,
+    std::function<void(std::vector<ChartImportResult>)> onDone) {
+    // The readers pull files off a shared counter, so the batch takes at
+    // most its reader count of workers however many files it has.
+    struct Batch {
+        std::vector<std::string> paths;
+        std::vector<ChartImportResult> results;
+        std::function<void(std::vector<ChartImportResult>)> onDone;
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> readersLeft = 0;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->results.resize(paths.size());
+    batch->paths = std::move(paths);
+    batch->onDone = std::move(onDone);
+    if (batch->paths.empty()) {
+        batch->onDone({});
+        return;
+    }
+
+    auto &executor = get_shared_executor();
+    const size_t readerCount =
+        std::min(batch->paths.size(),
+                 std::max<size_t>(1, executor.num_workers() /
+                                         CHART_IMPORT_WORKER_SHARE));
+    batch->readersLeft = readerCount;
+    for (size_t reader = 0; reader < readerCount; ++reader) {
+        executor.silent_async([batch]() {
+            for (size_t i = batch->next++; i < batch->paths.size();
+                 i = batch->next++) {
+                auto &result = batch->results[i];
+                result.path = batch->paths[i];
+                try {
+                    result.chart = read_chart_file(result.path);
+                    result.stats = compute_chart_import_stats(result.chart);
+                } catch (const std::exception &e) {
+                    result.chart = Chart();
+                    result.error = e.what();
+                    print_debug_message("Failed to import chart " +
+                                        result.path + ": " + result.error);
+                }
+            }
+            if (--batch->readersLeft == 0) {
+                batch->onDone(std::move(batch->results));
+            }
+        });
+    }
+}
+
+std::vector<ChartImportResult> import_chart_files(
+    std::span<const std::string> paths) {
+    using Results = std::vector<ChartImportResult>;
+    auto done = std::make_shared<std::promise<Results>>();
+    auto results = done->get_future();
+    import_chart_files_async({paths.begin(), paths.end()},
+                             [done](Results results) {
+                                 done->set_value(std::move(results));
+                             });
+    return results.get();
+}
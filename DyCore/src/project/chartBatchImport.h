@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "project.h"
+
+// Figures shown for each chart of a batch before any is opened.
+struct ChartImportStats {
+    size_t noteCount = 0;  // Without sub notes.
+    size_t holdCount = 0;
+    // Milliseconds up to the end of the last note.
+    double duration = 0;
+    double minBpm = 0;
+    double maxBpm = 0;
+};
+
+struct ChartImportResult {
+    std::string path;
+    // Empty when the chart was read.
+    std::string error;
+    Chart chart;
+    ChartImportStats stats;
+};
+
+ChartImportStats compute_chart_import_stats(const Chart &chart);
+
+// A batch import takes at most 1/CHART_IMPORT_WORKER_SHARE of the shared
+// executor's workers, so renders keep running beside it.
+inline constexpr size_t CHART_IMPORT_WORKER_SHARE = 2;
+
+// Reads the .xml, .dy, .dyn and .dynb charts at paths, several at once on
+// the shared executor, into independent Charts, without touching the current
+// chart, the note pool or the timing manager. The format follows the
+// extension; a project file gives its first chart. Results are in the order
+// of paths, and a file that fails only fails its own result.
+//
+// Returns at once; onDone gets the results on the worker that read the last
+// file.
+void import_chart_files_async(
+    std::vector<std::string> paths,
+    std::function<void(std::vector<ChartImportResult>)> onDone);
+// Waits for the results. Not for use from a shared executor worker.
+std::vector<ChartImportResult> import_chart_files(
+    std::span<const std::string> paths);
@@ -1,13 +1,20 @@
 
 #include "dy.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <exception>
-#include <fstream>
 #include <json.hpp>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 #include "gm.h"
 #include "dymImportCommon.h"
+#include "mappedFile.h"
 #include "note.h"
 #include "project.h"
 #include "utils.h"
@@ -15,32 +22,481 @@
 using nlohmann::json;
 using std::string;
 
-double json_to_double(const json& j) {
-    if (j.is_string()) {
-        return std::stod(j.get<string>());
+namespace {
+
+// A scalar value as the SAX parser reports it. DY files store numbers
+// either as JSON numbers or as strings.
+struct DyScalar {
+    enum class Kind { NUL, BOOLEAN, INTEGER, FLOAT, STRING };
+    Kind kind = Kind::NUL;
+    long long integer = 0;
+    double number = 0.0;
+    std::string_view text;
+};
+
+double scalar_to_double(const DyScalar& value) {
+    switch (value.kind) {
+        case DyScalar::Kind::STRING:
+            return std::stod(string(value.text));
+        case DyScalar::Kind::INTEGER:
+            return static_cast<double>(value.integer);
+        case DyScalar::Kind::FLOAT:
+            return value.number;
+        default:
+            throw std::runtime_error("Invalid type for double conversion");
     }
-    if (j.is_number()) {
-        return j.get<double>();
+}
+
+string scalar_to_string(const DyScalar& value) {
+    switch (value.kind) {
+        case DyScalar::Kind::STRING:
+            return string(value.text);
+        case DyScalar::Kind::INTEGER:
+            return std::to_string(value.integer);
+        case DyScalar::Kind::FLOAT:
+            return std::to_string(value.number);
+        case DyScalar::Kind::NUL:
+            return "";
+        default:
+            throw std::runtime_error("Invalid type for string conversion");
+    }
+}
+
+// Text fields such as the regions must be JSON strings.
+string scalar_text(const DyScalar& value, const char* field) {
+    if (value.kind != DyScalar::Kind::STRING) {
+        throw std::runtime_error("Invalid DY structure: <" + string(field) +
+                                 "> is not a string");
     }
-    throw std::runtime_error("Invalid type for double conversion");
+    return string(value.text);
 }
 
-string json_to_string(const json& j) {
-    if (j.is_string()) {
-        return j.get<string>();
+int note_type_from_string(std::string_view type) {
+    if (type == "NORMAL")
+        return 0;
+    if (type == "CHAIN")
+        return 1;
+    if (type == "HOLD")
+        return 2;
+    if (type == "SUB")
+        return 3;
+    return -1;
+}
+
+struct DyImportData : DYMChartData {
+    bool oldFormat = false;
+    bool hasMap = false;
+    string chartID;
+    json remix;
+};
+
+// Reads a .dy document through nlohmann's SAX interface, filling the notes
+// and timing points as their fields arrive instead of building a DOM of the
+// whole file. Only the remix part, which is handed to GameMaker as JSON, is
+// built into a json value.
+class DyChartSaxHandler {
+   public:
+    using number_integer_t = json::number_integer_t;
+    using number_unsigned_t = json::number_unsigned_t;
+    using number_float_t = json::number_float_t;
+    using string_t = json::string_t;
+    using binary_t = json::binary_t;
+
+    explicit DyChartSaxHandler(DyImportData& data) : data(data) {
+    }
+
+    // Every CMap field the chart needs was present.
+    bool has_map_fields() const {
+        return mapFields == MAP_REQUIRED_FIELDS;
+    }
+
+    bool null() {
+        return remixParser ? remixParser->null() : scalar({});
+    }
+    bool boolean(bool value) {
+        return remixParser ? remixParser->boolean(value)
+                           : scalar({.kind = DyScalar::Kind::BOOLEAN});
+    }
+    bool number_integer(number_integer_t value) {
+        return remixParser ? remixParser->number_integer(value)
+                           : scalar({.kind = DyScalar::Kind::INTEGER,
+                                     .integer = value});
+    }
+    bool number_unsigned(number_unsigned_t value) {
+        return remixParser
+                   ? remixParser->number_unsigned(value)
+                   : scalar({.kind = DyScalar::Kind::INTEGER,
+                             .integer = static_cast<long long>(value)});
+    }
+    bool number_float(number_float_t value, const string_t& text) {
+        return remixParser ? remixParser->number_float(value, text)
+                           : scalar({.kind = DyScalar::Kind::FLOAT,
+                                     .number = value});
+    }
+    bool string(string_t& value) {
+        return remixParser
+                   ? remixParser->string(value)
+                   : scalar({.kind = DyScalar::Kind::STRING, .text = value});
+    }
+    // JSON text has no binary values.
+    bool binary(binary_t& value) {
+        return remixParser ? remixParser->binary(value) : true;
+    }
+
+    bool key(string_t& value) {
+        if (remixParser) {
+            return remixParser->key(value);
+        }
+        currentKey = value;
+        // Old Dynamaker files are told apart by their root element; the
+        // rest of the file is not needed.
+        if (scopes.size() == 1 && currentKey == "DynamixMap") {
+            data.oldFormat = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t size) {
+        if (remixParser) {
+            ++remixDepth;
+            return remixParser->start_object(size);
+        }
+        if (begin_remix()) {
+            ++remixDepth;
+            return remixParser->start_object(size);
+        }
+        scopes.push_back(child_scope(true));
+        if (scopes.back() == Scope::MAP) {
+            data.hasMap = true;
+        } else if (scopes.back() == Scope::NOTE) {
+            note = DYMNotedata{};
+            note.side = noteSide;
+            noteFields = 0;
+        } else if (scopes.back() == Scope::BPM_CHANGE) {
+            timingFields = 0;
+        }
+        return true;
+    }
+
+    bool end_object() {
+        if (remixParser) {
+            const bool result = remixParser->end_object();
+            end_remix_value();
+            return result;
+        }
+        if (scopes.back() == Scope::NOTE) {
+            finish_note();
+        } else if (scopes.back() == Scope::BPM_CHANGE) {
+            finish_timing();
+        }
+        scopes.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t size) {
+        if (remixParser) {
+            ++remixDepth;
+            return remixParser->start_array(size);
+        }
+        if (begin_remix()) {
+            ++remixDepth;
+            return remixParser->start_array(size);
+        }
+        scopes.push_back(child_scope(false));
+        return true;
+    }
+
+    bool end_array() {
+        if (remixParser) {
+            const bool result = remixParser->end_array();
+            end_remix_value();
+            return result;
+        }
+        scopes.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception& e) {
+        throw std::runtime_error(e.what());
+    }
+
+   private:
+    enum class Scope {
+        ROOT,
+        MAP,
+        SIDE,
+        SIDE_NOTES,
+        NOTE_ARRAY,
+        NOTE,
+        ARGUMENT,
+        BPM,
+        BPM_ARRAY,
+        BPM_CHANGE,
+        IGNORED
+    };
+
+    enum NoteField : uint32_t {
+        NOTE_TYPE_FIELD = 1,
+        NOTE_TIME_FIELD = 2,
+        NOTE_POSITION_FIELD = 4,
+        NOTE_WIDTH_FIELD = 8,
+        NOTE_REQUIRED_FIELDS = 15
+    };
+    enum MapField : uint32_t {
+        MAP_LEFT_REGION_FIELD = 1,
+        MAP_RIGHT_REGION_FIELD = 2,
+        MAP_ID_FIELD = 4,
+        MAP_PATH_FIELD = 8,
+        MAP_BAR_PER_MIN_FIELD = 16,
+        MAP_TIME_OFFSET_FIELD = 32,
+        MAP_REQUIRED_FIELDS = 63
+    };
+    enum TimingField : uint32_t {
+        TIMING_TIME_FIELD = 1,
+        TIMING_VALUE_FIELD = 2,
+        TIMING_REQUIRED_FIELDS = 3
+    };
+
+    // The scope a value opened under the current key, or as an element of
+    // the current array, belongs to.
+    Scope child_scope(bool isObject) {
+        if (scopes.empty()) {
+            return isObject ? Scope::ROOT : Scope::IGNORED;
+        }
+        switch (scopes.back()) {
+            case Scope::ROOT:
+                return isObject && currentKey == "CMap" ? Scope::MAP
+                                                        : Scope::IGNORED;
+            case Scope::MAP:
+                if (!isObject) {
+                    return Scope::IGNORED;
+                }
+                if (currentKey == "m_notes") {
+                    noteSide = 0;
+                    return Scope::SIDE;
+                }
+                if (currentKey == "m_notesLeft") {
+                    noteSide = 1;
+                    return Scope::SIDE;
+                }
+                if (currentKey == "m_notesRight") {
+                    noteSide = 2;
+                    return Scope::SIDE;
+                }
+                return currentKey == "m_argument" ? Scope::ARGUMENT
+                                                  : Scope::IGNORED;
+            case Scope::SIDE:
+                return isObject && currentKey == "m_notes"
+                           ? Scope::SIDE_NOTES
+                           : Scope::IGNORED;
+            case Scope::SIDE_NOTES:
+                return !isObject && currentKey == "CMapNoteAsset"
+                           ? Scope::NOTE_ARRAY
+                           : Scope::IGNORED;
+            case Scope::NOTE_ARRAY:
+                if (!isObject) {
+                    throw std::runtime_error("Invalid DY note");
+                }
+                return Scope::NOTE;
+            case Scope::ARGUMENT:
+                return isObject && currentKey == "m_bpmchange"
+                           ? Scope::BPM
+                           : Scope::IGNORED;
+            case Scope::BPM:
+                return !isObject && currentKey == "CBpmchange"
+                           ? Scope::BPM_ARRAY
+                           : Scope::IGNORED;
+            case Scope::BPM_ARRAY:
+                if (!isObject) {
+                    throw std::runtime_error("Invalid DY BPM change");
+                }
+                return Scope::BPM_CHANGE;
+            default:
+                return Scope::IGNORED;
+        }
+    }
+
+    bool scalar(const DyScalar& value) {
+        if (scopes.empty()) {
+            throw std::runtime_error("Invalid DY structure: not an object");
+        }
+        switch (scopes.back()) {
+            case Scope::ROOT:
+                if (currentKey == "remix") {
+                    data.remix = scalar_to_json(value);
+                }
+                break;
+            case Scope::MAP:
+                read_map_field(value);
+                break;
+            case Scope::NOTE:
+                read_note_field(value);
+                break;
+            case Scope::NOTE_ARRAY:
+                throw std::runtime_error("Invalid DY note");
+            case Scope::BPM_CHANGE:
+                if (currentKey == "m_time") {
+                    timing.time = scalar_to_double(value);
+                    timingFields |= TIMING_TIME_FIELD;
+                } else if (currentKey == "m_value") {
+                    timing.barPerMinute = scalar_to_double(value);
+                    timingFields |= TIMING_VALUE_FIELD;
+                }
+                break;
+            case Scope::BPM_ARRAY:
+                throw std::runtime_error("Invalid DY BPM change");
+            default:
+                break;
+        }
+        return true;
     }
-    if (j.is_number_integer()) {
-        return std::to_string(j.get<long long>());
+
+    static json scalar_to_json(const DyScalar& value) {
+        switch (value.kind) {
+            case DyScalar::Kind::STRING:
+                return std::string(value.text);
+            case DyScalar::Kind::INTEGER:
+                return value.integer;
+            case DyScalar::Kind::FLOAT:
+                return value.number;
+            default:
+                return nullptr;
+        }
     }
-    if (j.is_number_float()) {
-        return std::to_string(j.get<double>());
+
+    void read_map_field(const DyScalar& value) {
+        if (currentKey == "m_leftRegion") {
+            data.metaData.sideType[0] = scalar_text(value, "m_leftRegion");
+            mapFields |= MAP_LEFT_REGION_FIELD;
+        } else if (currentKey == "m_rightRegion") {
+            data.metaData.sideType[1] = scalar_text(value, "m_rightRegion");
+            mapFields |= MAP_RIGHT_REGION_FIELD;
+        } else if (currentKey == "m_mapID") {
+            data.chartID = scalar_text(value, "m_mapID");
+            mapFields |= MAP_ID_FIELD;
+        } else if (currentKey == "m_path") {
+            data.metaData.title = scalar_text(value, "m_path");
+            mapFields |= MAP_PATH_FIELD;
+        } else if (currentKey == "m_barPerMin") {
+            data.barPerMin = scalar_to_double(value);
+            mapFields |= MAP_BAR_PER_MIN_FIELD;
+        } else if (currentKey == "m_timeOffset") {
+            data.offset = scalar_to_double(value);
+            mapFields |= MAP_TIME_OFFSET_FIELD;
+        }
+    }
+
+    void read_note_field(const DyScalar& value) {
+        if (currentKey == "m_id") {
+            note.id = scalar_to_string(value);
+        } else if (currentKey == "m_subId") {
+            note.subid = scalar_to_string(value);
+        } else if (currentKey == "m_type") {
+            note.type = note_type_from_string(scalar_text(value, "m_type"));
+            noteFields |= NOTE_TYPE_FIELD;
+        } else if (currentKey == "m_time") {
+            note.bar = scalar_to_double(value);
+            noteFields |= NOTE_TIME_FIELD;
+        } else if (currentKey == "m_position") {
+            note.position = scalar_to_double(value);
+            noteFields |= NOTE_POSITION_FIELD;
+        } else if (currentKey == "m_width") {
+            note.width = scalar_to_double(value);
+            noteFields |= NOTE_WIDTH_FIELD;
+        }
     }
-    if (j.is_null()) {
-        return "";
+
+    void finish_note() {
+        if (noteFields != NOTE_REQUIRED_FIELDS) {
+            throw std::runtime_error("Invalid DY note: missing fields");
+        }
+        // Convert DY's position to DyNode's position.
+        note.position = note.position + note.width / 2;
+        note.id += '_';
+        note.id += static_cast<char>('0' + note.side);
+        note.subid += '_';
+        note.subid += static_cast<char>('0' + note.side);
+        data.notes.push_back(std::move(note));
     }
-    throw std::runtime_error("Invalid type for string conversion: " + j.dump());
+
+    void finish_timing() {
+        if (timingFields != TIMING_REQUIRED_FIELDS) {
+            throw std::runtime_error("Invalid DY BPM change: missing fields");
+        }
+        data.timings.push_back(timing);
+        data.hasTimingData = true;
+    }
+
+    // Starts building the remix when the value about to open is the root's
+    // "remix" member.
+    bool begin_remix() {
+        if (scopes.size() != 1 || currentKey != "remix") {
+            return false;
+        }
+        data.remix = json();
+        remixParser.emplace(data.remix);
+        remixDepth = 0;
+        return true;
+    }
+
+    void end_remix_value() {
+        if (--remixDepth == 0) {
+            remixParser.reset();
+        }
+    }
+
+    DyImportData& data;
+    std::vector<Scope> scopes;
+    std::string currentKey;
+    uint32_t mapFields = 0;
+
+    int noteSide = 0;
+    DYMNotedata note;
+    uint32_t noteFields = 0;
+    DYMTimingData timing;
+    uint32_t timingFields = 0;
+
+    // The remix is the only part kept as JSON; nlohmann's own DOM builder
+    // receives its events.
+    std::optional<nlohmann::detail::json_sax_dom_parser<json>> remixParser;
+    int remixDepth = 0;
+};
+
+// Parses the chart in the mapped file, which is released once parsed.
+// Returns false for old Dynamaker files. Throws if the file is not a chart.
+bool parse_dy_chart(MappedFile file, DyImportData& data) {
+    {
+        const auto text = file.data();
+        DyChartSaxHandler handler(data);
+        json::sax_parse(text.data(), text.data() + text.size(), &handler);
+        file = MappedFile();
+
+        // Check for old Dynamaker format.
+        if (data.oldFormat) {
+            return false;
+        }
+        if (!data.hasMap) {
+            throw std::runtime_error(
+                "Invalid DY structure: Missing <CMap> root element");
+        }
+        if (!handler.has_map_fields() || data.chartID.empty()) {
+            throw std::runtime_error(
+                "Invalid DY structure: Missing chart information");
+        }
+    }
+
+    data.metaData.difficulty = difficulty_char_to_int(data.chartID.back());
+    std::sort(data.timings.begin(), data.timings.end(),
+              [](const DYMTimingData& a, const DYMTimingData& b) {
+                  return a.time < b.time;
+              });
+    return true;
 }
 
+}  // namespace
+
 json lastRemix;
 
 string get_dy_remix() {
@@ -50,115 +506,36 @@ string get_dy_remix() {
 IMPORT_DY_RESULT_STATES chart_import_dy(const char* filePath,
                                         bool importMetadata,
                                         bool importTiming) {
-    // Read file into buffer.
-    std::ifstream stream(convert_char_to_path(filePath));
-    if (!stream.is_open()) {
-        print_debug_message("Failed to open DY file: " + string(filePath));
+    // The document is parsed straight from the mapped file.
+    MappedFile file;
+    try {
+        file = MappedFile(convert_char_to_path(filePath));
+    } catch (const std::system_error& e) {
+        print_debug_message("Failed to open DY file: " + string(filePath) +
+                            ". " + e.what());
         return IMPORT_DY_RESULT_STATES::FAILURE;
     }
 
     auto start = std::chrono::high_resolution_clock::now();
 
     try {
-        json doc = json::parse(stream);
-        stream.close();
-
-        // Check for old Dynamaker format.
-        if (doc.contains("DynamixMap")) {
+        DyImportData data;
+        if (!parse_dy_chart(std::move(file), data)) {
             return IMPORT_DY_RESULT_STATES::OLD_FORMAT;
         }
 
-        auto map_root = doc["CMap"];
-        if (map_root.is_null()) {
-            throw std::runtime_error(
-                "Invalid DY structure: Missing <CMap> root element");
-        }
-
-        auto noteType_conversion = [](const string& type) -> int {
-            if (type == "NORMAL")
-                return 0;
-            if (type == "CHAIN")
-                return 1;
-            if (type == "HOLD")
-                return 2;
-            if (type == "SUB")
-                return 3;
-            return -1;
-        };
-
-        // Read chart metadata.
-        ChartMetadata metaData;
-        metaData.sideType[0] = map_root["m_leftRegion"];
-        metaData.sideType[1] = map_root["m_rightRegion"];
-        string chartID = map_root["m_mapID"];
-        metaData.difficulty = difficulty_char_to_int(chartID.back());
-        metaData.title = map_root["m_path"];
-
         if (importMetadata)
-            chart_set_metadata(metaData);
-
-        double barPerMin = json_to_double(map_root["m_barPerMin"]);
-        double offset = json_to_double(map_root["m_timeOffset"]);
-
-        // Read note data.
-        std::vector<DYMNotedata> notes;
-
-        auto import_side_notes = [&](const json& side_root, int side) {
-            auto arrNode = side_root["m_notes"]["CMapNoteAsset"];
-            if (!arrNode.is_array())
-                return;
-            for (auto noteNode : arrNode) {
-                DYMNotedata noteData;
-                // Read
-                noteData.id = json_to_string(noteNode["m_id"]);
-                noteData.subid = json_to_string(noteNode["m_subId"]);
-                noteData.type = noteType_conversion(noteNode["m_type"]);
-                noteData.bar = json_to_double(noteNode["m_time"]);
-                noteData.position = json_to_double(noteNode["m_position"]);
-                noteData.width = json_to_double(noteNode["m_width"]);
-
-                // Convert DY's position to DyNode's position.
-                noteData.position = noteData.position + noteData.width / 2;
-                noteData.id += "_" + std::to_string(side);
-                noteData.subid += "_" + std::to_string(side);
-                noteData.side = side;
-                notes.push_back(noteData);
-            }
-        };
-
-        import_side_notes(map_root["m_notes"], 0);
-        import_side_notes(map_root["m_notesLeft"], 1);
-        import_side_notes(map_root["m_notesRight"], 2);
-
-        // Read timing data.
-        bool hasTimingData = false;
-        std::vector<DYMTimingData> xmlTimings;
-        if (map_root.contains("m_argument") &&
-            map_root["m_argument"].contains("m_bpmchange")) {
-            auto timingRootNode = map_root["m_argument"]["m_bpmchange"];
-            for (auto timingNode : timingRootNode["CBpmchange"]) {
-                xmlTimings.push_back({
-                    json_to_double(timingNode["m_time"]),
-                    json_to_double(timingNode["m_value"]),
-                });
-                hasTimingData = true;
-            }
-
-            std::sort(xmlTimings.begin(), xmlTimings.end(),
-                      [](const DYMTimingData& a,
-                         const DYMTimingData& b) {
-                          return a.time < b.time;
-                      });
-        }
-
-        import_timing_points(importTiming, hasTimingData, xmlTimings, offset,
-                             barPerMin);
-        fix_imported_note_times(notes, xmlTimings, offset, barPerMin);
-        const auto noteIDTimeMap = build_note_id_time_map(notes);
-        add_imported_notes_to_project(notes, noteIDTimeMap);
+            chart_set_metadata(data.metaData);
+
+        import_timing_points(importTiming, data.hasTimingData, data.timings,
+                             data.offset, data.barPerMin);
+        fix_imported_note_times(data.notes, data.timings, data.offset,
+                                data.barPerMin);
+        const auto noteIDTimeMap = build_note_id_time_map(data.notes);
+        add_imported_notes_to_project(data.notes, noteIDTimeMap);
 
         // Save remix part.
-        lastRemix = doc["remix"];
+        lastRemix = std::move(data.remix);
     } catch (const std::exception& e) {
         print_debug_message("Exception occurred while importing DY: " +
                             string(e.what()));
@@ -174,3 +551,11 @@ IMPORT_DY_RESULT_STATES chart_import_dy(const char* filePath,
 
     return IMPORT_DY_RESULT_STATES::SUCCESS;
 }
+
+Chart read_dy_chart(const char* filePath) {
+    DyImportData data;
+    if (!parse_dy_chart(MappedFile(convert_char_to_path(filePath)), data)) {
+        throw std::runtime_error("Old Dynamaker charts are not supported.");
+    }
+    return make_imported_chart(data);
+}
@@ -1,7 +1,13 @@
 #pragma once
 #include <string>
 
+#include "project.h"
+
 enum class IMPORT_DY_RESULT_STATES { SUCCESS, FAILURE, OLD_FORMAT };
 std::string get_dy_remix();
 IMPORT_DY_RESULT_STATES chart_import_dy(const char* filePath, bool importInfo,
-                                        bool importTiming);
\ No newline at end of file
+                                        bool importTiming);
+// Reads a .dy chart into a Chart, leaving the current chart and the last
+// remix alone. Throws if the file cannot be read, is in the old Dynamaker
+// format or is not a chart.
+Chart read_dy_chart(const char* filePath);
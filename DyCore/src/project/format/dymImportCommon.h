@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "note.h"
+#include "project.h"
 #include "timing.h"
 
 struct DYMNotedata {
@@ -22,10 +25,63 @@ struct DYMTimingData {
     double barPerMinute = 0.0;
 };
 
+// A chart as read from a Dynamix XML or .dy file, with note times still in
+// bars.
+struct DYMChartData {
+    ChartMetadata metaData;
+    double barPerMin = 0;
+    double offset = 0;
+    bool hasTimingData = false;
+    std::vector<DYMNotedata> notes;
+    std::vector<DYMTimingData> timings;
+};
+
 inline double imported_bar_to_time(double offset, double barPerMinute) {
     return (offset * 60000.0) / barPerMinute;
 }
 
+// The timing points of an imported chart, in time order. Charts without BPM
+// changes get one timing point from their bar rate.
+inline std::vector<TimingPoint> make_imported_timing_points(
+    bool hasTimingData, const std::vector<DYMTimingData>& timings,
+    double offset, double barPerMin) {
+    std::vector<TimingPoint> points;
+    if (!hasTimingData) {
+        points.push_back({imported_bar_to_time(-offset, barPerMin),
+                          60000.0 / (barPerMin * 4), 4});
+        return points;
+    }
+
+    points.reserve(timings.size());
+    double runningTime = imported_bar_to_time(-offset, barPerMin);
+
+    for (int i = 0; i < timings.size(); i++) {
+        double timingPointTime = timings[i].time;
+        if (i > 0) {
+            timingPointTime =
+                imported_bar_to_time(timingPointTime - timings[i - 1].time,
+                                     timings[i - 1].barPerMinute) +
+                runningTime;
+        } else {
+            timingPointTime = runningTime;
+        }
+
+        runningTime = timingPointTime;
+
+        TimingPoint tp;
+        tp.meter = 4;
+        tp.time = timingPointTime;
+        tp.set_bpm(timings[i].barPerMinute * 4);
+        points.push_back(tp);
+    }
+    // Appending needs time order; points sharing a time keep theirs.
+    std::stable_sort(points.begin(), points.end(),
+                     [](const TimingPoint& a, const TimingPoint& b) {
+                         return a.time < b.time;
+                     });
+    return points;
+}
+
 inline void import_timing_points(bool importTiming, bool hasTimingData,
                                  const std::vector<DYMTimingData>& timings,
                                  double offset, double barPerMin) {
@@ -36,34 +92,15 @@ inline void import_timing_points(bool importTiming, bool hasTimingData,
     auto& timingMan = get_timing_manager();
     timingMan.clear();
 
+    const auto points =
+        make_imported_timing_points(hasTimingData, timings, offset, barPerMin);
     if (hasTimingData) {
-        double runningTime = imported_bar_to_time(-offset, barPerMin);
-
-        for (int i = 0; i < timings.size(); i++) {
-            double timingPointTime = timings[i].time;
-            if (i > 0) {
-                timingPointTime =
-                    imported_bar_to_time(timingPointTime - timings[i - 1].time,
-                                         timings[i - 1].barPerMinute) +
-                    runningTime;
-            } else {
-                timingPointTime = runningTime;
-            }
-
-            runningTime = timingPointTime;
-
-            TimingPoint tp;
-            tp.meter = 4;
-            tp.time = timingPointTime;
-            tp.set_bpm(timings[i].barPerMinute * 4);
-            timingMan.add_timing_point(tp);
-        }
+        // Inserted in one batch: each separate insert marks the timing
+        // modified, which charts with many speed changes feel.
+        timingMan.append_timing_points(points);
     } else {
-        timingMan.add_timing_point({imported_bar_to_time(-offset, barPerMin),
-                                    60000.0 / (barPerMin * 4), 4});
+        timingMan.add_timing_point(points.front());
     }
-
-    timingMan.sort();
 }
 
 inline void fix_imported_note_times(
@@ -72,30 +109,38 @@ inline void fix_imported_note_times(
     double barPerMin) {
     const double fixedOffset = imported_bar_to_time(offset, barPerMin);
 
-    for (auto& note : notes) {
-        if (timings.size() > 1) {
-            const double noteBar = note.bar;
-            double runningTime = 0.0;
-
-            for (int i = 1, l = timings.size(); i <= l; i++) {
-                if (i == l || timings[i].time > noteBar) {
-                    runningTime +=
-                        imported_bar_to_time(noteBar - timings[i - 1].time,
-                                             timings[i - 1].barPerMinute);
-                    break;
-                }
-
-                runningTime +=
-                    imported_bar_to_time(timings[i].time - timings[i - 1].time,
-                                         timings[i - 1].barPerMinute);
-            }
-
-            note.time = runningTime;
-        } else {
-            note.time = imported_bar_to_time(note.bar, barPerMin);
+    if (timings.size() <= 1) {
+        for (auto& note : notes) {
+            note.time = imported_bar_to_time(note.bar, barPerMin) - fixedOffset;
         }
+        return;
+    }
+
+    // Index the BPM changes from time 0 at the first one. DYM bars are always
+    // four beats long.
+    std::vector<TimingPoint> points;
+    points.reserve(timings.size());
+    double runningTime = 0.0;
+    for (int i = 0; i < timings.size(); i++) {
+        if (i > 0) {
+            runningTime +=
+                imported_bar_to_time(timings[i].time - timings[i - 1].time,
+                                     timings[i - 1].barPerMinute);
+        }
+        points.push_back(
+            {runningTime, 60000.0 / (timings[i].barPerMinute * 4), 4});
+    }
+    const TimingIndex timingIndex(points);
 
-        note.time -= fixedOffset;
+    std::vector<double> noteBeats(notes.size());
+    std::vector<double> noteTimes(notes.size());
+    for (size_t i = 0; i < notes.size(); i++) {
+        noteBeats[i] = (notes[i].bar - timings[0].time) * 4;
+    }
+    timingIndex.convert(noteBeats, noteTimes, TIMING_UNIT::BEAT,
+                        TIMING_UNIT::MS);
+    for (size_t i = 0; i < notes.size(); i++) {
+        notes[i].time = noteTimes[i] - fixedOffset;
     }
 }
 
@@ -108,9 +153,13 @@ inline std::unordered_map<std::string, double> build_note_id_time_map(
     return noteIDTimeMap;
 }
 
-inline void add_imported_notes_to_project(
+// The notes of an imported chart, without their sub notes. A hold takes its
+// length from its sub note.
+inline std::vector<Note> make_imported_notes(
     const std::vector<DYMNotedata>& notes,
     const std::unordered_map<std::string, double>& noteIDTimeMap) {
+    std::vector<Note> newNotes;
+    newNotes.reserve(notes.size());
     for (const auto& note : notes) {
         if (note.type == 3) {
             continue;
@@ -129,6 +178,27 @@ inline void add_imported_notes_to_project(
             newNote.lastTime = noteIDTimeMap.at(note.subid) - note.time;
         }
 
-        create_note(newNote);
+        newNotes.push_back(std::move(newNote));
     }
-}
\ No newline at end of file
+    return newNotes;
+}
+
+inline void add_imported_notes_to_project(
+    const std::vector<DYMNotedata>& notes,
+    const std::unordered_map<std::string, double>& noteIDTimeMap) {
+    create_notes(make_imported_notes(notes, noteIDTimeMap));
+}
+
+// Converts an imported chart into a Chart without touching the note pool or
+// the timing manager.
+inline Chart make_imported_chart(DYMChartData& data) {
+    Chart chart;
+    chart.metadata = data.metaData;
+    chart.timingPoints = make_imported_timing_points(
+        data.hasTimingData, data.timings, data.offset, data.barPerMin);
+    fix_imported_note_times(data.notes, data.timings, data.offset,
+                            data.barPerMin);
+    chart.notes = make_imported_notes(data.notes,
+                                      build_note_id_time_map(data.notes));
+    return chart;
+}
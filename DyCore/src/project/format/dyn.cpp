@@ -1,11 +1,26 @@
 #include "dyn.h"
 
-#include <fstream>
+#include <zstd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <json.hpp>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 #include "compress.h"
+#include "dynb.h"
 #include "gm.h"
+#include "mappedFile.h"
 #include "note.h"
 #include "project.h"
 #include "timing.h"
@@ -123,31 +138,461 @@ bool dyn_old_format_check(const json& input) {
     return false;
 }
 
+namespace {
+
+// =============================================================================
+// Loading by chart
+// =============================================================================
+
+[[noreturn]] void throw_malformed() {
+    throw std::runtime_error("Malformed DYN file.");
+}
+
+size_t skip_json_space(std::string_view text, size_t pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' ||
+                                 text[pos] == '\r' || text[pos] == '\t')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// The end of the string starting with the quote at pos.
+size_t skip_json_string(std::string_view text, size_t pos) {
+    for (++pos; pos < text.size(); ++pos) {
+        if (text[pos] == '\\') {
+            ++pos;
+        } else if (text[pos] == '"') {
+            return pos + 1;
+        }
+    }
+    throw_malformed();
+}
+
+// The end of the value starting at pos. Only strings and nesting are
+// tracked; nlohmann checks the rest when a value is parsed.
+size_t skip_json_value(std::string_view text, size_t pos) {
+    if (pos >= text.size()) {
+        throw_malformed();
+    }
+    if (text[pos] == '"') {
+        return skip_json_string(text, pos);
+    }
+    if (text[pos] != '{' && text[pos] != '[') {
+        while (pos < text.size() && text[pos] != ',' && text[pos] != '}' &&
+               text[pos] != ']' && text[pos] != ' ' && text[pos] != '\n' &&
+               text[pos] != '\r' && text[pos] != '\t') {
+            ++pos;
+        }
+        return pos;
+    }
+    int depth = 0;
+    for (; pos < text.size(); ++pos) {
+        switch (text[pos]) {
+            case '"':
+                pos = skip_json_string(text, pos) - 1;
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) {
+                    return pos + 1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    throw_malformed();
+}
+
+// Calls visit with the raw key and the value text of each member of the
+// object, or with an empty key and each element of the array.
+template <typename Visitor>
+void for_each_json_member(std::string_view text, Visitor&& visit) {
+    size_t pos = skip_json_space(text, 0);
+    if (pos >= text.size() || (text[pos] != '{' && text[pos] != '[')) {
+        throw_malformed();
+    }
+    const bool isObject = text[pos] == '{';
+    const char close = isObject ? '}' : ']';
+    pos = skip_json_space(text, pos + 1);
+    if (pos < text.size() && text[pos] == close) {
+        return;
+    }
+    while (true) {
+        std::string_view key;
+        if (isObject) {
+            const size_t keyEnd = skip_json_string(text, pos);
+            key = text.substr(pos + 1, keyEnd - pos - 2);
+            pos = skip_json_space(text, keyEnd);
+            if (pos >= text.size() || text[pos] != ':') {
+                throw_malformed();
+            }
+            pos = skip_json_space(text, pos + 1);
+        }
+        const size_t valueEnd = skip_json_value(text, pos);
+        visit(key, text.substr(pos, valueEnd - pos));
+        pos = skip_json_space(text, valueEnd);
+        if (pos < text.size() && text[pos] == ',') {
+            pos = skip_json_space(text, pos + 1);
+        } else if (pos < text.size() && text[pos] == close) {
+            return;
+        } else {
+            throw_malformed();
+        }
+    }
+}
+
+// Decompresses the bytes [begin, end) of the content of a zstd file,
+// keeping nothing before them.
+std::string decompress_range(std::string_view file, size_t begin,
+                             size_t end) {
+    ZSTD_DCtx* dctx = thread_decompress_context();
+    std::string range;
+    range.reserve(end - begin);
+    std::vector<char> output(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer in{file.data(), file.size(), 0};
+    size_t offset = 0;
+    while (offset < end && in.pos < in.size) {
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        const size_t result = ZSTD_decompressStream(dctx, &out, &in);
+        if (ZSTD_isError(result)) {
+            throw std::runtime_error(string("Error decompressing DYN file: ") +
+                                     ZSTD_getErrorName(result));
+        }
+        const size_t from = std::max(offset, begin);
+        const size_t to = std::min(offset + out.pos, end);
+        if (from < to) {
+            range.append(output.data() + (from - offset), to - from);
+        }
+        offset += out.pos;
+    }
+    if (range.size() != end - begin) {
+        throw std::runtime_error("DYN file ends early.");
+    }
+    return range;
+}
+
+// Fills records from a JSON array of flat objects, such as the notes of a
+// chart, through nlohmann's SAX interface, without building a DOM. Every
+// field must be a number; other members are skipped.
+template <typename Record>
+class RecordArraySaxReader {
+   public:
+    using number_integer_t = json::number_integer_t;
+    using number_unsigned_t = json::number_unsigned_t;
+    using number_float_t = json::number_float_t;
+    using string_t = json::string_t;
+    using binary_t = json::binary_t;
+
+    struct Field {
+        std::string_view key;
+        void (*set)(Record&, double);
+    };
+
+    RecordArraySaxReader(std::span<const Field> fields,
+                         std::vector<Record>& records)
+        : fields(fields), records(records) {
+    }
+
+    bool null() {
+        return other_value();
+    }
+    bool boolean(bool) {
+        return other_value();
+    }
+    bool number_integer(number_integer_t value) {
+        return number(static_cast<double>(value));
+    }
+    bool number_unsigned(number_unsigned_t value) {
+        return number(static_cast<double>(value));
+    }
+    bool number_float(number_float_t value, const string_t&) {
+        return number(value);
+    }
+    bool string(string_t&) {
+        return other_value();
+    }
+    bool binary(binary_t&) {
+        return other_value();
+    }
+
+    bool key(string_t& value) {
+        if (depth == 2) {
+            field = -1;
+            for (size_t i = 0; i < fields.size(); ++i) {
+                if (fields[i].key == value) {
+                    field = static_cast<int>(i);
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        if (depth == 0) {
+            throw_malformed();
+        }
+        if (depth == 1) {
+            records.emplace_back();
+            seenFields = 0;
+        } else if (depth == 2) {
+            check_field_is_number();
+        }
+        ++depth;
+        return true;
+    }
+
+    bool end_object() {
+        if (--depth == 1 && seenFields != (1u << fields.size()) - 1) {
+            throw_malformed();
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (depth == 1) {
+            throw_malformed();
+        } else if (depth == 2) {
+            check_field_is_number();
+        }
+        ++depth;
+        return true;
+    }
+
+    bool end_array() {
+        --depth;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception& e) {
+        throw std::runtime_error(e.what());
+    }
+
+   private:
+    bool number(double value) {
+        if (depth < 2) {
+            throw_malformed();
+        }
+        if (depth == 2 && field >= 0) {
+            fields[field].set(records.back(), value);
+            seenFields |= 1u << field;
+        }
+        return true;
+    }
+
+    bool other_value() {
+        if (depth < 2) {
+            throw_malformed();
+        }
+        if (depth == 2) {
+            check_field_is_number();
+        }
+        return true;
+    }
+
+    void check_field_is_number() const {
+        if (field >= 0) {
+            throw std::runtime_error("DYN field \"" +
+                                     std::string(fields[field].key) +
+                                     "\" is not a number.");
+        }
+    }
+
+    std::span<const Field> fields;
+    std::vector<Record>& records;
+    // 1 inside the array, 2 inside a record.
+    int depth = 0;
+    int field = -1;
+    uint32_t seenFields = 0;
+};
+
+constexpr RecordArraySaxReader<NoteRecord>::Field NOTE_RECORD_FIELDS[] = {
+    {"side", [](NoteRecord& r, double v) { r.side = static_cast<int>(v); }},
+    {"type", [](NoteRecord& r, double v) { r.type = static_cast<int>(v); }},
+    {"time", [](NoteRecord& r, double v) { r.time = v; }},
+    {"length", [](NoteRecord& r, double v) { r.lastTime = v; }},
+    {"width", [](NoteRecord& r, double v) { r.width = v; }},
+    {"position", [](NoteRecord& r, double v) { r.position = v; }},
+};
+
+constexpr RecordArraySaxReader<TimingPoint>::Field TIMING_POINT_FIELDS[] = {
+    {"offset", [](TimingPoint& tp, double v) { tp.time = v; }},
+    {"bpm", [](TimingPoint& tp, double v) { tp.set_bpm(v); }},
+    {"meter", [](TimingPoint& tp, double v) { tp.meter = static_cast<int>(v); }},
+};
+
+template <typename Record, size_t N>
+void read_record_array(
+    std::string_view text,
+    const typename RecordArraySaxReader<Record>::Field (&fields)[N],
+    std::vector<Record>& records) {
+    RecordArraySaxReader<Record> reader(fields, records);
+    json::sax_parse(text.data(), text.data() + text.size(), &reader);
+}
+
+ChartContent parse_chart_content(std::string_view notesText,
+                                 std::string_view timingText) {
+    ChartContent content;
+    read_record_array(notesText, NOTE_RECORD_FIELDS, content.notes);
+    read_record_array(timingText, TIMING_POINT_FIELDS, content.timingPoints);
+    return content;
+}
+
+// Parses the project and chart metadata. The notes and timing points of
+// each chart are read straight into records, now or, with lazyCharts, from
+// file when first used. Returns false for files in an older format, which
+// need converting through a DOM first.
+bool import_dyn_by_chart(std::span<const char> mapped, Project& project,
+                         bool lazyCharts) {
+    const bool compressed = check_compressed(mapped.data(), mapped.size());
+    string decompressed;
+    if (compressed) {
+        decompressed = decompress_to_string(mapped);
+    }
+    const std::string_view text =
+        compressed ? std::string_view(decompressed)
+                   : std::string_view(mapped.data(), mapped.size());
+
+    std::string_view version, metadata, charts;
+    bool currentFormat = false;
+    for_each_json_member(text, [&](std::string_view key,
+                                   std::string_view value) {
+        if (key == "version") {
+            version = value;
+        } else if (key == "metadata") {
+            metadata = value;
+        } else if (key == "charts") {
+            charts = value;
+        } else if (key == "formatVersion") {
+            currentFormat =
+                json::parse(value).get<int>() == DYN_FILE_FORMAT_VERSION;
+        }
+    });
+    if (!currentFormat) {
+        return false;
+    }
+
+    // Lazy charts keep their own copy of the file, so that it is not held
+    // open and can be saved over.
+    std::shared_ptr<const std::string> file;
+    if (lazyCharts) {
+        file = std::make_shared<const std::string>(mapped.begin(),
+                                                   mapped.end());
+    }
+    project = Project();
+    json::parse(version).get_to(project.version);
+    project.metadata = json::parse(metadata);
+    for_each_json_member(charts, [&](std::string_view,
+                                     std::string_view chartText) {
+        auto& chart = project.charts.emplace_back();
+        std::string_view notes, timingPoints;
+        for_each_json_member(chartText, [&](std::string_view key,
+                                            std::string_view value) {
+            if (key == "metadata") {
+                json::parse(value).get_to(chart.metadata);
+            } else if (key == "path") {
+                json::parse(value).get_to(chart.path);
+            } else if (key == "notes") {
+                notes = value;
+            } else if (key == "timingPoints") {
+                timingPoints = value;
+            }
+        });
+        if (notes.empty() || timingPoints.empty()) {
+            throw_malformed();
+        }
+        if (!lazyCharts) {
+            ChartContent content = parse_chart_content(notes, timingPoints);
+            chart.notes.reserve(content.notes.size());
+            for (const auto& record : content.notes) {
+                chart.notes.push_back(make_note(record));
+            }
+            chart.timingPoints = std::move(content.timingPoints);
+            return;
+        }
+
+        // Offsets into the JSON. A compressed file is decompressed again,
+        // up to the end of the chart, when the chart is used; a pass over
+        // several charts decompresses it once into the scratch.
+        const size_t notesBegin = notes.data() - text.data();
+        const size_t timingBegin = timingPoints.data() - text.data();
+        const size_t notesSize = notes.size();
+        const size_t timingSize = timingPoints.size();
+        chart.lazyContent = std::make_shared<LazyChartContent>(
+            [=](LazyChartScratch* scratch) -> ChartContent {
+                if (!compressed || scratch) {
+                    std::string_view source(*file);
+                    if (compressed) {
+                        if (scratch->source != file.get()) {
+                            scratch->text = decompress_to_string(*file);
+                            scratch->source = file.get();
+                        }
+                        source = scratch->text;
+                    }
+                    return parse_chart_content(
+                        source.substr(notesBegin, notesSize),
+                        source.substr(timingBegin, timingSize));
+                }
+                const size_t begin = std::min(notesBegin, timingBegin);
+                const size_t end = std::max(notesBegin + notesSize,
+                                            timingBegin + timingSize);
+                const string range = decompress_range(*file, begin, end);
+                return parse_chart_content(
+                    std::string_view(range).substr(notesBegin - begin,
+                                                   notesSize),
+                    std::string_view(range).substr(timingBegin - begin,
+                                                   timingSize));
+            });
+    });
+    print_debug_message("Loaded DYN project with " +
+                        std::to_string(project.charts.size()) +
+                        (lazyCharts ? " charts; chart content is parsed on "
+                                      "first use."
+                                    : " charts."));
+    return true;
+}
+
+}  // namespace
+
 // This function is for reading the entire project.
-int project_import_dyn(const char* filePath, Project& project) {
+int project_import_dyn(const char* filePath, Project& project,
+                       bool lazyCharts) {
+    if (is_dynb_file(filePath)) {
+        return project_import_dynb(filePath, project, lazyCharts);
+    }
+
     json projectJson;
 
-    std::ifstream stream(convert_char_to_path(filePath), std::ios::binary);
-    if (!stream.is_open()) {
-        print_debug_message("Failed to open DYN file: " + string(filePath));
+    MappedFile file;
+    try {
+        file = MappedFile(convert_char_to_path(filePath));
+    } catch (const std::system_error& e) {
+        print_debug_message("Failed to open DYN file: " + string(filePath) +
+                            ". " + e.what());
         return -1;
     }
     print_debug_message("Opened DYN file: " + string(filePath));
 
-    std::string content;
-    content.assign((std::istreambuf_iterator<char>(stream)),
-                   std::istreambuf_iterator<char>());
-    stream.close();
+    const auto content = file.data();
+    if (import_dyn_by_chart(content, project, lazyCharts)) {
+        return 0;
+    }
 
-    if (check_compressed(content.c_str(), content.size())) {
+    if (check_compressed(content.data(), content.size())) {
         print_debug_message("Decompressing DYN file...");
-        string decompressed =
-            decompress_string(content.c_str(), content.size());
+        const string decompressed = decompress_to_string(content);
         print_debug_message("Decompression complete. Parsing...");
         projectJson = json::parse(decompressed);
     } else {
         print_debug_message("Not a compressed DYN file. Directly parsing...");
-        projectJson = json::parse(content);
+        projectJson =
+            json::parse(content.data(), content.data() + content.size());
     }
 
     print_debug_message("Successfully parsed DYN file.");
@@ -168,6 +613,18 @@ int project_import_dyn(const char* filePath, Project& project) {
     return 0;
 }
 
+Chart read_dyn_chart(const char* filePath) {
+    Project project;
+    if (project_import_dyn(filePath, project) != 0) {
+        throw std::runtime_error("Failed to open DYN file: " +
+                                 string(filePath));
+    }
+    if (project.charts.empty()) {
+        throw std::runtime_error("DYN file has no charts.");
+    }
+    return std::move(project.charts[0]);
+}
+
 // This function is for importing charts.
 int chart_import_dyn(const char* filePath, bool importInfo, bool importTiming) {
     try {
@@ -176,9 +633,7 @@ int chart_import_dyn(const char* filePath, bool importInfo, bool importTiming) {
 
         // Import notes from the first chart.
         const Chart& chart = project.charts[0];
-        for (const Note& note : chart.notes) {
-            create_note(note);
-        }
+        create_notes(chart.notes);
 
         // Import chart information if requested.
         if (importInfo) {
@@ -195,4 +650,425 @@ int chart_import_dyn(const char* filePath, bool importInfo, bool importTiming) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+namespace {
+
+// Input is compressed in chunks of this size, and the compressed output is
+// handed to the writer in chunks of at most this size.
+constexpr size_t DYN_EXPORT_CHUNK_SIZE = 128 * 1024;
+
+// Compressed files end with a skippable frame holding the size and XXH3 of
+// the JSON, so a save can be checked by streaming it through zstd. Readers
+// that only know zstd skip it.
+constexpr char DYN_CHECKSUM_TAG[4] = {'D', 'Y', 'N', 'C'};
+
+struct DynChecksumFrame {
+    uint32_t magic;      // ZSTD_MAGIC_SKIPPABLE_START
+    uint32_t frameSize;  // Bytes after this field.
+    char tag[4];
+    uint32_t reserved;
+    uint64_t contentSize;
+    XXH64_hash_t contentChecksum;
+};
+
+static_assert(sizeof(DynChecksumFrame) == 32);
+
+struct XXH3StateDeleter {
+    void operator()(XXH3_state_t* state) const {
+        XXH3_freeState(state);
+    }
+};
+
+void check_zstd_result(size_t result) {
+    if (ZSTD_isError(result)) {
+        throw std::runtime_error(string("Error compressing project data: ") +
+                                 ZSTD_getErrorName(result));
+    }
+}
+
+// Measures the JSON so the zstd frame can carry its content size.
+class DynSizeCounter {
+   public:
+    void append(std::string_view text) {
+        size += text.size();
+    }
+
+    size_t size = 0;
+};
+
+// Compresses the JSON chunk by chunk and passes the output on, hashing
+// everything written.
+class DynChunkCompressor {
+   public:
+    DynChunkCompressor(const ZstdCompressOptions& options, size_t contentSize,
+                       const DynChunkWriter& write)
+        : write(write), input(DYN_EXPORT_CHUNK_SIZE) {
+        hashState.reset(XXH3_createState());
+        contentHashState.reset(XXH3_createState());
+        if (!hashState || XXH3_64bits_reset(hashState.get()) != XXH_OK ||
+            !contentHashState ||
+            XXH3_64bits_reset(contentHashState.get()) != XXH_OK) {
+            throw std::runtime_error("Error creating the checksum state.");
+        }
+        result.contentSize = contentSize;
+        if (options.level == 0) {
+            return;
+        }
+        lease.emplace(acquire_compress_context(options, contentSize));
+        cctx = lease->get();
+        check_zstd_result(
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1));
+        check_zstd_result(ZSTD_CCtx_setPledgedSrcSize(cctx, contentSize));
+        output.resize(std::max(DYN_EXPORT_CHUNK_SIZE, ZSTD_CStreamOutSize()));
+    }
+
+    void append(std::string_view text) {
+        while (!text.empty()) {
+            const size_t count =
+                std::min(text.size(), input.size() - inputSize);
+            std::memcpy(input.data() + inputSize, text.data(), count);
+            inputSize += count;
+            text.remove_prefix(count);
+            if (inputSize == input.size()) {
+                flush_input(ZSTD_e_continue);
+            }
+        }
+    }
+
+    DynExportResult finish() {
+        flush_input(ZSTD_e_end);
+        result.contentChecksum = XXH3_64bits_digest(contentHashState.get());
+        if (cctx) {
+            DynChecksumFrame frame{
+                .magic = ZSTD_MAGIC_SKIPPABLE_START,
+                .frameSize = sizeof(DynChecksumFrame) - 2 * sizeof(uint32_t),
+                .reserved = 0,
+                .contentSize = result.contentSize,
+                .contentChecksum = result.contentChecksum};
+            std::memcpy(frame.tag, DYN_CHECKSUM_TAG, sizeof(frame.tag));
+            emit(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        }
+        result.checksum = XXH3_64bits_digest(hashState.get());
+        return result;
+    }
+
+   private:
+    void flush_input(ZSTD_EndDirective mode) {
+        XXH3_64bits_update(contentHashState.get(), input.data(), inputSize);
+        if (!cctx) {
+            emit(input.data(), inputSize);
+            inputSize = 0;
+            return;
+        }
+        ZSTD_inBuffer in{input.data(), inputSize, 0};
+        bool finished = false;
+        while (!finished) {
+            ZSTD_outBuffer out{output.data(), output.size(), 0};
+            const size_t remaining =
+                ZSTD_compressStream2(cctx, &out, &in, mode);
+            check_zstd_result(remaining);
+            emit(output.data(), out.pos);
+            finished = mode == ZSTD_e_end ? remaining == 0 : in.pos == in.size;
+        }
+        inputSize = 0;
+    }
+
+    void emit(const char* data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        XXH3_64bits_update(hashState.get(), data, size);
+        write(data, size);
+        result.fileSize += size;
+    }
+
+    const DynChunkWriter& write;
+    std::optional<ZstdCompressLease> lease;
+    ZSTD_CCtx* cctx = nullptr;
+    std::unique_ptr<XXH3_state_t, XXH3StateDeleter> hashState;
+    std::unique_ptr<XXH3_state_t, XXH3StateDeleter> contentHashState;
+    std::vector<char> input;
+    size_t inputSize = 0;
+    std::vector<char> output;
+    DynExportResult result;
+};
+
+// Writes JSON the way nlohmann dumps it, keys sorted, so saved files read
+// the same as before.
+template <typename Output>
+class DynJsonWriter {
+   public:
+    explicit DynJsonWriter(Output& output) : output(output) {
+    }
+
+    void write_project(const ProjectSnapshot& project) {
+        output.append("{\"charts\":[");
+        LazyChartScratch scratch;
+        for (size_t i = 0; i < project.charts.size(); ++i) {
+            if (i > 0) {
+                output.append(",");
+            }
+            write_chart(project.charts[i], scratch);
+        }
+        output.append("],\"formatVersion\":");
+        write_int(DYN_FILE_FORMAT_VERSION);
+        output.append(",\"metadata\":");
+        output.append(project.metadata.dump());
+        output.append(",\"version\":");
+        write_string(project.version);
+        output.append("}");
+    }
+
+   private:
+    void write_chart(const ChartSnapshot& chart, LazyChartScratch& scratch) {
+        const auto content = resolve_chart_snapshot(chart, scratch);
+        const auto& notes = *content.notes;
+        const auto& timingPoints = *content.timingPoints;
+        const auto& meta = chart.metadata;
+        output.append("{\"metadata\":{\"artist\":");
+        write_string(meta.artist);
+        output.append(",\"charter\":");
+        write_string(meta.charter);
+        output.append(",\"difficulty\":");
+        write_int(meta.difficulty);
+        output.append(",\"sideType\":[");
+        write_string(meta.sideType[0]);
+        output.append(",");
+        write_string(meta.sideType[1]);
+        output.append("],\"title\":");
+        write_string(meta.title);
+
+        output.append("},\"notes\":[");
+        for (size_t i = 0; i < notes.size(); ++i) {
+            const auto& note = notes[i];
+            output.append(i > 0 ? ",{\"length\":" : "{\"length\":");
+            write_double(note.lastTime);
+            output.append(",\"position\":");
+            write_double(note.position);
+            output.append(",\"side\":");
+            write_int(note.side);
+            output.append(",\"time\":");
+            write_double(note.time);
+            output.append(",\"type\":");
+            write_int(note.type);
+            output.append(",\"width\":");
+            write_double(note.width);
+            output.append("}");
+        }
+
+        output.append("],\"path\":{\"image\":");
+        write_string(chart.path.image);
+        output.append(",\"music\":");
+        write_string(chart.path.music);
+        output.append(",\"video\":");
+        write_string(chart.path.video);
+
+        output.append("},\"timingPoints\":[");
+        for (size_t i = 0; i < timingPoints.size(); ++i) {
+            const auto& tp = timingPoints[i];
+            output.append(i > 0 ? ",{\"bpm\":" : "{\"bpm\":");
+            write_double(tp.get_bpm());
+            output.append(",\"meter\":");
+            write_int(tp.meter);
+            output.append(",\"offset\":");
+            write_double(tp.time);
+            output.append("}");
+        }
+        output.append("]}");
+    }
+
+    void write_int(int value) {
+        char buffer[16];
+        const auto end =
+            std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+        output.append({buffer, static_cast<size_t>(end - buffer)});
+    }
+
+    // Lays the shortest round-trip digits out the way nlohmann does: plain
+    // decimals while the point falls at most 15 digits after the first one
+    // and no more than 3 zeros follow it, exponent notation otherwise.
+    void write_double(double value) {
+        if (!std::isfinite(value)) {
+            output.append("null");
+            return;
+        }
+        char scientific[32];
+        char* const scientificEnd =
+            std::to_chars(scientific, scientific + sizeof(scientific), value,
+                          std::chars_format::scientific)
+                .ptr;
+        const char* const exponentBegin =
+            std::find(scientific, scientificEnd, 'e');
+        int exponent = 0;
+        std::from_chars(exponentBegin + (exponentBegin[1] == '+' ? 2 : 1),
+                        scientificEnd, exponent);
+
+        char buffer[48];
+        char* out = buffer;
+        char digits[20];
+        int digitCount = 0;
+        for (const char* c = scientific; c != exponentBegin; ++c) {
+            if (*c == '-') {
+                *out++ = '-';
+            } else if (*c != '.') {
+                digits[digitCount++] = *c;
+            }
+        }
+        // The point goes after this many digits.
+        const int point = exponent + 1;
+        constexpr int MAX_POINT = 15;
+        constexpr int MIN_POINT = -4;
+        if (digitCount <= point && point <= MAX_POINT) {
+            out = std::copy(digits, digits + digitCount, out);
+            out = std::fill_n(out, point - digitCount, '0');
+            out = std::copy_n(".0", 2, out);
+        } else if (0 < point && point <= MAX_POINT) {
+            out = std::copy(digits, digits + point, out);
+            *out++ = '.';
+            out = std::copy(digits + point, digits + digitCount, out);
+        } else if (MIN_POINT < point && point <= 0) {
+            out = std::copy_n("0.", 2, out);
+            out = std::fill_n(out, -point, '0');
+            out = std::copy(digits, digits + digitCount, out);
+        } else {
+            *out++ = digits[0];
+            if (digitCount > 1) {
+                *out++ = '.';
+                out = std::copy(digits + 1, digits + digitCount, out);
+            }
+            *out++ = 'e';
+            *out++ = exponent < 0 ? '-' : '+';
+            const int magnitude = std::abs(exponent);
+            if (magnitude < 10) {
+                *out++ = '0';
+            }
+            out = std::to_chars(out, buffer + sizeof(buffer), magnitude).ptr;
+        }
+        output.append({buffer, static_cast<size_t>(out - buffer)});
+    }
+
+    void write_string(std::string_view text) {
+        output.append("\"");
+        size_t begin = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const auto c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            output.append(text.substr(begin, i - begin));
+            begin = i + 1;
+            switch (c) {
+                case '"':
+                    output.append("\\\"");
+                    break;
+                case '\\':
+                    output.append("\\\\");
+                    break;
+                case '\b':
+                    output.append("\\b");
+                    break;
+                case '\f':
+                    output.append("\\f");
+                    break;
+                case '\n':
+                    output.append("\\n");
+                    break;
+                case '\r':
+                    output.append("\\r");
+                    break;
+                case '\t':
+                    output.append("\\t");
+                    break;
+                default: {
+                    static constexpr char HEX[] = "0123456789abcdef";
+                    const char escaped[] = {'\\', 'u', '0', '0',
+                                            HEX[c >> 4], HEX[c & 0xF]};
+                    output.append({escaped, sizeof(escaped)});
+                    break;
+                }
+            }
+        }
+        output.append(text.substr(begin));
+        output.append("\"");
+    }
+
+    Output& output;
+};
+
+}  // namespace
+
+DynExportResult project_export_dyn(const ProjectSnapshot& project,
+                                   ZstdCompressOptions options,
+                                   const DynChunkWriter& write) {
+    options.level = std::clamp(options.level, 0, ZSTD_maxCLevel());
+
+    // The first pass only measures, so nothing but the chunk buffers is held
+    // in memory.
+    DynSizeCounter counter;
+    DynJsonWriter<DynSizeCounter>(counter).write_project(project);
+
+    DynChunkCompressor compressor(options, counter.size, write);
+    DynJsonWriter<DynChunkCompressor>(compressor).write_project(project);
+    return compressor.finish();
+}
+
+DynExportResult project_export_dyn_content(std::string_view content,
+                                           ZstdCompressOptions options,
+                                           const DynChunkWriter& write) {
+    options.level = std::clamp(options.level, 0, ZSTD_maxCLevel());
+
+    DynChunkCompressor compressor(options, content.size(), write);
+    compressor.append(content);
+    return compressor.finish();
+}
+
+void verify_dyn_file(std::span<const char> file,
+                     const DynExportResult& expected) {
+    auto fail = [](const string& reason) {
+        throw std::runtime_error("Saved DYN file does not verify: " + reason);
+    };
+    if (!check_compressed(file.data(), file.size())) {
+        if (file.size() != expected.contentSize ||
+            XXH3_64bits(file.data(), file.size()) != expected.contentChecksum) {
+            fail("content mismatch");
+        }
+        return;
+    }
+
+    DynChecksumFrame frame;
+    if (file.size() < sizeof(frame)) {
+        fail("missing checksum frame");
+    }
+    std::memcpy(&frame, file.data() + file.size() - sizeof(frame),
+                sizeof(frame));
+    if (frame.magic != ZSTD_MAGIC_SKIPPABLE_START ||
+        std::memcmp(frame.tag, DYN_CHECKSUM_TAG, sizeof(frame.tag)) != 0) {
+        fail("missing checksum frame");
+    }
+    if (frame.contentSize != expected.contentSize ||
+        frame.contentChecksum != expected.contentChecksum) {
+        fail("checksum frame does not match the project");
+    }
+
+    // zstd checks its own frame checksum while decompressing; the JSON is
+    // hashed chunk by chunk and never held whole.
+    std::unique_ptr<XXH3_state_t, XXH3StateDeleter> hashState(
+        XXH3_createState());
+    if (!hashState || XXH3_64bits_reset(hashState.get()) != XXH_OK) {
+        throw std::runtime_error("Error creating the verification state.");
+    }
+    uint64_t contentSize = 0;
+    try {
+        contentSize = decompress_stream(file, [&](const char* data,
+                                                  size_t size) {
+            XXH3_64bits_update(hashState.get(), data, size);
+        });
+    } catch (const std::runtime_error& e) {
+        fail(e.what());
+    }
+    if (contentSize != frame.contentSize ||
+        XXH3_64bits_digest(hashState.get()) != frame.contentChecksum) {
+        fail("content mismatch");
+    }
+}
@@ -1,9 +1,57 @@
 #pragma once
 
+#include <xxhash/xxhash.h>
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string_view>
+
+#include "compress.h"
 #include "project.h"
 
 inline constexpr int DYN_FILE_FORMAT_VERSION = 1;
 
-int project_import_dyn(const char* filePath, Project& project);
+// Receives each chunk of an exported .dyn file in order.
+using DynChunkWriter = std::function<void(const char*, size_t)>;
+
+struct DynExportResult {
+    size_t contentSize = 0;  // Bytes of content before compression.
+    size_t fileSize = 0;
+    XXH64_hash_t checksum = 0;  // XXH3 of the written file.
+    // XXH3 of the JSON. Unset for DYNB, whose sections carry their own.
+    XXH64_hash_t contentChecksum = 0;
+};
+
+// Reads a .dyn or DYNB project. With lazyCharts, only the project and chart
+// metadata are parsed now; each chart's notes and timing points are parsed
+// when first used, through Chart::lazyContent.
+int project_import_dyn(const char* filePath, Project& project,
+                       bool lazyCharts = false);
 
 int chart_import_dyn(const char* filePath, bool importInfo, bool importTiming);
+// Reads the first chart of a .dyn or DYNB project, the one chart_import_dyn
+// imports, leaving the current chart alone. Throws if the file cannot be
+// read or has no charts.
+Chart read_dyn_chart(const char* filePath);
+
+// Serializes the project straight into a .dyn file, compressed with the
+// given options (level 0 writes plain JSON), and hands it to write in
+// fixed-size chunks. The zstd frame records the content size and a content
+// checksum, so it reads like a one-shot compressed file, and is followed by
+// a skippable frame with the size and XXH3 of the JSON.
+DynExportResult project_export_dyn(const ProjectSnapshot& project,
+                                   ZstdCompressOptions options,
+                                   const DynChunkWriter& write);
+
+// Writes already serialized project JSON as a .dyn file, the same way
+// project_export_dyn does.
+DynExportResult project_export_dyn_content(std::string_view content,
+                                           ZstdCompressOptions options,
+                                           const DynChunkWriter& write);
+
+// Streams a saved file through zstd and checks the JSON against its
+// embedded checksum and the export result, without parsing it. Throws if
+// the file is damaged.
+void verify_dyn_file(std::span<const char> file,
+                     const DynExportResult& expected);
@@ -0,0 +1,644 @@
+#include "dynb.h"
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <json.hpp>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "compress.h"
+#include "mappedFile.h"
+#include "note.h"
+#include "snap.h"
+#include "timing.h"
+#include "utils.h"
+
+using std::string;
+using json = nlohmann::json;
+
+namespace {
+
+static_assert(std::endian::native == std::endian::little,
+              "DYNB files are written in the host byte order");
+// Rounding a note to the tick must not take it off the grid; hold ends add
+// the rounding of the head and of the length.
+static_assert(2 * 0.5 / DYNB_TIME_SCALE <= SNAP_TIME_TOLERANCE_MS,
+              "snapping must tolerate the rounding of DYNB times");
+
+constexpr char DYNB_MAGIC[4] = {'D', 'Y', 'N', 'B'};
+// Sanity limit on the decoded size of one section.
+constexpr uint64_t DYNB_MAX_SECTION_SIZE = 1ull << 32;
+
+enum class DYNB_SECTION : uint32_t { PROJECT = 1, CHART, NOTES, TIMING };
+enum class DYNB_CODEC : uint32_t { STORED, ZSTD, ZSTD_DICTIONARY };
+
+// Sections up to this size also try the built-in dictionary; larger ones
+// gain nothing from it.
+constexpr size_t DYNB_DICTIONARY_MAX_SECTION_SIZE = 16 * 1024;
+
+// Raw-content dictionary for ZSTD_DICTIONARY sections: the skeleton of the
+// project and chart sections as DyNode writes them. Files depend on every
+// byte of it, so it must never change; a different dictionary needs a new
+// codec.
+constexpr std::string_view DYNB_DICTIONARY =
+    R"({"metadata":{"artist":"","charter":"","difficulty":0,)"
+    R"("sideType":["NORMAL","NORMAL"],"title":""},)"
+    R"("path":{"image":"","music":"","video":""}})"
+    R"({"metadata":{"settings":{"beatlineAlpha":0.0,"bgdim":0.65,)"
+    R"("defaultWidth":1.0,"defaultWidthMode":0,"editmode":4,)"
+    R"("editorSelectMultiSidesBinding":1,"editside":0,"fade":1,)"
+    R"("hitvol":0.5,"mainvol":0.7,"ntime":0.0,"pbspd":1.0,"pitchshift":0},)"
+    R"("stats":{"projectTime":0}},"version":"v0.2.0"})"
+    R"({"metadata":{"artist":"","charter":"","difficulty":0,)"
+    R"("sideType":["MIXER","MIXER"],"title":""},)"
+    R"("path":{"image":"","music":"","video":""}})";
+
+struct DynbHeader {
+    char magic[4];
+    uint16_t formatVersion;
+    uint16_t reserved;
+    uint32_t sectionCount;
+    uint32_t reserved2;
+};
+
+struct DynbSectionEntry {
+    DYNB_SECTION type;
+    uint32_t chart;
+    DYNB_CODEC codec;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t rawSize;
+    XXH64_hash_t checksum;  // XXH3 of the decoded content.
+};
+
+static_assert(sizeof(DynbHeader) == 16);
+static_assert(sizeof(DynbSectionEntry) == 48);
+
+[[noreturn]] void throw_corrupted(const string& reason) {
+    throw std::runtime_error("Corrupted DYNB file: " + reason);
+}
+
+class DynbWriter {
+   public:
+    template <typename T>
+    void put(const T& value) {
+        const auto* data = reinterpret_cast<const char*>(&value);
+        bytes.insert(bytes.end(), data, data + sizeof(T));
+    }
+
+    void put_varint(uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    // Zigzag keeps small negative values short.
+    void put_signed(int64_t value) {
+        put_varint((static_cast<uint64_t>(value) << 1) ^
+                   static_cast<uint64_t>(value >> 63));
+    }
+
+    std::vector<char> bytes;
+};
+
+class DynbReader {
+   public:
+    explicit DynbReader(std::span<const char> data) : data(data) {
+    }
+
+    template <typename T>
+    T get() {
+        require(sizeof(T));
+        T value;
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    uint64_t get_varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            require(1);
+            const auto byte = static_cast<uint8_t>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw_corrupted("invalid varint");
+    }
+
+    int64_t get_signed() {
+        const uint64_t value = get_varint();
+        return static_cast<int64_t>(value >> 1) ^
+               -static_cast<int64_t>(value & 1);
+    }
+
+    size_t remaining() const {
+        return data.size() - pos;
+    }
+
+   private:
+    void require(size_t size) const {
+        if (remaining() < size) {
+            throw_corrupted("section is truncated");
+        }
+    }
+
+    std::span<const char> data;
+    size_t pos = 0;
+};
+
+int64_t quantize(double value, double scale) {
+    const double scaled = std::round(value * scale);
+    // Stay well inside the range of int64 and of exact doubles.
+    if (!(std::abs(scaled) < 0x1p52)) {
+        throw std::runtime_error("Value out of range for DYNB: " +
+                                 std::to_string(value));
+    }
+    return static_cast<int64_t>(scaled);
+}
+
+uint8_t to_byte(int value) {
+    if (value < 0 || value > 0xFF) {
+        throw std::runtime_error("Value out of range for DYNB: " +
+                                 std::to_string(value));
+    }
+    return static_cast<uint8_t>(value);
+}
+
+std::vector<char> json_bytes(const json& j) {
+    const string text = j.dump();
+    return {text.begin(), text.end()};
+}
+
+std::vector<char> encode_notes(const std::vector<NoteRecord>& notes) {
+    std::vector<size_t> order(notes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return notes[a].time < notes[b].time;
+    });
+
+    DynbWriter out;
+    out.bytes.reserve(notes.size() * 12 + sizeof(uint64_t));
+    out.put<uint64_t>(notes.size());
+    for (const size_t i : order) {
+        out.put(to_byte(notes[i].side));
+    }
+    for (const size_t i : order) {
+        out.put(to_byte(notes[i].type));
+    }
+    int64_t lastTime = 0;
+    for (const size_t i : order) {
+        const int64_t time = quantize(notes[i].time, DYNB_TIME_SCALE);
+        out.put_signed(time - lastTime);
+        lastTime = time;
+    }
+    for (const size_t i : order) {
+        out.put_signed(quantize(notes[i].lastTime, DYNB_TIME_SCALE));
+    }
+    for (const size_t i : order) {
+        out.put_signed(quantize(notes[i].width, DYNB_LANE_SCALE));
+    }
+    for (const size_t i : order) {
+        out.put_signed(quantize(notes[i].position, DYNB_LANE_SCALE));
+    }
+    return std::move(out.bytes);
+}
+
+// Fills Note or NoteRecord values.
+template <typename NoteType>
+void decode_notes(std::span<const char> content,
+                  std::vector<NoteType>& notes) {
+    DynbReader in(content);
+    const auto count = in.get<uint64_t>();
+    // Every note takes at least six bytes.
+    if (count > in.remaining() / 6) {
+        throw_corrupted("invalid note count");
+    }
+    notes.assign(count, NoteType{});
+    for (auto& note : notes) {
+        note.side = in.get<uint8_t>();
+    }
+    for (auto& note : notes) {
+        note.type = in.get<uint8_t>();
+    }
+    int64_t time = 0;
+    for (auto& note : notes) {
+        time += in.get_signed();
+        note.time = time / DYNB_TIME_SCALE;
+    }
+    for (auto& note : notes) {
+        note.lastTime = in.get_signed() / DYNB_TIME_SCALE;
+    }
+    for (auto& note : notes) {
+        note.width = in.get_signed() / DYNB_LANE_SCALE;
+    }
+    for (auto& note : notes) {
+        note.position = in.get_signed() / DYNB_LANE_SCALE;
+    }
+}
+
+std::vector<char> encode_timing_points(const std::vector<TimingPoint>& points) {
+    DynbWriter out;
+    out.put<uint64_t>(points.size());
+    for (const auto& point : points) {
+        out.put(point.time);
+        out.put(point.beatLength);
+        out.put<int32_t>(point.meter);
+    }
+    return std::move(out.bytes);
+}
+
+void decode_timing_points(std::span<const char> content,
+                          std::vector<TimingPoint>& points) {
+    DynbReader in(content);
+    const auto count = in.get<uint64_t>();
+    if (count > in.remaining() / 20) {
+        throw_corrupted("invalid timing point count");
+    }
+    points.resize(count);
+    for (auto& point : points) {
+        point.time = in.get<double>();
+        point.beatLength = in.get<double>();
+        point.meter = in.get<int32_t>();
+    }
+}
+
+void check_compress_result(size_t result) {
+    if (ZSTD_isError(result)) {
+        throw std::runtime_error(string("Error compressing project data: ") +
+                                 ZSTD_getErrorName(result));
+    }
+}
+
+struct PendingSection {
+    DynbSectionEntry entry;
+    std::vector<char> stored;
+};
+
+// Reads the header and section table of a DYNB file, checking that every
+// section lies within it.
+std::vector<DynbSectionEntry> read_dynb_section_table(
+    std::span<const char> data) {
+    if (data.size() < sizeof(DynbHeader)) {
+        throw_corrupted("missing header");
+    }
+    DynbReader in(data);
+    const auto header = in.get<DynbHeader>();
+    if (std::memcmp(header.magic, DYNB_MAGIC, sizeof(DYNB_MAGIC)) != 0) {
+        throw_corrupted("bad magic");
+    }
+    if (header.formatVersion > DYNB_FILE_FORMAT_VERSION) {
+        throw std::runtime_error(
+            "This DYNB file was saved by a newer version of DyNode.");
+    }
+    if (header.sectionCount > in.remaining() / sizeof(DynbSectionEntry)) {
+        throw_corrupted("section table is truncated");
+    }
+    std::vector<DynbSectionEntry> entries(header.sectionCount);
+    for (auto& entry : entries) {
+        entry = in.get<DynbSectionEntry>();
+        if (entry.offset > data.size() ||
+            entry.storedSize > data.size() - entry.offset ||
+            entry.rawSize > DYNB_MAX_SECTION_SIZE) {
+            throw_corrupted("section out of bounds");
+        }
+    }
+    return entries;
+}
+
+// Decodes sections and checks them against their checksums. The returned
+// content is valid until the next call.
+class DynbSectionDecoder {
+   public:
+    DynbSectionDecoder() : dctx(ZSTD_createDCtx(), &ZSTD_freeDCtx) {
+        if (!dctx) {
+            throw std::runtime_error(
+                "Error creating the decompression context.");
+        }
+    }
+
+    std::span<const char> decode(const DynbSectionEntry& entry,
+                                 std::span<const char> stored) {
+        // Stored sections are read straight from the input.
+        std::span<const char> content;
+        switch (entry.codec) {
+            case DYNB_CODEC::STORED:
+                if (entry.storedSize != entry.rawSize) {
+                    throw_corrupted("invalid stored section");
+                }
+                content = stored;
+                break;
+            case DYNB_CODEC::ZSTD:
+            case DYNB_CODEC::ZSTD_DICTIONARY: {
+                buffer.resize(entry.rawSize);
+                const auto dictionary =
+                    entry.codec == DYNB_CODEC::ZSTD_DICTIONARY
+                        ? DYNB_DICTIONARY
+                        : std::string_view();
+                const size_t size = ZSTD_decompress_usingDict(
+                    dctx.get(), buffer.data(), buffer.size(), stored.data(),
+                    stored.size(), dictionary.data(), dictionary.size());
+                if (ZSTD_isError(size) || size != entry.rawSize) {
+                    throw_corrupted("section does not decompress");
+                }
+                content = buffer;
+                break;
+            }
+            default:
+                throw_corrupted("unknown section codec");
+        }
+        if (XXH3_64bits(content.data(), content.size()) != entry.checksum) {
+            throw_corrupted("section checksum mismatch");
+        }
+        return content;
+    }
+
+   private:
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx;
+    std::vector<char> buffer;
+};
+
+// Calls visit with each section entry of a DYNB file and its decoded
+// content, in file order. Throws if the file is damaged.
+template <typename Visitor>
+void for_each_dynb_section(std::span<const char> data, Visitor&& visit) {
+    DynbSectionDecoder decoder;
+    for (const auto& entry : read_dynb_section_table(data)) {
+        visit(entry, decoder.decode(
+                         entry, data.subspan(entry.offset, entry.storedSize)));
+    }
+}
+
+PendingSection make_stored_section(DYNB_SECTION type, size_t chart,
+                                   std::vector<char> content) {
+    DynbSectionEntry entry{.type = type,
+                           .chart = static_cast<uint32_t>(chart),
+                           .codec = DYNB_CODEC::STORED,
+                           .reserved = 0,
+                           .offset = 0,
+                           .storedSize = content.size(),
+                           .rawSize = content.size(),
+                           .checksum =
+                               XXH3_64bits(content.data(), content.size())};
+    return {entry, std::move(content)};
+}
+
+// Compresses the stored sections, unless options.level is 0, and writes
+// them out as a DYNB file.
+DynExportResult write_dynb_file(std::vector<PendingSection>& sections,
+                                DynExportResult result,
+                                ZstdCompressOptions options,
+                                const DynChunkWriter& write) {
+    if (options.level > 0) {
+        auto lease = acquire_compress_context(options, result.contentSize);
+        std::vector<char> compressed, withDictionary;
+        for (auto& section : sections) {
+            const auto& content = section.stored;
+            compressed.resize(ZSTD_compressBound(content.size()));
+            size_t size =
+                ZSTD_compress2(lease.get(), compressed.data(),
+                               compressed.size(), content.data(),
+                               content.size());
+            check_compress_result(size);
+            compressed.resize(size);
+            auto codec = DYNB_CODEC::ZSTD;
+
+            if (options.smallDataDictionary &&
+                content.size() <= DYNB_DICTIONARY_MAX_SECTION_SIZE) {
+                withDictionary.resize(ZSTD_compressBound(content.size()));
+                // The prefix applies to the next frame only.
+                check_compress_result(ZSTD_CCtx_refPrefix(
+                    lease.get(), DYNB_DICTIONARY.data(),
+                    DYNB_DICTIONARY.size()));
+                size = ZSTD_compress2(lease.get(), withDictionary.data(),
+                                      withDictionary.size(), content.data(),
+                                      content.size());
+                check_compress_result(size);
+                if (size < compressed.size()) {
+                    withDictionary.resize(size);
+                    std::swap(compressed, withDictionary);
+                    codec = DYNB_CODEC::ZSTD_DICTIONARY;
+                }
+            }
+            section.entry.codec = codec;
+            section.entry.storedSize = compressed.size();
+            section.stored.assign(compressed.begin(), compressed.end());
+        }
+    }
+
+    uint64_t offset =
+        sizeof(DynbHeader) + sections.size() * sizeof(DynbSectionEntry);
+    for (auto& section : sections) {
+        section.entry.offset = offset;
+        offset += section.stored.size();
+    }
+
+    std::unique_ptr<XXH3_state_t, decltype(&XXH3_freeState)> hashState(
+        XXH3_createState(), &XXH3_freeState);
+    if (!hashState || XXH3_64bits_reset(hashState.get()) != XXH_OK) {
+        throw std::runtime_error("Error creating the checksum state.");
+    }
+    auto emit = [&](const void* data, size_t size) {
+        XXH3_64bits_update(hashState.get(), data, size);
+        write(static_cast<const char*>(data), size);
+        result.fileSize += size;
+    };
+
+    DynbHeader header{.formatVersion = DYNB_FILE_FORMAT_VERSION,
+                      .reserved = 0,
+                      .sectionCount = static_cast<uint32_t>(sections.size()),
+                      .reserved2 = 0};
+    std::memcpy(header.magic, DYNB_MAGIC, sizeof(DYNB_MAGIC));
+    emit(&header, sizeof(header));
+    for (const auto& section : sections) {
+        emit(&section.entry, sizeof(section.entry));
+    }
+    for (const auto& section : sections) {
+        emit(section.stored.data(), section.stored.size());
+    }
+    result.checksum = XXH3_64bits_digest(hashState.get());
+    return result;
+}
+
+}  // namespace
+
+bool is_dynb_file(const char* filePath) {
+    std::ifstream stream(convert_char_to_path(filePath), std::ios::binary);
+    char magic[sizeof(DYNB_MAGIC)] = {};
+    stream.read(magic, sizeof(magic));
+    return is_dynb_data({magic, static_cast<size_t>(stream.gcount())});
+}
+
+bool is_dynb_data(std::span<const char> data) {
+    return data.size() >= sizeof(DYNB_MAGIC) &&
+           std::memcmp(data.data(), DYNB_MAGIC, sizeof(DYNB_MAGIC)) == 0;
+}
+
+DynExportResult project_export_dynb(const ProjectSnapshot& project,
+                                    ZstdCompressOptions options,
+                                    const DynChunkWriter& write) {
+    options.level = std::clamp(options.level, 0, ZSTD_maxCLevel());
+
+    DynExportResult result;
+    std::vector<PendingSection> sections;
+    auto add_section = [&](DYNB_SECTION type, size_t chart,
+                           std::vector<char> content) {
+        result.contentSize += content.size();
+        sections.push_back(
+            make_stored_section(type, chart, std::move(content)));
+    };
+
+    add_section(DYNB_SECTION::PROJECT, 0,
+                json_bytes({{"version", project.version},
+                            {"metadata", project.metadata}}));
+    LazyChartScratch scratch;
+    for (size_t i = 0; i < project.charts.size(); ++i) {
+        const auto& chart = project.charts[i];
+        const auto content = resolve_chart_snapshot(chart, scratch);
+        add_section(DYNB_SECTION::CHART, i,
+                    json_bytes({{"metadata", chart.metadata},
+                                {"path", chart.path}}));
+        add_section(DYNB_SECTION::NOTES, i, encode_notes(*content.notes));
+        add_section(DYNB_SECTION::TIMING, i,
+                    encode_timing_points(*content.timingPoints));
+    }
+
+    return write_dynb_file(sections, result, options, write);
+}
+
+int project_import_dynb(const char* filePath, Project& project,
+                        bool lazyCharts) {
+    MappedFile file;
+    try {
+        file = MappedFile(convert_char_to_path(filePath));
+    } catch (const std::system_error& e) {
+        print_debug_message("Failed to open DYNB file: " + string(filePath) +
+                            ". " + e.what());
+        return -1;
+    }
+    print_debug_message("Mapped DYNB file: " + string(filePath));
+
+    const auto data = file.data();
+    project = Project();
+    // The note and timing sections of each chart, still encoded, when
+    // loading lazily.
+    std::vector<std::vector<PendingSection>> deferred;
+    DynbSectionDecoder decoder;
+    for (const auto& entry : read_dynb_section_table(data)) {
+        const auto stored = data.subspan(entry.offset, entry.storedSize);
+        // Charts come in order, each before its notes and timing points.
+        auto section_chart = [&]() -> Chart& {
+            if (entry.chart >= project.charts.size()) {
+                throw_corrupted("sections out of order");
+            }
+            return project.charts[entry.chart];
+        };
+        if (lazyCharts && (entry.type == DYNB_SECTION::NOTES ||
+                           entry.type == DYNB_SECTION::TIMING)) {
+            section_chart();
+            deferred[entry.chart].push_back(
+                {entry, std::vector<char>(stored.begin(), stored.end())});
+            continue;
+        }
+
+        const auto content = decoder.decode(entry, stored);
+        switch (entry.type) {
+            case DYNB_SECTION::PROJECT: {
+                const auto j = json::parse(content.begin(), content.end());
+                j.at("version").get_to(project.version);
+                j.at("metadata").get_to(project.metadata);
+                break;
+            }
+            case DYNB_SECTION::CHART: {
+                if (entry.chart != project.charts.size()) {
+                    throw_corrupted("sections out of order");
+                }
+                const auto j = json::parse(content.begin(), content.end());
+                auto& chart = project.charts.emplace_back();
+                j.at("metadata").get_to(chart.metadata);
+                j.at("path").get_to(chart.path);
+                deferred.emplace_back();
+                break;
+            }
+            case DYNB_SECTION::NOTES:
+                decode_notes(content, section_chart().notes);
+                break;
+            case DYNB_SECTION::TIMING:
+                decode_timing_points(content, section_chart().timingPoints);
+                break;
+            default:
+                // Sections added by later versions are skipped.
+                break;
+        }
+    }
+
+    if (lazyCharts) {
+        for (size_t i = 0; i < project.charts.size(); ++i) {
+            project.charts[i].lazyContent = std::make_shared<
+                LazyChartContent>([sections = std::move(deferred[i])](
+                                  LazyChartScratch*) {
+                ChartContent content;
+                DynbSectionDecoder decoder;
+                for (const auto& section : sections) {
+                    const auto decoded =
+                        decoder.decode(section.entry, section.stored);
+                    if (section.entry.type == DYNB_SECTION::NOTES) {
+                        decode_notes(decoded, content.notes);
+                    } else {
+                        decode_timing_points(decoded, content.timingPoints);
+                    }
+                }
+                return content;
+            });
+        }
+    }
+
+    print_debug_message("Decoded DYNB file with " +
+                        std::to_string(project.charts.size()) + " charts.");
+    return 0;
+}
+
+DynExportResult project_export_dynb_content(std::span<const char> file,
+                                            ZstdCompressOptions options,
+                                            const DynChunkWriter& write) {
+    options.level = std::clamp(options.level, 0, ZSTD_maxCLevel());
+
+    DynExportResult result;
+    std::vector<PendingSection> sections;
+    for_each_dynb_section(file, [&](const DynbSectionEntry& entry,
+                                    std::span<const char> content) {
+        result.contentSize += content.size();
+        sections.push_back(make_stored_section(
+            entry.type, entry.chart,
+            std::vector<char>(content.begin(), content.end())));
+    });
+    return write_dynb_file(sections, result, options, write);
+}
+
+void verify_dynb_file(std::span<const char> file,
+                      const DynExportResult& expected) {
+    uint64_t contentSize = 0;
+    for_each_dynb_section(file, [&](const DynbSectionEntry&,
+                                    std::span<const char> content) {
+        contentSize += content.size();
+    });
+    if (contentSize != expected.contentSize) {
+        throw_corrupted("content size mismatch");
+    }
+}
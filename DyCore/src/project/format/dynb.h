@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "dyn.h"
+#include "project.h"
+
+// Binary project container, saved for paths ending in DYNB_FILE_EXTENSION.
+//
+// A header and a section table are followed by the sections, each one its
+// own zstd frame (or stored as is at compression level 0) with an XXH3
+// checksum of its content. Small sections may be compressed against a
+// built-in dictionary. The project and chart sections hold the same
+// JSON as .dyn; notes are stored column by column, sorted by time, with
+// delta-encoded times. Times and lengths are kept to the microsecond and
+// positions and widths to 1/1000 of a lane.
+inline constexpr int DYNB_FILE_FORMAT_VERSION = 1;
+inline constexpr const char* DYNB_FILE_EXTENSION = ".dynb";
+// Ticks per millisecond for times and lengths, and per lane unit for
+// positions and widths. Values are rounded to the nearest tick.
+inline constexpr double DYNB_TIME_SCALE = 1000.0;
+inline constexpr double DYNB_LANE_SCALE = 1000.0;
+
+bool is_dynb_file(const char* filePath);
+// Whether the data starts like a DYNB file.
+bool is_dynb_data(std::span<const char> data);
+
+DynExportResult project_export_dynb(const ProjectSnapshot& project,
+                                    ZstdCompressOptions options,
+                                    const DynChunkWriter& write);
+
+// Writes a DYNB file again with its sections compressed at options.level,
+// or stored as they are at level 0. Throws if the file is damaged.
+DynExportResult project_export_dynb_content(std::span<const char> file,
+                                            ZstdCompressOptions options,
+                                            const DynChunkWriter& write);
+
+// Maps the file and decodes every chart, or with lazyCharts only the
+// project and chart metadata; see project_import_dyn(). Returns -1 if the
+// file cannot be opened; throws if it is not a valid DYNB file.
+int project_import_dynb(const char* filePath, Project& project,
+                        bool lazyCharts = false);
+
+// Decompresses every section of a saved file and checks it against its
+// checksum, without decoding the project. Throws if the file is damaged.
+void verify_dynb_file(std::span<const char> file,
+                      const DynExportResult& expected);
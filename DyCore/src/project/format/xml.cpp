@@ -2,14 +2,26 @@
 #include "xml.h"
 
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
 #include <exception>
 #include <fstream>
+#include <iterator>
+#include <ostream>
 #include <pugixml.hpp>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 #include "dymImportCommon.h"
 #include "gm.h"
+#include "mappedFile.h"
 #include "note.h"
+#include "notePoolManager.h"
 #include "project.h"
 #include "timing.h"
 #include "utils.h"
@@ -41,43 +53,57 @@ int note_type_from_string(const string& type) {
     return -1;
 }
 
-struct XmlImportData {
-    ChartMetadata metaData;
-    double barPerMin = 0;
-    double offset = 0;
-    bool hasTimingData = false;
-    std::vector<DYMNotedata> notes;
-    std::vector<DYMTimingData> timings;
-};
+// Parses a number the way std::stod does, without copying it out of the
+// document.
+double parse_xml_double(const char* text) {
+    while (std::isspace(static_cast<unsigned char>(*text))) {
+        ++text;
+    }
+    if (*text == '+') {
+        ++text;
+    }
+    double value = 0.0;
+    const char* end = text + std::char_traits<char>::length(text);
+    if (std::from_chars(text, end, value).ec != std::errc()) {
+        throw std::invalid_argument("Invalid number in XML: \"" +
+                                    string(text) + "\"");
+    }
+    return value;
+}
 
-XmlImportData parse_standard_format_xml(pugi::xml_node map_root) {
-    XmlImportData importData;
+// Appends "_<side>", which keeps IDs unique across the three sides.
+string make_side_note_id(const char* id, int side) {
+    string result(id);
+    result += '_';
+    result += static_cast<char>('0' + side);
+    return result;
+}
 
-    static const auto import_side_notes = [](pugi::xml_node side_root, int side,
-                                             std::vector<DYMNotedata>& notes) {
-        auto arrNode = side_root.child("m_notes");
-        if (!arrNode)
-            return;
+struct XmlNoteNode {
+    pugi::xml_node node;
+    int side;
+};
 
-        for (auto noteNode : arrNode.children("CMapNoteAsset")) {
-            if (!noteNode.child("m_time") || !noteNode.child("m_id")) {
-                continue;
-            }
+// Converts note nodes into notes, in document order.
+template <typename Convert>
+void convert_note_nodes(const std::vector<XmlNoteNode>& nodes,
+                        std::vector<DYMNotedata>& notes, Convert convert) {
+    notes.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        convert(nodes[i].node, nodes[i].side, notes[i]);
+    }
+}
 
-            DYMNotedata noteData;
-            noteData.id = noteNode.child_value("m_id");
-            noteData.subid = noteNode.child_value("m_subId");
-            noteData.type =
-                note_type_from_string(noteNode.child_value("m_type"));
-            noteData.bar = std::stod(noteNode.child_value("m_time"));
-            noteData.position = std::stod(noteNode.child_value("m_position"));
-            noteData.width = std::stod(noteNode.child_value("m_width"));
+DYMChartData parse_standard_format_xml(pugi::xml_node map_root) {
+    DYMChartData importData;
 
-            noteData.position = noteData.position + noteData.width / 2;
-            noteData.id += "_" + std::to_string(side);
-            noteData.subid += "_" + std::to_string(side);
-            noteData.side = side;
-            notes.push_back(noteData);
+    std::vector<XmlNoteNode> noteNodes;
+    const auto collect_side_notes = [&](pugi::xml_node side_root, int side) {
+        for (auto noteNode :
+             side_root.child("m_notes").children("CMapNoteAsset")) {
+            if (noteNode.child("m_time") && noteNode.child("m_id")) {
+                noteNodes.push_back({noteNode, side});
+            }
         }
     };
 
@@ -90,19 +116,35 @@ XmlImportData parse_standard_format_xml(pugi::xml_node map_root) {
     }
     importData.metaData.title = map_root.child_value("m_path");
 
-    importData.barPerMin = std::stod(map_root.child_value("m_barPerMin"));
-    importData.offset = std::stod(map_root.child_value("m_timeOffset"));
-
-    import_side_notes(map_root.child("m_notes"), 0, importData.notes);
-    import_side_notes(map_root.child("m_notesLeft"), 1, importData.notes);
-    import_side_notes(map_root.child("m_notesRight"), 2, importData.notes);
+    importData.barPerMin =
+        parse_xml_double(map_root.child_value("m_barPerMin"));
+    importData.offset = parse_xml_double(map_root.child_value("m_timeOffset"));
+
+    collect_side_notes(map_root.child("m_notes"), 0);
+    collect_side_notes(map_root.child("m_notesLeft"), 1);
+    collect_side_notes(map_root.child("m_notesRight"), 2);
+    convert_note_nodes(
+        noteNodes, importData.notes,
+        [](pugi::xml_node noteNode, int side, DYMNotedata& noteData) {
+            noteData.id = make_side_note_id(noteNode.child_value("m_id"), side);
+            noteData.subid =
+                make_side_note_id(noteNode.child_value("m_subId"), side);
+            noteData.type =
+                note_type_from_string(noteNode.child_value("m_type"));
+            noteData.bar = parse_xml_double(noteNode.child_value("m_time"));
+            noteData.width = parse_xml_double(noteNode.child_value("m_width"));
+            noteData.position =
+                parse_xml_double(noteNode.child_value("m_position")) +
+                noteData.width / 2;
+            noteData.side = side;
+        });
 
     if (auto timingRootNode =
             map_root.child("m_argument").child("m_bpmchange")) {
         for (auto timingNode : timingRootNode.children("CBpmchange")) {
             importData.timings.push_back({
-                std::stod(timingNode.child_value("m_time")),
-                std::stod(timingNode.child_value("m_value")),
+                parse_xml_double(timingNode.child_value("m_time")),
+                parse_xml_double(timingNode.child_value("m_value")),
             });
             importData.hasTimingData = true;
         }
@@ -116,32 +158,13 @@ XmlImportData parse_standard_format_xml(pugi::xml_node map_root) {
     return importData;
 }
 
-XmlImportData parse_legacy_format_xml(pugi::xml_node map_root) {
-    XmlImportData importData;
-
-    static const auto import_side_notes = [](pugi::xml_node side_root, int side,
-                                             std::vector<DYMNotedata>& notes) {
-        if (!side_root) {
-            return;
-        }
+DYMChartData parse_legacy_format_xml(pugi::xml_node map_root) {
+    DYMChartData importData;
 
+    std::vector<XmlNoteNode> noteNodes;
+    const auto collect_side_notes = [&](pugi::xml_node side_root, int side) {
         for (auto noteNode : side_root.children("Note")) {
-            DYMNotedata noteData;
-            noteData.id = noteNode.attribute("Index").as_string();
-            noteData.subid = noteNode.attribute("SubIndex").as_string();
-            noteData.type =
-                note_type_from_string(noteNode.attribute("Type").as_string());
-
-            noteData.bar = noteNode.attribute("Time").as_double();
-            noteData.position = noteNode.attribute("Position").as_double();
-            noteData.width = noteNode.attribute("Size").as_double();
-
-            noteData.position = noteData.position + noteData.width / 2;
-
-            noteData.id += "_" + std::to_string(side);
-            noteData.subid += "_" + std::to_string(side);
-            noteData.side = side;
-            notes.push_back(noteData);
+            noteNodes.push_back({noteNode, side});
         }
     };
 
@@ -166,24 +189,43 @@ XmlImportData parse_legacy_format_xml(pugi::xml_node map_root) {
     importData.barPerMin = map_root.attribute("BarPerMinute").as_double();
     importData.offset = map_root.attribute("TimeOffset").as_double();
 
-    import_side_notes(map_root.child("Center"), 0, importData.notes);
-    import_side_notes(map_root.child("Left"), 1, importData.notes);
-    import_side_notes(map_root.child("Right"), 2, importData.notes);
+    collect_side_notes(map_root.child("Center"), 0);
+    collect_side_notes(map_root.child("Left"), 1);
+    collect_side_notes(map_root.child("Right"), 2);
+    convert_note_nodes(
+        noteNodes, importData.notes,
+        [](pugi::xml_node noteNode, int side, DYMNotedata& noteData) {
+            noteData.id = make_side_note_id(
+                noteNode.attribute("Index").as_string(), side);
+            noteData.subid = make_side_note_id(
+                noteNode.attribute("SubIndex").as_string(), side);
+            noteData.type =
+                note_type_from_string(noteNode.attribute("Type").as_string());
+            noteData.bar = noteNode.attribute("Time").as_double();
+            noteData.width = noteNode.attribute("Size").as_double();
+            noteData.position = noteNode.attribute("Position").as_double() +
+                                noteData.width / 2;
+            noteData.side = side;
+        });
 
     return importData;
 }
 
+// Collects the notes in time order. Each hold is numbered just before its
+// sub note. The pool is kept sorted, so only the sub notes need sorting
+// before the two runs are merged.
 std::vector<ExportNote> collect_export_notes() {
-    std::vector<ExportNote> exportNotes;
-    int noteIndex = 0;
-
-    std::vector<Note> notes;
-    get_notes_array(notes);
-    std::sort(notes.begin(), notes.end(),
-              [](const Note& a, const Note& b) { return a.time < b.time; });
+    auto& pool = get_note_pool_manager();
+    pool.array_sort_request();
 
-    for (const auto& note : notes) {
-        ExportNote en;
+    std::vector<ExportNote> heads, subs;
+    heads.reserve(pool.get_note_count());
+    int noteIndex = 0;
+    pool.for_each_note([&](const Note& note) {
+        if (note.get_note_type() == NOTE_TYPE::SUB) {
+            return;
+        }
+        ExportNote& en = heads.emplace_back();
         en.id = noteIndex++;
         en.time = note.time;
         en.type = note.type;
@@ -192,7 +234,7 @@ std::vector<ExportNote> collect_export_notes() {
         en.side = note.side;
 
         if (note.get_note_type() == NOTE_TYPE::HOLD) {
-            ExportNote subNote;
+            ExportNote& subNote = subs.emplace_back();
             subNote.id = noteIndex++;
             en.subId = subNote.id;
             subNote.time = note.time + note.lastTime;
@@ -200,16 +242,16 @@ std::vector<ExportNote> collect_export_notes() {
             subNote.position = note.position;
             subNote.width = note.width;
             subNote.side = note.side;
-            exportNotes.push_back(subNote);
         }
-        exportNotes.push_back(en);
-    }
-
-    std::sort(exportNotes.begin(), exportNotes.end(),
-              [](const ExportNote& a, const ExportNote& b) {
-                  return a.time < b.time;
-              });
+    });
 
+    const auto by_time = [](const ExportNote& a, const ExportNote& b) {
+        return a.time < b.time;
+    };
+    std::stable_sort(subs.begin(), subs.end(), by_time);
+    std::vector<ExportNote> exportNotes(heads.size() + subs.size());
+    std::merge(heads.begin(), heads.end(), subs.begin(), subs.end(),
+               exportNotes.begin(), by_time);
     return exportNotes;
 }
 
@@ -244,40 +286,37 @@ void apply_note_time_fix(std::vector<ExportNote>& exportNotes,
 class TimeToBarConverter {
    public:
     TimeToBarConverter(bool isDym, double timeOffset, double barPerMin,
-                       const std::vector<TimingPoint>& timingPoints)
+                       const TimingIndex& timingIndex)
         : isDym_(isDym),
           timeOffset_(timeOffset),
           barPerMin_(barPerMin),
-          timingPoints_(timingPoints) {
+          timingIndex_(timingIndex) {
     }
 
-    double operator()(double time) const {
+    // Converts note times into bars. Sorted times walk the timing index once.
+    void operator()(std::span<const double> times,
+                    std::span<double> bars) const {
         if (!isDym_) {
-            return (time + timeOffset_) * barPerMin_ / 60000.0;
+            std::transform(times.begin(), times.end(), bars.begin(),
+                           [this](double time) {
+                               return (time + timeOffset_) * barPerMin_ /
+                                      60000.0;
+                           });
+            return;
         }
 
-        double current_bar = 0;
-        double last_time = timingPoints_[0].time;
-        double last_bpm = timingPoints_[0].get_bpm();
-
-        for (const auto& tp : timingPoints_) {
-            if (time < tp.time) {
-                break;
-            }
-            current_bar += (tp.time - last_time) * (last_bpm / 4.0) / 60000.0;
-            last_time = tp.time;
-            last_bpm = tp.get_bpm();
+        // DYM bars are always four beats long.
+        timingIndex_.convert(times, bars, TIMING_UNIT::MS, TIMING_UNIT::BEAT);
+        for (auto& bar : bars.first(times.size())) {
+            bar /= 4.0;
         }
-
-        current_bar += (time - last_time) * (last_bpm / 4.0) / 60000.0;
-        return current_bar;
     }
 
    private:
     bool isDym_;
     double timeOffset_;
     double barPerMin_;
-    const std::vector<TimingPoint>& timingPoints_;
+    const TimingIndex& timingIndex_;
 };
 
 const char* note_type_to_string(int type) {
@@ -294,77 +333,205 @@ const char* note_type_to_string(int type) {
     return "";
 }
 
-pugi::xml_node get_side_root(int side, pugi::xml_node notes_middle_root,
-                             pugi::xml_node notes_left_root,
-                             pugi::xml_node notes_right_root) {
-    switch (side) {
-        case 0:
-            return notes_middle_root;
-        case 1:
-            return notes_left_root;
-        case 2:
-            return notes_right_root;
+// Writes XML as pugixml saves a document with the default format, one tab
+// per level, without building the document first.
+class XmlChartWriter {
+   public:
+    explicit XmlChartWriter(std::ostream& stream) : stream(stream) {
+        buffer.reserve(XML_EXPORT_BUFFER_SIZE + 4096);
     }
-    return {};
-}
 
-void append_note_nodes(pugi::xml_node root,
-                       const std::vector<ExportNote>& exportNotes,
-                       const TimeToBarConverter& timeToBar) {
-    auto notes_middle_root =
-        root.append_child("m_notes").append_child("m_notes");
-    auto notes_left_root =
-        root.append_child("m_notesLeft").append_child("m_notes");
-    auto notes_right_root =
-        root.append_child("m_notesRight").append_child("m_notes");
+    void raw(std::string_view text) {
+        buffer += text;
+    }
+    void open(std::string_view name, int depth) {
+        start_line(depth);
+        buffer += '<';
+        buffer += name;
+        buffer += ">\n";
+    }
+    void close(std::string_view name, int depth) {
+        start_line(depth);
+        buffer += "</";
+        buffer += name;
+        buffer += ">\n";
+        if (buffer.size() >= XML_EXPORT_BUFFER_SIZE) {
+            flush();
+        }
+    }
+    void empty(std::string_view name, int depth) {
+        start_line(depth);
+        buffer += '<';
+        buffer += name;
+        buffer += " />\n";
+    }
+    void text(std::string_view name, int depth, std::string_view value) {
+        start_element(name, depth);
+        append_escaped(value);
+        end_element(name);
+    }
+    void number(std::string_view name, int depth, double value) {
+        start_element(name, depth);
+        append_double_with_precision(buffer, value, XML_EXPORT_EPS);
+        end_element(name);
+    }
+    void integer(std::string_view name, int depth, int value) {
+        start_element(name, depth);
+        char digits[16];
+        const auto end = std::to_chars(digits, std::end(digits), value).ptr;
+        buffer.append(digits, end);
+        end_element(name);
+    }
 
+    void flush() {
+        stream.write(buffer.data(),
+                     static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+   private:
+    void start_line(int depth) {
+        buffer.append(depth, '\t');
+    }
+    void start_element(std::string_view name, int depth) {
+        start_line(depth);
+        buffer += '<';
+        buffer += name;
+        buffer += '>';
+    }
+    void end_element(std::string_view name) {
+        buffer += "</";
+        buffer += name;
+        buffer += ">\n";
+    }
+    // Escapes text as pugixml does in element content.
+    void append_escaped(std::string_view value) {
+        for (const char c : value) {
+            switch (c) {
+                case '&':
+                    buffer += "&amp;";
+                    break;
+                case '<':
+                    buffer += "&lt;";
+                    break;
+                case '>':
+                    buffer += "&gt;";
+                    break;
+                case '\t':
+                case '\n':
+                case '\r':
+                    buffer += c;
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 32) {
+                        buffer += "&#";
+                        buffer += static_cast<char>('0' + c / 10);
+                        buffer += static_cast<char>('0' + c % 10);
+                        buffer += ';';
+                    } else {
+                        buffer += c;
+                    }
+            }
+        }
+    }
+
+    std::ostream& stream;
+    std::string buffer;
+};
+
+// Writes the notes of each side in time order, converting all note times to
+// bars in one pass.
+void write_note_elements(XmlChartWriter& writer,
+                         const std::vector<ExportNote>& exportNotes,
+                         const TimeToBarConverter& timeToBar) {
+    std::vector<double> noteBars(exportNotes.size());
+    {
+        std::vector<double> noteTimes(exportNotes.size());
+        std::transform(exportNotes.begin(), exportNotes.end(),
+                       noteTimes.begin(),
+                       [](const ExportNote& note) { return note.time; });
+        timeToBar(noteTimes, noteBars);
+    }
+
+    std::array<size_t, 3> sideCounts{};
     for (const auto& note : exportNotes) {
-        auto side_root = get_side_root(note.side, notes_middle_root,
-                                       notes_left_root, notes_right_root);
-
-        auto note_node = side_root.append_child("CMapNoteAsset");
-        note_node.append_child("m_id").text().set(note.id);
-        note_node.append_child("m_type").text().set(
-            note_type_to_string(note.type));
-        note_node.append_child("m_time").text().set(
-            format_double_with_precision(timeToBar(note.time), XML_EXPORT_EPS)
-                .c_str());
-        note_node.append_child("m_position")
-            .text()
-            .set(format_double_with_precision(note.position - note.width / 2.0,
-                                              XML_EXPORT_EPS)
-                     .c_str());
-        note_node.append_child("m_width").text().set(
-            format_double_with_precision(note.width, XML_EXPORT_EPS).c_str());
-        note_node.append_child("m_subId").text().set(note.subId);
+        if (note.side >= 0 && note.side < 3) {
+            ++sideCounts[note.side];
+        }
+    }
+
+    static constexpr std::string_view sideNames[] = {"m_notes", "m_notesLeft",
+                                                     "m_notesRight"};
+    for (int side = 0; side < 3; ++side) {
+        writer.open(sideNames[side], 1);
+        if (sideCounts[side] == 0) {
+            writer.empty("m_notes", 2);
+            writer.close(sideNames[side], 1);
+            continue;
+        }
+        writer.open("m_notes", 2);
+        for (size_t i = 0; i < exportNotes.size(); ++i) {
+            const auto& note = exportNotes[i];
+            if (note.side != side) {
+                continue;
+            }
+            writer.open("CMapNoteAsset", 3);
+            writer.integer("m_id", 4, note.id);
+            writer.text("m_type", 4, note_type_to_string(note.type));
+            writer.number("m_time", 4, noteBars[i]);
+            writer.number("m_position", 4, note.position - note.width / 2.0);
+            writer.number("m_width", 4, note.width);
+            writer.integer("m_subId", 4, note.subId);
+            writer.close("CMapNoteAsset", 3);
+        }
+        writer.close("m_notes", 2);
+        writer.close(sideNames[side], 1);
     }
 }
 
-void append_timing_nodes_for_dym(pugi::xml_node root, bool isDym,
-                                 const std::vector<TimingPoint>& timingPoints) {
+void write_timing_elements_for_dym(XmlChartWriter& writer, bool isDym,
+                                   const TimingIndex& timingIndex) {
     if (!isDym) {
         return;
     }
 
-    auto arg_root = root.append_child("m_argument");
-    auto bpm_root = arg_root.append_child("m_bpmchange");
-
-    double current_bar = 0;
-    double last_time = timingPoints[0].time;
-    double last_bpm = timingPoints[0].get_bpm();
+    writer.open("m_argument", 1);
+    writer.open("m_bpmchange", 2);
+    for (const auto& segment : timingIndex.get_segments()) {
+        writer.open("CBpmchange", 3);
+        writer.number("m_time", 4, segment.beat / 4.0);
+        writer.number("m_value", 4, 60000.0 / segment.beatLength / 4.0);
+        writer.close("CBpmchange", 3);
+    }
+    writer.close("m_bpmchange", 2);
+    writer.close("m_argument", 1);
+}
 
-    for (const auto& tp : timingPoints) {
-        current_bar += (tp.time - last_time) * (last_bpm / 4.0) / 60000.0;
-        last_time = tp.time;
-        last_bpm = tp.get_bpm();
+// Parses the chart in the file, which is mapped copy-on-write so pugixml
+// parses it in place. Throws if the document is not a chart.
+DYMChartData parse_xml_chart(MappedFile file, const char* filePath) {
+    // Embedding the text of elements such as <m_time> in them halves the
+    // nodes of a note; child_value() reads it the same. The document points
+    // into the mapping, which outlives it.
+    pugi::xml_document doc;
+    const auto buffer = file.writable_data();
+    pugi::xml_parse_result result = doc.load_buffer_inplace(
+        buffer.data(), buffer.size(),
+        pugi::parse_default | pugi::parse_embed_pcdata);
+    if (!result) {
+        throw std::runtime_error("Failed to parse XML file: " +
+                                 string(filePath));
+    }
 
-        auto bpm_node = bpm_root.append_child("CBpmchange");
-        bpm_node.append_child("m_time").text().set(
-            format_double_with_precision(current_bar, XML_EXPORT_EPS).c_str());
-        bpm_node.append_child("m_value").text().set(
-            format_double_with_precision(tp.get_bpm() / 4.0, XML_EXPORT_EPS)
-                .c_str());
+    if (auto legacy_map_root = doc.child("DynamixMap")) {
+        return parse_legacy_format_xml(legacy_map_root);
+    }
+    if (auto map_root = doc.child("CMap")) {
+        return parse_standard_format_xml(map_root);
     }
+    throw std::runtime_error(
+        "Invalid XML structure: Missing <CMap> or <DynamixMap> root "
+        "element");
 }
 
 }  // namespace
@@ -372,33 +539,21 @@ void append_timing_nodes_for_dym(pugi::xml_node root, bool isDym,
 IMPORT_XML_RESULT_STATES chart_import_xml(const char* filePath,
                                           bool importMetadata,
                                           bool importTiming) {
-    // Read file into buffer.
-    std::ifstream stream(convert_char_to_path(filePath));
-    if (!stream.is_open()) {
-        print_debug_message("Failed to open XML file: " + string(filePath));
+    MappedFile file;
+    try {
+        file = MappedFile(convert_char_to_path(filePath),
+                          MappedFile::Access::COPY_ON_WRITE);
+    } catch (const std::system_error& e) {
+        print_debug_message("Failed to open XML file: " + string(filePath) +
+                            ". " + e.what());
         return IMPORT_XML_RESULT_STATES::FAILURE;
     }
 
     auto start = std::chrono::high_resolution_clock::now();
 
     try {
-        pugi::xml_document doc;
-        pugi::xml_parse_result result = doc.load(stream);
-        if (!result) {
-            throw std::runtime_error("Failed to parse XML file: " +
-                                     string(filePath));
-        }
-
-        XmlImportData importData;
-        if (auto legacy_map_root = doc.child("DynamixMap")) {
-            importData = parse_legacy_format_xml(legacy_map_root);
-        } else if (auto map_root = doc.child("CMap")) {
-            importData = parse_standard_format_xml(map_root);
-        } else {
-            throw std::runtime_error(
-                "Invalid XML structure: Missing <CMap> or <DynamixMap> root "
-                "element");
-        }
+        DYMChartData importData =
+            parse_xml_chart(std::move(file), filePath);
 
         if (importMetadata) {
             chart_set_metadata(importData.metaData);
@@ -427,67 +582,61 @@ IMPORT_XML_RESULT_STATES chart_import_xml(const char* filePath,
     return IMPORT_XML_RESULT_STATES::SUCCESS;
 }
 
-void chart_export_xml(const char* filePath, bool isDym, double fixError) {
-    const auto& fdwp = format_double_with_precision;
-    pugi::xml_document doc;
-
-    // Prolog
-    auto prolog = doc.append_child(pugi::node_declaration);
-    prolog.append_attribute("version") = "1.0";
-
-    // Root
-    auto root = doc.append_child("CMap");
-    root.append_attribute("xmlns:xsi") =
-        "http://www.w3.org/2001/XMLSchema-instance";
-    root.append_attribute("xmlns:xsd") = "http://www.w3.org/2001/XMLSchema";
+Chart read_xml_chart(const char* filePath) {
+    DYMChartData data =
+        parse_xml_chart(MappedFile(convert_char_to_path(filePath),
+                                   MappedFile::Access::COPY_ON_WRITE),
+                        filePath);
+    return make_imported_chart(data);
+}
 
+void chart_export_xml(const char* filePath, bool isDym, double fixError) {
     // Metadata
     auto chartMetadata = chart_get_metadata();
     auto& timingMan = get_timing_manager();
 
-    std::vector<TimingPoint> timingPoints;
-    timingMan.get_timing_points(timingPoints);
-    auto firstTp = timingPoints[0];
-    double barPerMin = firstTp.get_bpm() / 4.0;
+    const auto& timingIndex = timingMan.get_index();
+    if (timingIndex.empty()) {
+        throw_error_event("Cannot export a chart without timing points.");
+        return;
+    }
+    const auto& firstTp = timingIndex.get_segments()[0];
+    double barPerMin = 60000.0 / firstTp.beatLength / 4.0;
     double timeOffset = -firstTp.time;
     double barOffset = timeOffset * barPerMin / 60000;
 
-    root.append_child("m_path").text().set(chartMetadata.title.c_str());
-    root.append_child("m_barPerMin")
-        .text()
-        .set(fdwp(barPerMin, XML_EXPORT_EPS).c_str());
-    root.append_child("m_timeOffset")
-        .text()
-        .set(fdwp(barOffset, XML_EXPORT_EPS).c_str());
-    root.append_child("m_leftRegion")
-        .text()
-        .set(chartMetadata.sideType[0].c_str());
-    root.append_child("m_rightRegion")
-        .text()
-        .set(chartMetadata.sideType[1].c_str());
-    root.append_child("m_mapID").text().set(
-        ("_map_" + chartMetadata.title + "_" +
-         difficulty_int_to_char(chartMetadata.difficulty))
-            .c_str());
-
-    auto exportNotes = collect_export_notes();
-    apply_note_time_fix(exportNotes, fixError);
-    TimeToBarConverter timeToBar(isDym, timeOffset, barPerMin, timingPoints);
-    append_note_nodes(root, exportNotes, timeToBar);
-    append_timing_nodes_for_dym(root, isDym, timingPoints);
-
-    // Save file
+    // Text mode, as pugixml's save wrote it.
     std::ofstream stream(convert_char_to_path(filePath));
     if (!stream.is_open()) {
         throw_error_event("Failed to open XML file for writing: " +
                           string(filePath));
-    }
-    try {
-        doc.save(stream);
-    } catch (const std::exception& e) {
-        throw_error_event("Failed to save XML file to " + string(filePath) +
-                          ": " + e.what());
+        return;
     }
 
+    XmlChartWriter writer(stream);
+    writer.raw(
+        "<?xml version=\"1.0\"?>\n"
+        "<CMap xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+        "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\">\n");
+    writer.text("m_path", 1, chartMetadata.title);
+    writer.number("m_barPerMin", 1, barPerMin);
+    writer.number("m_timeOffset", 1, barOffset);
+    writer.text("m_leftRegion", 1, chartMetadata.sideType[0]);
+    writer.text("m_rightRegion", 1, chartMetadata.sideType[1]);
+    writer.text("m_mapID", 1,
+                "_map_" + chartMetadata.title + "_" +
+                    difficulty_int_to_char(chartMetadata.difficulty));
+
+    auto exportNotes = collect_export_notes();
+    apply_note_time_fix(exportNotes, fixError);
+    TimeToBarConverter timeToBar(isDym, timeOffset, barPerMin, timingIndex);
+    write_note_elements(writer, exportNotes, timeToBar);
+    write_timing_elements_for_dym(writer, isDym, timingIndex);
+    writer.raw("</CMap>\n");
+    writer.flush();
+
     stream.close();
+    if (!stream) {
+        throw_error_event("Failed to save XML file to " + string(filePath));
+    }
 }
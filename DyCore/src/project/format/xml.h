@@ -1,8 +1,17 @@
 #pragma once
 
+#include <cstddef>
+
+#include "project.h"
+
 inline constexpr int XML_EXPORT_EPS = 6;
+// The exporter writes to the file whenever this much text is buffered.
+inline constexpr size_t XML_EXPORT_BUFFER_SIZE = 1024 * 1024;
 
 enum class IMPORT_XML_RESULT_STATES { SUCCESS, FAILURE, OLD_FORMAT };
 IMPORT_XML_RESULT_STATES chart_import_xml(const char* filePath, bool importInfo,
                                           bool importTiming);
+// Reads an XML chart into a Chart, leaving the current chart alone. Throws
+// if the file cannot be read or is not a chart.
+Chart read_xml_chart(const char* filePath);
 void chart_export_xml(const char* filePath, bool isDym, double fixError);
@@ -0,0 +1,919 @@
+#include "journal.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include "compress.h"
+#include "mappedFile.h"
+#include "projectManager.h"
+#include "utils.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char JOURNAL_MAGIC[4] = {'D', 'Y', 'N', 'J'};
+// Saved times and lanes may be rounded to this (DYNB keeps microseconds
+// and 1/1000 lane), so replay matches fields within it.
+constexpr double JOURNAL_MATCH_TOLERANCE = 1e-3;
+constexpr intptr_t JOURNAL_NO_FILE = -1;
+constexpr int JOURNAL_COMPRESSION_LEVEL = 1;
+
+enum class JOURNAL_RECORD : uint32_t {
+    NOTE_CHANGE = 1,
+    NOTES_CLEARED,
+    TIMING,
+    NOTES_LOADED,
+    // Tagged with the index of the first chart appended.
+    CHARTS_APPENDED
+};
+
+struct JournalHeader {
+    char magic[4];
+    uint16_t formatVersion;
+    uint16_t reserved;
+    uint32_t reserved2;
+    uint32_t reserved3;
+    uint64_t baseFileSize;
+    XXH64_hash_t baseChecksum;
+};
+
+struct JournalRecordHeader {
+    JOURNAL_RECORD type;
+    uint32_t size;
+    int32_t chart;  // Index of the chart the edit was made on.
+    uint32_t reserved;
+    // XXH3 of the payload, seeded with the type and the chart.
+    XXH64_hash_t checksum;
+};
+
+XXH64_hash_t record_checksum(JOURNAL_RECORD type, int32_t chart,
+                             const char* data, size_t size) {
+    const uint64_t seed = static_cast<uint64_t>(type) |
+                          static_cast<uint64_t>(static_cast<uint32_t>(chart))
+                              << 32;
+    return XXH3_64bits_withSeed(data, size, seed);
+}
+
+// Depth of ProjectJournalPause on this thread.
+thread_local int journalPauseDepth = 0;
+
+// =============================================================================
+// Files
+// =============================================================================
+
+#ifdef _WIN32
+[[noreturn]] void throw_journal_error(const char* message) {
+    throw std::system_error(static_cast<int>(GetLastError()),
+                            std::system_category(), message);
+}
+
+HANDLE to_handle(intptr_t file) {
+    return reinterpret_cast<HANDLE>(file);
+}
+#else
+[[noreturn]] void throw_journal_error(const char* message) {
+    throw std::system_error(errno, std::generic_category(), message);
+}
+#endif
+
+intptr_t open_for_append(const fs::path& path) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.wstring().c_str(), FILE_APPEND_DATA,
+                                FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw_journal_error("Error opening journal.");
+    }
+    return reinterpret_cast<intptr_t>(handle);
+#else
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw_journal_error("Error opening journal.");
+    }
+    return fd;
+#endif
+}
+
+void write_all(intptr_t file, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        const DWORD chunkSize =
+            static_cast<DWORD>(std::min<size_t>(size, MAXDWORD));
+        DWORD count = 0;
+        if (!WriteFile(to_handle(file), data, chunkSize, &count, nullptr) ||
+            count == 0) {
+            throw_journal_error("Error writing journal.");
+        }
+#else
+        const ssize_t count = ::write(static_cast<int>(file), data, size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_journal_error("Error writing journal.");
+        }
+#endif
+        data += count;
+        size -= static_cast<size_t>(count);
+    }
+}
+
+void sync_file(intptr_t file) {
+#ifdef _WIN32
+    if (!FlushFileBuffers(to_handle(file))) {
+        throw_journal_error("Error syncing journal.");
+    }
+#else
+    if (::fsync(static_cast<int>(file)) != 0) {
+        throw_journal_error("Error syncing journal.");
+    }
+#endif
+}
+
+void close_handle(intptr_t file) {
+#ifdef _WIN32
+    CloseHandle(to_handle(file));
+#else
+    ::close(static_cast<int>(file));
+#endif
+}
+
+void replace_file(const fs::path& from, const fs::path& to) {
+#ifdef _WIN32
+    if (!MoveFileExW(from.wstring().c_str(), to.wstring().c_str(),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        throw_journal_error("Error replacing journal.");
+    }
+#else
+    fs::rename(from, to);
+#endif
+}
+
+// Writes a journal holding records, against base, and returns it opened
+// for appending. The file is replaced in one step.
+intptr_t write_journal(const fs::path& path, const ProjectJournalBase& base,
+                       std::span<const char> records) {
+    JournalHeader header{.formatVersion = PROJECT_JOURNAL_FORMAT_VERSION,
+                         .reserved = 0,
+                         .reserved2 = 0,
+                         .reserved3 = 0,
+                         .baseFileSize = base.fileSize,
+                         .baseChecksum = base.checksum};
+    std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+
+    fs::path tempPath = path;
+    tempPath += ".tmp";
+    std::error_code ec;
+    fs::remove(tempPath, ec);
+    const intptr_t temp = open_for_append(tempPath);
+    try {
+        write_all(temp, reinterpret_cast<const char*>(&header),
+                  sizeof(header));
+        write_all(temp, records.data(), records.size());
+        sync_file(temp);
+    } catch (...) {
+        close_handle(temp);
+        fs::remove(tempPath, ec);
+        throw;
+    }
+    close_handle(temp);
+    replace_file(tempPath, path);
+    return open_for_append(path);
+}
+
+// The intact records of the journal at path, if it was written against
+// base. Reading stops at the first torn or corrupted record.
+std::optional<std::vector<char>> read_journal_records(
+    const fs::path& path, const ProjectJournalBase& base) {
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
+        return std::nullopt;
+    }
+    MappedFile file;
+    try {
+        file = MappedFile(path);
+    } catch (const std::system_error& e) {
+        print_debug_message("Failed to open journal: " + std::string(e.what()));
+        return std::nullopt;
+    }
+    const auto data = file.data();
+    JournalHeader header;
+    if (data.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        header.formatVersion != PROJECT_JOURNAL_FORMAT_VERSION) {
+        print_debug_message("Ignoring a journal of an unknown format.");
+        return std::nullopt;
+    }
+    if (header.baseFileSize != base.fileSize ||
+        header.baseChecksum != base.checksum) {
+        print_debug_message(
+            "Ignoring a journal written for another version of the project.");
+        return std::nullopt;
+    }
+
+    auto records = data.subspan(sizeof(header));
+    size_t valid = 0;
+    while (records.size() - valid >= sizeof(JournalRecordHeader)) {
+        JournalRecordHeader record;
+        std::memcpy(&record, records.data() + valid, sizeof(record));
+        const size_t remaining =
+            records.size() - valid - sizeof(JournalRecordHeader);
+        if (record.size > remaining ||
+            record_checksum(record.type, record.chart,
+                            records.data() + valid + sizeof(record),
+                            record.size) != record.checksum) {
+            print_debug_message("Journal ends with a damaged record.");
+            break;
+        }
+        valid += sizeof(record) + record.size;
+    }
+    return std::vector<char>(records.begin(), records.begin() + valid);
+}
+
+// =============================================================================
+// Records
+// =============================================================================
+
+class JournalWriter {
+   public:
+    template <typename T>
+        requires(std::is_trivially_copyable_v<T>)
+    void put(const T& value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void put(const std::string& text) {
+        put(static_cast<uint32_t>(text.size()));
+        data.insert(data.end(), text.begin(), text.end());
+    }
+
+    void put(const Note& note) {
+        put(static_cast<int32_t>(note.side));
+        put(static_cast<int32_t>(note.type));
+        put(note.time);
+        put(note.width);
+        put(note.position);
+        put(note.lastTime);
+        put(note.beginTime);
+        put(note.noteID);
+        put(note.subNoteID);
+    }
+
+    std::vector<char> data;
+};
+
+// Appends raw to out compressed. Logs and returns false on failure.
+bool put_compressed(JournalWriter& out, std::span<const char> raw) {
+    const size_t headerSize = out.data.size();
+    out.data.resize(headerSize + ZSTD_compressBound(raw.size()));
+    const size_t packedSize =
+        ZSTD_compress(out.data.data() + headerSize,
+                      out.data.size() - headerSize, raw.data(), raw.size(),
+                      JOURNAL_COMPRESSION_LEVEL);
+    if (ZSTD_isError(packedSize)) {
+        print_debug_message("Failed to compress journal record: " +
+                            std::string(ZSTD_getErrorName(packedSize)));
+        return false;
+    }
+    out.data.resize(headerSize + packedSize);
+    return true;
+}
+
+class JournalReader {
+   public:
+    explicit JournalReader(std::span<const char> data) : data(data) {
+    }
+
+    template <typename T>
+        requires(std::is_trivially_copyable_v<T>)
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string get_string() {
+        const auto size = get<uint32_t>();
+        return std::string(take(size), size);
+    }
+
+    // The bytes not read yet, which are consumed.
+    std::span<const char> get_rest() {
+        const size_t size = data.size() - offset;
+        return {take(size), size};
+    }
+
+    Note get_note() {
+        Note note{};
+        note.side = get<int32_t>();
+        note.type = get<int32_t>();
+        note.time = get<double>();
+        note.width = get<double>();
+        note.position = get<double>();
+        note.lastTime = get<double>();
+        note.beginTime = get<double>();
+        note.noteID = get_string();
+        note.subNoteID = get_string();
+        return note;
+    }
+
+   private:
+    const char* take(size_t size) {
+        if (size > data.size() - offset) {
+            throw std::runtime_error("Journal record is truncated.");
+        }
+        const char* begin = data.data() + offset;
+        offset += size;
+        return begin;
+    }
+
+    std::span<const char> data;
+    size_t offset = 0;
+};
+
+bool near(double a, double b) {
+    return std::abs(a - b) <= JOURNAL_MATCH_TOLERANCE;
+}
+
+bool has_partner(const Note& note) {
+    return note.get_note_type() == NOTE_TYPE::HOLD ||
+           note.get_note_type() == NOTE_TYPE::SUB;
+}
+
+// Applies records to the note pool and timing manager. Notes loaded from
+// the file got new IDs, so the first record about one finds it by its
+// fields and remembers the ID it now has. Records of another chart than the
+// selected one select theirs first, keeping the edits made so far in the
+// chart left, as switching charts in the editor does.
+class JournalReplayer {
+   public:
+    JournalReplayer() : selectedChart(manager.get_current_chart_index()) {
+        originalChart = selectedChart;
+    }
+
+    bool apply(JOURNAL_RECORD type, int chart, JournalReader& in) {
+        if (type == JOURNAL_RECORD::CHARTS_APPENDED) {
+            return apply_charts_appended(chart, in);
+        }
+        if (!select_chart(chart)) {
+            return false;
+        }
+        switch (type) {
+            case JOURNAL_RECORD::NOTE_CHANGE: {
+                const auto hasBefore = in.get<uint8_t>();
+                const auto hasAfter = in.get<uint8_t>();
+                std::optional<Note> before, after;
+                if (hasBefore) {
+                    before = in.get_note();
+                }
+                if (hasAfter) {
+                    after = in.get_note();
+                }
+                return apply_note_change(before, after);
+            }
+            case JOURNAL_RECORD::NOTES_CLEARED: {
+                pool.clear_notes();
+                auto& state = charts[selectedChart];
+                state.loadedNotes.clear();
+                state.indexed = true;
+                state.idMap.clear();
+                return true;
+            }
+            case JOURNAL_RECORD::NOTES_LOADED:
+                return apply_notes_loaded(in);
+            case JOURNAL_RECORD::TIMING: {
+                std::vector<TimingPoint> points(in.get<uint32_t>());
+                for (auto& point : points) {
+                    point.time = in.get<double>();
+                    point.beatLength = in.get<double>();
+                    point.meter = in.get<int32_t>();
+                }
+                auto& timing = get_timing_manager();
+                timing.clear();
+                timing.append_timing_points(points);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // Selects the chart that was selected before replay.
+    void finish() {
+        if (originalChart >= 0) {
+            select_chart(originalChart);
+        }
+    }
+
+   private:
+    // What replay knows about the notes of one chart.
+    struct ChartState {
+        // Loaded notes no record has referred to yet, by time.
+        std::multimap<double, Note> loadedNotes;
+        bool indexed = false;
+        // Note IDs in the journal to their IDs now.
+        std::unordered_map<std::string, std::string> idMap;
+    };
+
+    bool select_chart(int chart) {
+        if (chart == selectedChart) {
+            return true;
+        }
+        // Charts added after the save are not in the file.
+        if (chart < 0 || chart >= manager.get_chart_count()) {
+            return false;
+        }
+        manager.update_current_chart();
+        manager.set_current_chart(chart);
+        selectedChart = chart;
+        return true;
+    }
+
+    // Only appends onto the charts the project had when they were appended,
+    // so records of other charts keep their indices.
+    bool apply_charts_appended(int firstIndex, JournalReader& in) {
+        if (firstIndex != manager.get_chart_count()) {
+            return false;
+        }
+        const auto list =
+            nlohmann::json::parse(decompress_to_string(in.get_rest()));
+        manager.append_charts(list.get<std::vector<Chart>>());
+        return true;
+    }
+
+    bool apply_notes_loaded(JournalReader& in) {
+        std::vector<Note> notes(in.get<uint32_t>());
+        const std::string raw = decompress_to_string(in.get_rest());
+        JournalReader notesIn(raw);
+        for (auto& note : notes) {
+            note = notesIn.get_note();
+        }
+        pool.bulk_load(notes);
+
+        // The sub notes were created anew, so later records about a hold
+        // name a sub note that no longer exists.
+        auto& idMap = charts[selectedChart].idMap;
+        for (const auto& note : notes) {
+            if (note.get_note_type() != NOTE_TYPE::HOLD ||
+                !pool.note_exists(note.noteID)) {
+                continue;
+            }
+            const auto& loaded = pool.get_note(note.noteID);
+            if (loaded.subNoteID != note.subNoteID) {
+                idMap[note.subNoteID] = loaded.subNoteID;
+            }
+        }
+        return true;
+    }
+
+    bool apply_note_change(const std::optional<Note>& before,
+                           const std::optional<Note>& after) {
+        if (!after) {
+            const auto id = before ? resolve(*before) : std::nullopt;
+            return id && pool.release_note(*id);
+        }
+
+        Note note = *after;
+        note.subNoteID = map_id(note.subNoteID);
+        if (before) {
+            const auto id = resolve(*before);
+            if (!id) {
+                return false;
+            }
+            note.noteID = *id;
+        }
+        if (!pool.note_exists(note.noteID)) {
+            return pool.create_note(note);
+        }
+        // Edits of a hold or sub note update its partner, which must exist.
+        if (has_partner(note) && !pool.note_exists(note.subNoteID)) {
+            return false;
+        }
+        pool.set_note(note);
+        return true;
+    }
+
+    std::string map_id(const std::string& id) {
+        const auto& idMap = charts[selectedChart].idMap;
+        const auto it = idMap.find(id);
+        return it == idMap.end() ? id : it->second;
+    }
+
+    std::optional<std::string> resolve(const Note& note) {
+        auto& state = charts[selectedChart];
+        const auto mapped = state.idMap.find(note.noteID);
+        if (mapped != state.idMap.end()) {
+            return mapped->second;
+        }
+        if (pool.note_exists(note.noteID)) {
+            return note.noteID;
+        }
+
+        index_loaded_notes(state);
+        auto& loadedNotes = state.loadedNotes;
+        auto it = loadedNotes.lower_bound(note.time - JOURNAL_MATCH_TOLERANCE);
+        for (; it != loadedNotes.end() &&
+               it->first <= note.time + JOURNAL_MATCH_TOLERANCE;
+             ++it) {
+            const Note& loaded = it->second;
+            if (loaded.side != note.side || loaded.type != note.type ||
+                !near(loaded.width, note.width) ||
+                !near(loaded.position, note.position) ||
+                !near(loaded.lastTime, note.lastTime)) {
+                continue;
+            }
+            state.idMap[note.noteID] = loaded.noteID;
+            if (has_partner(note)) {
+                state.idMap[note.subNoteID] = loaded.subNoteID;
+            }
+            std::string id = loaded.noteID;
+            loadedNotes.erase(it);
+            return id;
+        }
+        return std::nullopt;
+    }
+
+    void index_loaded_notes(ChartState& state) {
+        if (state.indexed) {
+            return;
+        }
+        pool.for_each_note([&](const Note& note) {
+            state.loadedNotes.emplace(note.time, note);
+        });
+        state.indexed = true;
+    }
+
+    NotePoolManager& pool = get_note_pool_manager();
+    ProjectManager& manager = ProjectManager::inst();
+    int selectedChart;
+    int originalChart;
+    std::unordered_map<int, ChartState> charts;
+};
+
+}  // namespace
+
+ProjectJournalBase hash_project_file(const fs::path& path) {
+    const MappedFile file(path);
+    return {.fileSize = file.size(),
+            .checksum = XXH3_64bits(file.data().data(), file.size())};
+}
+
+fs::path project_journal_path(const fs::path& projectPath) {
+    fs::path path = projectPath;
+    path += PROJECT_JOURNAL_EXTENSION;
+    return path;
+}
+
+ProjectJournal& ProjectJournal::inst() {
+    static ProjectJournal instance;
+    return instance;
+}
+
+ProjectJournal::~ProjectJournal() {
+    try {
+        close(false);
+    } catch (...) {
+    }
+}
+
+void ProjectJournal::open(const fs::path& projectPath,
+                          const ProjectJournalBase& base) {
+    close(false);
+
+    const fs::path path = project_journal_path(projectPath);
+    const auto records =
+        read_journal_records(path, base).value_or(std::vector<char>());
+
+    std::lock_guard<std::mutex> fileLock(fileMtx);
+    file = write_journal(path, base, records);
+    journalPath = path;
+    written = records.size();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.clear();
+        appended = written;
+        stopping = false;
+        opened = true;
+    }
+    writer = std::thread([this]() { run_writer(); });
+}
+
+void ProjectJournal::close(bool discard) {
+    stop_writer();
+
+    std::lock_guard<std::mutex> fileLock(fileMtx);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!opened) {
+            return;
+        }
+        opened = false;
+    }
+    try {
+        if (!discard) {
+            write_pending();
+        }
+    } catch (const std::exception& e) {
+        print_debug_message("Failed to write journal: " +
+                            std::string(e.what()));
+    }
+    close_file();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.clear();
+        appended = 0;
+    }
+    if (discard) {
+        std::error_code ec;
+        fs::remove(journalPath, ec);
+    }
+}
+
+bool ProjectJournal::is_open() const {
+    return opened;
+}
+
+uint64_t ProjectJournal::mark() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return appended;
+}
+
+void ProjectJournal::rebase(const fs::path& projectPath,
+                            const ProjectJournalBase& base, uint64_t mark) {
+    if (!is_open()) {
+        open(projectPath, base);
+        return;
+    }
+
+    std::lock_guard<std::mutex> fileLock(fileMtx);
+    // The records after mark, from the file and then from pending. Edits
+    // made meanwhile stay pending and go to the new file.
+    std::vector<char> batch;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        const size_t skip =
+            mark > written ? std::min<size_t>(mark - written, pending.size())
+                           : 0;
+        batch.assign(pending.begin() + skip, pending.end());
+        pending.clear();
+    }
+    std::vector<char> tail;
+    if (mark < written) {
+        std::ifstream in(journalPath, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(sizeof(JournalHeader) + mark));
+        tail.resize(written - mark);
+        in.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+        if (!in) {
+            throw std::runtime_error("Error reading journal.");
+        }
+    }
+    tail.insert(tail.end(), batch.begin(), batch.end());
+
+    const fs::path path = project_journal_path(projectPath);
+    close_file();
+    file = write_journal(path, base, tail);
+    if (path != journalPath) {
+        std::error_code ec;
+        fs::remove(journalPath, ec);
+        journalPath = path;
+    }
+    written = tail.size();
+    std::lock_guard<std::mutex> lock(mtx);
+    appended = written + pending.size();
+}
+
+void ProjectJournal::sync() {
+    std::lock_guard<std::mutex> fileLock(fileMtx);
+    write_pending();
+}
+
+void ProjectJournal::select_chart(int index) {
+    chartIndex = index;
+}
+
+bool ProjectJournal::logging() const {
+    return opened.load(std::memory_order_relaxed) && journalPauseDepth == 0;
+}
+
+void ProjectJournal::note_changed(const Note* before, const Note* after) {
+    if (!logging()) {
+        return;
+    }
+    JournalWriter out;
+    out.put<uint8_t>(before != nullptr);
+    out.put<uint8_t>(after != nullptr);
+    if (before) {
+        out.put(*before);
+    }
+    if (after) {
+        out.put(*after);
+    }
+    append(static_cast<uint32_t>(JOURNAL_RECORD::NOTE_CHANGE), out.data);
+}
+
+void ProjectJournal::notes_cleared() {
+    if (!logging()) {
+        return;
+    }
+    append(static_cast<uint32_t>(JOURNAL_RECORD::NOTES_CLEARED), {});
+}
+
+void ProjectJournal::notes_loaded(std::span<const Note> notes) {
+    if (!logging() || notes.empty()) {
+        return;
+    }
+    JournalWriter raw;
+    for (const auto& note : notes) {
+        raw.put(note);
+    }
+    JournalWriter out;
+    out.put(static_cast<uint32_t>(notes.size()));
+    if (!put_compressed(out, raw.data)) {
+        return;
+    }
+    append(static_cast<uint32_t>(JOURNAL_RECORD::NOTES_LOADED), out.data);
+}
+
+void ProjectJournal::timing_changed(const TimingManager& timing) {
+    if (!logging()) {
+        return;
+    }
+    std::vector<TimingPoint> points;
+    timing.get_timing_points(points);
+    JournalWriter out;
+    out.put(static_cast<uint32_t>(points.size()));
+    for (const auto& point : points) {
+        out.put(point.time);
+        out.put(point.beatLength);
+        out.put(static_cast<int32_t>(point.meter));
+    }
+    append(static_cast<uint32_t>(JOURNAL_RECORD::TIMING), out.data);
+}
+
+void ProjectJournal::charts_appended(int firstIndex,
+                                     std::span<const Chart> charts) {
+    if (!logging() || charts.empty()) {
+        return;
+    }
+    nlohmann::json list = nlohmann::json::array();
+    for (const auto& chart : charts) {
+        list.push_back(chart);
+    }
+    const std::string text = list.dump();
+    JournalWriter out;
+    if (!put_compressed(out, text)) {
+        return;
+    }
+    append(static_cast<uint32_t>(JOURNAL_RECORD::CHARTS_APPENDED), firstIndex,
+           out.data);
+}
+
+void ProjectJournal::append(uint32_t type, const std::vector<char>& payload) {
+    append(type, chartIndex, payload);
+}
+
+void ProjectJournal::append(uint32_t type, int32_t chart,
+                            const std::vector<char>& payload) {
+    const JournalRecordHeader header{
+        .type = static_cast<JOURNAL_RECORD>(type),
+        .size = static_cast<uint32_t>(payload.size()),
+        .chart = chart,
+        .reserved = 0,
+        .checksum = record_checksum(static_cast<JOURNAL_RECORD>(type), chart,
+                                    payload.data(), payload.size())};
+    const char* headerBytes = reinterpret_cast<const char*>(&header);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!opened) {
+        return;
+    }
+    pending.insert(pending.end(), headerBytes, headerBytes + sizeof(header));
+    pending.insert(pending.end(), payload.begin(), payload.end());
+    appended += sizeof(header) + payload.size();
+    if (pending.size() >= PROJECT_JOURNAL_FLUSH_SIZE) {
+        wake.notify_one();
+    }
+}
+
+void ProjectJournal::run_writer() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping) {
+        wake.wait_for(lock, PROJECT_JOURNAL_SYNC_INTERVAL, [this]() {
+            return stopping || pending.size() >= PROJECT_JOURNAL_FLUSH_SIZE;
+        });
+        lock.unlock();
+        try {
+            std::lock_guard<std::mutex> fileLock(fileMtx);
+            write_pending();
+        } catch (const std::exception& e) {
+            print_debug_message("Failed to write journal: " +
+                                std::string(e.what()));
+        }
+        lock.lock();
+    }
+}
+
+void ProjectJournal::stop_writer() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void ProjectJournal::write_pending() {
+    std::vector<char> batch;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        batch.swap(pending);
+    }
+    if (batch.empty() || file == JOURNAL_NO_FILE) {
+        return;
+    }
+    write_all(file, batch.data(), batch.size());
+    sync_file(file);
+    written += batch.size();
+}
+
+void ProjectJournal::close_file() {
+    if (file != JOURNAL_NO_FILE) {
+        close_handle(file);
+        file = JOURNAL_NO_FILE;
+    }
+}
+
+ProjectJournalPause::ProjectJournalPause() {
+    ++journalPauseDepth;
+}
+
+ProjectJournalPause::~ProjectJournalPause() {
+    --journalPauseDepth;
+}
+
+void install_project_journal() {
+    get_note_pool_manager().set_change_listener(&ProjectJournal::inst());
+    get_timing_manager().set_change_listener(&ProjectJournal::inst());
+}
+
+size_t replay_project_journal(const fs::path& projectPath,
+                              const ProjectJournalBase& base) {
+    const auto records =
+        read_journal_records(project_journal_path(projectPath), base);
+    if (!records) {
+        return 0;
+    }
+
+    JournalReplayer replayer;
+    size_t applied = 0, skipped = 0;
+    std::span<const char> rest(*records);
+    while (!rest.empty()) {
+        JournalRecordHeader header;
+        std::memcpy(&header, rest.data(), sizeof(header));
+        JournalReader in(rest.subspan(sizeof(header), header.size));
+        try {
+            if (replayer.apply(header.type, header.chart, in)) {
+                ++applied;
+            } else {
+                ++skipped;
+            }
+        } catch (const std::exception& e) {
+            print_debug_message("Skipping journal record: " +
+                                std::string(e.what()));
+            ++skipped;
+        }
+        rest = rest.subspan(sizeof(header) + header.size);
+    }
+    replayer.finish();
+    get_note_pool_manager().array_sort_request();
+    print_debug_message("Replayed journal: " + std::to_string(applied) +
+                        " records applied, " + std::to_string(skipped) +
+                        " skipped.");
+    return applied;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <xxhash/xxhash.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "note.h"
+#include "notePoolManager.h"
+#include "project.h"
+#include "timing.h"
+
+// Append-only log of the note and timing edits made since the project was
+// last saved, kept next to it as <project file><PROJECT_JOURNAL_EXTENSION>.
+// Edits are buffered as checksummed records and written and synced in
+// batches, so a crash loses at most about PROJECT_JOURNAL_SYNC_INTERVAL of
+// work. Saving drops the records the saved file already holds; reopening
+// the project after an unclean shutdown replays the rest.
+//
+// Notes are saved without IDs, so replay finds the notes a record refers to
+// by their saved fields. Each record carries the index of the chart it was
+// made on; replay selects that chart first and skips records of charts the
+// saved project does not have. A bulk load is logged as one compressed
+// record, and the content of a newly selected chart is not logged at all.
+// Charts appended to the project are logged whole, so the records made on
+// them find their chart again.
+inline constexpr int PROJECT_JOURNAL_FORMAT_VERSION = 2;
+inline constexpr const char *PROJECT_JOURNAL_EXTENSION = ".journal";
+inline constexpr auto PROJECT_JOURNAL_SYNC_INTERVAL = std::chrono::seconds(1);
+// Pending records are written early once they reach this size.
+inline constexpr size_t PROJECT_JOURNAL_FLUSH_SIZE = 256 * 1024;
+
+// Identifies the saved project file a journal applies to.
+struct ProjectJournalBase {
+    uint64_t fileSize = 0;
+    XXH64_hash_t checksum = 0;  // XXH3 of the file.
+
+    bool operator==(const ProjectJournalBase &) const = default;
+};
+
+// Throws std::system_error if the file cannot be read.
+ProjectJournalBase hash_project_file(const std::filesystem::path &path);
+
+std::filesystem::path project_journal_path(
+    const std::filesystem::path &projectPath);
+
+class ProjectJournal : public NoteChangeListener, public TimingChangeListener {
+   public:
+    static ProjectJournal &inst();
+
+    ProjectJournal(const ProjectJournal &) = delete;
+    ProjectJournal &operator=(const ProjectJournal &) = delete;
+    ~ProjectJournal() override;
+
+    // Starts logging edits to the project saved at projectPath, as base.
+    // Records already in its journal are kept if they were written against
+    // the same base. Throws if the journal cannot be created.
+    void open(const std::filesystem::path &projectPath,
+              const ProjectJournalBase &base);
+    // Stops logging. Pending records are written first unless discard is
+    // set, in which case the journal file is deleted.
+    void close(bool discard);
+    bool is_open() const;
+
+    // The position after the last record. Take it together with the
+    // project snapshot for a save, with no edit in between, and pass it to
+    // rebase() once the save succeeded.
+    uint64_t mark() const;
+    // Moves the journal to the project now saved at projectPath, as base,
+    // keeping only the records after mark. Starts logging if the journal
+    // was not open.
+    void rebase(const std::filesystem::path &projectPath,
+                const ProjectJournalBase &base, uint64_t mark);
+
+    // Writes the pending records and syncs the file.
+    void sync();
+
+    // The chart later records apply to. Kept while the journal is closed.
+    void select_chart(int index);
+
+    void note_changed(const Note *before, const Note *after) override;
+    void notes_cleared() override;
+    void notes_loaded(std::span<const Note> notes) override;
+    void timing_changed(const TimingManager &timing) override;
+    // The charts were added to the project at firstIndex and after.
+    void charts_appended(int firstIndex, std::span<const Chart> charts);
+
+   private:
+    ProjectJournal() = default;
+
+    // Whether edits of the calling thread are logged now.
+    bool logging() const;
+    void append(uint32_t type, const std::vector<char> &payload);
+    void append(uint32_t type, int32_t chart, const std::vector<char> &payload);
+    void run_writer();
+    void stop_writer();
+    // Both need fileMtx held.
+    void write_pending();
+    void close_file();
+
+    mutable std::mutex mtx;  // Guards pending, appended and stopping.
+    std::mutex fileMtx;      // Guards the file and written.
+    std::condition_variable wake;
+    std::thread writer;
+    std::vector<char> pending;
+    // Bytes of records logged, written or pending; what mark() returns.
+    uint64_t appended = 0;
+    bool stopping = false;
+    // Set under mtx; read without it to skip building unwanted records.
+    std::atomic<bool> opened{false};
+    std::atomic<int> chartIndex{0};
+
+    std::filesystem::path journalPath;
+    // Platform file handle, or -1 / INVALID_HANDLE_VALUE as intptr_t.
+    intptr_t file = -1;
+    // Bytes of records in the file.
+    uint64_t written = 0;
+};
+
+// Keeps the calling thread's edits out of the journal while it lives, for
+// changes replay restores from the project itself.
+class ProjectJournalPause {
+   public:
+    ProjectJournalPause();
+    ~ProjectJournalPause();
+    ProjectJournalPause(const ProjectJournalPause &) = delete;
+    ProjectJournalPause &operator=(const ProjectJournalPause &) = delete;
+};
+
+// Registers the journal as the note pool and timing listener. Call once at
+// startup.
+void install_project_journal();
+
+// Replays the journal of projectPath onto the loaded project if it was
+// written against base. The chart selected before is selected again after.
+// Returns the number of records applied.
+size_t replay_project_journal(const std::filesystem::path &projectPath,
+                              const ProjectJournalBase &base);
@@ -5,255 +5,238 @@
 
 #include <exception>
 
-#ifdef _WIN32
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <windows.h>
-#endif
-
 #include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <system_error>
+#include <numeric>
+#include <string>
+#include <vector>
 
-#include "compress.h"
+#include "backupStore.h"
+#include "durableFile.h"
 #include "format/dyn.h"
+#include "format/dynb.h"
 #include "gm.h"
+#include "journal.h"
+#include "mappedFile.h"
 #include "note.h"
 #include "projectManager.h"
+#include "saveQueue.h"
 #include "timer.h"
 #include "timing.h"
 #include "utils.h"
 
 namespace {
 
-constexpr int EMERGENCY_PROJECT_BACKUP_SLOT_COUNT = 3;
-
 std::mutex projectSaveMutex;
 
-#ifdef _WIN32
-void throw_last_windows_error(const char *message) {
-    throw std::system_error(static_cast<int>(GetLastError()),
-                            std::system_category(), message);
-}
-#endif
-
-void write_file_durably(const std::filesystem::path &path, const char *data,
-                        size_t size) {
-#ifdef _WIN32
-    HANDLE handle = CreateFileW(
-        path.wstring().c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW,
-        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, nullptr);
-    if (handle == INVALID_HANDLE_VALUE) {
-        throw_last_windows_error("Error opening file for writing.");
-    }
+// Thrown inside a save once it is cancelled.
+class ProjectSaveCancelled : public std::runtime_error {
+   public:
+    ProjectSaveCancelled() : std::runtime_error("Project save cancelled.") {}
+};
 
-    size_t writtenTotal = 0;
-    while (writtenTotal < size) {
-        const size_t remaining = size - writtenTotal;
-        const DWORD chunkSize =
-            static_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
-        DWORD written = 0;
-        if (!WriteFile(handle, data + writtenTotal, chunkSize, &written,
-                       nullptr)) {
-            const DWORD error = GetLastError();
-            CloseHandle(handle);
-            throw std::system_error(static_cast<int>(error),
-                                    std::system_category(),
-                                    "Error writing to file.");
-        }
-        if (written == 0) {
-            CloseHandle(handle);
-            throw std::runtime_error("Error writing to file.");
-        }
-        writtenTotal += written;
-    }
+void push_save_progress(const std::string &filePath, const char *phase,
+                        size_t serialized, size_t written) {
+    push_async_event({PROJECT_SAVE_PROGRESS, 0,
+                      nlohmann::json{{"path", filePath},
+                                     {"phase", phase},
+                                     {"serialized", serialized},
+                                     {"written", written}}
+                          .dump()});
+}
 
-    if (!FlushFileBuffers(handle)) {
-        const DWORD error = GetLastError();
-        CloseHandle(handle);
-        throw std::system_error(static_cast<int>(error), std::system_category(),
-                                "Error flushing file to disk.");
-    }
+}  // namespace
 
-    if (!CloseHandle(handle)) {
-        throw_last_windows_error("Error closing file.");
-    }
-#else
-    std::ofstream file(path, std::ios::binary | std::ios::trunc);
-    if (!file.is_open()) {
-        throw std::runtime_error("Error opening file for writing.");
-    }
-    file.write(data, size);
-    file.flush();
-    if (file.fail()) {
-        throw std::runtime_error("Error writing to file.");
-    }
-    file.close();
-    if (file.fail()) {
-        throw std::runtime_error("Error closing file.");
+void backup_existing_project_file(const std::filesystem::path &finalPath) {
+    if (!std::filesystem::exists(finalPath)) {
+        return;
     }
-#endif
+    ProjectBackupStore(finalPath).add(finalPath);
 }
 
-void replace_file_durably(const std::filesystem::path &tempPath,
-                          const std::filesystem::path &finalPath) {
-#ifdef _WIN32
-    if (!MoveFileExW(tempPath.wstring().c_str(), finalPath.wstring().c_str(),
-                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
-        throw_last_windows_error("Error replacing project file.");
+namespace {
+
+// Whether a decoded value is the one saved. .dyn numbers read back exactly;
+// DYNB rounds them to the nearest 1/scale.
+bool saved_value_matches(double saved, double expected, bool binary,
+                         double scale) {
+    if (!binary) {
+        return saved == expected;
     }
-#else
-    std::filesystem::rename(tempPath, finalPath);
-#endif
+    // Half a tick, and the error of scaling back.
+    return std::abs(saved - expected) <=
+           0.5 / scale + std::abs(expected) * 1e-12;
 }
 
-void delete_file_durably(const std::filesystem::path &path) {
-    if (!std::filesystem::exists(path)) {
-        return;
+bool saved_notes_match(const std::vector<Note> &saved,
+                       const std::vector<NoteRecord> &expected,
+                       bool binary) {
+    if (saved.size() != expected.size()) {
+        return false;
     }
-#ifdef _WIN32
-    if (!DeleteFileW(path.wstring().c_str())) {
-        throw_last_windows_error("Error deleting file.");
+    // DYNB stores notes in a stable sort by time.
+    std::vector<size_t> order(expected.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (binary) {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return expected[a].time < expected[b].time;
+        });
     }
-#else
-    if (!std::filesystem::remove(path)) {
-        throw std::runtime_error("Error deleting file.");
+    for (size_t i = 0; i < saved.size(); ++i) {
+        const auto &note = saved[i];
+        const auto &record = expected[order[i]];
+        if (note.side != record.side || note.type != record.type ||
+            !saved_value_matches(note.time, record.time, binary,
+                                 DYNB_TIME_SCALE) ||
+            !saved_value_matches(note.lastTime, record.lastTime, binary,
+                                 DYNB_TIME_SCALE) ||
+            !saved_value_matches(note.width, record.width, binary,
+                                 DYNB_LANE_SCALE) ||
+            !saved_value_matches(note.position, record.position, binary,
+                                 DYNB_LANE_SCALE)) {
+            return false;
+        }
     }
-#endif
+    return true;
 }
 
-void copy_file_durably(const std::filesystem::path &sourcePath,
-                       const std::filesystem::path &targetPath) {
-#ifdef _WIN32
-    if (!CopyFileW(sourcePath.wstring().c_str(), targetPath.wstring().c_str(),
-                   FALSE)) {
-        throw_last_windows_error("Error copying project file.");
+bool saved_timing_points_match(const std::vector<TimingPoint> &saved,
+                               const std::vector<TimingPoint> &expected) {
+    if (saved.size() != expected.size()) {
+        return false;
     }
-#else
-    std::filesystem::copy_file(
-        sourcePath, targetPath,
-        std::filesystem::copy_options::overwrite_existing);
-#endif
-}
-
-std::filesystem::path emergency_backup_path(
-    const std::filesystem::path &finalPath, int version) {
-    std::filesystem::path backupName = finalPath.stem();
-    backupName += ".bak.";
-    backupName += std::to_string(version);
-    backupName += finalPath.extension();
-    return finalPath.parent_path() / "backups" / backupName;
+    for (size_t i = 0; i < saved.size(); ++i) {
+        // .dyn stores the BPM, whose beat length may differ in the last bit.
+        if (saved[i].time != expected[i].time ||
+            saved[i].meter != expected[i].meter ||
+            std::abs(saved[i].beatLength - expected[i].beatLength) >
+                std::abs(expected[i].beatLength) * 1e-12) {
+            return false;
+        }
+    }
+    return true;
 }
 
 }  // namespace
 
-void backup_existing_project_file(const std::filesystem::path &finalPath) {
-    namespace fs = std::filesystem;
-
-    if (!fs::exists(finalPath)) {
-        return;
+// Compares a decoded save with the snapshot it was written from, note by
+// note and timing point by timing point.
+bool saved_project_matches(const Project &saved,
+                           const ProjectSnapshot &snapshot, bool binary) {
+    if (saved.version != snapshot.version ||
+        saved.metadata != snapshot.metadata ||
+        saved.charts.size() != snapshot.charts.size()) {
+        return false;
     }
-
-    const fs::path backupDir = finalPath.parent_path() / "backups";
-    fs::create_directories(backupDir);
-
-    static_assert(EMERGENCY_PROJECT_BACKUP_SLOT_COUNT > 0);
-
-    delete_file_durably(emergency_backup_path(
-        finalPath, EMERGENCY_PROJECT_BACKUP_SLOT_COUNT - 1));
-
-    for (int version = EMERGENCY_PROJECT_BACKUP_SLOT_COUNT - 2; version >= 0;
-         --version) {
-        const fs::path currentPath = emergency_backup_path(finalPath, version);
-        if (!fs::exists(currentPath)) {
-            continue;
+    LazyChartScratch scratch;
+    for (size_t i = 0; i < saved.charts.size(); ++i) {
+        const auto &chart = saved.charts[i];
+        const auto &expected = snapshot.charts[i];
+        if (nlohmann::json(chart.metadata) !=
+                nlohmann::json(expected.metadata) ||
+            nlohmann::json(chart.path) != nlohmann::json(expected.path)) {
+            return false;
+        }
+        const auto content = resolve_chart_snapshot(expected, scratch);
+        if (!saved_notes_match(chart.notes, *content.notes, binary) ||
+            !saved_timing_points_match(chart.timingPoints,
+                                       *content.timingPoints)) {
+            return false;
         }
-        replace_file_durably(currentPath,
-                             emergency_backup_path(finalPath, version + 1));
     }
-
-    copy_file_durably(finalPath, emergency_backup_path(finalPath, 0));
+    return true;
 }
 
-// Verifies the integrity of a project string by checking its JSON structure.
+// Checks the saved file against what was written: its bytes against the
+// checksum of the written data, then its content against the checksums
+// embedded in it. A safe save also decodes the project and compares it
+// with the snapshot.
 //
-// @param projectStr The project data as a JSON string.
-// @return 0 if the project is valid, -1 otherwise.
-int verify_project(string projectStr) {
-    print_debug_message("Verifying project property...");
+// @return 0 if the file matches, -1 otherwise.
+int verify_saved_project_file(const std::filesystem::path &path,
+                              bool binary, const DynExportResult &expected,
+                              const ProjectSnapshot &snapshot, bool safeSave) {
     try {
-        json j = json::parse(projectStr);
-        if (!j.contains("version") || !j["version"].is_string()) {
-            print_debug_message("Invalid project property: " + projectStr);
-            return -1;
+        {
+            const MappedFile file(path);
+            const auto data = file.data();
+            if (data.size() != expected.fileSize ||
+                XXH3_64bits(data.data(), data.size()) != expected.checksum) {
+                print_debug_message(
+                    "Saved file does not match the written data.");
+                return -1;
+            }
+            if (binary) {
+                verify_dynb_file(data, expected);
+            } else {
+                verify_dyn_file(data, expected);
+            }
+        }
+        if (safeSave) {
+            Project saved;
+            const auto utf8Path = path.u8string();
+            if (project_import_dyn(
+                    reinterpret_cast<const char *>(utf8Path.c_str()),
+                    saved) != 0 ||
+                !saved_project_matches(saved, snapshot, binary)) {
+                print_debug_message("Saved project does not match.");
+                return -1;
+            }
         }
-    } catch (json::exception &e) {
-        print_debug_message("Parse failed:" + string(e.what()));
+    } catch (const std::exception &e) {
+        print_debug_message("Saved file does not verify: " +
+                            string(e.what()));
         return -1;
     }
     return 0;
 }
 
-// Verifies the integrity of a project buffer.
-// It handles both compressed and uncompressed data.
-//
-// @param buffer A pointer to the project data buffer.
-// @param size The size of the buffer.
-// @return 0 if the project is valid, -1 otherwise.
-int verify_project_buffer(const char *buffer, size_t size) {
-    if (!check_compressed(buffer, size)) {
-        return verify_project(buffer);
-    }
-    return verify_project(decompress_string(buffer, size));
-}
-
-// Asynchronously saves the project to a file.
-// This function is intended to be run in a separate thread.
+// Saves the project to a file and reports the result with a PROJECT_SAVING
+// event. ProjectSaveQueue runs it on its worker thread.
 void __async_save_project(SaveProjectParams params) {
     namespace fs = std::filesystem;
 
     std::lock_guard<std::mutex> saveLock(projectSaveMutex);
 
+    const auto isCancelled = [&]() {
+        return params.cancelled && params.cancelled->load() != 0;
+    };
+    const auto checkCancelled = [&]() {
+        if (isCancelled()) {
+            throw ProjectSaveCancelled();
+        }
+    };
+    if (isCancelled()) {
+        push_async_event({PROJECT_SAVING, params.cancelled->load()});
+        return;
+    }
+
     bool err = false;
     string errInfo = "";
-    string projectString = "";
-    try {
-        // Update current chart.
-        ProjectManager::inst().update_current_chart();
-        projectString = ProjectManager::inst().dump();
-        if (projectString == "" || verify_project(projectString) != 0) {
-            print_debug_message("Invalid saving project property.");
-            push_async_event(
-                {PROJECT_SAVING, -1,
-                 "Invalid project format. projectString: " + projectString});
+    if (!params.snapshot) {
+        try {
+            params.journalMark = ProjectJournal::inst().mark();
+            params.snapshot = ProjectManager::inst().snapshot();
+        } catch (const std::exception &e) {
+            print_debug_message("Encounter unknown errors. Details:" +
+                                string(e.what()));
+            push_async_event({PROJECT_SAVING, -1});
             return;
         }
-    } catch (const std::exception &e) {
-        print_debug_message("Encounter unknown errors. Details:" +
-                            string(e.what()));
-        push_async_event({PROJECT_SAVING, -1});
-        return;
     }
+    const ProjectSnapshot &snapshot = *params.snapshot;
 
-    auto chartBuffer =
-        std::make_unique<char[]>(compress_bound(projectString.size()));
     fs::path finalPath, tempPath;
     bool tempFileVerified = false;
 
     try {
-        const double compressedSize = get_project_buffer(
-            projectString, chartBuffer.get(), params.compressionLevel);
-        if (compressedSize < 0) {
-            throw std::runtime_error("Error compressing project data.");
-        }
-        size_t cSize = static_cast<size_t>(compressedSize);
-
         print_debug_message("Open file at:" + params.filePath);
         finalPath = convert_char_to_path(params.filePath.c_str());
         fs::path tempName = finalPath.filename();
@@ -261,31 +244,72 @@ void __async_save_project(SaveProjectParams params) {
         tempName += ".tmp";
 
         tempPath = finalPath.parent_path() / tempName;
-        write_file_durably(tempPath, chartBuffer.get(), cSize);
+        std::string extension = finalPath.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char ch) { return std::tolower(ch); });
+        const bool binary = extension == DYNB_FILE_EXTENSION;
+        checkCancelled();
+        push_save_progress(params.filePath, "writing", 0, 0);
+        DynExportResult written;
+        {
+            DurableFileWriter file(tempPath);
+            const auto exporter =
+                binary ? project_export_dynb : project_export_dyn;
+            // Compressed chunks are written as they come, so one count
+            // covers both.
+            size_t writtenSize = 0;
+            size_t reportedSize = 0;
+            written = exporter(snapshot, {.level = params.compressionLevel},
+                               [&](const char *data, size_t size) {
+                                   checkCancelled();
+                                   file.write(data, size);
+                                   writtenSize += size;
+                                   if (writtenSize - reportedSize >=
+                                       PROJECT_SAVE_PROGRESS_INTERVAL) {
+                                       reportedSize = writtenSize;
+                                       push_save_progress(params.filePath,
+                                                          "writing", 0,
+                                                          writtenSize);
+                                   }
+                               });
+            file.close();
+        }
+        print_debug_message("Project written: " +
+                            std::to_string(written.contentSize) + " -> " +
+                            std::to_string(written.fileSize) + " bytes.");
 
+        checkCancelled();
+        push_save_progress(params.filePath, "verifying", written.contentSize,
+                           written.fileSize);
         print_debug_message("Verifying...");
-
-        // Read the saved file.
-        std::ifstream vfile(tempPath, std::ios::binary);
-        if (!vfile.is_open()) {
-            print_debug_message(L"Error opening saved file for verification: " +
-                                tempPath.wstring());
-            throw std::runtime_error(
-                "Error opening saved file for verification.");
-        } else {
-            std::string buffer((std::istreambuf_iterator<char>(vfile)),
-                               std::istreambuf_iterator<char>());
-            vfile.close();
-
-            if (verify_project_buffer(buffer.c_str(), buffer.size()) != 0) {
-                throw std::runtime_error("Saved file is corrupted.");
-            }
+        if (verify_saved_project_file(tempPath, binary, written, snapshot,
+                                      params.safeSave) != 0) {
+            throw std::runtime_error("Saved file is corrupted.");
         }
+        // The last point the old file can be kept.
+        checkCancelled();
+        push_save_progress(params.filePath, "replacing", written.contentSize,
+                           written.fileSize);
         tempFileVerified = true;
 
         backup_existing_project_file(finalPath);
         replace_file_durably(tempPath, finalPath);
         print_debug_message("Project save completed.");
+
+        try {
+            ProjectJournal::inst().rebase(
+                finalPath, {written.fileSize, written.checksum},
+                params.journalMark);
+        } catch (const std::exception &e) {
+            print_debug_message("Failed to move the edit journal: " +
+                                string(e.what()));
+        }
+    } catch (const ProjectSaveCancelled &) {
+        std::error_code ec;
+        fs::remove(tempPath, ec);
+        print_debug_message("Project save cancelled.");
+        push_async_event({PROJECT_SAVING, params.cancelled->load()});
+        return;
     } catch (const std::exception &e) {
         if (!tempFileVerified && fs::exists(tempPath))
             fs::remove(tempPath);
@@ -296,12 +320,21 @@ void __async_save_project(SaveProjectParams params) {
         errInfo = gb2312ToUtf8(e.what());
     }
 
+    // Superseded too late to stop: the newer save still reports the result,
+    // so GameMaker gets one result per file.
+    if (params.cancelled &&
+        params.cancelled->load() == PROJECT_SAVE_STATUS_SUPERSEDED) {
+        push_async_event({PROJECT_SAVING, PROJECT_SAVE_STATUS_SUPERSEDED});
+        return;
+    }
     push_async_event({PROJECT_SAVING, err ? -1 : 0, errInfo});
 }
 
 void load_project(const char *filePath) {
     TIMER_SCOPE("load_project");
 
+    // Loading is not an edit; the journal of the new project opens after.
+    ProjectJournal::inst().close(false);
     try {
         ProjectManager::inst().load_project_from_file(filePath);
     } catch (const std::exception &) {
@@ -309,28 +342,35 @@ void load_project(const char *filePath) {
         ProjectManager::inst().setup_default_chart();
         throw;
     }
+
+    try {
+        const auto path = convert_char_to_path(filePath);
+        const auto base = hash_project_file(path);
+        const size_t recovered = replay_project_journal(path, base);
+        if (recovered > 0) {
+            gamemaker_announcement(GM_ANNOUNCEMENT_TYPE::ANNO_INFO,
+                                   "anno_project_journal_recovered",
+                                   {std::to_string(recovered)});
+        }
+        ProjectJournal::inst().open(path, base);
+    } catch (const std::exception &e) {
+        print_debug_message("Failed to open the edit journal: " +
+                            string(e.what()));
+    }
 }
 
-// Initiates an asynchronous save of the project.
-void save_project(const char *filePath, double compressionLevel) {
+// Queues an asynchronous save of the project. See ProjectSaveQueue.
+void save_project(const char *filePath, double compressionLevel,
+                  bool safeSave) {
     SaveProjectParams params;
     params.filePath.assign(filePath);
     params.compressionLevel = (int)compressionLevel;
-    std::thread t([=]() { __async_save_project(params); });
-    t.detach();
-    return;
-}
-
-// Compresses the project string into a buffer.
-//
-// @param projectString The project data as a string.
-// @param targetBuffer The buffer to store the compressed data.
-// @param compressionLevel The compression level.
-// @return The size of the compressed data.
-double get_project_buffer(const string &projectString, char *targetBuffer,
-                          double compressionLevel) {
-    return DyCore_compress_string(projectString.c_str(), targetBuffer,
-                                  compressionLevel);
+    params.safeSave = safeSave;
+    // Edits come from this thread, so no edit falls between the two and the
+    // journal keeps exactly the ones the file will not hold.
+    params.journalMark = ProjectJournal::inst().mark();
+    params.snapshot = ProjectManager::inst().snapshot();
+    ProjectSaveQueue::inst().push(std::move(params));
 }
 
 // =============================================================================
@@ -376,6 +416,94 @@ string project_get_full_path(const char *relativePath) {
     return projectManager.get_full_path(relativePath);
 }
 
+// =============================================================================
+// Snapshots
+// =============================================================================
+
+NoteRecord make_note_record(const Note &note) {
+    return {note.side,  note.type,     note.time,
+            note.width, note.position, note.lastTime};
+}
+
+Note make_note(const NoteRecord &record) {
+    Note note{};
+    note.side = record.side;
+    note.type = record.type;
+    note.time = record.time;
+    note.width = record.width;
+    note.position = record.position;
+    note.lastTime = record.lastTime;
+    return note;
+}
+
+const ChartContent &LazyChartContent::get() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!content) {
+        content = std::make_shared<const ChartContent>(decoder(nullptr));
+        // The file data is no longer needed.
+        decoder = nullptr;
+    }
+    return *content;
+}
+
+std::shared_ptr<const ChartContent> LazyChartContent::decode_uncached(
+    LazyChartScratch &scratch) {
+    Decoder pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (content) {
+            return content;
+        }
+        pending = decoder;
+    }
+    // Decode outside the lock, so that selecting the chart meanwhile does
+    // not wait for the save.
+    return std::make_shared<const ChartContent>(pending(&scratch));
+}
+
+bool LazyChartContent::is_decoded() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return content != nullptr;
+}
+
+ChartSnapshotContent resolve_chart_snapshot(const ChartSnapshot &chart,
+                                            LazyChartScratch &scratch) {
+    if (!chart.lazyContent) {
+        return {&chart.notes, &chart.timingPoints, nullptr};
+    }
+    auto decoded = chart.lazyContent->decode_uncached(scratch);
+    return {&decoded->notes, &decoded->timingPoints, decoded};
+}
+
+ChartSnapshot make_chart_snapshot(const Chart &chart) {
+    if (chart.lazyContent) {
+        // Decoded by the writer on the save thread.
+        return {.metadata = chart.metadata,
+                .path = chart.path,
+                .lazyContent = chart.lazyContent};
+    }
+    ChartSnapshot snapshot{.metadata = chart.metadata,
+                           .path = chart.path,
+                           .timingPoints = chart.timingPoints};
+    snapshot.notes.reserve(chart.notes.size());
+    for (const auto &note : chart.notes) {
+        if (note.get_note_type() != NOTE_TYPE::SUB) {
+            snapshot.notes.push_back(make_note_record(note));
+        }
+    }
+    return snapshot;
+}
+
+ProjectSnapshot make_project_snapshot(const Project &project) {
+    ProjectSnapshot snapshot{.version = project.version,
+                             .metadata = project.metadata};
+    snapshot.charts.reserve(project.charts.size());
+    for (const auto &chart : project.charts) {
+        snapshot.charts.push_back(make_chart_snapshot(chart));
+    }
+    return snapshot;
+}
+
 // =============================================================================
 // JSON Serialization/Deserialization Functions
 // =============================================================================
@@ -410,11 +538,19 @@ void to_json(nlohmann::json &j, const Chart &chart) {
     j["metadata"] = chart.metadata;
     j["path"] = chart.path;
     j["notes"] = nlohmann::json::array();
+    if (chart.lazyContent) {
+        for (const auto &record : chart.lazyContent->get().notes) {
+            j["notes"].push_back(NoteExportView(make_note(record)));
+        }
+    }
     for (const auto &note : chart.notes) {
         j["notes"].push_back(NoteExportView(note));
     }
+    const auto &timingPoints = chart.lazyContent
+                                   ? chart.lazyContent->get().timingPoints
+                                   : chart.timingPoints;
     j["timingPoints"] = nlohmann::json::array();
-    for (const auto &tp : chart.timingPoints) {
+    for (const auto &tp : timingPoints) {
         j["timingPoints"].push_back(TimingPointExportView(tp));
     }
 }
@@ -2,19 +2,20 @@
 #include <zstd.h>
 
 #include <array>
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "audio.h"
 #include "note.h"
 #include "timing.h"
 
-struct SaveProjectParams {
-    std::string filePath;
-    int compressionLevel;
-};
-
 struct Project;
 struct Chart;
 struct ChartMetadata;
@@ -36,11 +37,65 @@ struct ChartPath {
 void to_json(nlohmann::json &j, const ChartPath &path);
 void from_json(const nlohmann::json &j, ChartPath &path);
 
+// The saved fields of a note.
+struct NoteRecord {
+    int side;
+    int type;
+    double time;
+    double width;
+    double position;
+    double lastTime;
+};
+
+// The notes and timing points of a chart as saved.
+struct ChartContent {
+    std::vector<NoteRecord> notes;
+    std::vector<TimingPoint> timingPoints;
+};
+
+// Work shared by the decoders of the charts of one file during a pass over
+// them, such as the decompressed text of a .dyn file.
+struct LazyChartScratch {
+    const void *source = nullptr;
+    std::string text;
+};
+
+// The content of a chart a lazy load left in the file, decoded on first
+// use. The decoder holds what it needs of the file, which is not kept open.
+class LazyChartContent {
+   public:
+    // Decodes the content; the scratch is null outside of a pass.
+    using Decoder = std::function<ChartContent(LazyChartScratch *scratch)>;
+
+    explicit LazyChartContent(Decoder decoder) : decoder(std::move(decoder)) {
+    }
+
+    // Decodes the content on the first call; concurrent callers wait for it.
+    // Throws if the content is damaged, and again on later calls.
+    const ChartContent &get();
+
+    // Returns the content without keeping it: the cached content if the
+    // chart was already decoded, or else a temporary copy. Used by saves so
+    // that charts nobody opened are not left decoded in memory.
+    std::shared_ptr<const ChartContent> decode_uncached(
+        LazyChartScratch &scratch);
+
+    bool is_decoded() const;
+
+   private:
+    mutable std::mutex mtx;
+    Decoder decoder;
+    std::shared_ptr<const ChartContent> content;
+};
+
 struct Chart {
     ChartMetadata metadata;
     ChartPath path;
     std::vector<Note> notes;
     std::vector<TimingPoint> timingPoints;
+    // Set while notes and timingPoints are still in the file. Selecting the
+    // chart moves the content in; snapshots read it from here.
+    std::shared_ptr<LazyChartContent> lazyContent;
 
     // Non-serialized fields
     AudioData audioData;
@@ -57,15 +112,76 @@ struct Project {
 void to_json(nlohmann::json &j, const Project &project);
 void from_json(const nlohmann::json &j, Project &project);
 
+// A copy of the saved state of a project, taken so it can be serialized
+// without holding the project, note pool or timing locks.
+struct ChartSnapshot {
+    ChartMetadata metadata;
+    ChartPath path;
+    std::vector<NoteRecord> notes;
+    std::vector<TimingPoint> timingPoints;
+    // Set instead of notes and timingPoints for charts still in the file;
+    // the writer decodes them with resolve_chart_snapshot().
+    std::shared_ptr<LazyChartContent> lazyContent;
+};
+
+// The notes and timing points of a snapshot chart, decoding lazy content
+// into a temporary that lives as long as this view.
+struct ChartSnapshotContent {
+    const std::vector<NoteRecord> *notes;
+    const std::vector<TimingPoint> *timingPoints;
+    std::shared_ptr<const ChartContent> decoded;
+};
+ChartSnapshotContent resolve_chart_snapshot(const ChartSnapshot &chart,
+                                            LazyChartScratch &scratch);
+
+struct ProjectSnapshot {
+    std::string version;
+    nlohmann::json metadata;
+    std::vector<ChartSnapshot> charts;
+};
+
+struct SaveProjectParams {
+    std::string filePath;
+    int compressionLevel;
+    // Also decode the saved file and compare it with the snapshot, instead
+    // of only checking its checksums.
+    bool safeSave = false;
+    // Taken on save when not given.
+    std::optional<ProjectSnapshot> snapshot;
+    // ProjectJournal::mark() taken together with the snapshot.
+    uint64_t journalMark = 0;
+    // Once set to a PROJECT_SAVE_STATUS_* value, the save stops at its next
+    // phase or written chunk, leaves the old file in place and reports that
+    // status. After the file is replaced the save runs to the end, and only
+    // PROJECT_SAVE_STATUS_SUPERSEDED still replaces its result.
+    std::shared_ptr<const std::atomic<int>> cancelled;
+};
+
+// PROJECT_SAVING status of a save replaced by a newer save of the same file,
+// even one that already wrote the file. The newer save reports the result.
+inline constexpr int PROJECT_SAVE_STATUS_SUPERSEDED = 1;
+// PROJECT_SAVING status of a save that was cancelled with no newer save to
+// report a result.
+inline constexpr int PROJECT_SAVE_STATUS_CANCELLED = 2;
+// A PROJECT_SAVE_PROGRESS event is sent at each phase of a save, and while
+// writing each time this many more bytes are written.
+inline constexpr size_t PROJECT_SAVE_PROGRESS_INTERVAL = 16 * 1024 * 1024;
+
+NoteRecord make_note_record(const Note &note);
+Note make_note(const NoteRecord &record);
+// Snapshot of a chart as stored in the project, without sub notes.
+ChartSnapshot make_chart_snapshot(const Chart &chart);
+ProjectSnapshot make_project_snapshot(const Project &project);
+
 void __async_save_project(SaveProjectParams params);
 
 void load_project(const char *filePath);
-void save_project(const char *filePath, double compressionLevel);
+void save_project(const char *filePath, double compressionLevel,
+                  bool safeSave = false);
+// Adds the file, if it exists, as the newest version in its
+// ProjectBackupStore.
 void backup_existing_project_file(const std::filesystem::path &finalPath);
 
-double get_project_buffer(const std::string &projectString, char *targetBuffer,
-                          double compressionLevel);
-
 void chart_set_metadata(const ChartMetadata &metaData);
 ChartMetadata chart_get_metadata();
 
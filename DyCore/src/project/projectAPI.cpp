@@ -1,10 +1,17 @@
+#include <atomic>
+#include <memory>
+
 #include "api.h"
+#include "backupStore.h"
+#include "chartBatchImport.h"
 #include "format/dy.h"
 #include "format/dyn.h"
 #include "format/xml.h"
 #include "gm.h"
+#include "journal.h"
 #include "project.h"
 #include "projectManager.h"
+#include "saveQueue.h"
 #include "utils.h"
 
 // Saves the project to a file.
@@ -12,9 +19,12 @@
 //
 // @param filePath The path to save the project file.
 // @param compressionLevel The compression level to use.
+// @param safeSave Nonzero to also decode the saved file and compare it
+// with the project, instead of only checking its checksums.
 // @return 0 on success, -1 on error.
 DYCORE_API double DyCore_save_project(const char* filePath,
-                                      double compressionLevel) {
+                                      double compressionLevel,
+                                      double safeSave) {
     namespace fs = std::filesystem;
 
     if (!filePath || strlen(filePath) == 0) {
@@ -30,7 +40,54 @@ DYCORE_API double DyCore_save_project(const char* filePath,
         return -1;
     }
 
-    save_project(filePath, compressionLevel);
+    save_project(filePath, compressionLevel, safeSave > 0);
+    return 0;
+}
+
+// Drops the queued saves and stops the running one before it replaces the
+// file. Each reports PROJECT_SAVE_STATUS_CANCELLED, except a running save
+// that already replaced the file, which reports its result. GameMaker calls
+// this before saving to another file while a save is in progress.
+DYCORE_API double DyCore_project_save_cancel() {
+    ProjectSaveQueue::inst().cancel_all();
+    return 0;
+}
+
+// Lists the backed up versions of a project file, oldest first, as a JSON
+// array of {id, time, size}. Times are seconds since the epoch.
+DYCORE_API const char* DyCore_project_backup_list(const char* projectPath) {
+    static string versionList;
+    nlohmann::json list = nlohmann::json::array();
+    try {
+        const ProjectBackupStore store(convert_char_to_path(projectPath));
+        for (const auto& version : store.versions()) {
+            list.push_back({{"id", version.id},
+                            {"time", version.time},
+                            {"size", version.size}});
+        }
+    } catch (const std::exception& e) {
+        print_debug_message("Failed to read the project backups: " +
+                            string(e.what()));
+    }
+    versionList = list.dump();
+    return versionList.c_str();
+}
+
+// Writes a backed up version of a project file to targetPath.
+//
+// @return 0 on success, -1 on error.
+DYCORE_API double DyCore_project_backup_restore(const char* projectPath,
+                                                double versionId,
+                                                const char* targetPath) {
+    try {
+        const ProjectBackupStore store(convert_char_to_path(projectPath));
+        store.restore(static_cast<uint64_t>(versionId),
+                      convert_char_to_path(targetPath));
+    } catch (const std::exception& e) {
+        print_debug_message("Failed to restore the project backup: " +
+                            string(e.what()));
+        return -1;
+    }
     return 0;
 }
 
@@ -68,6 +125,82 @@ DYCORE_API const char* DyCore_chart_import_dy_get_remix() {
     return remix.c_str();
 }
 
+namespace {
+
+// Appends the charts read if asked and lists the results for GameMaker.
+string finish_chart_import_batch(std::vector<ChartImportResult>& results,
+                                 bool append) {
+    nlohmann::json list = nlohmann::json::array();
+    std::vector<Chart> charts;
+    for (auto& result : results) {
+        nlohmann::json entry = {
+            {"path", result.path},
+            {"error", result.error},
+            {"title", result.chart.metadata.title},
+            {"difficulty", result.chart.metadata.difficulty},
+            {"notes", result.stats.noteCount},
+            {"holds", result.stats.holdCount},
+            {"duration", result.stats.duration},
+            {"minBpm", result.stats.minBpm},
+            {"maxBpm", result.stats.maxBpm}};
+        if (append && result.error.empty()) {
+            charts.push_back(std::move(result.chart));
+        }
+        list.push_back(std::move(entry));
+    }
+    if (!charts.empty()) {
+        int chartIndex =
+            ProjectManager::inst().append_charts(std::move(charts));
+        for (auto& entry : list) {
+            if (entry["error"].get_ref<const string&>().empty()) {
+                entry["chartIndex"] = chartIndex++;
+            }
+        }
+    }
+    return list.dump();
+}
+
+}  // namespace
+
+// Starts reading the .xml, .dy, .dyn and .dynb charts listed in pathsJson, a
+// JSON array of paths, several at once in the background. The current chart
+// is left alone. With append set, the charts read are added after the
+// project's charts when the result is taken, and reach the note pool only
+// once selected.
+//
+// @return The ID of the batch, or -1 if pathsJson is not a list of paths.
+// A CHART_IMPORT_BATCH event with the ID as status reports the batch done.
+// Its content is a JSON array with {path, error, title, difficulty, notes,
+// holds, duration, minBpm, maxBpm} for each path, in order, and chartIndex
+// for an appended chart. error is empty for charts that were read.
+DYCORE_API double DyCore_chart_import_batch(const char* pathsJson,
+                                            double append) {
+    static std::atomic<int> nextBatchId = 1;
+    std::vector<string> paths;
+    try {
+        paths = nlohmann::json::parse(pathsJson).get<std::vector<string>>();
+    } catch (const std::exception& e) {
+        print_debug_message("Batch chart import failed: " + string(e.what()));
+        throw_error_event("Batch chart import error: " + string(e.what()));
+        return -1;
+    }
+
+    const int batchId = nextBatchId++;
+    import_chart_files_async(
+        std::move(paths),
+        [batchId, append](std::vector<ChartImportResult> results) {
+            auto taken = std::make_shared<std::vector<ChartImportResult>>(
+                std::move(results));
+            // The project is only changed on the GameMaker thread.
+            push_async_event({CHART_IMPORT_BATCH, batchId, "",
+                              [taken, append](AsyncEvent& event) {
+                                  event.content = finish_chart_import_batch(
+                                      *taken, append > 0);
+                              }});
+        });
+    return batchId;
+}
+
 DYCORE_API double DyCore_project_load(const char* filePath) {
     try {
         load_project(filePath);
@@ -80,6 +213,26 @@ DYCORE_API double DyCore_project_load(const char* filePath) {
     return 0;
 }
 
+// Stops logging edits to the open project. Call with discard set when the
+// project is closed without keeping its unsaved edits.
+DYCORE_API double DyCore_project_journal_close(double discard) {
+    try {
+        ProjectJournal::inst().close(discard > 0);
+    } catch (const std::exception& e) {
+        print_debug_message("Failed to close the edit journal: " +
+                            string(e.what()));
+        return -1;
+    }
+    return 0;
+}
+
+// Sets whether opening a project also parses its other charts in the
+// background, instead of when each is first selected.
+DYCORE_API double DyCore_project_set_chart_prefetch(double enabled) {
+    ProjectManager::inst().set_chart_prefetch(enabled > 0);
+    return 0;
+}
+
 DYCORE_API double DyCore_chart_import_dyn(const char* filePath,
                                           double importInfo,
                                           double importTiming) {
@@ -2,12 +2,14 @@
 
 #include <mutex>
 #include <shared_mutex>
+#include <span>
 #include <stdexcept>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "format/dyn.h"
+#include "journal.h"
 #include "note.h"
 #include "notePoolManager.h"
 #include "project.h"
@@ -29,6 +31,21 @@ int ProjectManager::get_chart_count() const {
     return project.charts.size();
 }
 
+int ProjectManager::get_current_chart_index() const {
+    return currentChartIndex;
+}
+
+int ProjectManager::append_charts(std::vector<Chart> charts) {
+    std::lock_guard<std::shared_mutex> lock(mtx);
+    const int firstIndex = get_chart_count();
+    for (auto &chart : charts) {
+        project.charts.push_back(std::move(chart));
+    }
+    ProjectJournal::inst().charts_appended(
+        firstIndex, std::span(project.charts).subspan(firstIndex));
+    return firstIndex;
+}
+
 void ProjectManager::set_current_chart(int index) {
     if (index < 0 || index >= get_chart_count()) {
         throw std::out_of_range("Chart index out of range");
@@ -36,11 +53,28 @@ void ProjectManager::set_current_chart(int index) {
     currentChartIndex = index;
 
     auto &currentChart = get_current_chart();
+    if (currentChart.lazyContent) {
+        const auto &content = currentChart.lazyContent->get();
+        std::vector<Note> notes;
+        notes.reserve(content.notes.size());
+        for (const auto &record : content.notes) {
+            notes.push_back(make_note(record));
+        }
+        // Snapshots may read the chart from the save thread.
+        std::lock_guard<std::shared_mutex> lock(mtx);
+        currentChart.notes = std::move(notes);
+        currentChart.timingPoints = content.timingPoints;
+        currentChart.lazyContent.reset();
+    }
+
+    // The journal replays a chart switch by selecting the chart again, so
+    // the content loaded here is not logged.
+    ProjectJournal::inst().select_chart(index);
+    ProjectJournalPause journalPause;
+
     // Set notes.
     get_note_pool_manager().clear_notes();
-    for (auto &note : currentChart.notes) {
-        create_note(note);
-    }
+    create_notes(currentChart.notes);
 
     // Set timing points.
     get_timing_manager().clear();
@@ -59,6 +93,7 @@ Chart &ProjectManager::get_current_chart() {
 void ProjectManager::clear_project() {
     std::lock_guard<std::shared_mutex> lock(mtx);
     ++chartMusicLoadRequestId;
+    ++projectLoadId;
     project = Project();
     currentChartIndex = -1;
     chartMetadataLastModifiedTime++;
@@ -109,10 +144,9 @@ void ProjectManager::load_all_audio_data() {
     }).detach();
 }
 
-void ProjectManager::setup_default_chart() {
-    std::lock_guard<std::shared_mutex> lock(mtx);
-    ++chartMusicLoadRequestId;
+namespace {
 
+Project make_default_project() {
     Project defaultProject;
     defaultProject.charts.push_back(
         Chart{.metadata = {
@@ -120,7 +154,20 @@ void ProjectManager::setup_default_chart() {
                   .sideType = {"MIXER", "PAD"},
                   .difficulty = 3,
               }});
-    project = std::move(defaultProject);
+    return defaultProject;
+}
+
+}  // namespace
+
+ProjectManager::ProjectManager()
+    : project(make_default_project()), currentChartIndex(0) {}
+
+void ProjectManager::setup_default_chart() {
+    std::lock_guard<std::shared_mutex> lock(mtx);
+    ++chartMusicLoadRequestId;
+    ++projectLoadId;
+
+    project = make_default_project();
     chartMetadataLastModifiedTime++;
 
     set_current_chart(0);
@@ -128,7 +175,8 @@ void ProjectManager::setup_default_chart() {
 
 void ProjectManager::load_project_from_file(const char *filePath) {
     clear_project();
-    if (project_import_dyn(filePath, project) != 0) {
+    // Charts other than the first are parsed when first selected.
+    if (project_import_dyn(filePath, project, true) != 0) {
         throw std::runtime_error("Failed to import DYN project file.");
     }
 
@@ -148,6 +196,43 @@ void ProjectManager::load_project_from_file(const char *filePath) {
             "This project does not contain any chart. The project file may be "
             "corrupted.");
     }
+    if (chartPrefetch) {
+        prefetch_charts();
+    }
+}
+
+void ProjectManager::set_chart_prefetch(bool enabled) {
+    chartPrefetch = enabled;
+}
+
+void ProjectManager::prefetch_charts() {
+    std::vector<std::shared_ptr<LazyChartContent>> pending;
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        for (const auto &chart : project.charts) {
+            if (chart.lazyContent) {
+                pending.push_back(chart.lazyContent);
+            }
+        }
+    }
+    if (pending.empty()) {
+        return;
+    }
+    const uint64_t loadId = projectLoadId;
+    std::thread([this, loadId, pending = std::move(pending)]() {
+        for (const auto &content : pending) {
+            // Stop once another project is loaded.
+            if (projectLoadId != loadId) {
+                return;
+            }
+            try {
+                content->get();
+            } catch (const std::exception &e) {
+                print_debug_message("Failed to prefetch a chart: " +
+                                    string(e.what()));
+            }
+        }
+    }).detach();
 }
 
 void ProjectManager::update_current_chart() {
@@ -163,6 +248,31 @@ void ProjectManager::update_current_chart() {
     get_note_pool_manager().get_notes(chart.notes, true);
 }
 
+ProjectSnapshot ProjectManager::snapshot() const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    ProjectSnapshot result{.version = project.version,
+                           .metadata = project.metadata};
+    result.charts.reserve(project.charts.size());
+    for (int index = 0; index < get_chart_count(); ++index) {
+        const auto &chart = project.charts[index];
+        if (index != currentChartIndex) {
+            result.charts.push_back(make_chart_snapshot(chart));
+            continue;
+        }
+        auto &saved = result.charts.emplace_back(
+            ChartSnapshot{.metadata = chart.metadata, .path = chart.path});
+        auto &pool = get_note_pool_manager();
+        saved.notes.reserve(pool.get_note_count());
+        pool.for_each_note([&](const Note &note) {
+            if (note.get_note_type() != NOTE_TYPE::SUB) {
+                saved.notes.push_back(make_note_record(note));
+            }
+        });
+        get_timing_manager().get_timing_points(saved.timingPoints);
+    }
+    return result;
+}
+
 void ProjectManager::set_chart_metadata(const ChartMetadata &meta) {
     std::lock_guard<std::shared_mutex> lock(mtx);
     if (!check_current_chart_set()) {
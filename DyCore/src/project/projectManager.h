@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <mutex>
 #include <shared_mutex>
+#include <vector>
 
 #include "json.hpp"
 #include "project.h"
@@ -22,6 +23,9 @@ class ProjectManager {
     fs::path projectFilePath;
     fs::path projectDirPath;
     std::atomic<uint64_t> chartMusicLoadRequestId = 0;
+    // Bumped whenever the project is replaced.
+    std::atomic<uint64_t> projectLoadId = 0;
+    std::atomic<bool> chartPrefetch = false;
 
     int currentChartIndex;
     uint64_t chartMetadataLastModifiedTime = 0;
@@ -30,21 +34,35 @@ class ProjectManager {
     Chart &get_current_chart();
 
     void load_all_audio_data();
+    // Decodes the charts a lazy load left in the file on a background
+    // thread, so selecting them later does not wait.
+    void prefetch_charts();
 
    public:
-    ProjectManager() {
-        setup_default_chart();
-    }
+    // Starts on the default chart. The editor's notes and timing points are
+    // left alone, as the chart has none.
+    ProjectManager();
 
     void setup_default_chart();
 
     void clear_project();
     void load_project(const Project &proj);
+    // Parses the first chart's notes and timing points now and the other
+    // charts' when first selected, or in the background with chart prefetch.
     void load_project_from_file(const char *filePath);
+    void set_chart_prefetch(bool enabled);
     int get_chart_count() const;
+    // -1 if no chart is selected.
+    int get_current_chart_index() const;
+    // Adds the charts after the existing ones, leaving the current chart
+    // selected. Returns the index of the first added chart.
+    int append_charts(std::vector<Chart> charts);
     void set_current_chart(int index);
     // Update timing points and notes to the current chart.
     void update_current_chart();
+    // Copy the project for saving, with the current chart's notes and timing
+    // points taken from the note pool and timing manager.
+    ProjectSnapshot snapshot() const;
 
     /// Getters & Setters
 
@@ -0,0 +1,103 @@
+#include "saveQueue.h"
+
+#include <exception>
+
+#include "gm.h"
+#include "utils.h"
+
+ProjectSaveQueue &ProjectSaveQueue::inst() {
+    static ProjectSaveQueue instance(__async_save_project);
+    return instance;
+}
+
+ProjectSaveQueue::ProjectSaveQueue(SaveFunction save)
+    : save(std::move(save)) {}
+
+ProjectSaveQueue::~ProjectSaveQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ProjectSaveQueue::push(SaveProjectParams params) {
+    Job job{.target = convert_char_to_path(params.filePath.c_str())
+                          .lexically_normal(),
+            .cancelled = std::make_shared<std::atomic<int>>(0)};
+    params.cancelled = job.cancelled;
+    job.params = std::move(params);
+
+    size_t superseded = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (runningCancelled && runningTarget == job.target) {
+            *runningCancelled = PROJECT_SAVE_STATUS_SUPERSEDED;
+        }
+        superseded = std::erase_if(pending, [&](const Job &other) {
+            return other.target == job.target;
+        });
+        pending.push_back(std::move(job));
+        if (!worker.joinable()) {
+            worker = std::thread([this]() { run_worker(); });
+        }
+    }
+    wake.notify_one();
+
+    for (size_t i = 0; i < superseded; ++i) {
+        push_async_event({PROJECT_SAVING, PROJECT_SAVE_STATUS_SUPERSEDED});
+    }
+}
+
+void ProjectSaveQueue::cancel_all() {
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (runningCancelled) {
+            *runningCancelled = PROJECT_SAVE_STATUS_CANCELLED;
+        }
+        dropped.swap(pending);
+    }
+    idle.notify_all();
+
+    for (size_t i = 0; i < dropped.size(); ++i) {
+        push_async_event({PROJECT_SAVING, PROJECT_SAVE_STATUS_CANCELLED});
+    }
+}
+
+void ProjectSaveQueue::wait_idle() {
+    std::unique_lock<std::mutex> lock(mtx);
+    idle.wait(lock, [this]() { return pending.empty() && !runningCancelled; });
+}
+
+void ProjectSaveQueue::run_worker() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+        Job job = std::move(pending.front());
+        pending.pop_front();
+        runningTarget = job.target;
+        runningCancelled = job.cancelled;
+        lock.unlock();
+
+        try {
+            save(std::move(job.params));
+        } catch (const std::exception &e) {
+            print_debug_message("Project save failed: " + string(e.what()));
+            push_async_event({PROJECT_SAVING, -1, e.what()});
+        }
+
+        lock.lock();
+        runningCancelled.reset();
+        runningTarget.clear();
+        if (pending.empty()) {
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "project.h"
+
+// Runs project saves one at a time on a single worker thread. A save
+// replaces the pending save of the same file, which then never runs, and
+// cancels the running one, which stops at its next phase. Both report
+// PROJECT_SAVE_STATUS_SUPERSEDED instead of a result, so rapid saves write
+// the file once or twice instead of once per request. Saves of different
+// files all run, in the order they were pushed. Saves dropped by
+// cancel_all() report PROJECT_SAVE_STATUS_CANCELLED.
+class ProjectSaveQueue {
+   public:
+    // Runs one save and reports its result.
+    using SaveFunction = std::function<void(SaveProjectParams)>;
+
+    static ProjectSaveQueue &inst();
+
+    explicit ProjectSaveQueue(SaveFunction save);
+    ProjectSaveQueue(const ProjectSaveQueue &) = delete;
+    ProjectSaveQueue &operator=(const ProjectSaveQueue &) = delete;
+    // Runs the pending saves first.
+    ~ProjectSaveQueue();
+
+    void push(SaveProjectParams params);
+    // Drops the pending saves and cancels the running one. Each reports
+    // PROJECT_SAVE_STATUS_CANCELLED.
+    void cancel_all();
+    // Blocks until no save is pending or running.
+    void wait_idle();
+
+   private:
+    struct Job {
+        SaveProjectParams params;
+        std::filesystem::path target;
+        std::shared_ptr<std::atomic<int>> cancelled;
+    };
+
+    void run_worker();
+
+    SaveFunction save;
+    std::mutex mtx;  // Guards everything below but the worker.
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Job> pending;
+    // Target and cancel status of the running save; the status is null when
+    // idle.
+    std::filesystem::path runningTarget;
+    std::shared_ptr<std::atomic<int>> runningCancelled;
+    bool stopping = false;
+    // Started with the first save.
+    std::thread worker;
+};
@@ -0,0 +1,292 @@
+#include "beatGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <mutex>
+
+#include "layout.h"
+#include "render.h"
+#include "timing.h"
+#include "vertex.h"
+
+namespace {
+
+constexpr uint32_t BEAT_GRID_GREY = 0x808080;
+constexpr uint32_t BEAT_GRID_LIGHT_GREY = 0xC0C0C0;
+constexpr uint32_t BEAT_GRID_WHITE = 0xFFFFFF;
+constexpr float BEAT_GRID_SIDE_INFO_THICKNESS = 7.0f;
+constexpr double BEAT_GRID_MIN_ALPHA = 0.01;
+// Lines are enumerated for this many visible spans ahead, so playback only
+// re-walks the timing points every few frames.
+constexpr double BEAT_GRID_LINE_WINDOW_SPANS = 2.0;
+// 1 Quad = 6 Vertices = 120 Bytes
+constexpr size_t BEAT_GRID_BYTES_PER_QUAD = 120;
+
+struct BeatGridLine {
+    double time;
+    int division;
+    bool hard;
+};
+
+glm::ivec4 bgr_to_color(uint32_t bgr, double alpha) {
+    return {static_cast<int>(bgr & 0xFF), static_cast<int>((bgr >> 8) & 0xFF),
+            static_cast<int>((bgr >> 16) & 0xFF),
+            static_cast<int>(std::lround(std::clamp(alpha, 0.0, 1.0) * 255))};
+}
+
+// Draws a straight line as one quad. The ends are extended by half the
+// thickness in place of the rounded caps the GML version used.
+void write_line(char*& out, glm::vec2 from, glm::vec2 to, float thickness,
+                glm::ivec4 color) {
+    const glm::vec2 delta = to - from;
+    const float length = std::hypot(delta.x, delta.y);
+    if (length <= 0.0f) {
+        return;
+    }
+    const glm::vec2 direction = delta / length;
+    const glm::vec2 along = direction * (thickness / 2.0f);
+    const glm::vec2 across = glm::vec2(-direction.y, direction.x) *
+                             (thickness / 2.0f);
+    from -= along;
+    to += along;
+    const glm::vec2 uv{0.0f, 0.0f};
+    vertex_quad_write(out, from - across, to - across, from + across,
+                      to + across, uv, uv, uv, uv, color);
+}
+
+class BeatGridCache {
+   public:
+    void set_style(const BeatGridStyle& newStyle) {
+        std::lock_guard<std::mutex> lock(mtx);
+        style = newStyle;
+        ++styleGeneration;
+    }
+
+    std::span<const char> render(const BeatGridView& view) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& timing = get_timing_manager();
+        const double visibleSpan = BASE_RES_H / std::max(view.noteSpeed, 1e-6);
+
+        std::vector<int> divisions;
+        for (const int division : view.divisions) {
+            if (division >= 1) {
+                divisions.push_back(division);
+            }
+        }
+        std::sort(divisions.begin(), divisions.end(), std::greater<>());
+        divisions.erase(std::unique(divisions.begin(), divisions.end()),
+                        divisions.end());
+
+        const bool linesValid =
+            lineTimingModified == timing.get_last_modified_time() &&
+            lineDivisions == divisions &&
+            lineMusicLength == view.musicLength &&
+            view.nowTime >= lineWindowBegin &&
+            view.nowTime + visibleSpan <= lineWindowEnd;
+        if (!linesValid) {
+            lineTimingModified = timing.get_last_modified_time();
+            lineDivisions = divisions;
+            lineMusicLength = view.musicLength;
+            lineWindowBegin = view.nowTime;
+            lineWindowEnd =
+                view.nowTime + visibleSpan * BEAT_GRID_LINE_WINDOW_SPANS;
+            build_lines(timing);
+            ++lineGeneration;
+            ++stats.lineBuilds;
+        }
+
+        const bool verticesValid = vertexLineGeneration == lineGeneration &&
+                                   vertexStyleGeneration == styleGeneration &&
+                                   vertexNowTime == view.nowTime &&
+                                   vertexNoteSpeed == view.noteSpeed &&
+                                   vertexSideAlpha == view.sideAlpha;
+        if (!verticesValid) {
+            vertexLineGeneration = lineGeneration;
+            vertexStyleGeneration = styleGeneration;
+            vertexNowTime = view.nowTime;
+            vertexNoteSpeed = view.noteSpeed;
+            vertexSideAlpha = view.sideAlpha;
+            build_vertices(view);
+            ++stats.vertexBuilds;
+        }
+        return vertices;
+    }
+
+    BeatGridStats get_stats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+   private:
+    // Same walk as the GML beat line loop: from the segment holding the
+    // window start, every beat of every segment until the window ends. An even
+    // division only adds its odd parts; the even ones belong to its half.
+    void build_lines(TimingManager& timing) {
+        lines.clear();
+        std::vector<TimingPoint> points;
+        timing.get_timing_points(points);
+        if (points.empty()) {
+            return;
+        }
+
+        size_t at = 0;
+        while (at + 1 < points.size() && points[at + 1].time <= lineWindowBegin)
+            ++at;
+        double firstBeat = std::floor((lineWindowBegin - points[at].time) /
+                                      points[at].beatLength);
+        for (; at < points.size(); ++at, firstBeat = 0) {
+            const auto& point = points[at];
+            if (point.time > lineWindowEnd && at != 0) {
+                break;
+            }
+            const double nextTime = at + 1 < points.size()
+                                        ? points[at + 1].time
+                                        : lineMusicLength;
+            for (double beat = firstBeat;
+                 point.time + beat * point.beatLength + 1 < nextTime &&
+                 point.time + beat * point.beatLength <= lineWindowEnd;
+                 ++beat) {
+                const bool barBeat =
+                    std::fmod(beat, static_cast<double>(point.meter)) == 0;
+                for (const int division : lineDivisions) {
+                    const int step = division % 2 == 1 ? 1 : 2;
+                    for (int part = division == 1 ? 0 : 1; part < division;
+                         part += step) {
+                        const double time =
+                            point.time +
+                            (beat + static_cast<double>(part) / division) *
+                                point.beatLength;
+                        if (time >= nextTime) {
+                            break;
+                        }
+                        lines.push_back({time, division, part == 0 && barBeat});
+                    }
+                }
+            }
+        }
+    }
+
+    double get_length_offset(int division) const {
+        const auto& offsets = style.lengthOffsets;
+        if (static_cast<size_t>(division) < offsets.size()) {
+            return offsets[division];
+        }
+        double shortest = 0;
+        for (size_t index = 1; index < offsets.size(); ++index) {
+            shortest = std::min(shortest, offsets[index]);
+        }
+        // Extra offset for very short beat lines (e.g. 1/64).
+        return shortest - 10 - division;
+    }
+
+    void build_vertices(const BeatGridView& view) {
+        const auto& alpha = view.sideAlpha;
+        const float judgeBottom =
+            BASE_RES_H - (JUDGE_LINE_BELOW_FROM_BOTTOM +
+                          JUDGE_LINE_BELOW_THICKNESS / 2.0f);
+        const float centerX = BASE_RES_W / 2.0f;
+
+        vertices.resize(lines.size() * 4 * BEAT_GRID_BYTES_PER_QUAD);
+        char* out = vertices.data();
+        for (const auto& line : lines) {
+            const float downY = time_to_vertPos(line.time, view.nowTime,
+                                                view.noteSpeed, 0);
+            const float leftX = time_to_vertPos(line.time, view.nowTime,
+                                                view.noteSpeed, 1);
+            const float rightX = time_to_vertPos(line.time, view.nowTime,
+                                                 view.noteSpeed, 2);
+            const float thickness =
+                static_cast<float>(line.hard ? style.hardWidth : style.width) *
+                3.0f;
+            double length = line.hard ? style.hardLength : style.length;
+            const float height =
+                static_cast<float>(line.hard ? style.hardHeight : style.height);
+            length += get_length_offset(line.division);
+
+            uint32_t bgr =
+                static_cast<size_t>(line.division) < style.colors.size()
+                    ? style.colors[line.division]
+                    : 0;
+            if (bgr == 0) {
+                bgr = BEAT_GRID_GREY;
+            }
+            if (style.mono) {
+                bgr = line.hard ? BEAT_GRID_WHITE : BEAT_GRID_LIGHT_GREY;
+            }
+            if (style.longLines) {
+                length = line.hard ? style.hardLength : style.longLength;
+            }
+
+            if (leftX > JUDGE_LINE_SIDE_FROM_EDGE && leftX <= centerX) {
+                if (alpha[1] > BEAT_GRID_MIN_ALPHA) {
+                    write_line(out, {leftX, judgeBottom - height},
+                               {leftX, judgeBottom}, thickness,
+                               bgr_to_color(bgr, alpha[1]));
+                }
+                if (alpha[2] > BEAT_GRID_MIN_ALPHA) {
+                    write_line(out, {rightX, judgeBottom - height},
+                               {rightX, judgeBottom}, thickness,
+                               bgr_to_color(bgr, alpha[2]));
+                }
+            }
+            if (downY <= judgeBottom && downY >= 0 &&
+                alpha[0] > BEAT_GRID_MIN_ALPHA) {
+                const float halfLength = static_cast<float>(length) / 2.0f;
+                write_line(out, {centerX - halfLength, downY},
+                           {centerX + halfLength, downY}, thickness,
+                           bgr_to_color(bgr, alpha[0]));
+                if (line.division == 1 && !line.hard) {
+                    const float infoX = static_cast<float>(style.sideInfoX);
+                    write_line(out, {infoX, downY},
+                               {infoX + static_cast<float>(style.sideInfoWidth),
+                                downY},
+                               BEAT_GRID_SIDE_INFO_THICKNESS,
+                               bgr_to_color(BEAT_GRID_LIGHT_GREY, alpha[0]));
+                }
+            }
+        }
+        vertices.resize(static_cast<size_t>(out - vertices.data()));
+        stats.lineCount = lines.size();
+        stats.byteSize = vertices.size();
+    }
+
+    std::mutex mtx;
+    BeatGridStyle style;
+    uint64_t styleGeneration = 0;
+    BeatGridStats stats;
+
+    std::vector<BeatGridLine> lines;
+    uint64_t lineGeneration = 0;
+    uint64_t lineTimingModified = UINT64_MAX;
+    std::vector<int> lineDivisions;
+    double lineMusicLength = 0.0;
+    double lineWindowBegin = 0.0;
+    double lineWindowEnd = -1.0;
+
+    std::vector<char> vertices;
+    uint64_t vertexLineGeneration = UINT64_MAX;
+    uint64_t vertexStyleGeneration = UINT64_MAX;
+    double vertexNowTime = 0.0;
+    double vertexNoteSpeed = 0.0;
+    std::array<double, 3> vertexSideAlpha{};
+};
+
+BeatGridCache& get_beat_grid_cache() {
+    static BeatGridCache cache;
+    return cache;
+}
+
+}  // namespace
+
+void set_beat_grid_style(const BeatGridStyle& style) {
+    get_beat_grid_cache().set_style(style);
+}
+
+std::span<const char> render_beat_grid(const BeatGridView& view) {
+    return get_beat_grid_cache().render(view);
+}
+
+BeatGridStats get_beat_grid_stats() {
+    return get_beat_grid_cache().get_stats();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Appearance of the editor beat lines, mirroring objEditor's beatline
+// settings. Colors are GameMaker BGR values and a zero color falls back to
+// grey. colors and lengthOffsets are indexed by division; divisions past the
+// end of lengthOffsets get progressively shorter.
+struct BeatGridStyle {
+    std::vector<uint32_t> colors;
+    std::vector<double> lengthOffsets;
+    double width = 2.0;
+    double hardWidth = 3.5;
+    double length = 0.0;
+    double hardLength = 0.0;
+    double longLength = 0.0;
+    double height = 0.0;
+    double hardHeight = 0.0;
+    // Beat tick beside the down lane, drawn for every unaccented beat.
+    double sideInfoX = 0.0;
+    double sideInfoWidth = 0.0;
+    // MONO: white bar lines and light grey beat lines.
+    bool mono = false;
+    // LONG: every non-bar line uses longLength.
+    bool longLines = false;
+};
+
+// Everything besides the style that decides the grid of one frame.
+struct BeatGridView {
+    double nowTime = 0.0;
+    double noteSpeed = 1.0;
+    // Enabled divisions, e.g. {1, 2, 4}.
+    std::vector<int> divisions;
+    // Down, left and right; sides at or below 0.01 are skipped.
+    std::array<double, 3> sideAlpha{};
+    // End of the last timing segment.
+    double musicLength = 0.0;
+};
+
+void set_beat_grid_style(const BeatGridStyle& style);
+
+// Returns the grid vertices in the note vertex format. The enumerated lines
+// are reused while the timing points, divisions and a window around nowTime
+// are unchanged, and the vertices are reused for an unchanged view. The span
+// stays valid until the next call.
+std::span<const char> render_beat_grid(const BeatGridView& view);
+
+struct BeatGridStats {
+    size_t lineCount = 0;
+    size_t byteSize = 0;
+    uint64_t lineBuilds = 0;
+    uint64_t vertexBuilds = 0;
+};
+
+BeatGridStats get_beat_grid_stats();
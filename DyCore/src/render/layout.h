@@ -3,6 +3,7 @@ inline constexpr int BASE_RES_W = 1920;
 inline constexpr int BASE_RES_H = 1080;
 
 inline constexpr int JUDGE_LINE_BELOW_FROM_BOTTOM = 137;
+inline constexpr int JUDGE_LINE_BELOW_THICKNESS = 6;
 inline constexpr int JUDGE_LINE_SIDE_FROM_EDGE = 112;
 
 inline constexpr int ACTIVATION_AHEAD_PIXELS = 50;
\ No newline at end of file
@@ -0,0 +1,517 @@
+#include "offline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "layout.h"
+#include "profile.h"
+#include "render.h"
+#include "utils.h"
+
+namespace {
+
+// Position, UV and color; see vertex_tri_write.
+constexpr size_t RASTER_VERTEX_BYTES = 20;
+constexpr size_t RASTER_TRIANGLE_BYTES = 3 * RASTER_VERTEX_BYTES;
+
+struct OfflineAtlas {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+class OfflineAtlasStore {
+   public:
+    void set(std::shared_ptr<const OfflineAtlas> newAtlas) {
+        std::lock_guard<std::mutex> lock(mtx);
+        atlas = std::move(newAtlas);
+    }
+
+    std::shared_ptr<const OfflineAtlas> get() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return atlas;
+    }
+
+   private:
+    std::mutex mtx;
+    std::shared_ptr<const OfflineAtlas> atlas;
+};
+
+OfflineAtlasStore& get_offline_atlas_store() {
+    static OfflineAtlasStore store;
+    return store;
+}
+
+struct RasterVertex {
+    glm::vec2 position;
+    glm::vec2 uv;
+    uint8_t color[4];
+};
+
+RasterVertex read_raster_vertex(const char* data) {
+    RasterVertex vertex;
+    std::memcpy(&vertex.position, data, sizeof(glm::vec2));
+    std::memcpy(&vertex.uv, data + 8, sizeof(glm::vec2));
+    std::memcpy(vertex.color, data + 16, 4);
+    return vertex;
+}
+
+float edge_function(glm::vec2 a, glm::vec2 b, glm::vec2 point) {
+    return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+}
+
+// Pixels centred exactly on an edge shared by two triangles belong to one of
+// them: a reversed edge always gets the opposite answer.
+bool owns_edge(glm::vec2 a, glm::vec2 b) {
+    return a.y == b.y ? b.x > a.x : b.y < a.y;
+}
+
+enum class RasterBlend { NORMAL, REPLACE };
+
+// Screen-space affine UV mapping, uv = origin + dx * x + dy * y.
+struct UvGradient {
+    glm::vec2 origin;
+    glm::vec2 dx;
+    glm::vec2 dy;
+};
+
+// Maps p[0], p[1], p[2] to uv[0], uv[1], uv[2]. Parallelograms share the
+// mapping of their first three corners.
+UvGradient make_uv_gradient(const glm::vec2 p[3], const glm::vec2 uv[3]) {
+    const glm::vec2 e1 = p[1] - p[0];
+    const glm::vec2 e2 = p[2] - p[0];
+    const float det = e1.x * e2.y - e1.y * e2.x;
+    const glm::vec2 f1 = uv[1] - uv[0];
+    const glm::vec2 f2 = uv[2] - uv[0];
+    UvGradient gradient;
+    gradient.dx = f1 * (e2.y / det) + f2 * (-e1.y / det);
+    gradient.dy = f1 * (-e2.x / det) + f2 * (e1.x / det);
+    gradient.origin = uv[0] - gradient.dx * p[0].x - gradient.dy * p[0].y;
+    return gradient;
+}
+
+// Half-space rasterizer for the note vertex format, writing RGBA8 pixels in
+// base resolution coordinates times scale.
+class Rasterizer {
+   public:
+    Rasterizer(const OfflineAtlas& atlas, std::vector<uint8_t>& target,
+               int width, int height, glm::vec2 scale, RasterBlend blend)
+        : atlas(atlas),
+          target(target),
+          width(width),
+          height(height),
+          scale(scale),
+          blend(blend) {}
+
+    // Quads from vertex_quad_write that are axis-aligned rectangles with
+    // affine UVs, which covers nearly every note sprite, are filled as
+    // rectangles. Everything else goes through the triangle path.
+    void draw(std::span<const char> vertices) {
+        const size_t triangleCount = vertices.size() / RASTER_TRIANGLE_BYTES;
+        for (size_t index = 0; index < triangleCount; ++index) {
+            const char* data = vertices.data() + index * RASTER_TRIANGLE_BYTES;
+            RasterVertex v[3];
+            for (int corner = 0; corner < 3; ++corner) {
+                v[corner] =
+                    read_raster_vertex(data + corner * RASTER_VERTEX_BYTES);
+                v[corner].position *= scale;
+            }
+            if (index + 1 < triangleCount) {
+                const RasterVertex last = read_raster_vertex(
+                    data + RASTER_TRIANGLE_BYTES + 2 * RASTER_VERTEX_BYTES);
+                if (draw_rectangle(v, last, data + RASTER_TRIANGLE_BYTES)) {
+                    ++index;
+                    continue;
+                }
+            }
+            draw_triangle(v);
+        }
+    }
+
+   private:
+    bool draw_rectangle(const RasterVertex v[3], RasterVertex last,
+                        const char* nextTriangle) {
+        // The second triangle must be (b, c, d) of the same quad.
+        RasterVertex b = read_raster_vertex(nextTriangle);
+        RasterVertex c = read_raster_vertex(nextTriangle + RASTER_VERTEX_BYTES);
+        b.position *= scale;
+        c.position *= scale;
+        last.position *= scale;
+        if (b.position != v[1].position || c.position != v[2].position ||
+            b.uv != v[1].uv || c.uv != v[2].uv ||
+            std::memcmp(last.color, v[0].color, 4) != 0) {
+            return false;
+        }
+
+        constexpr float epsilon = 1e-3f;
+        const glm::vec2 a = v[0].position;
+        const glm::vec2 e1 = v[1].position - a;
+        const glm::vec2 e2 = v[2].position - a;
+        const bool axisAligned =
+            (std::abs(e1.y) < epsilon && std::abs(e2.x) < epsilon) ||
+            (std::abs(e1.x) < epsilon && std::abs(e2.y) < epsilon);
+        const glm::vec2 expectedLast = a + e1 + e2;
+        const glm::vec2 expectedUv = v[1].uv + v[2].uv - v[0].uv;
+        if (!axisAligned || std::abs(e1.x * e2.y - e1.y * e2.x) < 1e-6f ||
+            std::abs(last.position.x - expectedLast.x) > epsilon ||
+            std::abs(last.position.y - expectedLast.y) > epsilon ||
+            std::abs(last.uv.x - expectedUv.x) > 1e-6f ||
+            std::abs(last.uv.y - expectedUv.y) > 1e-6f) {
+            return false;
+        }
+
+        const glm::vec2 p[3] = {v[0].position, v[1].position, v[2].position};
+        const glm::vec2 uv[3] = {v[0].uv, v[1].uv, v[2].uv};
+        const UvGradient gradient = make_uv_gradient(p, uv);
+        const glm::vec2 low = glm::min(a, last.position);
+        const glm::vec2 high = glm::max(a, last.position);
+        // Pixel centres in [low, high).
+        const int xBegin =
+            std::max(0, static_cast<int>(std::ceil(low.x - 0.5f)));
+        const int xEnd =
+            std::min(width, static_cast<int>(std::ceil(high.x - 0.5f)));
+        const int yBegin =
+            std::max(0, static_cast<int>(std::ceil(low.y - 0.5f)));
+        const int yEnd =
+            std::min(height, static_cast<int>(std::ceil(high.y - 0.5f)));
+        for (int y = yBegin; y < yEnd; ++y) {
+            write_span(y, xBegin, xEnd, gradient, v[0].color);
+        }
+        return true;
+    }
+
+    void draw_triangle(RasterVertex v[3]) {
+        glm::vec2 p[3] = {v[0].position, v[1].position, v[2].position};
+        const float area = edge_function(p[0], p[1], p[2]);
+        if (std::abs(area) < 1e-6f) {
+            return;
+        }
+        if (area < 0) {
+            std::swap(v[1], v[2]);
+            std::swap(p[1], p[2]);
+        }
+        const glm::vec2 uv[3] = {v[0].uv, v[1].uv, v[2].uv};
+        const UvGradient gradient = make_uv_gradient(p, uv);
+        const bool owns[3] = {owns_edge(p[1], p[2]), owns_edge(p[2], p[0]),
+                              owns_edge(p[0], p[1])};
+        auto inside = [&](float x, float y) {
+            const glm::vec2 center{x, y};
+            const float w[3] = {edge_function(p[1], p[2], center),
+                                edge_function(p[2], p[0], center),
+                                edge_function(p[0], p[1], center)};
+            for (int edge = 0; edge < 3; ++edge) {
+                if (w[edge] < 0 || (w[edge] == 0 && !owns[edge])) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        const float minY = std::min({p[0].y, p[1].y, p[2].y});
+        const float maxY = std::max({p[0].y, p[1].y, p[2].y});
+        const int yBegin = std::max(0, static_cast<int>(std::floor(minY)));
+        const int yEnd =
+            std::min(height, static_cast<int>(std::ceil(maxY)) + 1);
+        for (int y = yBegin; y < yEnd; ++y) {
+            const float centerY = y + 0.5f;
+            // Each edge bounds the row from one side; w is linear in x.
+            float low = -std::numeric_limits<float>::infinity();
+            float high = std::numeric_limits<float>::infinity();
+            bool empty = false;
+            for (int edge = 0; edge < 3 && !empty; ++edge) {
+                const glm::vec2 a = p[(edge + 1) % 3];
+                const glm::vec2 b = p[(edge + 2) % 3];
+                const float slope = b.y - a.y;
+                const float offset =
+                    (b.x - a.x) * (centerY - a.y) + slope * a.x;
+                if (slope > 0) {
+                    high = std::min(high, offset / slope);
+                } else if (slope < 0) {
+                    low = std::max(low, offset / slope);
+                } else {
+                    empty = offset < 0;
+                }
+            }
+            if (empty || low > high) {
+                continue;
+            }
+            // Widen by a pixel and settle the ends with the exact test.
+            int xBegin = std::max(
+                0, static_cast<int>(std::floor(std::max(low, -1.0f))) - 1);
+            int xEnd = std::min(
+                width, static_cast<int>(std::ceil(std::min(
+                           high, static_cast<float>(width)))) + 1);
+            while (xBegin < xEnd && !inside(xBegin + 0.5f, centerY)) {
+                ++xBegin;
+            }
+            while (xEnd > xBegin && !inside(xEnd - 0.5f, centerY)) {
+                --xEnd;
+            }
+            write_span(y, xBegin, xEnd, gradient, v[0].color);
+        }
+    }
+
+    // Texels are fetched nearest with wrapping, like the GPU path with
+    // texture repeat on. Vertex colors are flat per primitive.
+    void write_span(int y, int xBegin, int xEnd, const UvGradient& gradient,
+                    const uint8_t color[4]) {
+        if (xBegin >= xEnd) {
+            return;
+        }
+        uint8_t* pixel = target.data() +
+                         (static_cast<size_t>(y) * width + xBegin) * 4;
+        const glm::vec2 first = gradient.origin +
+                                gradient.dx * (xBegin + 0.5f) +
+                                gradient.dy * (y + 0.5f);
+        const glm::vec2 last =
+            first + gradient.dx * static_cast<float>(xEnd - 1 - xBegin);
+        // UVs are linear along the span, so checking its ends tells whether
+        // the whole span stays inside one repetition of the atlas.
+        const bool wraps = std::min(first.x, last.x) < 0 ||
+                           std::min(first.y, last.y) < 0 ||
+                           std::max(first.x, last.x) >= 1 ||
+                           std::max(first.y, last.y) >= 1;
+        if (wraps) {
+            write_span_texels<true>(pixel, xEnd - xBegin, first, gradient.dx,
+                                    color);
+        } else {
+            write_span_texels<false>(pixel, xEnd - xBegin, first, gradient.dx,
+                                     color);
+        }
+    }
+
+    template <bool Wrap>
+    void write_span_texels(uint8_t* pixel, int count, glm::vec2 uv,
+                           glm::vec2 step, const uint8_t color[4]) {
+        const float atlasWidth = static_cast<float>(atlas.width);
+        const float atlasHeight = static_cast<float>(atlas.height);
+        const bool whiteColor =
+            color[0] == 255 && color[1] == 255 && color[2] == 255;
+        for (int index = 0; index < count; ++index, pixel += 4, uv += step) {
+            int tx;
+            int ty;
+            if constexpr (Wrap) {
+                tx = static_cast<int>(std::floor(uv.x * atlasWidth)) %
+                     atlas.width;
+                ty = static_cast<int>(std::floor(uv.y * atlasHeight)) %
+                     atlas.height;
+                tx += tx < 0 ? atlas.width : 0;
+                ty += ty < 0 ? atlas.height : 0;
+            } else {
+                tx = std::min(static_cast<int>(uv.x * atlasWidth),
+                              atlas.width - 1);
+                ty = std::min(static_cast<int>(uv.y * atlasHeight),
+                              atlas.height - 1);
+            }
+            const uint8_t* texel =
+                atlas.rgba.data() +
+                (static_cast<size_t>(ty) * atlas.width + tx) * 4;
+
+            const int alpha = texel[3] * color[3] / 255;
+            if (blend == RasterBlend::REPLACE) {
+                for (int channel = 0; channel < 3; ++channel) {
+                    pixel[channel] = static_cast<uint8_t>(
+                        texel[channel] * color[channel] / 255);
+                }
+                pixel[3] = static_cast<uint8_t>(alpha);
+                continue;
+            }
+            if (alpha == 0) {
+                continue;
+            }
+            if (alpha == 255 && whiteColor) {
+                std::memcpy(pixel, texel, 3);
+                continue;
+            }
+            for (int channel = 0; channel < 3; ++channel) {
+                const int source = texel[channel] * color[channel] / 255;
+                pixel[channel] = static_cast<uint8_t>(
+                    (source * alpha + pixel[channel] * (255 - alpha)) / 255);
+            }
+        }
+    }
+
+    const OfflineAtlas& atlas;
+    std::vector<uint8_t>& target;
+    int width;
+    int height;
+    glm::vec2 scale;
+    RasterBlend blend;
+};
+
+// bm_add of a layer drawn with (bm_one, bm_zero), as the editor composes the
+// hold backgrounds.
+void add_layer(std::vector<uint8_t>& target,
+               const std::vector<uint8_t>& layer) {
+    for (size_t index = 0; index < target.size(); index += 4) {
+        const int alpha = layer[index + 3];
+        if (alpha == 0) {
+            continue;
+        }
+        for (int channel = 0; channel < 3; ++channel) {
+            target[index + channel] = static_cast<uint8_t>(std::min(
+                255, target[index + channel] +
+                         layer[index + channel] * alpha / 255));
+        }
+    }
+}
+
+}  // namespace
+
+void set_offline_render_atlas(int width, int height,
+                              std::span<const uint8_t> rgba) {
+    if (width <= 0 || height <= 0 ||
+        rgba.size() != static_cast<size_t>(width) * height * 4) {
+        throw std::invalid_argument("Atlas size does not match its pixels");
+    }
+    auto atlas = std::make_shared<OfflineAtlas>();
+    atlas->width = width;
+    atlas->height = height;
+    atlas->rgba.assign(rgba.begin(), rgba.end());
+    get_offline_atlas_store().set(std::move(atlas));
+}
+
+OfflineChartRenderer::OfflineChartRenderer(
+    const OfflineRenderSettings& settings, OfflineFrameSink sink)
+    : settings(settings), sink(std::move(sink)) {
+    if (settings.fps <= 0 || settings.width <= 0 || settings.height <= 0 ||
+        settings.noteSpeed <= 0 || settings.endTime < settings.startTime) {
+        throw std::invalid_argument("Invalid offline render settings");
+    }
+    // Frames at startTime + k / fps up to endTime, which counts as reached
+    // despite rounding.
+    frameCount = static_cast<size_t>(std::floor(
+                     (settings.endTime - settings.startTime) * settings.fps /
+                         1000.0 +
+                     1e-6)) +
+                 1;
+
+    const size_t slotCount = settings.framesInFlight > 0
+                                 ? settings.framesInFlight
+                                 : get_render_worker_count() + 1;
+    // Slots are captured by the render jobs, so they never move.
+    slots.resize(std::min(slotCount, frameCount));
+    const size_t frameBytes =
+        static_cast<size_t>(settings.width) * settings.height * 4;
+    for (auto& slot : slots) {
+        // Exports draw every note whatever the editor's LOD mode.
+        slot.context = create_render_context(true);
+        slot.pixels.resize(frameBytes);
+    }
+}
+
+OfflineChartRenderer::~OfflineChartRenderer() {
+    // Destroying a context waits for its in-flight job, which writes into the
+    // slot buffers.
+    for (const auto& slot : slots) {
+        try {
+            destroy_render_context(slot.context);
+        } catch (const std::exception& e) {
+            print_debug_message(
+                std::string("Error releasing offline render context: ") +
+                e.what());
+        }
+    }
+}
+
+void OfflineChartRenderer::request_frame(size_t frame) {
+    auto atlas = get_offline_atlas_store().get();
+    if (!atlas) {
+        throw std::logic_error("Offline render atlas is not set");
+    }
+
+    Slot* slot = &slots[frame % slots.size()];
+    const double nowTime =
+        settings.startTime + static_cast<double>(frame) * 1000.0 / settings.fps;
+    const int width = settings.width;
+    const int height = settings.height;
+    const uint32_t background = settings.background;
+    request_context_render(
+        slot->context, nowTime, settings.noteSpeed,
+        [slot, atlas = std::move(atlas), width, height,
+         background](const RenderContextVertices& vertices) {
+            PROFILE_SCOPE("Offline Frame Rasterize");
+            const glm::vec2 scale{static_cast<float>(width) / BASE_RES_W,
+                                  static_cast<float>(height) / BASE_RES_H};
+            const uint8_t clear[4] = {
+                static_cast<uint8_t>(background & 0xFF),
+                static_cast<uint8_t>((background >> 8) & 0xFF),
+                static_cast<uint8_t>((background >> 16) & 0xFF), 255};
+            for (size_t index = 0; index < slot->pixels.size(); index += 4) {
+                std::memcpy(slot->pixels.data() + index, clear, 4);
+            }
+
+            // Same order and blending as NoteRenderer.render().
+            Rasterizer(*atlas, slot->pixels, width, height, scale,
+                       RasterBlend::NORMAL)
+                .draw(vertices[1]);
+            if (!vertices[0].empty()) {
+                slot->layer.assign(slot->pixels.size(), 0);
+                Rasterizer(*atlas, slot->layer, width, height, scale,
+                           RasterBlend::REPLACE)
+                    .draw(vertices[0]);
+                add_layer(slot->pixels, slot->layer);
+            }
+            Rasterizer(*atlas, slot->pixels, width, height, scale,
+                       RasterBlend::NORMAL)
+                .draw(vertices[2]);
+        });
+}
+
+void OfflineChartRenderer::deliver_frame() {
+    const auto& slot = slots[deliveredFrames % slots.size()];
+    wait_context_render(slot.context);
+    if (sink(slot.pixels) != 0) {
+        throw std::runtime_error("Offline frame sink aborted rendering");
+    }
+    ++deliveredFrames;
+}
+
+bool OfflineChartRenderer::step(size_t maxFrames) {
+    PROFILE_SCOPE("Offline Render Step");
+    const auto begin = std::chrono::steady_clock::now();
+    auto fill_pipeline = [&] {
+        while (nextFrame < frameCount &&
+               nextFrame - deliveredFrames < slots.size()) {
+            request_frame(nextFrame++);
+        }
+    };
+
+    fill_pipeline();
+    for (size_t delivered = 0;
+         delivered < maxFrames && deliveredFrames < frameCount; ++delivered) {
+        deliver_frame();
+        fill_pipeline();
+    }
+    elapsedMs += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+    return deliveredFrames < frameCount;
+}
+
+void OfflineChartRenderer::run() {
+    while (step(SIZE_MAX)) {
+    }
+}
+
+double OfflineChartRenderer::get_progress() const {
+    return static_cast<double>(deliveredFrames) /
+           static_cast<double>(frameCount);
+}
+
+OfflineRenderStats OfflineChartRenderer::get_stats() const {
+    return {
+        .frameCount = frameCount,
+        .framesDelivered = deliveredFrames,
+        .elapsedMs = elapsedMs,
+        .framesPerSecond =
+            elapsedMs > 0 ? deliveredFrames * 1000.0 / elapsedMs : 0.0,
+    };
+}
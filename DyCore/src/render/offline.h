@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+// Headless chart video rendering. Frames are stepped at a fixed rate through
+// render contexts and rasterized on the CPU against the note sprite atlas, so
+// exports neither need a GPU nor run at playback speed.
+
+// The texture page holding the note sprites, as RGBA8. Sprite UVs index into
+// it. Must be set before rendering.
+void set_offline_render_atlas(int width, int height,
+                              std::span<const uint8_t> rgba);
+
+struct OfflineRenderSettings {
+    double startTime = 0.0;
+    double endTime = 0.0;
+    int fps = 60;
+    int width = 1920;
+    int height = 1080;
+    double noteSpeed = 1.0;
+    // BGR, drawn opaque behind the notes.
+    uint32_t background = 0;
+    // Frames rendered ahead of the sink. Zero uses the render worker count
+    // plus one.
+    size_t framesInFlight = 0;
+};
+
+struct OfflineRenderStats {
+    size_t frameCount = 0;
+    size_t framesDelivered = 0;
+    double elapsedMs = 0.0;
+    double framesPerSecond = 0.0;
+};
+
+// Receives finished RGBA frames in order. A non-zero return aborts rendering.
+using OfflineFrameSink = std::function<int(std::span<const uint8_t> frame)>;
+
+class OfflineChartRenderer {
+   public:
+    OfflineChartRenderer(const OfflineRenderSettings& settings,
+                         OfflineFrameSink sink);
+    ~OfflineChartRenderer();
+    OfflineChartRenderer(const OfflineChartRenderer&) = delete;
+    OfflineChartRenderer& operator=(const OfflineChartRenderer&) = delete;
+
+    // Delivers up to maxFrames more frames to the sink while keeping the
+    // pipeline full. Activation runs on the calling thread, rendering and
+    // rasterization on the render executor. Returns false once every frame
+    // has been delivered. Throws if a frame fails or the sink aborts.
+    bool step(size_t maxFrames);
+    void run();
+
+    double get_progress() const;
+    OfflineRenderStats get_stats() const;
+
+   private:
+    struct Slot {
+        int context = 0;
+        std::vector<uint8_t> pixels;
+        std::vector<uint8_t> layer;
+    };
+
+    void request_frame(size_t frame);
+    void deliver_frame();
+
+    OfflineRenderSettings settings;
+    OfflineFrameSink sink;
+    std::vector<Slot> slots;
+    size_t frameCount = 0;
+    size_t nextFrame = 0;
+    size_t deliveredFrames = 0;
+    double elapsedMs = 0.0;
+};
@@ -0,0 +1,235 @@
+#include "overview.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "note.h"
+#include "notePoolManager.h"
+#include "profile.h"
+#include "render.h"
+
+namespace {
+
+// Lateral positions run from 0 to 5 on every side.
+constexpr double OVERVIEW_LANE_UNITS = 5.0;
+// Normal, chain and hold counts per cell.
+constexpr size_t OVERVIEW_CELL_TYPES = 3;
+
+void validate_overview_settings(const OverviewSettings& settings) {
+    if (settings.width < 3 || settings.rowsPerTile < 1 ||
+        !(settings.msPerRow > 0) || !(settings.saturation > 0)) {
+        throw std::invalid_argument("Invalid overview settings");
+    }
+}
+
+class OverviewCache {
+   public:
+    std::span<const uint8_t> render(const OverviewSettings& newSettings) {
+        std::lock_guard<std::mutex> lock(mtx);
+        validate_overview_settings(newSettings);
+        if (newSettings != settings) {
+            settings = newSettings;
+            tiles.clear();
+            image.clear();
+            binned = false;
+        }
+
+        auto& pool = get_note_pool_manager();
+        const uint64_t generation = pool.get_last_modified_time();
+        if (binned && generation == binnedGeneration) {
+            stats.lastRenderedTiles = 0;
+            return image;
+        }
+        PROFILE_SCOPE("Overview Render");
+        binned = true;
+        binnedGeneration = generation;
+        ++stats.rebins;
+
+        const size_t tileCount = bin_notes(pool);
+        const bool layoutChanged = tileCount != tiles.size();
+        tiles.resize(tileCount);
+
+        // Only tiles whose bins changed are rasterized again.
+        std::vector<size_t> dirty;
+        for (size_t index = 0; index < tileCount; ++index) {
+            auto& tile = tiles[index];
+            if (tile.pixels.empty() || tile.bins != scratchBins[index]) {
+                tile.bins.swap(scratchBins[index]);
+                dirty.push_back(index);
+            }
+        }
+        run_render_tasks(dirty.size(), [&](size_t index) {
+            rasterize_tile(tiles[dirty[index]]);
+        });
+
+        const size_t tileBytes = get_tile_cells() * 4;
+        image.resize(tileCount * tileBytes);
+        auto place_tile = [&](size_t index) {
+            // The latest tile goes on top.
+            std::memcpy(image.data() + (tileCount - 1 - index) * tileBytes,
+                        tiles[index].pixels.data(), tileBytes);
+        };
+        if (layoutChanged) {
+            for (size_t index = 0; index < tileCount; ++index) {
+                place_tile(index);
+            }
+        } else {
+            for (const size_t index : dirty) {
+                place_tile(index);
+            }
+        }
+
+        if (layoutChanged || !dirty.empty()) {
+            ++stats.version;
+        }
+        stats.tileCount = tileCount;
+        stats.height = tileCount * static_cast<size_t>(settings.rowsPerTile);
+        stats.lastRenderedTiles = dirty.size();
+        stats.tilesRendered += dirty.size();
+        return image;
+    }
+
+    OverviewStats get_stats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+   private:
+    struct Tile {
+        std::vector<uint32_t> bins;
+        std::vector<uint8_t> pixels;
+    };
+
+    size_t get_tile_cells() const {
+        return static_cast<size_t>(settings.rowsPerTile) * settings.width;
+    }
+
+    // Fills scratchBins with the note counts of every tile and returns the
+    // number of tiles covering the chart.
+    size_t bin_notes(const NotePoolManager& pool) {
+        const size_t binCount = get_tile_cells() * OVERVIEW_CELL_TYPES;
+        const double tileDuration = settings.msPerRow * settings.rowsPerTile;
+        size_t tileCount = std::max<size_t>(
+            1,
+            static_cast<size_t>(std::ceil(settings.duration / tileDuration)));
+        auto ensure_tiles = [&](size_t count) {
+            tileCount = std::max(tileCount, count);
+            if (scratchBins.size() < tileCount) {
+                scratchBins.resize(tileCount);
+            }
+        };
+        ensure_tiles(tileCount);
+        for (auto& bins : scratchBins) {
+            bins.assign(binCount, 0);
+        }
+
+        const int width = settings.width;
+        pool.for_each_note([&](const Note& note) {
+            if (note.get_note_type() == NOTE_TYPE::SUB) {
+                return;
+            }
+            // Bands from left to right: left side, down side, right side.
+            const int band = note.side == 1 ? 0 : note.side == 0 ? 1 : 2;
+            const int bandBegin = band * width / 3;
+            const int bandWidth = (band + 1) * width / 3 - bandBegin;
+            const double left =
+                (note.position - note.width / 2) / OVERVIEW_LANE_UNITS;
+            const double right =
+                (note.position + note.width / 2) / OVERVIEW_LANE_UNITS;
+            const int columnBegin = std::clamp(
+                static_cast<int>(std::floor(left * bandWidth)), 0,
+                bandWidth - 1);
+            const int columnEnd = std::clamp(
+                static_cast<int>(std::ceil(right * bandWidth)),
+                columnBegin + 1, bandWidth);
+
+            const size_t type = std::min<size_t>(note.type, 2);
+            const double endTime = note.get_note_type() == NOTE_TYPE::HOLD
+                                       ? note.time + note.lastTime
+                                       : note.time;
+            const size_t rowBegin = static_cast<size_t>(
+                std::floor(std::max(note.time, 0.0) / settings.msPerRow));
+            const size_t rowEnd = static_cast<size_t>(
+                std::floor(std::max(endTime, 0.0) / settings.msPerRow));
+            ensure_tiles(rowEnd / settings.rowsPerTile + 1);
+            for (size_t row = rowBegin; row <= rowEnd; ++row) {
+                auto& bins = scratchBins[row / settings.rowsPerTile];
+                if (bins.empty()) {
+                    bins.assign(binCount, 0);
+                }
+                const size_t rowOffset = row % settings.rowsPerTile * width;
+                for (int column = columnBegin; column < columnEnd; ++column) {
+                    ++bins[(rowOffset + bandBegin + column) *
+                               OVERVIEW_CELL_TYPES +
+                           type];
+                }
+            }
+        });
+        for (size_t index = 0; index < tileCount; ++index) {
+            if (scratchBins[index].empty()) {
+                scratchBins[index].assign(binCount, 0);
+            }
+        }
+        return tileCount;
+    }
+
+    void rasterize_tile(Tile& tile) const {
+        const size_t cells = get_tile_cells();
+        tile.pixels.resize(cells * 4);
+        const size_t width = static_cast<size_t>(settings.width);
+        const size_t rows = static_cast<size_t>(settings.rowsPerTile);
+        for (size_t row = 0; row < rows; ++row) {
+            // Time runs upwards within the tile.
+            uint8_t* pixel = tile.pixels.data() + (rows - 1 - row) * width * 4;
+            const uint32_t* cell =
+                tile.bins.data() + row * width * OVERVIEW_CELL_TYPES;
+            for (size_t column = 0; column < width;
+                 ++column, pixel += 4, cell += OVERVIEW_CELL_TYPES) {
+                const uint32_t total = cell[0] + cell[1] + cell[2];
+                if (total == 0) {
+                    std::memset(pixel, 0, 4);
+                    continue;
+                }
+                for (size_t channel = 0; channel < 3; ++channel) {
+                    uint64_t sum = 0;
+                    for (size_t type = 0; type < OVERVIEW_CELL_TYPES; ++type) {
+                        const uint32_t color = settings.colors[type];
+                        sum += static_cast<uint64_t>(cell[type]) *
+                               ((color >> (8 * channel)) & 0xFF);
+                    }
+                    pixel[channel] = static_cast<uint8_t>(sum / total);
+                }
+                pixel[3] = static_cast<uint8_t>(std::lround(
+                    std::min(1.0, total / settings.saturation) * 255));
+            }
+        }
+    }
+
+    std::mutex mtx;
+    OverviewSettings settings;
+    bool binned = false;
+    uint64_t binnedGeneration = 0;
+    std::vector<Tile> tiles;
+    std::vector<std::vector<uint32_t>> scratchBins;
+    std::vector<uint8_t> image;
+    OverviewStats stats;
+};
+
+OverviewCache& get_overview_cache() {
+    static OverviewCache cache;
+    return cache;
+}
+
+}  // namespace
+
+std::span<const uint8_t> render_overview(const OverviewSettings& settings) {
+    return get_overview_cache().render(settings);
+}
+
+OverviewStats get_overview_stats() {
+    return get_overview_cache().get_stats();
+}
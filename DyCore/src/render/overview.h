@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Whole-chart overview for minimaps and scrollbar previews. The chart is cut
+// into tiles of rowsPerTile rows, each row covering msPerRow of time. The
+// image is width pixels wide with a band per side (left, down, right); a cell
+// is coloured by the note types in it and opaque in proportion to how many
+// notes it holds. Tiles are stacked so the top row is the latest time.
+struct OverviewSettings {
+    int width = 96;
+    int rowsPerTile = 256;
+    double msPerRow = 50.0;
+    // Covered length besides the notes, e.g. the music length.
+    double duration = 0.0;
+    // Notes per cell drawn fully opaque.
+    double saturation = 4.0;
+    // BGR colours of normal, chain and hold notes.
+    std::array<uint32_t, 3> colors = {0xF39621, 0x3643F4, 0x50AF4C};
+
+    bool operator==(const OverviewSettings&) const = default;
+};
+
+// Rebins the notes if the pool changed since the last call and re-renders
+// only the tiles whose bins differ, on the render executor. The span stays
+// valid until the next call. Must run on the thread that edits notes.
+std::span<const uint8_t> render_overview(const OverviewSettings& settings);
+
+struct OverviewStats {
+    size_t tileCount = 0;
+    size_t height = 0;
+    // Bumped whenever the image content changes.
+    uint64_t version = 0;
+    size_t lastRenderedTiles = 0;
+    uint64_t tilesRendered = 0;
+    uint64_t rebins = 0;
+};
+
+OverviewStats get_overview_stats();
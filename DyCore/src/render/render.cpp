@@ -1,12 +1,27 @@
 #include "render.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <format>
+#include <future>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <taskflow/algorithm/for_each.hpp>
 #include <taskflow/taskflow.hpp>
+#include <unordered_map>
 #include <vector>
 
 #include "activation.h"
@@ -425,6 +440,7 @@ void draw_sprite_part(char*& vertBuf, const SpriteData& sprite,
 
 // 1 Quad = 6 Vertices = 120 Bytes
 constexpr size_t BYTES_PER_QUAD = 120;
+constexpr size_t BYTES_PER_VERTEX = BYTES_PER_QUAD / 6;
 
 size_t get_sprite_max_bytes(const SpriteData& sprite) {
     try {
@@ -461,6 +477,58 @@ struct RenderSource {
     RenderItemKind kind;
 };
 
+// Side whose travel axis the source's vertices scroll along, or -1 for hold
+// parts already pinned to the judge line.
+int get_shift_side(const RenderSource& source, double nowTime) {
+    if (source.kind != RenderItemKind::NORMAL && source.note->time < nowTime) {
+        return -1;
+    }
+    return std::clamp(source.note->side, 0, 2);
+}
+
+// A run of rendered bytes whose vertices scroll along one side's travel axis.
+struct RenderShiftSpan {
+    size_t begin = 0;
+    size_t end = 0;
+    int side = 0;
+    // Side notes fade towards the screen centre. Their alpha was taken from
+    // the farthest of the heads between these positions on the travel axis,
+    // times alphaScale.
+    float alphaAxisMin = 0.0f;
+    float alphaAxisMax = 0.0f;
+    double alphaScale = 1.0;
+};
+
+// The shift span of a source, without its byte range.
+RenderShiftSpan make_shift_span(const RenderSource& source, double nowTime,
+                                double noteSpeed) {
+    RenderShiftSpan span{.side = get_shift_side(source, nowTime)};
+    if (span.side > 0) {
+        span.alphaAxisMin = span.alphaAxisMax =
+            get_note_pos(*source.note, nowTime, noteSpeed).x;
+        if (source.kind == RenderItemKind::HOLD_BACKGROUND) {
+            span.alphaScale = HOLD_BG_LIGHTNESS;
+        }
+    }
+    return span;
+}
+
+void append_shift_span(std::vector<RenderShiftSpan>& spans, size_t begin,
+                       size_t byteSize, const RenderShiftSpan& shift) {
+    if (byteSize == 0 || shift.side < 0) {
+        return;
+    }
+    // Side notes keep a span each, as their alpha differs.
+    if (shift.side == 0 && !spans.empty() && spans.back().side == 0 &&
+        spans.back().end == begin) {
+        spans.back().end += byteSize;
+    } else {
+        auto& span = spans.emplace_back(shift);
+        span.begin = begin;
+        span.end = begin + byteSize;
+    }
+}
+
 struct PreparedSprite {
     const SpriteRenderData* renderData = nullptr;
     PIVOT pivot = PIVOT::CENTER;
@@ -480,6 +548,18 @@ struct alignas(64) RenderChunk {
     bool requiresPreparation = true;
 };
 
+// A prepared sprite plus the screen extents the LOD pass merges by. axis runs
+// along the note's travel direction and lateral across it.
+struct LodItem {
+    PreparedSprite sprite;
+    RenderItemKind kind = RenderItemKind::NORMAL;
+    int side = 0;
+    RenderShiftSpan shift;
+    float axis = 0.0f;
+    float lateralBegin = 0.0f;
+    float lateralEnd = 0.0f;
+};
+
 size_t get_sprite_render_bytes(const SpriteData& sprite, glm::vec2 size) {
     switch (sprite.drawSetting.type) {
         case SPRITE_DRAW_TYPE::REPEAT_VERT:
@@ -501,7 +581,7 @@ size_t get_sprite_render_bytes(const SpriteData& sprite, glm::vec2 size) {
 }
 
 size_t renderWorkerCountOverride = 0;
-bool renderWorkspaceInitialized = false;
+bool renderExecutorInitialized = false;
 
 int configured_render_worker_count() {
     const int availableWorkerCount = std::max(1, hardware_concurrency());
@@ -513,16 +593,41 @@ int configured_render_worker_count() {
                            static_cast<size_t>(availableWorkerCount)));
 }
 
-class RenderWorkspace {
+// The executor is shared by the synchronous render path and the pipelined
+// frame jobs, so both draw from the same worker budget.
+class RenderExecutor {
    public:
-    RenderWorkspace()
+    RenderExecutor()
         : workerCount(configured_render_worker_count()),
           executor(static_cast<size_t>(workerCount)) {
-        renderWorkspaceInitialized = true;
+        renderExecutorInitialized = true;
+    }
+
+    // Pipelined frames run their taskflows from inside a worker. Blocking on
+    // run().get() there could starve the pool, so cooperate instead.
+    void run_and_wait(tf::Taskflow& taskflow) {
+        if (executor.this_worker_id() >= 0) {
+            executor.corun(taskflow);
+        } else {
+            executor.run(taskflow).get();
+        }
     }
 
     int workerCount;
     tf::Executor executor;
+};
+
+RenderExecutor& get_render_executor() {
+    static RenderExecutor renderExecutor;
+    return renderExecutor;
+}
+
+class RenderScheduler;
+class RenderLodStatsTable;
+
+// Per-caller scratch memory. Each concurrent render needs its own workspace.
+class RenderWorkspace {
+   public:
     tf::Taskflow taskflow;
     std::vector<RenderSource> sources;
     std::vector<RenderSource> deferredSources;
@@ -531,6 +636,18 @@ class RenderWorkspace {
     std::vector<RenderChunk> chunks;
     std::vector<tf::Task> prepareTasks;
     std::vector<tf::Task> renderTasks;
+    std::vector<LodItem> lodItems;
+    std::vector<LodItem> lodMerged;
+    std::vector<size_t> lodOrder;
+    std::vector<char> lodKeep;
+    // Filled with the scrolling spans of the output when set.
+    std::vector<RenderShiftSpan>* shiftSpans = nullptr;
+    // Owner's schedule measurements; null means the editor's.
+    RenderScheduler* scheduler = nullptr;
+    // Owner's LOD results; null means the editor's.
+    RenderLodStatsTable* lodStats = nullptr;
+    // Draws every note in full whatever the LOD mode, e.g. for exports.
+    bool fullDetail = false;
 };
 
 RenderWorkspace& get_render_workspace() {
@@ -540,27 +657,721 @@ RenderWorkspace& get_render_workspace() {
 
 }  // namespace
 
+size_t get_render_worker_count() {
+    return static_cast<size_t>(get_render_executor().workerCount);
+}
+
+tf::Executor& get_shared_executor() {
+    return get_render_executor().executor;
+}
+
+void run_on_shared_executor(tf::Taskflow& taskflow) {
+    get_render_executor().run_and_wait(taskflow);
+}
+
+void run_render_tasks(size_t count,
+                      const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    auto& renderExecutor = get_render_executor();
+    if (count == 1 || renderExecutor.workerCount <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            task(index);
+        }
+        return;
+    }
+    tf::Taskflow taskflow;
+    taskflow.for_each_index(size_t{0}, count, size_t{1}, task);
+    renderExecutor.run_and_wait(taskflow);
+}
+
 void set_render_worker_count_override(size_t workerCount) {
-    if (renderWorkspaceInitialized) {
+    if (renderExecutorInitialized) {
         throw std::logic_error(
             "Render worker count must be configured before the first render");
     }
     renderWorkerCountOverride = workerCount;
 }
 
-// For param state:
-//   0: Render addition bg
-//   1: Render hold bg
-//   2: Render other parts
-size_t render_active_notes(char* const vertexBuffer, double nowTime,
-                           double noteSpeed, int state) {
-    PROFILE_SCOPE(std::format("Render Active Notes (State {})", state));
+namespace {
 
-    // Get active notes list.
-    const auto& actMan = get_note_activation_manager();
-    const auto& activeNotes = actMan.get_active_notes();
-    const auto& activeHolds = actMan.get_active_holds();
-    const auto& lastingHolds = actMan.get_lasting_holds();
+using RenderClock = std::chrono::steady_clock;
+
+double elapsed_ns(RenderClock::time_point begin) {
+    return std::chrono::duration<double, std::nano>(RenderClock::now() - begin)
+        .count();
+}
+
+// AUTO mode candidates. Arm 0 is serial; arm i runs parallel with
+// RENDER_AUTO_CHUNKS_PER_WORKER[i - 1] chunks per worker.
+constexpr std::array<size_t, 3> RENDER_AUTO_CHUNKS_PER_WORKER = {1, 4, 16};
+constexpr size_t RENDER_AUTO_ARM_COUNT =
+    RENDER_AUTO_CHUNKS_PER_WORKER.size() + 1;
+// Item counts are bucketed by power of two, since the fixed cost of a parallel
+// run only pays off above some size.
+constexpr size_t RENDER_AUTO_BUCKET_COUNT = 32;
+// Every this many renders of a slot, the least recently used arm is retried so
+// the measurements follow changes in load.
+constexpr uint64_t RENDER_AUTO_PROBE_INTERVAL = 64;
+constexpr double RENDER_AUTO_SMOOTHING = 0.2;
+
+std::atomic<RENDER_SCHEDULE_MODE> renderScheduleMode =
+    RENDER_SCHEDULE_MODE::STATIC;
+
+// Renders in flight in the low bits and a count of render starts and ends
+// above them, so a render can tell whether another one overlapped it.
+constexpr uint64_t RENDER_RUN_EVENT = uint64_t{1} << 32;
+constexpr uint64_t RENDER_RUN_COUNT_MASK = RENDER_RUN_EVENT - 1;
+std::atomic<uint64_t> renderRunState = 0;
+
+// Marks a timed render region. Wall times of renders that shared the executor
+// with another render measure contention, not their own cost.
+class RenderRunProbe {
+   public:
+    RenderRunProbe() {
+        const uint64_t previous =
+            renderRunState.fetch_add(RENDER_RUN_EVENT + 1);
+        aloneAtStart = (previous & RENDER_RUN_COUNT_MASK) == 0;
+        startEvent = (previous >> 32) + 1;
+    }
+    RenderRunProbe(const RenderRunProbe&) = delete;
+    RenderRunProbe& operator=(const RenderRunProbe&) = delete;
+    ~RenderRunProbe() {
+        if (running) {
+            finish();
+        }
+    }
+
+    // Ends the region. True if no other render started or ended meanwhile.
+    bool finish() {
+        running = false;
+        const uint64_t previous =
+            renderRunState.fetch_add(RENDER_RUN_EVENT - 1);
+        return aloneAtStart && (previous >> 32) == startEvent &&
+               (previous & RENDER_RUN_COUNT_MASK) == 1;
+    }
+
+   private:
+    bool running = true;
+    bool aloneAtStart = false;
+    uint64_t startEvent = 0;
+};
+
+// Chooses serial or parallel execution and the chunk count per render slot.
+// In AUTO mode this picks the arm with the lowest measured wall time per item
+// for renders of similar size. The editor, the render pipeline and every
+// render context keep their own measurements.
+class RenderScheduler {
+   public:
+    struct Plan {
+        bool parallel;
+        size_t chunkCount;
+        size_t bucket;
+        size_t arm;
+    };
+
+    Plan plan(int slot, size_t itemCount, bool staticParallel,
+              int workerCount) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& state = slots.at(slot);
+        const size_t bucket =
+            std::min<size_t>(std::bit_width(std::max<size_t>(itemCount, 1)) - 1,
+                             RENDER_AUTO_BUCKET_COUNT - 1);
+        auto& arms = state.buckets[bucket];
+        const size_t staticArm = staticParallel ? 2 : 0;
+        size_t arm = staticArm;
+        ++state.renders;
+
+        if (renderScheduleMode == RENDER_SCHEDULE_MODE::AUTO &&
+            workerCount > 1 &&
+            itemCount > 1 && arms[staticArm].runs > 0) {
+            auto untried =
+                std::find_if(arms.begin(), arms.end(),
+                             [](const Arm& a) { return a.runs == 0; });
+            if (untried != arms.end()) {
+                arm = untried - arms.begin();
+            } else if (state.renders % RENDER_AUTO_PROBE_INTERVAL == 0) {
+                arm = std::min_element(arms.begin(), arms.end(),
+                                       [](const Arm& a, const Arm& b) {
+                                           return a.lastUsed < b.lastUsed;
+                                       }) -
+                      arms.begin();
+            } else {
+                arm = std::min_element(arms.begin(), arms.end(),
+                                       [](const Arm& a, const Arm& b) {
+                                           return a.nsPerItem < b.nsPerItem;
+                                       }) -
+                      arms.begin();
+            }
+        }
+        arms[arm].lastUsed = state.renders;
+
+        Plan result{.parallel = arm != 0,
+                    .chunkCount = 1,
+                    .bucket = bucket,
+                    .arm = arm};
+        if (result.parallel) {
+            result.chunkCount =
+                std::min(itemCount, static_cast<size_t>(workerCount) *
+                                        RENDER_AUTO_CHUNKS_PER_WORKER[arm - 1]);
+        }
+        state.stats.parallel = result.parallel;
+        state.stats.chunkCount = result.chunkCount;
+        state.stats.itemCount = itemCount;
+        return result;
+    }
+
+    // Only renders that ran alone update the arm measurements.
+    void record(int slot, const Plan& plan, size_t itemCount, double wallNs,
+                bool ranAlone) {
+        if (itemCount == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& state = slots.at(slot);
+        auto& arms = state.buckets[plan.bucket];
+        auto& stats = state.stats;
+        ++(plan.parallel ? stats.parallelRuns : stats.serialRuns);
+        stats.lastWallNs = wallNs;
+        if (!ranAlone) {
+            ++stats.sharedRuns;
+            return;
+        }
+
+        auto& arm = arms[plan.arm];
+        const double sample = wallNs / itemCount;
+        arm.nsPerItem =
+            arm.runs == 0
+                ? sample
+                : arm.nsPerItem + RENDER_AUTO_SMOOTHING * (sample - arm.nsPerItem);
+        ++arm.runs;
+
+        stats.serialItemNs = arms[0].nsPerItem;
+        stats.parallelItemNs = 0.0;
+        for (size_t index = 1; index < arms.size(); ++index) {
+            if (arms[index].runs > 0 &&
+                (stats.parallelItemNs == 0.0 ||
+                 arms[index].nsPerItem < stats.parallelItemNs)) {
+                stats.parallelItemNs = arms[index].nsPerItem;
+            }
+        }
+    }
+
+    RenderScheduleStats get_stats(int slot) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return slots.at(slot).stats;
+    }
+    void reset() {
+        std::lock_guard<std::mutex> lock(mtx);
+        slots = {};
+    }
+
+   private:
+    struct Arm {
+        double nsPerItem = 0.0;
+        uint64_t runs = 0;
+        uint64_t lastUsed = 0;
+    };
+    struct SlotState {
+        std::array<std::array<Arm, RENDER_AUTO_ARM_COUNT>,
+                   RENDER_AUTO_BUCKET_COUNT>
+            buckets{};
+        uint64_t renders = 0;
+        RenderScheduleStats stats;
+    };
+
+    std::mutex mtx;
+    std::array<SlotState, RENDER_SCHEDULE_SLOT_COUNT> slots;
+};
+
+// Measurements of the synchronous editor renders.
+RenderScheduler& get_render_scheduler() {
+    static RenderScheduler scheduler;
+    return scheduler;
+}
+
+RenderScheduler& get_workspace_scheduler(RenderWorkspace& workspace) {
+    return workspace.scheduler != nullptr ? *workspace.scheduler
+                                          : get_render_scheduler();
+}
+
+}  // namespace
+
+void set_render_schedule_mode(RENDER_SCHEDULE_MODE mode) {
+    renderScheduleMode = mode;
+}
+
+RENDER_SCHEDULE_MODE get_render_schedule_mode() {
+    return renderScheduleMode;
+}
+
+RenderScheduleStats get_render_schedule_stats(int slot) {
+    return get_render_scheduler().get_stats(slot);
+}
+
+namespace {
+
+// Settings of the level-of-detail pass, shared by every renderer.
+class RenderLodController {
+   public:
+    struct Settings {
+        RENDER_LOD_MODE mode;
+        size_t vertexCap;
+    };
+
+    Settings get_settings() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return {mode, vertexCap};
+    }
+    void set_mode(RENDER_LOD_MODE newMode) {
+        std::lock_guard<std::mutex> lock(mtx);
+        mode = newMode;
+    }
+    RENDER_LOD_MODE get_mode() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return mode;
+    }
+    void set_vertex_cap(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mtx);
+        vertexCap = bytes;
+    }
+
+   private:
+    std::mutex mtx;
+    RENDER_LOD_MODE mode = RENDER_LOD_MODE::OFF;
+    size_t vertexCap = RENDER_LOD_DEFAULT_VERTEX_CAP;
+};
+
+RenderLodController& get_render_lod_controller() {
+    static RenderLodController controller;
+    return controller;
+}
+
+// LOD results of the latest render of each state by one renderer.
+class RenderLodStatsTable {
+   public:
+    void set(int state, const RenderLodStats& newStats) {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.at(state) = newStats;
+    }
+    RenderLodStats get(int state) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats.at(state);
+    }
+
+   private:
+    std::mutex mtx;
+    std::array<RenderLodStats, 3> stats;
+};
+
+RenderLodStatsTable& get_render_lod_stats_table() {
+    static RenderLodStatsTable table;
+    return table;
+}
+
+RenderLodStatsTable& get_workspace_lod_stats(RenderWorkspace& workspace) {
+    return workspace.lodStats != nullptr ? *workspace.lodStats
+                                         : get_render_lod_stats_table();
+}
+
+}  // namespace
+
+void set_render_lod_mode(RENDER_LOD_MODE mode) {
+    get_render_lod_controller().set_mode(mode);
+}
+
+RENDER_LOD_MODE get_render_lod_mode() {
+    return get_render_lod_controller().get_mode();
+}
+
+void set_render_lod_vertex_cap(size_t bytes) {
+    get_render_lod_controller().set_vertex_cap(bytes);
+}
+
+RenderLodStats get_render_lod_stats(int state) {
+    return get_render_lod_stats_table().get(state);
+}
+
+namespace {
+
+void draw_prepared_sprite(char*& out, const PreparedSprite& prepared) {
+    if (prepared.renderData == nullptr)
+        return;
+    char* const begin = out;
+    draw_sprite(out, *prepared.renderData, prepared.pivot, prepared.position,
+                prepared.size, prepared.rotation, prepared.color);
+    if (static_cast<size_t>(out - begin) != prepared.byteSize) {
+        throw std::runtime_error(
+            "Prepared sprite byte count does not match rendered output");
+    }
+}
+
+// Length of the visible lane between the judge line and the far screen edge.
+double get_lane_pixels(int side) {
+    return side == 0 ? BASE_RES_H - JUDGE_LINE_BELOW_FROM_BOTTOM
+                     : BASE_RES_W / 2.0 - JUDGE_LINE_SIDE_FROM_EDGE;
+}
+
+float get_judge_distance(int side, float axis) {
+    switch (side) {
+        case 0:
+            return BASE_RES_H - JUDGE_LINE_BELOW_FROM_BOTTOM - axis;
+        case 1:
+            return axis - JUDGE_LINE_SIDE_FROM_EDGE;
+        default:
+            return BASE_RES_W - JUDGE_LINE_SIDE_FROM_EDGE - axis;
+    }
+}
+
+// NORMAL-typed copies of the hold sprites, so LOD can draw them as one
+// stretched quad. The render data points into this object, so it stays put.
+struct LodSimpleSprites {
+    LodSimpleSprites(const SpriteData& edge, const SpriteData& bar,
+                     const SpriteData& background)
+        : holdEdge(as_single_quad(edge)),
+          holdBar(as_single_quad(bar)),
+          holdBackground(as_single_quad(background)),
+          holdEdgeData(make_sprite_render_data(holdEdge)),
+          holdBarData(make_sprite_render_data(holdBar)),
+          holdBackgroundData(make_sprite_render_data(holdBackground)) {}
+    LodSimpleSprites(const LodSimpleSprites&) = delete;
+    LodSimpleSprites& operator=(const LodSimpleSprites&) = delete;
+
+    static SpriteData as_single_quad(SpriteData sprite) {
+        sprite.drawSetting.type = SPRITE_DRAW_TYPE::NORMAL;
+        return sprite;
+    }
+
+    const SpriteData holdEdge;
+    const SpriteData holdBar;
+    const SpriteData holdBackground;
+    const SpriteRenderData holdEdgeData;
+    const SpriteRenderData holdBarData;
+    const SpriteRenderData holdBackgroundData;
+};
+
+// Merges tap and chain notes that share a side and a row of rowPixels and
+// overlap laterally. Other items and the order between runs are kept. Within a
+// side the items arrive in time order, so rows come in runs and only each run
+// needs sorting by lateral position.
+void merge_lod_rows(const std::vector<LodItem>& items,
+                    std::vector<LodItem>& merged, std::vector<size_t>& order,
+                    float rowPixels) {
+    auto get_row = [&](const LodItem& item) {
+        return std::floor(item.axis / rowPixels);
+    };
+
+    merged.clear();
+    for (size_t begin = 0; begin < items.size();) {
+        size_t end = begin + 1;
+        while (end < items.size() && items[end].kind == items[begin].kind &&
+               items[end].sprite.renderData ==
+                   items[begin].sprite.renderData) {
+            ++end;
+        }
+        if (items[begin].kind != RenderItemKind::NORMAL) {
+            merged.insert(merged.end(), items.begin() + begin,
+                          items.begin() + end);
+            begin = end;
+            continue;
+        }
+
+        // Group by side, keeping the time order inside each side.
+        order.clear();
+        order.reserve(end - begin);
+        for (int side = 0; side < 3; ++side) {
+            for (size_t index = begin; index < end; ++index) {
+                if (std::clamp(items[index].side, 0, 2) == side) {
+                    order.push_back(index);
+                }
+            }
+        }
+
+        for (size_t runBegin = 0; runBegin < order.size();) {
+            const auto& first = items[order[runBegin]];
+            const float row = get_row(first);
+            size_t runEnd = runBegin + 1;
+            while (runEnd < order.size() &&
+                   items[order[runEnd]].side == first.side &&
+                   get_row(items[order[runEnd]]) == row) {
+                ++runEnd;
+            }
+            std::sort(order.begin() + runBegin, order.begin() + runEnd,
+                      [&](size_t left, size_t right) {
+                          return items[left].lateralBegin <
+                                 items[right].lateralBegin;
+                      });
+
+            for (size_t index = runBegin; index < runEnd;) {
+                LodItem group = items[order[index]];
+                float axisMin = group.axis;
+                float axisMax = group.axis;
+                size_t next = index + 1;
+                for (; next < runEnd; ++next) {
+                    const auto& item = items[order[next]];
+                    if (item.lateralBegin > group.lateralEnd) {
+                        break;
+                    }
+                    group.lateralEnd =
+                        std::max(group.lateralEnd, item.lateralEnd);
+                    axisMin = std::min(axisMin, item.axis);
+                    axisMax = std::max(axisMax, item.axis);
+                    group.sprite.color.w =
+                        std::max(group.sprite.color.w, item.sprite.color.w);
+                    group.shift.alphaAxisMin = std::min(
+                        group.shift.alphaAxisMin, item.shift.alphaAxisMin);
+                    group.shift.alphaAxisMax = std::max(
+                        group.shift.alphaAxisMax, item.shift.alphaAxisMax);
+                }
+                if (next - index > 1) {
+                    // Rows wider than the sprite stretch it into a density
+                    // bar.
+                    auto& sprite = group.sprite;
+                    const float lateral =
+                        (group.lateralBegin + group.lateralEnd) / 2.0f;
+                    group.axis = (axisMin + axisMax) / 2.0f;
+                    sprite.size = {group.lateralEnd - group.lateralBegin,
+                                   sprite.size.y + (axisMax - axisMin)};
+                    sprite.position = group.side == 0
+                                          ? glm::vec2{lateral, group.axis}
+                                          : glm::vec2{group.axis, lateral};
+                    sprite.byteSize = get_sprite_render_bytes(
+                        *sprite.renderData->sprite, sprite.size);
+                }
+                merged.push_back(group);
+                index = next;
+            }
+            runBegin = runEnd;
+        }
+        begin = end;
+    }
+}
+
+size_t sum_lod_bytes(const std::vector<LodItem>& items) {
+    size_t bytes = 0;
+    for (const auto& item : items) {
+        bytes += item.sprite.byteSize;
+    }
+    return bytes;
+}
+
+constexpr size_t RENDER_LOD_PARALLEL_PREPARE_ITEMS = 4096;
+
+// LOD render of one state. sources and prepare_source are those of
+// render_resolved_notes, so the full-detail geometry is the starting point.
+template <typename PrepareSource>
+size_t render_lod_sources(char* const vertexBuffer,
+                          std::span<const RenderSource> sources,
+                          PrepareSource&& prepare_source,
+                          const LodSimpleSprites& simple, float holdTileHeight,
+                          size_t vertexCap, double nowTime, double noteSpeed,
+                          RenderWorkspace& workspace, RenderLodStats& stats) {
+    auto& items = workspace.lodItems;
+    auto& merged = workspace.lodMerged;
+    items.resize(sources.size());
+    auto prepare_range = [&](size_t begin, size_t end) {
+        for (size_t index = begin; index < end; ++index) {
+            const auto& source = sources[index];
+            auto& item = items[index];
+            item = {.sprite = prepare_source(source),
+                    .kind = source.kind,
+                    .side = source.note->side,
+                    .shift = make_shift_span(source, nowTime, noteSpeed)};
+            auto& sprite = item.sprite;
+            if (sprite.renderData == nullptr) {
+                continue;
+            }
+            if (item.kind == RenderItemKind::HOLD_EDGE &&
+                sprite.size.y < holdTileHeight) {
+                sprite.renderData = &simple.holdEdgeData;
+                sprite.byteSize = BYTES_PER_QUAD;
+            }
+            const bool vertical = item.side == 0;
+            const float lateral =
+                vertical ? sprite.position.x : sprite.position.y;
+            item.axis = vertical ? sprite.position.y : sprite.position.x;
+            item.lateralBegin = lateral - sprite.size.x / 2.0f;
+            item.lateralEnd = lateral + sprite.size.x / 2.0f;
+        }
+    };
+
+    // Preparation is the bulk of the work before merging shrinks the list.
+    auto& renderExecutor = get_render_executor();
+    if (renderExecutor.workerCount > 1 &&
+        sources.size() >= RENDER_LOD_PARALLEL_PREPARE_ITEMS) {
+        const size_t chunkCount =
+            static_cast<size_t>(renderExecutor.workerCount);
+        const size_t chunkSize = (sources.size() + chunkCount - 1) / chunkCount;
+        auto& taskflow = workspace.taskflow;
+        taskflow.clear();
+        for (size_t begin = 0; begin < sources.size(); begin += chunkSize) {
+            const size_t end = std::min(begin + chunkSize, sources.size());
+            taskflow.emplace([&, begin, end] { prepare_range(begin, end); });
+        }
+        renderExecutor.run_and_wait(taskflow);
+    } else {
+        prepare_range(0, sources.size());
+    }
+    std::erase_if(items, [](const LodItem& item) {
+        return item.sprite.renderData == nullptr;
+    });
+    const bool mergeable =
+        std::any_of(items.begin(), items.end(), [](const LodItem& item) {
+            return item.kind == RenderItemKind::NORMAL;
+        });
+
+    float rowPixels = 1.0f;
+    merge_lod_rows(items, merged, workspace.lodOrder, rowPixels);
+    size_t bytes = sum_lod_bytes(merged);
+    if (bytes > vertexCap) {
+        for (auto& item : merged) {
+            auto& sprite = item.sprite;
+            switch (item.kind) {
+                case RenderItemKind::HOLD_EDGE:
+                    sprite.renderData = &simple.holdEdgeData;
+                    break;
+                case RenderItemKind::HOLD_BAR:
+                    sprite.renderData = &simple.holdBarData;
+                    break;
+                case RenderItemKind::HOLD_BACKGROUND:
+                    sprite.renderData = &simple.holdBackgroundData;
+                    break;
+                default:
+                    continue;
+            }
+            bytes -= sprite.byteSize - BYTES_PER_QUAD;
+            sprite.byteSize = BYTES_PER_QUAD;
+        }
+    }
+    // Coarser rows are merged from the previous result, which is already much
+    // smaller than the input.
+    const float maxRowPixels = std::max(BASE_RES_W, BASE_RES_H);
+    while (mergeable && bytes > vertexCap && rowPixels < maxRowPixels) {
+        rowPixels *= 2.0f;
+        std::swap(items, merged);
+        merge_lod_rows(items, merged, workspace.lodOrder, rowPixels);
+        bytes = sum_lod_bytes(merged);
+    }
+
+    // Keep the items nearest to the judge line, drawn in their usual order.
+    auto& keep = workspace.lodKeep;
+    keep.assign(merged.size(), 1);
+    if (bytes > vertexCap) {
+        auto& order = workspace.lodOrder;
+        order.resize(merged.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(
+            order.begin(), order.end(), [&](size_t left, size_t right) {
+                return get_judge_distance(merged[left].side,
+                                          merged[left].axis) <
+                       get_judge_distance(merged[right].side,
+                                          merged[right].axis);
+            });
+        size_t keptBytes = 0;
+        size_t index = 0;
+        for (; index < order.size(); ++index) {
+            const size_t byteSize = merged[order[index]].sprite.byteSize;
+            if (keptBytes + byteSize > vertexCap) {
+                break;
+            }
+            keptBytes += byteSize;
+        }
+        for (; index < order.size(); ++index) {
+            keep[order[index]] = 0;
+        }
+    }
+
+    char* out = vertexBuffer;
+    for (size_t index = 0; index < merged.size(); ++index) {
+        if (keep[index]) {
+            char* const begin = out;
+            draw_prepared_sprite(out, merged[index].sprite);
+            ++stats.outputItems;
+            if (workspace.shiftSpans != nullptr) {
+                append_shift_span(*workspace.shiftSpans,
+                                  static_cast<size_t>(begin - vertexBuffer),
+                                  static_cast<size_t>(out - begin),
+                                  merged[index].shift);
+            }
+        }
+    }
+    stats.rowPixels = rowPixels;
+    stats.inputItems = sources.size();
+    stats.droppedItems = merged.size() - stats.outputItems;
+    stats.renderedBytes = static_cast<size_t>(out - vertexBuffer);
+    return stats.renderedBytes;
+}
+
+}  // namespace
+
+namespace {
+
+const std::vector<const Note*>& resolve_active_notes(
+    RenderWorkspace& workspace, const NoteActivationManager::ActiveLists& list,
+    size_t maxBytes) {
+    auto& renderExecutor = get_render_executor();
+    auto& resolvedNotes = workspace.resolvedNotes;
+    resolvedNotes.resize(list.size());
+    if (maxBytes == 0) {
+        throw std::logic_error(
+            "Render item maximum byte count must be positive");
+    }
+    const size_t parallelThreshold =
+        (MULTITHREAD_RENDERING_BYTE_THRESHOLD + maxBytes - 1) / maxBytes;
+    const bool staticParallel = renderExecutor.workerCount > 1 &&
+                                list.size() > 1 &&
+                                list.size() >= parallelThreshold;
+    auto& scheduler = get_workspace_scheduler(workspace);
+    const auto schedule =
+        scheduler.plan(RENDER_SCHEDULE_RESOLVE_SLOT, list.size(),
+                       staticParallel, renderExecutor.workerCount);
+    RenderRunProbe probe;
+    const auto startTime = RenderClock::now();
+    if (!schedule.parallel) {
+        for (size_t index = 0; index < list.size(); ++index) {
+            resolvedNotes[index] =
+                &get_note_pool_manager().get_note_unsafe(list[index].second);
+        }
+        const double wallNs = elapsed_ns(startTime);
+        scheduler.record(RENDER_SCHEDULE_RESOLVE_SLOT, schedule, list.size(),
+                         wallNs, probe.finish());
+        return resolvedNotes;
+    }
+
+    auto& taskflow = workspace.taskflow;
+    auto& resolveTasks = workspace.prepareTasks;
+    taskflow.clear();
+    resolveTasks.clear();
+    const size_t resolveChunkSize =
+        (list.size() + schedule.chunkCount - 1) / schedule.chunkCount;
+    resolveTasks.reserve(schedule.chunkCount);
+    // Activation and note mutation finish before rendering. These tasks
+    // only read the stable note map and write disjoint output slots.
+    for (size_t begin = 0; begin < list.size(); begin += resolveChunkSize) {
+        const size_t end = std::min(begin + resolveChunkSize, list.size());
+        resolveTasks.push_back(taskflow.emplace([&, begin, end] {
+            for (size_t index = begin; index < end; ++index) {
+                resolvedNotes[index] = &get_note_pool_manager().get_note_unsafe(
+                    list[index].second);
+            }
+        }));
+    }
+    renderExecutor.run_and_wait(taskflow);
+    const double wallNs = elapsed_ns(startTime);
+    scheduler.record(RENDER_SCHEDULE_RESOLVE_SLOT, schedule, list.size(),
+                     wallNs, probe.finish());
+    return resolvedNotes;
+}
+
+// Renders one state from notes that are already resolved. The list is the
+// lasting holds for state 0, the active holds for state 1 and all active
+// notes for state 2, in activation order.
+size_t render_resolved_notes(char* const vertexBuffer,
+                             std::span<const Note* const> notes, double nowTime,
+                             double noteSpeed, int state,
+                             RenderWorkspace& workspace) {
+    auto& renderExecutor = get_render_executor();
 
     // Get sprites.
     const auto& spriteMan = get_sprite_manager();
@@ -699,7 +1510,6 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
         return prepared;
     };
 
-    auto& workspace = get_render_workspace();
     auto& sources = workspace.sources;
     auto& deferredSources = workspace.deferredSources;
     sources.clear();
@@ -730,72 +1540,22 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
         sources.push_back({&note, kind});
         add_estimated_bytes(maxBytes);
     };
-    auto resolve_notes =
-        [&](const NoteActivationManager::ActiveLists& list,
-            size_t maxBytes) -> const std::vector<const Note*>& {
-        auto& resolvedNotes = workspace.resolvedNotes;
-        resolvedNotes.resize(list.size());
-        if (maxBytes == 0) {
-            throw std::logic_error(
-                "Render item maximum byte count must be positive");
-        }
-        const size_t parallelThreshold =
-            (MULTITHREAD_RENDERING_BYTE_THRESHOLD + maxBytes - 1) / maxBytes;
-        const bool parallelResolve = workspace.workerCount > 1 &&
-                                     list.size() > 1 &&
-                                     list.size() >= parallelThreshold;
-        if (!parallelResolve) {
-            for (size_t index = 0; index < list.size(); ++index) {
-                resolvedNotes[index] = &get_note_pool_manager().get_note_unsafe(
-                    list[index].second);
-            }
-            return resolvedNotes;
-        }
-
-        auto& taskflow = workspace.taskflow;
-        auto& resolveTasks = workspace.prepareTasks;
-        taskflow.clear();
-        resolveTasks.clear();
-        const size_t resolveChunkCount = std::min(
-            list.size(), static_cast<size_t>(workspace.workerCount) * 4);
-        const size_t resolveChunkSize =
-            (list.size() + resolveChunkCount - 1) / resolveChunkCount;
-        resolveTasks.reserve(resolveChunkCount);
-        // Activation and note mutation finish before rendering. These tasks
-        // only read the stable note map and write disjoint output slots.
-        for (size_t begin = 0; begin < list.size(); begin += resolveChunkSize) {
-            const size_t end = std::min(begin + resolveChunkSize, list.size());
-            resolveTasks.push_back(taskflow.emplace([&, begin, end] {
-                for (size_t index = begin; index < end; ++index) {
-                    resolvedNotes[index] =
-                        &get_note_pool_manager().get_note_unsafe(
-                            list[index].second);
-                }
-            }));
-        }
-        workspace.executor.run(taskflow).get();
-        return resolvedNotes;
-    };
-
     if (state == 0) {
-        sources.reserve(lastingHolds.size());
-        for (const auto& [time, noteID] : lastingHolds) {
-            const auto& note = get_note_pool_manager().get_note_unsafe(noteID);
-            append_source(note, RenderItemKind::HOLD_BACKGROUND,
+        sources.reserve(notes.size());
+        for (const Note* note : notes) {
+            append_source(*note, RenderItemKind::HOLD_BACKGROUND,
                           holdBgMaxBytes);
         }
     } else if (state == 1) {
-        sources.reserve(activeHolds.size());
-        for (const Note* note : resolve_notes(activeHolds, holdBarMaxBytes)) {
+        sources.reserve(notes.size());
+        for (const Note* note : notes) {
             append_source(*note, RenderItemKind::HOLD_BAR, holdBarMaxBytes);
         }
     } else {
-        const auto& resolvedNotes = resolve_notes(activeNotes, tapMaxBytes);
-
         // activeHolds is the ordered HOLD subset of activeNotes, so filtering
         // here preserves the original HOLD -> NORMAL -> CHAIN draw order.
-        sources.reserve(activeNotes.size());
-        for (const Note* note : resolvedNotes) {
+        sources.reserve(notes.size());
+        for (const Note* note : notes) {
             if (note->get_note_type() == NOTE_TYPE::HOLD) {
                 append_source(*note, RenderItemKind::HOLD_EDGE,
                               holdEdgeMaxBytes);
@@ -803,8 +1563,8 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
         }
         state2HoldCount = sources.size();
 
-        deferredSources.reserve(activeNotes.size());
-        for (const Note* note : resolvedNotes) {
+        deferredSources.reserve(notes.size());
+        for (const Note* note : notes) {
             if (note->get_note_type() == NOTE_TYPE::NORMAL) {
                 append_source(*note, RenderItemKind::NORMAL, tapMaxBytes);
             } else if (note->get_note_type() == NOTE_TYPE::CHAIN) {
@@ -824,27 +1584,60 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
         return prepare_hold(*source.note, source.kind);
     };
 
-    auto draw_prepared = [&](char*& out, const PreparedSprite& prepared) {
-        if (prepared.renderData == nullptr)
-            return;
-        char* const begin = out;
-        draw_sprite(out, *prepared.renderData, prepared.pivot,
-                    prepared.position, prepared.size, prepared.rotation,
-                    prepared.color);
-        if (static_cast<size_t>(out - begin) != prepared.byteSize) {
-            throw std::runtime_error(
-                "Prepared sprite byte count does not match rendered output");
+    if (workspace.shiftSpans != nullptr) {
+        workspace.shiftSpans->clear();
+    }
+
+    auto& lodStatsTable = get_workspace_lod_stats(workspace);
+    const auto lodSettings = get_render_lod_controller().get_settings();
+    RenderLodStats lodStats;
+    if (!workspace.fullDetail && lodSettings.mode != RENDER_LOD_MODE::OFF) {
+        std::array<size_t, 3> sideCounts{};
+        for (const auto& source : sources) {
+            ++sideCounts[std::clamp(source.note->side, 0, 2)];
         }
-    };
+        for (int side = 0; side < 3; ++side) {
+            lodStats.density = std::max(
+                lodStats.density, sideCounts[side] / get_lane_pixels(side));
+        }
+        lodStats.active = lodSettings.mode == RENDER_LOD_MODE::ALWAYS ||
+                          lodStats.density >= RENDER_LOD_DENSITY_THRESHOLD ||
+                          estimatedBytes > lodSettings.vertexCap;
+    }
+    if (lodStats.active) {
+        const LodSimpleSprites simple(holdEdgeSprite, holdBarSprite,
+                                      holdBgSprite);
+        const size_t renderedBytes = render_lod_sources(
+            vertexBuffer, sources, prepare_source, simple, holdBarSprite.size.y,
+            lodSettings.vertexCap, nowTime, noteSpeed, workspace, lodStats);
+        lodStatsTable.set(state, lodStats);
+        return renderedBytes;
+    }
+    lodStatsTable.set(state, lodStats);
 
-    const bool useParallelRendering =
-        workspace.workerCount > 1 && sources.size() > 1 &&
+    const bool staticParallel =
+        renderExecutor.workerCount > 1 && sources.size() > 1 &&
         estimatedBytes >= MULTITHREAD_RENDERING_BYTE_THRESHOLD;
-    if (!useParallelRendering) {
+    auto& scheduler = get_workspace_scheduler(workspace);
+    const auto schedule = scheduler.plan(state, sources.size(), staticParallel,
+                                         renderExecutor.workerCount);
+    RenderRunProbe probe;
+    const auto startTime = RenderClock::now();
+    if (!schedule.parallel) {
         char* out = vertexBuffer;
         for (const auto& source : sources) {
-            draw_prepared(out, prepare_source(source));
+            char* const begin = out;
+            draw_prepared_sprite(out, prepare_source(source));
+            if (workspace.shiftSpans != nullptr) {
+                append_shift_span(*workspace.shiftSpans,
+                                  static_cast<size_t>(begin - vertexBuffer),
+                                  static_cast<size_t>(out - begin),
+                                  make_shift_span(source, nowTime, noteSpeed));
+            }
         }
+        const double wallNs = elapsed_ns(startTime);
+        scheduler.record(state, schedule, sources.size(), wallNs,
+                         probe.finish());
         return static_cast<size_t>(out - vertexBuffer);
     }
 
@@ -853,9 +1646,7 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
     const bool useState2DirectPath = state != 0 && state != 1;
     prepared.resize(useState2DirectPath ? state2HoldCount : sources.size());
 
-    const size_t desiredChunkCount =
-        static_cast<size_t>(workspace.workerCount) * 4;
-    const size_t chunkCount = std::min(sources.size(), desiredChunkCount);
+    const size_t chunkCount = schedule.chunkCount;
     const size_t chunkSize = (sources.size() + chunkCount - 1) / chunkCount;
     const size_t state2ChainCount =
         sources.size() - state2HoldCount - state2NormalCount;
@@ -946,14 +1737,14 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
             char* const expectedEnd = out + chunk.byteSize;
             for (size_t index = chunk.begin; index < chunk.end; ++index) {
                 if (chunk.requiresPreparation) {
-                    draw_prepared(out, prepared[index]);
+                    draw_prepared_sprite(out, prepared[index]);
                 } else {
                     const auto item = prepare_source(sources[index]);
                     if (item.byteSize != chunk.itemByteSize) {
                         throw std::runtime_error(
                             "Direct render item byte count is not constant");
                     }
-                    draw_prepared(out, item);
+                    draw_prepared_sprite(out, item);
                 }
             }
             if (out != expectedEnd) {
@@ -964,10 +1755,539 @@ size_t render_active_notes(char* const vertexBuffer, double nowTime,
         prefixTask.precede(renderTasks.back());
     }
 
-    workspace.executor.run(taskflow).get();
+    renderExecutor.run_and_wait(taskflow);
+    const double wallNs = elapsed_ns(startTime);
+    scheduler.record(state, schedule, sources.size(), wallNs, probe.finish());
+
+    if (workspace.shiftSpans != nullptr) {
+        for (const auto& chunk : chunks) {
+            size_t offset = chunk.byteOffset;
+            for (size_t index = chunk.begin; index < chunk.end; ++index) {
+                const size_t byteSize = chunk.requiresPreparation
+                                            ? prepared[index].byteSize
+                                            : chunk.itemByteSize;
+                append_shift_span(
+                    *workspace.shiftSpans, offset, byteSize,
+                    make_shift_span(sources[index], nowTime, noteSpeed));
+                offset += byteSize;
+            }
+        }
+    }
     return renderedBytes;
 }
 
+}  // namespace
+
+// For param state:
+//   0: Render addition bg
+//   1: Render hold bg
+//   2: Render other parts
+size_t render_active_notes(char* const vertexBuffer, double nowTime,
+                           double noteSpeed, int state) {
+    PROFILE_SCOPE(std::format("Render Active Notes (State {})", state));
+
+    // Get active notes list.
+    const auto& actMan = get_note_activation_manager();
+    auto& workspace = get_render_workspace();
+    const std::vector<const Note*>* notes;
+    if (state == 0) {
+        notes = &resolve_active_notes(workspace, actMan.get_lasting_holds(),
+                                      get_sprite_max_bytes("sprHoldGrey"));
+    } else if (state == 1) {
+        notes = &resolve_active_notes(workspace, actMan.get_active_holds(),
+                                      get_sprite_max_bytes("sprHold"));
+    } else {
+        notes = &resolve_active_notes(workspace, actMan.get_active_notes(),
+                                      get_sprite_max_bytes("sprNote"));
+    }
+    return render_resolved_notes(vertexBuffer, *notes, nowTime, noteSpeed,
+                                 state, workspace);
+}
+
+namespace {
+
+size_t get_state_vertex_bound(int state, size_t noteCount, size_t holdCount) {
+    switch (state) {
+        case 0:
+            return noteCount * get_sprite_max_bytes("sprHoldGrey");
+        case 1:
+            return noteCount * get_sprite_max_bytes("sprHold");
+        default:
+            return holdCount * get_sprite_max_bytes("sprHoldEdge") +
+                   (noteCount - holdCount) *
+                       std::max(get_sprite_max_bytes("sprNote"),
+                                get_sprite_max_bytes("sprChain"));
+    }
+}
+
+// Moves the given spans as if they were rendered pixels later along their
+// side's travel direction, fading side notes to their new positions.
+void shift_vertices(char* const vertices,
+                    std::span<const RenderShiftSpan> spans, float pixels) {
+    // Each vertex is a position, a uv and then a color.
+    constexpr size_t ALPHA_OFFSET = 4 * sizeof(float) + 3;
+    for (const auto& span : spans) {
+        // Side 0 scrolls down the screen, sides 1 and 2 towards their edges.
+        const size_t axisOffset = span.side == 0 ? sizeof(float) : 0;
+        const float delta = span.side == 1 ? -pixels : pixels;
+        int8_t alpha = 0;
+        if (span.side != 0) {
+            const double fade = std::max(
+                get_note_alpha(span.side, {span.alphaAxisMin + delta, 0.0f}),
+                get_note_alpha(span.side, {span.alphaAxisMax + delta, 0.0f}));
+            alpha = static_cast<int8_t>(
+                static_cast<int>(fade * 255 * span.alphaScale));
+        }
+        for (size_t offset = span.begin; offset < span.end;
+             offset += BYTES_PER_VERTEX) {
+            char* const axis = vertices + offset + axisOffset;
+            float value;
+            std::memcpy(&value, axis, sizeof(float));
+            value += delta;
+            std::memcpy(axis, &value, sizeof(float));
+            if (span.side != 0) {
+                std::memcpy(vertices + offset + ALPHA_OFFSET, &alpha,
+                            sizeof(alpha));
+            }
+        }
+    }
+}
+
+// Copied notes of one activation window and the vertices of every state,
+// rendered by a job on the render executor.
+struct RenderFrame {
+    ~RenderFrame() {
+        wait();
+    }
+
+    // Activation and snapshotting touch the note pool, so they run on the
+    // calling thread. The job started here only sees copied notes.
+    void start(const NoteActivationManager& activation, double time,
+               double speed, RenderContextCallback onRendered = {}) {
+        wait();
+        requested = false;
+
+        const auto& activeNotes = activation.get_active_notes();
+        const auto& activeHolds = activation.get_active_holds();
+        const auto& lastingHolds = activation.get_lasting_holds();
+
+        nowTime = time;
+        noteSpeed = speed;
+        noteGeneration = get_note_pool_manager().get_last_modified_time();
+        notes.clear();
+        notes.reserve(activeNotes.size());
+        for (const auto& [noteTime, noteID] : activeNotes) {
+            notes.push_back(get_note_pool_manager().get_note_unsafe(noteID));
+        }
+
+        // Holds and lasting holds are sorted subsequences of activeNotes with
+        // identical keys, so a single merge pass maps them onto the snapshot.
+        auto map_subset = [&](const NoteActivationManager::ActiveLists& subset,
+                              std::vector<const Note*>& out) {
+            out.clear();
+            out.reserve(subset.size());
+            size_t index = 0;
+            for (const auto& item : subset) {
+                while (index < activeNotes.size() &&
+                       activeNotes[index] != item) {
+                    ++index;
+                }
+                if (index == activeNotes.size()) {
+                    throw std::logic_error(
+                        "Active note subset is not ordered like its parent");
+                }
+                out.push_back(&notes[index]);
+            }
+        };
+        map_subset(lastingHolds, stateNotes[0]);
+        map_subset(activeHolds, stateNotes[1]);
+        stateNotes[2].clear();
+        stateNotes[2].reserve(notes.size());
+        for (const auto& note : notes) {
+            stateNotes[2].push_back(&note);
+        }
+
+        for (int state = 0; state < 3; ++state) {
+            earliestHoldTimes[state] = std::numeric_limits<double>::infinity();
+            for (const Note* note : stateNotes[state]) {
+                if (note->get_note_type() == NOTE_TYPE::HOLD) {
+                    earliestHoldTimes[state] =
+                        std::min(earliestHoldTimes[state], note->time);
+                }
+            }
+            const size_t bound = get_state_vertex_bound(
+                state, stateNotes[state].size(), activeHolds.size());
+            if (vertices[state].size() < bound) {
+                vertices[state].resize(bound);
+            }
+        }
+
+        requested = true;
+        failed = false;
+        job = get_render_executor().executor.async(
+            [this, onRendered = std::move(onRendered)] {
+                PROFILE_SCOPE("Async Render Frame");
+                for (int state = 0; state < 3; ++state) {
+                    workspace.shiftSpans = &shiftSpans[state];
+                    byteSizes[state] = render_resolved_notes(
+                        vertices[state].data(), stateNotes[state], nowTime,
+                        noteSpeed, state, workspace);
+                }
+                if (onRendered) {
+                    onRendered({std::span<const char>(vertices[0].data(),
+                                                      byteSizes[0]),
+                                std::span<const char>(vertices[1].data(),
+                                                      byteSizes[1]),
+                                std::span<const char>(vertices[2].data(),
+                                                      byteSizes[2])});
+                }
+            });
+    }
+
+    void wait() {
+        if (!job.valid()) {
+            return;
+        }
+        try {
+            job.get();
+        } catch (const std::exception& e) {
+            failed = true;
+            print_debug_message(
+                std::string("Pipelined note render failed: ") + e.what());
+        }
+    }
+
+    double nowTime = 0.0;
+    double noteSpeed = 0.0;
+    uint64_t noteGeneration = 0;
+    bool requested = false;
+    bool failed = false;
+    std::vector<Note> notes;
+    std::array<std::vector<const Note*>, 3> stateNotes;
+    std::array<std::vector<char>, 3> vertices;
+    std::array<size_t, 3> byteSizes{};
+    std::array<std::vector<RenderShiftSpan>, 3> shiftSpans;
+    // Of the heads of the holds in each state.
+    std::array<double, 3> earliestHoldTimes{};
+    RenderWorkspace workspace;
+    std::future<void> job;
+};
+
+// Double-buffered frame pipeline. request() snapshots the notes visible at a
+// predicted time and renders all states on the render executor; collect()
+// hands the finished vertices to the caller if the prediction still holds.
+class AsyncRenderPipeline {
+   public:
+    AsyncRenderPipeline() {
+        for (auto& frame : frames) {
+            frame.workspace.scheduler = &scheduler;
+            frame.workspace.lodStats = &lodStats;
+        }
+    }
+    ~AsyncRenderPipeline() {
+        reset();
+    }
+
+    void request(double nowTime, double noteSpeed) {
+        PROFILE_SCOPE("Async Render Request");
+
+        // Reuse the older slot so the latest frame stays collectable.
+        const size_t slot = latestSlot ^ 1;
+        auto& frame = frames[slot];
+        frame.wait();
+        frame.requested = false;
+
+        activation.set_range(nowTime, noteSpeed);
+        activation.recalculate();
+        frame.start(activation, nowTime, noteSpeed);
+        latestSlot = slot;
+    }
+
+    // Returns the number of bytes written, or nullopt if no pending frame can
+    // stand in for the given parameters.
+    std::optional<size_t> collect(char* const vertexBuffer, size_t bufferSize,
+                                  double nowTime, double noteSpeed,
+                                  double tolerance, int state) {
+        if (state < 0 || state > 2) {
+            throw std::out_of_range("Invalid render state");
+        }
+        const uint64_t noteGeneration =
+            get_note_pool_manager().get_last_modified_time();
+
+        // Prefer the newest frame, then the one still left from before it. A
+        // frame rendered for a slightly different time is scrolled into place,
+        // so normal frame jitter does not throw the prediction away. Holds
+        // pinned to the judge line at either time are shaped by the time
+        // itself, so frames with them are only used for the exact time.
+        for (const size_t slot : {latestSlot, latestSlot ^ 1}) {
+            auto& frame = frames[slot];
+            const double shift = nowTime - frame.nowTime;
+            if (!frame.requested || frame.noteSpeed != noteSpeed ||
+                frame.noteGeneration != noteGeneration ||
+                std::abs(shift) > tolerance ||
+                (shift != 0.0 && frame.earliestHoldTimes[state] <
+                                     std::max(frame.nowTime, nowTime))) {
+                continue;
+            }
+            frame.wait();
+            if (frame.failed || frame.byteSizes[state] > bufferSize) {
+                break;
+            }
+            std::memcpy(vertexBuffer, frame.vertices[state].data(),
+                        frame.byteSizes[state]);
+            std::lock_guard<std::mutex> lock(statsMtx);
+            if (shift == 0.0) {
+                ++stats.exactCollects;
+            } else {
+                shift_vertices(vertexBuffer, frame.shiftSpans[state],
+                               static_cast<float>(shift * noteSpeed));
+                ++stats.shiftedCollects;
+            }
+            stats.lastShift = shift;
+            return frame.byteSizes[state];
+        }
+        std::lock_guard<std::mutex> lock(statsMtx);
+        ++stats.missedCollects;
+        return std::nullopt;
+    }
+
+    AsyncRenderStats get_stats() {
+        std::lock_guard<std::mutex> lock(statsMtx);
+        return stats;
+    }
+    void reset_stats() {
+        std::lock_guard<std::mutex> lock(statsMtx);
+        stats = {};
+    }
+
+    RenderScheduler& get_scheduler() {
+        return scheduler;
+    }
+
+    RenderLodStats get_lod_stats(int state) {
+        return lodStats.get(state);
+    }
+
+    // Waits for in-flight jobs and drops every pending frame.
+    void reset() {
+        for (auto& frame : frames) {
+            frame.wait();
+            frame.requested = false;
+        }
+    }
+
+   private:
+    // Declared first so the frames' jobs are finished before they go away.
+    RenderScheduler scheduler;
+    RenderLodStatsTable lodStats;
+    NoteActivationManager activation;
+    std::array<RenderFrame, 2> frames;
+    size_t latestSlot = 0;
+    std::mutex statsMtx;
+    AsyncRenderStats stats;
+};
+
+AsyncRenderPipeline& get_async_render_pipeline() {
+    static AsyncRenderPipeline pipeline;
+    return pipeline;
+}
+
+// A viewport with its own activation window, active lists and scratch space.
+// Contexts only read the shared note pool while snapshotting, so their render
+// jobs run on the executor alongside each other and the main pipeline.
+class RenderContext {
+   public:
+    explicit RenderContext(bool fullDetail) {
+        frame.workspace.scheduler = &scheduler;
+        frame.workspace.lodStats = &lodStats;
+        frame.workspace.fullDetail = fullDetail;
+    }
+
+    void request(double nowTime, double noteSpeed,
+                 RenderContextCallback onRendered) {
+        PROFILE_SCOPE("Render Context Request");
+        frame.wait();
+        frame.requested = false;
+        activation.set_range(nowTime, noteSpeed);
+        activation.recalculate();
+        frame.start(activation, nowTime, noteSpeed, std::move(onRendered));
+    }
+
+    void wait() {
+        (void)get_finished_frame(0);
+    }
+
+    size_t get_size(int state) {
+        return get_finished_frame(state).byteSizes[state];
+    }
+
+    size_t collect(char* const vertexBuffer, size_t bufferSize, int state) {
+        const auto& finished = get_finished_frame(state);
+        if (finished.byteSizes[state] > bufferSize) {
+            throw std::length_error("Vertex buffer is too small");
+        }
+        std::memcpy(vertexBuffer, finished.vertices[state].data(),
+                    finished.byteSizes[state]);
+        return finished.byteSizes[state];
+    }
+
+    const NoteActivationManager& get_activation() const {
+        return activation;
+    }
+
+    RenderLodStats get_lod_stats(int state) {
+        (void)get_finished_frame(state);
+        return lodStats.get(state);
+    }
+
+   private:
+    const RenderFrame& get_finished_frame(int state) {
+        if (state < 0 || state > 2) {
+            throw std::out_of_range("Invalid render state");
+        }
+        if (!frame.requested) {
+            throw std::logic_error("Render context has no requested frame");
+        }
+        frame.wait();
+        if (frame.failed) {
+            throw std::runtime_error("Render context frame failed");
+        }
+        return frame;
+    }
+
+    // Declared first so the frame's job is finished before they go away.
+    RenderScheduler scheduler;
+    RenderLodStatsTable lodStats;
+    NoteActivationManager activation;
+    RenderFrame frame;
+};
+
+class RenderContextRegistry {
+   public:
+    int create(bool fullDetail) {
+        std::lock_guard<std::mutex> lock(mtx);
+        const int id = nextID++;
+        contexts.emplace(id, std::make_shared<RenderContext>(fullDetail));
+        return id;
+    }
+
+    void destroy(int id) {
+        std::shared_ptr<RenderContext> context;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = contexts.find(id);
+            if (it == contexts.end()) {
+                throw std::out_of_range("Unknown render context");
+            }
+            context = std::move(it->second);
+            contexts.erase(it);
+        }
+        // The last reference waits for the in-flight job outside the lock.
+    }
+
+    std::shared_ptr<RenderContext> get(int id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = contexts.find(id);
+        if (it == contexts.end()) {
+            throw std::out_of_range("Unknown render context");
+        }
+        return it->second;
+    }
+
+   private:
+    std::mutex mtx;
+    std::unordered_map<int, std::shared_ptr<RenderContext>> contexts;
+    int nextID = 1;
+};
+
+RenderContextRegistry& get_render_context_registry() {
+    static RenderContextRegistry registry;
+    return registry;
+}
+
+}  // namespace
+
+void request_async_render(double nowTime, double noteSpeed) {
+    get_async_render_pipeline().request(nowTime, noteSpeed);
+}
+
+size_t collect_async_render(char* const vertexBuffer, size_t bufferSize,
+                            double nowTime, double noteSpeed, double tolerance,
+                            int state) {
+    auto result = get_async_render_pipeline().collect(
+        vertexBuffer, bufferSize, nowTime, noteSpeed, tolerance, state);
+    if (result) {
+        return *result;
+    }
+    // Seeks, edits and speed changes invalidate the prediction.
+    return render_active_notes(vertexBuffer, nowTime, noteSpeed, state);
+}
+
+void reset_async_render() {
+    get_async_render_pipeline().reset();
+}
+
+AsyncRenderStats get_async_render_stats() {
+    return get_async_render_pipeline().get_stats();
+}
+
+RenderScheduleStats get_async_render_schedule_stats(int slot) {
+    return get_async_render_pipeline().get_scheduler().get_stats(slot);
+}
+
+RenderLodStats get_async_render_lod_stats(int state) {
+    return get_async_render_pipeline().get_lod_stats(state);
+}
+
+void reset_async_render_stats() {
+    get_async_render_pipeline().reset_stats();
+}
+
+void reset_render_schedule_stats() {
+    get_render_scheduler().reset();
+    get_async_render_pipeline().get_scheduler().reset();
+}
+
+int create_render_context(bool fullDetail) {
+    return get_render_context_registry().create(fullDetail);
+}
+
+void destroy_render_context(int context) {
+    get_render_context_registry().destroy(context);
+}
+
+void request_context_render(int context, double nowTime, double noteSpeed,
+                            RenderContextCallback onRendered) {
+    get_render_context_registry().get(context)->request(nowTime, noteSpeed,
+                                                        std::move(onRendered));
+}
+
+void wait_context_render(int context) {
+    get_render_context_registry().get(context)->wait();
+}
+
+size_t get_context_render_size(int context, int state) {
+    return get_render_context_registry().get(context)->get_size(state);
+}
+
+size_t collect_context_render(int context, char* const vertexBuffer,
+                              size_t bufferSize, int state) {
+    return get_render_context_registry().get(context)->collect(
+        vertexBuffer, bufferSize, state);
+}
+
+size_t get_context_active_note_count(int context) {
+    return get_render_context_registry()
+        .get(context)
+        ->get_activation()
+        .get_active_notes()
+        .size();
+}
+
+RenderLodStats get_context_render_lod_stats(int context, int state) {
+    return get_render_context_registry().get(context)->get_lod_stats(state);
+}
+
 size_t get_vertex_buffer_bound() {
     const auto& actMan = get_note_activation_manager();
     const auto& activeNotes = actMan.get_active_notes();
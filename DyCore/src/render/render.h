@@ -1,10 +1,19 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <glm/glm.hpp>
+#include <span>
 #include <string>
 #include <unordered_map>
 
+namespace tf {
+class Executor;
+class Taskflow;
+}  // namespace tf
+
 inline constexpr double HOLD_BG_LIGHTNESS = 0.3;
 inline constexpr size_t MULTITHREAD_RENDERING_BYTE_THRESHOLD = 2 * 1024 * 1024;
 
@@ -72,12 +81,154 @@ class SpriteManager {
 size_t get_sprite_max_bytes(const SpriteData& sprite);
 size_t get_sprite_max_bytes(const std::string& name);
 
+// Screen coordinate along the travel direction of a note on the given side.
+float time_to_vertPos(double time, double nowTime, double noteSpeed, int side);
+
 size_t render_active_notes(char* const vertexBuffer, double nowTime,
                            double noteSpeed, int state);
 
+// Pipelined rendering. request_async_render starts rendering every state of an
+// upcoming frame in the background; collect_async_render copies the finished
+// state out when nowTime is within tolerance of the requested time and no note
+// has changed since, scrolling it by (nowTime - requested time) * noteSpeed.
+// Hold parts pinned to the judge line are left in place. Otherwise it falls
+// back to render_active_notes.
+void request_async_render(double nowTime, double noteSpeed);
+size_t collect_async_render(char* const vertexBuffer, size_t bufferSize,
+                            double nowTime, double noteSpeed, double tolerance,
+                            int state);
+// Waits for pending frames and discards them.
+void reset_async_render();
+
+struct AsyncRenderStats {
+    // Per collected state: frames used as rendered, frames scrolled into
+    // place, and collects that fell back to a synchronous render.
+    uint64_t exactCollects = 0;
+    uint64_t shiftedCollects = 0;
+    uint64_t missedCollects = 0;
+    // nowTime minus the requested time of the latest frame used, in ms.
+    double lastShift = 0.0;
+};
+
+AsyncRenderStats get_async_render_stats();
+void reset_async_render_stats();
+
+// Independent render contexts, e.g. for an export render or a preview pane
+// beside the editor viewport. Each owns its activation window, active lists and
+// render scratch space. request_context_render snapshots the notes on the
+// calling thread and renders every state on the shared render executor, so
+// requests to different contexts are evaluated concurrently. The size and
+// collect calls wait for the requested frame. Unknown contexts throw.
+// onRendered runs inside the render job with the vertices of every state, so
+// consumers such as the offline renderer can continue on the same worker.
+// A fullDetail context ignores the LOD mode, so exports never coalesce or drop
+// notes.
+using RenderContextVertices = std::array<std::span<const char>, 3>;
+using RenderContextCallback = std::function<void(const RenderContextVertices&)>;
+int create_render_context(bool fullDetail = false);
+void destroy_render_context(int context);
+void request_context_render(int context, double nowTime, double noteSpeed,
+                            RenderContextCallback onRendered = {});
+// Waits for the requested frame, including onRendered. Throws if it failed.
+void wait_context_render(int context);
+size_t get_context_render_size(int context, int state);
+size_t collect_context_render(int context, char* const vertexBuffer,
+                              size_t bufferSize, int state);
+// Active notes of the context's last requested window.
+size_t get_context_active_note_count(int context);
+
+// STATIC decides parallelism from MULTITHREAD_RENDERING_BYTE_THRESHOLD and uses
+// a fixed chunk count. AUTO picks serial/parallel execution and the chunk
+// granularity from the measured wall time of earlier renders of the same slot.
+enum class RENDER_SCHEDULE_MODE { STATIC, AUTO };
+
+// Slots 0-2 are the render states; the last one is note ID resolution.
+inline constexpr int RENDER_SCHEDULE_RESOLVE_SLOT = 3;
+inline constexpr int RENDER_SCHEDULE_SLOT_COUNT = 4;
+
+struct RenderScheduleStats {
+    // Decision taken by the latest render of the slot.
+    bool parallel = false;
+    size_t chunkCount = 0;
+    size_t itemCount = 0;
+    // Smoothed wall time per item for renders of that size; zero until
+    // measured. parallelItemNs is the best of the parallel candidates.
+    double serialItemNs = 0.0;
+    double parallelItemNs = 0.0;
+    double lastWallNs = 0.0;
+    uint64_t serialRuns = 0;
+    uint64_t parallelRuns = 0;
+    // Runs that overlapped another render. Their wall times are not used.
+    uint64_t sharedRuns = 0;
+};
+
+// The mode applies everywhere, but the synchronous editor renders, the render
+// pipeline and each render context learn from their own renders.
+void set_render_schedule_mode(RENDER_SCHEDULE_MODE mode);
+RENDER_SCHEDULE_MODE get_render_schedule_mode();
+// Stats of the synchronous editor renders.
+RenderScheduleStats get_render_schedule_stats(int slot);
+// Stats of the pipelined frames, see request_async_render.
+RenderScheduleStats get_async_render_schedule_stats(int slot);
+// Forgets the measurements of the editor and the render pipeline. The mode is
+// kept.
+void reset_render_schedule_stats();
+
+// Level of detail for dense or zoomed-out views. OFF draws every note in full.
+// AUTO switches a state to LOD once the busiest side holds more than
+// RENDER_LOD_DENSITY_THRESHOLD notes per pixel of lane, or when its full output
+// would exceed the vertex cap. ALWAYS uses LOD for every render.
+//
+// In LOD, notes of the same kind and side whose rows fall within the same
+// pixel row and that overlap horizontally are drawn as one coalesced sprite,
+// and hold edges shorter than a hold tile are drawn as a single quad. If the
+// output still exceeds the cap, every hold part collapses to a single quad,
+// then rows are widened until the merged sprites become density bars, and
+// finally the items farthest from the judge line are dropped.
+enum class RENDER_LOD_MODE { OFF, AUTO, ALWAYS };
+
+inline constexpr double RENDER_LOD_DENSITY_THRESHOLD = 0.25;
+inline constexpr size_t RENDER_LOD_DEFAULT_VERTEX_CAP = 8 * 1024 * 1024;
+
+struct RenderLodStats {
+    // Decision taken by the latest render of the state.
+    bool active = false;
+    double density = 0.0;
+    double rowPixels = 0.0;
+    size_t inputItems = 0;
+    size_t outputItems = 0;
+    size_t droppedItems = 0;
+    size_t renderedBytes = 0;
+};
+
+// The mode and cap apply to every renderer except full-detail contexts, but the
+// editor renders, the render pipeline and each render context keep their own
+// stats.
+void set_render_lod_mode(RENDER_LOD_MODE mode);
+RENDER_LOD_MODE get_render_lod_mode();
+// Vertex bytes allowed per render state while LOD is not OFF.
+void set_render_lod_vertex_cap(size_t bytes);
+// Stats of the synchronous editor renders.
+RenderLodStats get_render_lod_stats(int state);
+// Stats of the pipelined frames, see request_async_render.
+RenderLodStats get_async_render_lod_stats(int state);
+// Stats of the context's requested frame; waits for it like collect.
+RenderLodStats get_context_render_lod_stats(int context, int state);
+
 // Must be called before the first render. A value of zero keeps the automatic
 // hardware-concurrency setting.
 void set_render_worker_count_override(size_t workerCount);
+size_t get_render_worker_count();
+// The executor renders run on, sized by the render worker count. Other
+// parallel work, such as chart batch imports, runs on it too, so that it
+// all shares one pool of workers.
+tf::Executor& get_shared_executor();
+// Runs the taskflow on the shared executor and waits. From inside one of its
+// workers it helps run the taskflow instead of blocking the worker.
+void run_on_shared_executor(tf::Taskflow& taskflow);
+// Runs task(index) for every index below count on the shared executor and
+// waits. Safe to call from inside a render job.
+void run_render_tasks(size_t count, const std::function<void(size_t)>& task);
 
 size_t get_vertex_buffer_bound();
 
@@ -1,10 +1,16 @@
 #include <json.hpp>
 
 #include "api.h"
+#include "beatGrid.h"
+#include "offline.h"
+#include "overview.h"
 #include "render.h"
 #include "utils.h"
 
 DYCORE_API double DyCore_add_sprite_data(const char* spriteData) {
+    // Pending frames read the sprite table from worker threads.
+    reset_async_render();
+
     auto j = nlohmann::json::parse(spriteData);
     SpriteData data = {.name = j["name"],
                        .size = {j["width"], j["height"]},
@@ -41,4 +47,239 @@ DYCORE_API double DyCore_render_active_notes(char* vertexBuffer, double nowTime,
                             e.what());
         return -1;
     }
-}
\ No newline at end of file
+}
+
+// mode: 0 = static thresholds, 1 = auto-tune from measured render cost.
+DYCORE_API double DyCore_set_render_schedule_mode(double mode) {
+    set_render_schedule_mode(mode >= 1 ? RENDER_SCHEDULE_MODE::AUTO
+                                       : RENDER_SCHEDULE_MODE::STATIC);
+    return 0;
+}
+
+// mode: 0 = off, 1 = switch by on-screen density, 2 = always.
+// vertexCap: vertex bytes allowed per render state; 0 keeps the current cap.
+DYCORE_API double DyCore_set_render_lod(double mode, double vertexCap) {
+    set_render_lod_mode(mode >= 2   ? RENDER_LOD_MODE::ALWAYS
+                        : mode >= 1 ? RENDER_LOD_MODE::AUTO
+                                    : RENDER_LOD_MODE::OFF);
+    if (vertexCap > 0) {
+        set_render_lod_vertex_cap(static_cast<size_t>(vertexCap));
+    }
+    return 0;
+}
+
+namespace {
+// Set by the latest request so the collect call stays within the four
+// arguments GameMaker allows when one of them is a pointer.
+double asyncRenderTolerance = 0.0;
+}  // namespace
+
+// tolerance: how far (ms) the collected time may be from the requested one.
+DYCORE_API double DyCore_render_async_request(double nowTime, double noteSpeed,
+                                              double tolerance) {
+    try {
+        asyncRenderTolerance = tolerance;
+        request_async_render(nowTime, noteSpeed);
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error requesting async render: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+// The buffer must hold DyCore_get_note_rendering_vertex_buffer_bound() bytes.
+DYCORE_API double DyCore_render_async_collect(char* vertexBuffer,
+                                              double nowTime, double noteSpeed,
+                                              double state) {
+    try {
+        auto result = collect_async_render(
+            vertexBuffer, get_vertex_buffer_bound(), nowTime, noteSpeed,
+            asyncRenderTolerance, static_cast<int>(state));
+        return static_cast<double>(result);
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error collecting async render: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_render_context_create() {
+    try {
+        return create_render_context();
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error creating render context: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_render_context_destroy(double context) {
+    try {
+        destroy_render_context(static_cast<int>(context));
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error destroying render context: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_render_context_request(double context,
+                                                double nowTime,
+                                                double noteSpeed) {
+    try {
+        request_context_render(static_cast<int>(context), nowTime, noteSpeed);
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(
+            std::string("Error requesting render context frame: ") + e.what());
+        return -1;
+    }
+}
+
+// Waits for the requested frame and returns the byte size of the state.
+DYCORE_API double DyCore_render_context_get_size(double context,
+                                                 double state) {
+    try {
+        return static_cast<double>(get_context_render_size(
+            static_cast<int>(context), static_cast<int>(state)));
+    } catch (const std::exception& e) {
+        print_debug_message(
+            std::string("Error reading render context frame: ") + e.what());
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_render_context_collect(double context,
+                                                char* vertexBuffer,
+                                                double bufferSize,
+                                                double state) {
+    try {
+        return static_cast<double>(collect_context_render(
+            static_cast<int>(context), vertexBuffer,
+            static_cast<size_t>(bufferSize), static_cast<int>(state)));
+    } catch (const std::exception& e) {
+        print_debug_message(
+            std::string("Error collecting render context frame: ") + e.what());
+        return -1;
+    }
+}
+
+// rgba: the note texture page as width * height RGBA8 pixels.
+DYCORE_API double DyCore_set_offline_render_atlas(const char* rgba,
+                                                  double width,
+                                                  double height) {
+    try {
+        const int atlasWidth = static_cast<int>(width);
+        const int atlasHeight = static_cast<int>(height);
+        set_offline_render_atlas(
+            atlasWidth, atlasHeight,
+            {reinterpret_cast<const uint8_t*>(rgba),
+             static_cast<size_t>(std::max(atlasWidth, 0)) *
+                 static_cast<size_t>(std::max(atlasHeight, 0)) * 4});
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error setting offline atlas: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+// style: {colors, lengthOffsets, width, hardWidth, length, hardLength,
+// longLength, height, hardHeight, sideInfoX, sideInfoWidth, mono, long}
+// mono and long are 0 or 1.
+DYCORE_API double DyCore_set_beat_grid_style(const char* style) {
+    try {
+        auto j = nlohmann::json::parse(style);
+        set_beat_grid_style({
+            .colors = j["colors"].get<std::vector<uint32_t>>(),
+            .lengthOffsets = j["lengthOffsets"].get<std::vector<double>>(),
+            .width = j["width"],
+            .hardWidth = j["hardWidth"],
+            .length = j["length"],
+            .hardLength = j["hardLength"],
+            .longLength = j["longLength"],
+            .height = j["height"],
+            .hardHeight = j["hardHeight"],
+            .sideInfoX = j["sideInfoX"],
+            .sideInfoWidth = j["sideInfoWidth"],
+            .mono = j["mono"].get<int>() != 0,
+            .longLines = j["long"].get<int>() != 0,
+        });
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error setting beat grid style: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+namespace {
+std::span<const char> preparedBeatGrid;
+}  // namespace
+
+// view: {divisions, alpha: [down, left, right], musicLength}
+// Returns the byte size DyCore_copy_beat_grid will write.
+DYCORE_API double DyCore_prepare_beat_grid(const char* view, double nowTime,
+                                           double noteSpeed) {
+    try {
+        auto j = nlohmann::json::parse(view);
+        preparedBeatGrid = render_beat_grid({
+            .nowTime = nowTime,
+            .noteSpeed = noteSpeed,
+            .divisions = j["divisions"].get<std::vector<int>>(),
+            .sideAlpha = j["alpha"].get<std::array<double, 3>>(),
+            .musicLength = j["musicLength"],
+        });
+        return static_cast<double>(preparedBeatGrid.size());
+    } catch (const std::exception& e) {
+        preparedBeatGrid = {};
+        print_debug_message(std::string("Error preparing beat grid: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_copy_beat_grid(char* vertexBuffer) {
+    std::copy(preparedBeatGrid.begin(), preparedBeatGrid.end(), vertexBuffer);
+    return static_cast<double>(preparedBeatGrid.size());
+}
+
+namespace {
+std::span<const uint8_t> preparedOverview;
+}  // namespace
+
+// settings: {width, rowsPerTile, msPerRow, duration, saturation, colors}
+// colors are the BGR colours of normal, chain and hold notes. Returns the
+// image height; DyCore_copy_overview writes width * height * 4 bytes.
+DYCORE_API double DyCore_prepare_overview(const char* settings) {
+    try {
+        auto j = nlohmann::json::parse(settings);
+        OverviewSettings overview;
+        overview.width = j.value("width", overview.width);
+        overview.rowsPerTile = j.value("rowsPerTile", overview.rowsPerTile);
+        overview.msPerRow = j.value("msPerRow", overview.msPerRow);
+        overview.duration = j.value("duration", overview.duration);
+        overview.saturation = j.value("saturation", overview.saturation);
+        overview.colors = j.value("colors", overview.colors);
+        preparedOverview = render_overview(overview);
+        return static_cast<double>(get_overview_stats().height);
+    } catch (const std::exception& e) {
+        preparedOverview = {};
+        print_debug_message(std::string("Error preparing overview: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_copy_overview(char* buffer) {
+    std::copy(preparedOverview.begin(), preparedOverview.end(),
+              reinterpret_cast<uint8_t*>(buffer));
+    return static_cast<double>(preparedOverview.size());
+}
+
+// Changes whenever the overview image does, so callers can skip uploads.
+DYCORE_API double DyCore_get_overview_version() {
+    return static_cast<double>(get_overview_stats().version);
+}
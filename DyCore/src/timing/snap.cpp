@@ -0,0 +1,154 @@
+#include "snap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "note.h"
+#include "notePoolManager.h"
+
+namespace {
+
+// Times this close to a grid line, in divisions, count as on it, so rounding
+// error never pushes a snapped time to the previous or next line. Widened to
+// SNAP_TIME_TOLERANCE_MS for short divisions.
+constexpr double SNAP_GRID_EPSILON = 1e-6;
+// A snapped time must land at least this far before the next timing point.
+constexpr double SNAP_SEGMENT_EPSILON_MS = 1.0;
+
+// Snaps a run of times that all fall in the segment starting at start. The
+// loop is branch-free per mode so the compiler can vectorize the rounding.
+template <SNAP_MODE Mode>
+void snap_segment_run(std::span<const double> times, std::span<double> out,
+                      double start, double end, double divDuration) {
+    const double limit = end - SNAP_SEGMENT_EPSILON_MS;
+    const double epsilon =
+        std::max(SNAP_GRID_EPSILON, SNAP_TIME_TOLERANCE_MS / divDuration);
+    const double* in = times.data();
+    double* result = out.data();
+    for (size_t i = 0; i < times.size(); ++i) {
+        const double divs = (in[i] - start) / divDuration;
+        const double lower = std::floor(divs + epsilon);
+        const double upper = std::ceil(divs - epsilon);
+        double primary = lower, secondary = upper;
+        if constexpr (Mode == SNAP_MODE::POST) {
+            primary = upper;
+            secondary = lower;
+        } else if constexpr (Mode == SNAP_MODE::AROUND) {
+            const bool nearLower = divs - lower <= upper - divs;
+            primary = nearLower ? lower : upper;
+            secondary = nearLower ? upper : lower;
+        }
+        const double primaryTime = start + primary * divDuration;
+        const double secondaryTime = start + secondary * divDuration;
+        const double fallback = secondaryTime <= limit ? secondaryTime : in[i];
+        result[i] = primaryTime <= limit ? primaryTime : fallback;
+    }
+}
+
+void snap_segment_run(std::span<const double> times, std::span<double> out,
+                      double start, double end, double divDuration,
+                      SNAP_MODE mode) {
+    switch (mode) {
+        case SNAP_MODE::AROUND:
+            snap_segment_run<SNAP_MODE::AROUND>(times, out, start, end,
+                                                divDuration);
+            break;
+        case SNAP_MODE::PRE:
+            snap_segment_run<SNAP_MODE::PRE>(times, out, start, end,
+                                             divDuration);
+            break;
+        case SNAP_MODE::POST:
+            snap_segment_run<SNAP_MODE::POST>(times, out, start, end,
+                                              divDuration);
+            break;
+    }
+}
+
+}  // namespace
+
+void snap_times_to_grid(const TimingIndex& index, std::span<const double> times,
+                        std::span<double> out, int divsPerBeat,
+                        SNAP_MODE mode) {
+    if (out.size() < times.size()) {
+        throw std::length_error("Output span is too small");
+    }
+    if (divsPerBeat < 1) {
+        throw std::invalid_argument("Invalid beat division");
+    }
+    if (index.empty()) {
+        std::copy(times.begin(), times.end(), out.begin());
+        return;
+    }
+
+    const auto& segments = index.get_segments();
+    size_t begin = 0;
+    while (begin < times.size()) {
+        const size_t segment =
+            index.find_segment(times[begin], TIMING_UNIT::MS);
+        const double start = segments[segment].time;
+        const double end = segment + 1 < segments.size()
+                               ? segments[segment + 1].time
+                               : std::numeric_limits<double>::infinity();
+        size_t runEnd = begin + 1;
+        while (runEnd < times.size() &&
+               (segment == 0 || times[runEnd] >= start) &&
+               times[runEnd] < end) {
+            ++runEnd;
+        }
+        snap_segment_run(times.subspan(begin, runEnd - begin),
+                         out.subspan(begin, runEnd - begin), start, end,
+                         segments[segment].beatLength / divsPerBeat, mode);
+        begin = runEnd;
+    }
+}
+
+size_t snap_notes_to_grid(std::span<const std::string> noteIDs,
+                          int divsPerBeat, SNAP_MODE mode) {
+    auto& pool = get_note_pool_manager();
+
+    // Heads first, then the ends of the holds among them.
+    std::vector<std::string> editIDs;
+    std::vector<double> times;
+    std::vector<size_t> holdHeads;
+    std::vector<std::string> subIDs;
+    std::vector<double> holdEnds;
+    for (const auto& noteID : noteIDs) {
+        if (!pool.note_exists(noteID)) {
+            continue;
+        }
+        const Note note = pool.get_note(noteID);
+        if (note.get_note_type() == NOTE_TYPE::SUB) {
+            continue;
+        }
+        if (note.get_note_type() == NOTE_TYPE::HOLD) {
+            holdHeads.push_back(editIDs.size());
+            subIDs.push_back(note.subNoteID);
+            holdEnds.push_back(note.time + note.lastTime);
+        }
+        editIDs.push_back(noteID);
+        times.push_back(note.time);
+    }
+    if (editIDs.empty()) {
+        return 0;
+    }
+    const size_t headCount = editIDs.size();
+    editIDs.insert(editIDs.end(), subIDs.begin(), subIDs.end());
+    times.insert(times.end(), holdEnds.begin(), holdEnds.end());
+
+    std::vector<double> snapped(times.size());
+    snap_times_to_grid(get_timing_manager().get_index(), times, snapped,
+                       divsPerBeat, mode);
+    for (size_t i = 0; i < holdHeads.size(); ++i) {
+        const double head = snapped[holdHeads[i]];
+        double& end = snapped[headCount + i];
+        end = head + std::max(1.0, end - head);
+    }
+
+    pool.access_notes(editIDs, [&](Note& note, size_t index) {
+        note.time = snapped[index];
+    });
+    return headCount;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+#include "timing.h"
+
+// Matches SNAP_MODE in the editor: the nearest grid line, the one before or
+// the one after, falling back to the other side when the preferred line lies
+// past the start of the next timing point.
+enum class SNAP_MODE { AROUND, PRE, POST };
+
+// Times this close to a grid line, in milliseconds, count as on it. This
+// covers times rounded to the microsecond, as .dynb files store them, so
+// snapping a loaded chart leaves notes on the grid where they are.
+inline constexpr double SNAP_TIME_TOLERANCE_MS = 1e-3;
+
+// Snaps times onto the grid of divsPerBeat divisions per beat. The grid
+// restarts at every timing point. Times are left as they are when there are
+// no timing points. Sorted input is processed one timing segment at a time.
+void snap_times_to_grid(const TimingIndex& index, std::span<const double> times,
+                        std::span<double> out, int divsPerBeat,
+                        SNAP_MODE mode);
+
+// Snaps the heads and hold ends of the given notes in the pool as one edit.
+// Sub notes and unknown IDs are skipped. Returns the number of notes snapped.
+size_t snap_notes_to_grid(std::span<const std::string> noteIDs,
+                          int divsPerBeat, SNAP_MODE mode);
@@ -1,6 +1,121 @@
 #include "timing.h"
 
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Bars covered by a segment are rounded up to whole bars, allowing for
+// rounding error on segments that end exactly on a bar line.
+constexpr double TIMING_INDEX_BAR_EPSILON = 1e-6;
+
+double segment_key(const TimingSegment& segment, TIMING_UNIT unit) {
+    switch (unit) {
+        case TIMING_UNIT::MS:
+            return segment.time;
+        case TIMING_UNIT::BEAT:
+            return segment.beat;
+        case TIMING_UNIT::BAR:
+            return segment.bar;
+    }
+    return segment.time;
+}
+
+double segment_units_per_beat(const TimingSegment& segment, TIMING_UNIT unit) {
+    switch (unit) {
+        case TIMING_UNIT::MS:
+            return segment.beatLength;
+        case TIMING_UNIT::BEAT:
+            return 1.0;
+        case TIMING_UNIT::BAR:
+            return 1.0 / segment.meter;
+    }
+    return segment.beatLength;
+}
+
+double convert_in_segment(const TimingSegment& segment, double value,
+                          TIMING_UNIT from, TIMING_UNIT to) {
+    const double beats = (value - segment_key(segment, from)) /
+                         segment_units_per_beat(segment, from);
+    return segment_key(segment, to) +
+           beats * segment_units_per_beat(segment, to);
+}
+
+}  // namespace
+
+TimingIndex::TimingIndex(const std::vector<TimingPoint>& sortedPoints) {
+    segments.reserve(sortedPoints.size());
+    for (const auto& point : sortedPoints) {
+        TimingSegment segment{point.time, 0.0, 0.0, point.beatLength,
+                              std::max(point.meter, 1)};
+        if (!segments.empty()) {
+            const auto& last = segments.back();
+            const double beats = (point.time - last.time) / last.beatLength;
+            segment.beat = last.beat + beats;
+            segment.bar =
+                last.bar +
+                std::ceil(beats / last.meter - TIMING_INDEX_BAR_EPSILON);
+        }
+        segments.push_back(segment);
+    }
+}
+
+size_t TimingIndex::find_segment(double value, TIMING_UNIT unit) const {
+    auto it = std::upper_bound(segments.begin(), segments.end(), value,
+                               [unit](double v, const TimingSegment& segment) {
+                                   return v < segment_key(segment, unit);
+                               });
+    return it == segments.begin() ? 0 : std::prev(it) - segments.begin();
+}
+
+double TimingIndex::convert(double value, TIMING_UNIT from,
+                            TIMING_UNIT to) const {
+    if (segments.empty()) {
+        throw std::logic_error("No timing points to convert with");
+    }
+    if (from == to) {
+        return value;
+    }
+    return convert_in_segment(segments[find_segment(value, from)], value,
+                              from, to);
+}
+
+void TimingIndex::convert(std::span<const double> values,
+                          std::span<double> out, TIMING_UNIT from,
+                          TIMING_UNIT to) const {
+    if (out.size() < values.size()) {
+        throw std::length_error("Output span is too small");
+    }
+    if (values.empty()) {
+        return;
+    }
+    if (segments.empty()) {
+        throw std::logic_error("No timing points to convert with");
+    }
+
+    const size_t count = segments.size();
+    auto key = [&](size_t index) { return segment_key(segments[index], from); };
+    auto contains = [&](size_t index, double value) {
+        return (index == 0 || value >= key(index)) &&
+               (index + 1 == count || value < key(index + 1));
+    };
+
+    size_t current = find_segment(values[0], from);
+    for (size_t i = 0; i < values.size(); ++i) {
+        const double value = values[i];
+        if (!contains(current, value)) {
+            if (current + 1 < count && contains(current + 1, value)) {
+                ++current;
+            } else {
+                current = find_segment(value, from);
+            }
+        }
+        out[i] = from == to ? value
+                            : convert_in_segment(segments[current], value,
+                                                 from, to);
+    }
+}
 
 TimingManager& get_timing_manager() {
     static TimingManager instance;
@@ -13,103 +128,120 @@ void TimingManager::clear() {
 }
 
 void TimingManager::add_timing_point(TimingPoint timingPoint) {
-    timingPoints.push_back(timingPoint);
-    outOfOrder = true;
-    mark_modified();
-}
-
-void TimingManager::sort() {
-    if (!outOfOrder)
-        return;
-    outOfOrder = false;
-    std::sort(timingPoints.begin(), timingPoints.end(),
-              [](const TimingPoint& a, const TimingPoint& b) {
-                  return a.time < b.time;
-              });
+    timingPoints.emplace(timingPoint.time, timingPoint);
     mark_modified();
 }
 
 void TimingManager::append_timing_points(
     const std::vector<TimingPoint>& points) {
-    timingPoints.insert(timingPoints.end(), points.begin(), points.end());
-    outOfOrder = true;
+    for (const auto& point : points) {
+        // Sorted input appends in constant time per point.
+        timingPoints.emplace_hint(timingPoints.end(), point.time, point);
+    }
     mark_modified();
 }
 
-void TimingManager::get_timing_points(std::vector<TimingPoint>& outPoints) {
-    sort();
-    outPoints = timingPoints;
+void TimingManager::get_timing_points(
+    std::vector<TimingPoint>& outPoints) const {
+    outPoints.clear();
+    outPoints.reserve(timingPoints.size());
+    for (const auto& [time, point] : timingPoints) {
+        outPoints.push_back(point);
+    }
 }
 
-const double TIMING_POINT_EPSILON = 1;
-bool TimingManager::has_timing_point_at(double time) {
-    sort();
-    auto it = std::lower_bound(
-        timingPoints.begin(), timingPoints.end(), time,
-        [](const TimingPoint& a, double b) { return a.time < b; });
-
-    // Check the element at the found position (or the one after the target
-    // time)
-    if (it != timingPoints.end()) {
-        if (std::abs(it->time - time) < TIMING_POINT_EPSILON) {
-            return true;
-        }
+void TimingManager::get_timing_points_in_window(
+    double begin, double end, std::vector<TimingPoint>& outPoints) const {
+    outPoints.clear();
+    if (timingPoints.empty()) {
+        return;
     }
-
-    // Check the element before the found position (the one before the target
-    // time)
+    auto it = timingPoints.upper_bound(begin);
     if (it != timingPoints.begin()) {
-        auto prev_it = std::prev(it);
-        if (std::abs(prev_it->time - time) < TIMING_POINT_EPSILON) {
-            return true;
+        --it;
+    }
+    outPoints.push_back(it->second);
+    for (++it; it != timingPoints.end() && it->first <= end; ++it) {
+        outPoints.push_back(it->second);
+    }
+}
+
+TimingManager::TimingPointMap::iterator TimingManager::find_near(double time) {
+    auto it = timingPoints.lower_bound(time - TIMING_POINT_EPSILON);
+    auto nearest = timingPoints.end();
+    double nearestDistance = TIMING_POINT_EPSILON;
+    for (; it != timingPoints.end() && it->first < time + TIMING_POINT_EPSILON;
+         ++it) {
+        const double distance = std::abs(it->first - time);
+        if (distance < nearestDistance) {
+            nearest = it;
+            nearestDistance = distance;
         }
     }
+    return nearest;
+}
 
-    return false;
+bool TimingManager::has_timing_point_at(double time) {
+    return find_near(time) != timingPoints.end();
 }
 
-bool TimingManager::get_timing_point_at(double time, TimingPoint& outPoint) {
-    sort();
+bool TimingManager::get_timing_point_at(double time,
+                                        TimingPoint& outPoint) const {
     if (timingPoints.empty()) {
         return false;
     }
 
-    auto it = std::upper_bound(timingPoints.begin(), timingPoints.end(), time,
-                               [](double value, const TimingPoint& point) {
-                                   return value < point.time;
-                               });
-
-    if (it == timingPoints.begin()) {
-        outPoint = *it;
-    } else {
-        outPoint = *std::prev(it);
+    auto it = timingPoints.upper_bound(time);
+    if (it != timingPoints.begin()) {
+        --it;
     }
+    outPoint = it->second;
     return true;
 }
 
+const TimingIndex& TimingManager::get_index() {
+    if (indexStale) {
+        std::vector<TimingPoint> points;
+        get_timing_points(points);
+        index = TimingIndex(points);
+        indexStale = false;
+    }
+    return index;
+}
+
 void TimingManager::change_timing_point_at_time(double time,
                                                 const TimingPoint& tp) {
-    for (auto& point : timingPoints) {
-        if (point.time == time) {
-            point = tp;
-            mark_modified();
-            return;
-        }
+    auto it = find_near(time);
+    if (it == timingPoints.end()) {
+        return;
+    }
+    if (it->first == tp.time) {
+        it->second = tp;
+    } else {
+        auto node = timingPoints.extract(it);
+        node.key() = tp.time;
+        node.mapped() = tp;
+        timingPoints.insert(std::move(node));
     }
+    mark_modified();
 }
 
 void TimingManager::delete_timing_point_at_time(double time) {
-    timingPoints.erase(std::remove_if(timingPoints.begin(), timingPoints.end(),
-                                      [time](const TimingPoint& point) {
-                                          return point.time == time;
-                                      }),
-                       timingPoints.end());
+    auto it = find_near(time);
+    if (it == timingPoints.end()) {
+        return;
+    }
+    const auto [first, last] = timingPoints.equal_range(it->first);
+    timingPoints.erase(first, last);
     mark_modified();
 }
 
 void TimingManager::add_offset(double offset) {
-    for (auto& point : timingPoints) {
+    TimingPointMap shifted;
+    for (auto& [time, point] : timingPoints) {
         point.time += offset;
+        shifted.emplace_hint(shifted.end(), point.time, point);
     }
+    timingPoints.swap(shifted);
     mark_modified();
 }
@@ -1,6 +1,10 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
+#include <iterator>
 #include <json.hpp>
+#include <map>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -53,25 +57,107 @@ inline void from_json(const nlohmann::json& j, TimingPointImportView& view) {
     j.at("meter").get_to(view.tp.meter);
 }
 
+enum class TIMING_UNIT { MS, BEAT, BAR };
+
+// A timing point with its position accumulated from the first one. Bars
+// restart at every timing point, like the editor's bar numbering.
+struct TimingSegment {
+    double time;
+    double beat;
+    double bar;
+    double beatLength;
+    int meter;
+};
+
+// Cumulative index over sorted timing points for O(log n) conversion between
+// milliseconds, beats and bars. Beat and bar 0 sit on the first timing point;
+// earlier times extrapolate with the first segment.
+class TimingIndex {
+   public:
+    TimingIndex() = default;
+    explicit TimingIndex(const std::vector<TimingPoint>& sortedPoints);
+
+    bool empty() const {
+        return segments.empty();
+    }
+    const std::vector<TimingSegment>& get_segments() const {
+        return segments;
+    }
+
+    // Index of the segment containing the value, clamped to the first one.
+    size_t find_segment(double value, TIMING_UNIT unit) const;
+
+    // Throws std::logic_error if there are no timing points.
+    double convert(double value, TIMING_UNIT from, TIMING_UNIT to) const;
+    // Converts values into out, which must be at least as long. Sorted input
+    // walks the segments once instead of searching for each value.
+    void convert(std::span<const double> values, std::span<double> out,
+                 TIMING_UNIT from, TIMING_UNIT to) const;
+
+    double time_to_beat(double time) const {
+        return convert(time, TIMING_UNIT::MS, TIMING_UNIT::BEAT);
+    }
+    double beat_to_time(double beat) const {
+        return convert(beat, TIMING_UNIT::BEAT, TIMING_UNIT::MS);
+    }
+    double time_to_bar(double time) const {
+        return convert(time, TIMING_UNIT::MS, TIMING_UNIT::BAR);
+    }
+    double bar_to_time(double bar) const {
+        return convert(bar, TIMING_UNIT::BAR, TIMING_UNIT::MS);
+    }
+
+   private:
+    std::vector<TimingSegment> segments;
+};
+
+// Points closer than this, in ms, count as the same point in keyed lookups.
+inline constexpr double TIMING_POINT_EPSILON = 1;
+
+class TimingManager;
+
+// Told after every change to the timing points, on the thread that made it.
+class TimingChangeListener {
+   public:
+    virtual ~TimingChangeListener() = default;
+    virtual void timing_changed(const TimingManager& timing) = 0;
+};
+
 class TimingManager {
    private:
-    std::vector<TimingPoint> timingPoints;
-    bool outOfOrder = false;
+    // Kept sorted by time. Points sharing a time keep their insertion order.
+    using TimingPointMap = std::multimap<double, TimingPoint>;
+    TimingPointMap timingPoints;
     uint64_t lastModifiedTime = 0;
+    TimingIndex index;
+    bool indexStale = true;
+    std::atomic<TimingChangeListener*> changeListener{nullptr};
 
     void mark_modified() {
         lastModifiedTime++;
+        indexStale = true;
+        if (auto* listener = changeListener.load(std::memory_order_acquire)) {
+            listener->timing_changed(*this);
+        }
     }
 
+    // The point closest to time within TIMING_POINT_EPSILON, or end().
+    TimingPointMap::iterator find_near(double time);
+
    public:
     uint64_t get_last_modified_time() const {
         return lastModifiedTime;
     }
 
-    // Should be called before any operations that require sorted timing points.
-    // This will sort the timing points if they are out of order.
-    // If they are already sorted, this is a no-op.
-    void sort();
+    // Only one listener at a time; null removes it.
+    void set_change_listener(TimingChangeListener* listener) {
+        changeListener.store(listener, std::memory_order_release);
+    }
+
+    // Timing points are always kept sorted, so this is a no-op. Kept for
+    // existing callers.
+    void sort() {
+    }
 
     // Clear all timing points.
     void clear();
@@ -83,36 +169,49 @@ class TimingManager {
     void append_timing_points(const std::vector<TimingPoint>& points);
 
     // Get the timing points array.
-    void get_timing_points(std::vector<TimingPoint>& outPoints);
+    void get_timing_points(std::vector<TimingPoint>& outPoints) const;
+
+    // Get the points in effect between begin and end: the one in effect at
+    // begin, as for get_timing_point_at, then every one up to end inclusive.
+    void get_timing_points_in_window(double begin, double end,
+                                     std::vector<TimingPoint>& outPoints) const;
 
     bool has_timing_point_at(double time);
-    bool get_timing_point_at(double time, TimingPoint& outPoint);
+    bool get_timing_point_at(double time, TimingPoint& outPoint) const;
+
+    // The cumulative index of the sorted timing points, rebuilt on first use
+    // after a modification.
+    const TimingIndex& get_index();
 
-    int count() {
+    int count() const {
         return timingPoints.size();
     }
 
     // Dump the timing points array to JSON.
-    nlohmann::json dump_json() {
-        sort();
-        return timingPoints;
+    nlohmann::json dump_json() const {
+        std::vector<TimingPoint> points;
+        get_timing_points(points);
+        return points;
     }
     // Dump the timing points array to a string.
-    std::string dump() {
+    std::string dump() const {
         return dump_json().dump();
     }
 
-    int size() {
+    int size() const {
         return timingPoints.size();
     }
 
-    TimingPoint operator[](int index) {
-        sort();
-        return timingPoints[index];
+    // Linear in index; prefer get_timing_points for iteration.
+    TimingPoint operator[](int index) const {
+        return std::next(timingPoints.begin(), index)->second;
     }
     TimingPoint operator=(const TimingPoint& other) = delete;
 
+    // Replaces the point within TIMING_POINT_EPSILON of time, if any.
     void change_timing_point_at_time(double time, const TimingPoint& tp);
+    // Deletes the points at the time nearest to the given one, within
+    // TIMING_POINT_EPSILON.
     void delete_timing_point_at_time(double time);
     void add_offset(double offset);
 };
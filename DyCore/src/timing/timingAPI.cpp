@@ -1,6 +1,16 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "api.h"
 #include "json.hpp"
+#include "snap.h"
 #include "timing.h"
+#include "utils.h"
 
 DYCORE_API const char* DyCore_get_timing_array_string() {
     static std::string timingArrayString;
@@ -26,6 +36,37 @@ DYCORE_API double DyCore_insert_timing_point(const char* timingPointObject) {
     return 0;
 }
 
+namespace {
+
+// Time (f64), beat length (f64) and meter (s32) per point.
+constexpr size_t TIMING_POINT_RECORD_SIZE = 20;
+std::vector<char> preparedTimingPoints;
+
+}  // namespace
+
+// Packs the points in effect between begin and end for
+// DyCore_copy_timing_points. Returns the number of points.
+DYCORE_API double DyCore_prepare_timing_points(double begin, double end) {
+    std::vector<TimingPoint> points;
+    get_timing_manager().get_timing_points_in_window(begin, end, points);
+    preparedTimingPoints.resize(points.size() * TIMING_POINT_RECORD_SIZE);
+    char* ptr = preparedTimingPoints.data();
+    for (const auto& point : points) {
+        const int32_t meter = point.meter;
+        std::memcpy(ptr, &point.time, sizeof(double));
+        std::memcpy(ptr + 8, &point.beatLength, sizeof(double));
+        std::memcpy(ptr + 16, &meter, sizeof(int32_t));
+        ptr += TIMING_POINT_RECORD_SIZE;
+    }
+    return static_cast<double>(points.size());
+}
+
+DYCORE_API double DyCore_copy_timing_points(char* buffer) {
+    std::copy(preparedTimingPoints.begin(), preparedTimingPoints.end(),
+              buffer);
+    return static_cast<double>(preparedTimingPoints.size());
+}
+
 DYCORE_API double DyCore_get_timing_points_count() {
     return get_timing_manager().count();
 }
@@ -64,3 +105,84 @@ DYCORE_API double DyCore_get_timing_points_last_modified_time() {
 DYCORE_API double DyCore_has_timing_point_at_time(double time) {
     return get_timing_manager().has_timing_point_at(time) ? 1 : 0;
 }
+
+namespace {
+
+TIMING_UNIT timing_unit_from_double(double unit) {
+    if (unit < 0 || unit > 2) {
+        throw std::invalid_argument("Invalid timing unit");
+    }
+    return static_cast<TIMING_UNIT>(static_cast<int>(unit));
+}
+
+SNAP_MODE snap_mode_from_double(double mode) {
+    if (mode < 0 || mode > 2) {
+        throw std::invalid_argument("Invalid snap mode");
+    }
+    return static_cast<SNAP_MODE>(static_cast<int>(mode));
+}
+
+}  // namespace
+
+// Units: 0 for milliseconds, 1 for beats, 2 for bars. Bars restart at every
+// timing point.
+DYCORE_API double DyCore_timing_convert(double value, double from, double to) {
+    try {
+        return get_timing_manager().get_index().convert(
+            value, timing_unit_from_double(from), timing_unit_from_double(to));
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error converting timing value: ") +
+                            e.what());
+        return 0;
+    }
+}
+
+// Converts count doubles in place. Sorted values convert in linear time.
+DYCORE_API double DyCore_timing_convert_buffer(char* buffer, double count,
+                                               double from, double to) {
+    try {
+        std::span<double> values(reinterpret_cast<double*>(buffer),
+                                 static_cast<size_t>(count));
+        get_timing_manager().get_index().convert(
+            values, values, timing_unit_from_double(from),
+            timing_unit_from_double(to));
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error converting timing buffer: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+// Snaps count doubles in place to divsPerBeat divisions per beat. Modes follow
+// the editor's SNAP_MODE: 0 around, 1 previous, 2 next.
+DYCORE_API double DyCore_snap_times(char* buffer, double count,
+                                    double divsPerBeat, double mode) {
+    try {
+        std::span<double> times(reinterpret_cast<double*>(buffer),
+                                static_cast<size_t>(count));
+        snap_times_to_grid(get_timing_manager().get_index(), times, times,
+                           static_cast<int>(divsPerBeat),
+                           snap_mode_from_double(mode));
+        return 0;
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error snapping times: ") + e.what());
+        return -1;
+    }
+}
+
+// Snaps the notes in a JSON array of note IDs as a single edit. Returns the
+// number of notes snapped.
+DYCORE_API double DyCore_snap_notes(const char* noteIDs, double divsPerBeat,
+                                    double mode) {
+    try {
+        const auto ids =
+            nlohmann::json::parse(noteIDs).get<std::vector<std::string>>();
+        return static_cast<double>(
+            snap_notes_to_grid(ids, static_cast<int>(divsPerBeat),
+                               snap_mode_from_double(mode)));
+    } catch (const std::exception& e) {
+        print_debug_message(std::string("Error snapping notes: ") + e.what());
+        return -1;
+    }
+}
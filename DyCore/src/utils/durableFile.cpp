@@ -0,0 +1,108 @@
+#include "durableFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+#ifdef _WIN32
+[[noreturn]] void throw_last_windows_error(const char* message) {
+    throw std::system_error(static_cast<int>(GetLastError()),
+                            std::system_category(), message);
+}
+#endif
+
+}  // namespace
+
+DurableFileWriter::DurableFileWriter(const std::filesystem::path& path) {
+#ifdef _WIN32
+    handle = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, 0, nullptr,
+                         CREATE_NEW,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH,
+                         nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        handle = nullptr;
+        throw_last_windows_error("Error opening file for writing.");
+    }
+#else
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening file for writing.");
+    }
+#endif
+}
+
+DurableFileWriter::~DurableFileWriter() {
+#ifdef _WIN32
+    if (handle) {
+        CloseHandle(handle);
+    }
+#endif
+}
+
+void DurableFileWriter::write(const char* data, size_t size) {
+#ifdef _WIN32
+    size_t writtenTotal = 0;
+    while (writtenTotal < size) {
+        const size_t remaining = size - writtenTotal;
+        const DWORD chunkSize =
+            static_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
+        DWORD written = 0;
+        if (!WriteFile(handle, data + writtenTotal, chunkSize, &written,
+                       nullptr)) {
+            throw_last_windows_error("Error writing to file.");
+        }
+        if (written == 0) {
+            throw std::runtime_error("Error writing to file.");
+        }
+        writtenTotal += written;
+    }
+#else
+    file.write(data, size);
+    if (file.fail()) {
+        throw std::runtime_error("Error writing to file.");
+    }
+#endif
+}
+
+void DurableFileWriter::close() {
+#ifdef _WIN32
+    if (!FlushFileBuffers(handle)) {
+        throw_last_windows_error("Error flushing file to disk.");
+    }
+    const HANDLE closing = handle;
+    handle = nullptr;
+    if (!CloseHandle(closing)) {
+        throw_last_windows_error("Error closing file.");
+    }
+#else
+    file.flush();
+    if (file.fail()) {
+        throw std::runtime_error("Error writing to file.");
+    }
+    file.close();
+    if (file.fail()) {
+        throw std::runtime_error("Error closing file.");
+    }
+#endif
+}
+
+void replace_file_durably(const std::filesystem::path& tempPath,
+                          const std::filesystem::path& finalPath) {
+#ifdef _WIN32
+    if (!MoveFileExW(tempPath.wstring().c_str(), finalPath.wstring().c_str(),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        throw_last_windows_error("Error replacing file.");
+    }
+#else
+    std::filesystem::rename(tempPath, finalPath);
+#endif
+}
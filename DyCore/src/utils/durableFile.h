@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+// Writes a new file chunk by chunk and flushes it to disk on close. Throws
+// std::runtime_error, or std::system_error on Windows, if the file cannot be
+// created or written. Files are written to a temporary path and moved over
+// their target with replace_file_durably(), so a failed write never leaves
+// the target half written.
+class DurableFileWriter {
+   public:
+    explicit DurableFileWriter(const std::filesystem::path& path);
+    ~DurableFileWriter();
+
+    DurableFileWriter(const DurableFileWriter&) = delete;
+    DurableFileWriter& operator=(const DurableFileWriter&) = delete;
+
+    void write(const char* data, size_t size);
+    void close();
+
+   private:
+#ifdef _WIN32
+    // Windows HANDLE of the file.
+    void* handle = nullptr;
+#else
+    std::ofstream file;
+#endif
+};
+
+// Moves tempPath over finalPath, replacing it in one step.
+void replace_file_durably(const std::filesystem::path& tempPath,
+                          const std::filesystem::path& finalPath);
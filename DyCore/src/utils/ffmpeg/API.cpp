@@ -1,9 +1,30 @@
 #include "api.h"
 
 #include <json.hpp>
+#include <memory>
 
 #include "ffmpeg/base.h"
+#include "offline.h"
 #include "record.h"
+#include "utils.h"
+
+namespace {
+
+// Frames buffered for FFmpeg before the offline renderer waits for it.
+constexpr size_t OFFLINE_RECORDER_QUEUE_FRAMES = 8;
+
+std::unique_ptr<OfflineChartRenderer> offlineRenderer;
+OfflineRenderStats offlineRenderStats;
+
+void end_offline_render() {
+    if (offlineRenderer) {
+        offlineRenderStats = offlineRenderer->get_stats();
+        offlineRenderer.reset();
+    }
+    get_recorder().finish_recording();
+}
+
+}  // namespace
 
 DYCORE_API double DyCore_ffmpeg_is_available() {
     return is_FFmpeg_available() ? 1.0 : 0.0;
@@ -43,4 +64,85 @@ DYCORE_API const char *DyCore_ffmpeg_get_using_decoder() {
     static std::string result;
     result = recorder.get_using_decoder();
     return result.c_str();
-}
\ No newline at end of file
+}
+
+// parameter: the DyCore_ffmpeg_start_recording fields plus startTime,
+// endTime, noteSpeed and background (BGR). Needs the offline render atlas.
+DYCORE_API double DyCore_ffmpeg_offline_start(const char *parameter) {
+    try {
+        if (offlineRenderer) {
+            throw std::logic_error("Offline render already running");
+        }
+        nlohmann::json j = nlohmann::json::parse(parameter);
+        OfflineRenderSettings settings{
+            .startTime = j.value("startTime", 0.0),
+            .endTime = j.value("endTime", 0.0),
+            .fps = j.value("fps", 60),
+            .width = j.value("width", 1920),
+            .height = j.value("height", 1080),
+            .noteSpeed = j.value("noteSpeed", 1.0),
+            .background = j.value("background", 0u),
+        };
+        auto renderer = std::make_unique<OfflineChartRenderer>(
+            settings, [](std::span<const uint8_t> frame) {
+                auto &recorder = get_recorder();
+                recorder.wait_for_queue(OFFLINE_RECORDER_QUEUE_FRAMES);
+                return recorder.push_frame(frame.data(),
+                                           static_cast<int>(frame.size()));
+            });
+
+        const int rc = get_recorder().start_recording(
+            j.value("filename", "output.mp4"), j.value("musicPath", ""),
+            settings.width, settings.height, settings.fps,
+            j.value("musicOffset", 0.0));
+        if (rc != 0) {
+            return rc;
+        }
+        offlineRenderer = std::move(renderer);
+        return 0;
+    } catch (const std::exception &e) {
+        print_debug_message(std::string("Error starting offline render: ") +
+                            e.what());
+        return -1;
+    }
+}
+
+// Delivers up to maxFrames frames. Returns the progress in [0, 1]; at 1 the
+// recording is finished.
+DYCORE_API double DyCore_ffmpeg_offline_step(double maxFrames) {
+    try {
+        if (!offlineRenderer) {
+            throw std::logic_error("No offline render is running");
+        }
+        const bool pending = offlineRenderer->step(
+            static_cast<size_t>(std::max(maxFrames, 1.0)));
+        const double progress = offlineRenderer->get_progress();
+        if (!pending) {
+            end_offline_render();
+        }
+        return progress;
+    } catch (const std::exception &e) {
+        print_debug_message(std::string("Error rendering offline frames: ") +
+                            e.what());
+        end_offline_render();
+        return -1;
+    }
+}
+
+DYCORE_API double DyCore_ffmpeg_offline_abort() {
+    end_offline_render();
+    return 0;
+}
+
+// Stats of the running or last offline render.
+DYCORE_API const char *DyCore_ffmpeg_offline_get_stats() {
+    const auto stats =
+        offlineRenderer ? offlineRenderer->get_stats() : offlineRenderStats;
+    static std::string result;
+    result = nlohmann::json{{"frameCount", stats.frameCount},
+                            {"framesDelivered", stats.framesDelivered},
+                            {"elapsedMs", stats.elapsedMs},
+                            {"fps", stats.framesPerSecond}}
+                 .dump();
+    return result.c_str();
+}
@@ -350,6 +350,7 @@ void Recorder::writer_worker() {
             std::vector<char> frame_data = std::move(frame_queue.front());
             frame_queue.pop();
             lock.unlock();
+            space_cond.notify_all();
 
             if (ffmpeg_pipe) {
                 size_t written = fwrite(frame_data.data(), 1, frame_data.size(),
@@ -482,11 +483,19 @@ int Recorder::push_frame(const void* frameData, int frameSize) {
 #endif
 }
 
+void Recorder::wait_for_queue(size_t maxFrames) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    space_cond.wait(lock, [&] {
+        return frame_queue.size() < maxFrames || !recording_active;
+    });
+}
+
 void Recorder::finish_recording() {
 #ifdef _WIN32
     if (recording_active) {
         recording_active = false;
         queue_cond.notify_one();
+        space_cond.notify_all();
         if (writer_thread.joinable()) {
             writer_thread.join();
         }
@@ -522,6 +531,7 @@ void Recorder::finish_recording() {
     if (recording_active) {
         recording_active = false;
         queue_cond.notify_one();
+        space_cond.notify_all();
         if (writer_thread.joinable()) {
             writer_thread.join();
         }
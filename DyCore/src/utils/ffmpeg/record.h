@@ -61,6 +61,8 @@ class Recorder {
     std::queue<std::vector<char>> frame_queue;
     std::mutex queue_mutex;
     std::condition_variable queue_cond;
+    // Signalled whenever the writer drains a frame.
+    std::condition_variable space_cond;
     bool recording_active = false;
 
     void writer_worker();
@@ -89,6 +91,9 @@ class Recorder {
     // Push a frame to the recorder.
     // Returns 0 on success, or FFmpegPushFrameError on failure.
     int push_frame(const void* frameData, int frameSize);
+    // Blocks while maxFrames or more frames are waiting for FFmpeg, so
+    // producers faster than the encoder keep a bounded queue.
+    void wait_for_queue(size_t maxFrames);
     // Finish recording.
     void finish_recording();
     std::string get_default_encoder();
@@ -0,0 +1,191 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+#ifdef _WIN32
+[[noreturn]] void throw_mapping_error(const char* message) {
+    throw std::system_error(static_cast<int>(GetLastError()),
+                            std::system_category(), message);
+}
+
+// Closes the handle when leaving the scope, after any error is recorded.
+struct HandleCloser {
+    HANDLE handle;
+    ~HandleCloser() {
+        CloseHandle(handle);
+    }
+};
+#else
+[[noreturn]] void throw_mapping_error(const char* message) {
+    throw std::system_error(errno, std::generic_category(), message);
+}
+
+// Closes the descriptor when leaving the scope, after any error is recorded.
+struct FileCloser {
+    int fd;
+    ~FileCloser() {
+        ::close(fd);
+    }
+};
+#endif
+
+}  // namespace
+
+MappedFile::MappedFile(const std::filesystem::path& path, Access access)
+    : writable(access == Access::COPY_ON_WRITE) {
+#ifdef _WIN32
+    HANDLE file =
+        CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                    nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw_mapping_error("Error opening file for mapping.");
+    }
+    const HandleCloser fileCloser{file};
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        throw_mapping_error("Error reading file size.");
+    }
+    if (fileSize.QuadPart == 0) {
+        return;
+    }
+    const auto size = static_cast<size_t>(fileSize.QuadPart);
+    // The mapping keeps the file open.
+    mapping = CreateFileMappingW(file, nullptr,
+                                 writable ? PAGE_WRITECOPY : PAGE_READONLY, 0,
+                                 0, nullptr);
+    if (mapping) {
+        view = static_cast<char*>(MapViewOfFile(
+            mapping, writable ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+        if (view) {
+            length = size;
+            return;
+        }
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+
+    buffer = std::make_unique_for_overwrite<char[]>(size);
+    while (length < size) {
+        const DWORD chunk = static_cast<DWORD>(
+            std::min<size_t>(size - length, 1u << 30));
+        DWORD read = 0;
+        if (!ReadFile(file, buffer.get() + length, chunk, &read, nullptr)) {
+            throw_mapping_error("Error reading file.");
+        }
+        if (read == 0) {
+            break;
+        }
+        length += read;
+    }
+    view = buffer.get();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw_mapping_error("Error opening file for mapping.");
+    }
+    const FileCloser fileCloser{fd};
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw_mapping_error("Error reading file size.");
+    }
+    if (info.st_size == 0) {
+        return;
+    }
+    const auto size = static_cast<size_t>(info.st_size);
+    // The mapping keeps the file open.
+    void* address =
+        ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+               MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+        // The whole file is about to be read; start reading it ahead.
+        ::madvise(address, size, MADV_WILLNEED);
+        view = static_cast<char*>(address);
+        length = size;
+        return;
+    }
+
+    buffer = std::make_unique_for_overwrite<char[]>(size);
+    while (length < size) {
+        const ssize_t read = ::read(fd, buffer.get() + length, size - length);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read < 0) {
+            throw_mapping_error("Error reading file.");
+        }
+        if (read == 0) {
+            break;
+        }
+        length += static_cast<size_t>(read);
+    }
+    view = buffer.get();
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+std::span<char> MappedFile::writable_data() {
+    if (!writable) {
+        throw std::logic_error("The file is mapped read-only.");
+    }
+    return {view, length};
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        view = std::exchange(other.view, nullptr);
+        length = std::exchange(other.length, 0);
+        writable = std::exchange(other.writable, false);
+        buffer = std::move(other.buffer);
+#ifdef _WIN32
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::close() {
+    if (buffer) {
+        buffer.reset();
+    } else if (view) {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+#else
+        ::munmap(view, length);
+#endif
+    }
+#ifdef _WIN32
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    mapping = nullptr;
+#endif
+    view = nullptr;
+    length = 0;
+    writable = false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+// A view of a whole file mapped into memory. Files that cannot be mapped,
+// such as some on network shares, are read into a buffer instead. The view
+// lives as long as the object; empty files give an empty view.
+//
+// On Windows the file cannot be replaced while it is mapped, so anything
+// kept past loading should be copied out of the view.
+class MappedFile {
+   public:
+    enum class Access {
+        READ_ONLY,
+        // The view can be written, for parsers that work in place. Written
+        // pages are copied privately and the file is never changed.
+        COPY_ON_WRITE
+    };
+
+    MappedFile() = default;
+    // Throws std::system_error if the file cannot be opened or read.
+    explicit MappedFile(const std::filesystem::path& path,
+                        Access access = Access::READ_ONLY);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const char> data() const {
+        return {view, length};
+    }
+    // Throws std::logic_error unless opened with Access::COPY_ON_WRITE.
+    std::span<char> writable_data();
+    size_t size() const {
+        return length;
+    }
+    // Whether the file was read into a buffer rather than mapped.
+    bool buffered() const {
+        return buffer != nullptr;
+    }
+
+   private:
+    void close();
+
+    char* view = nullptr;
+    size_t length = 0;
+    bool writable = false;
+    std::unique_ptr<char[]> buffer;
+#ifdef _WIN32
+    // Windows HANDLE of the file mapping.
+    void* mapping = nullptr;
+#endif
+};
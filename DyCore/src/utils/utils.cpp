@@ -3,6 +3,7 @@
 #define NOMINMAX
 #include <Windows.h>
 
+#include <charconv>
 #include <chrono>
 #include <cstdio>
 #include <ctime>
@@ -10,6 +11,7 @@
 #include <iostream>
 #include <mutex>
 #include <random>
+#include <string_view>
 #include <taskflow/taskflow.hpp>
 
 #include "analytics.h"
@@ -218,18 +220,30 @@ int hardware_concurrency() {
     return std::thread::hardware_concurrency();
 }
 
-std::string format_double_with_precision(double value, int precision) {
+void append_double_with_precision(std::string& out, double value,
+                                  int precision) {
+    // Fixed notation as "%.*f" prints it.
     char buffer[512];
-    snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
-    std::string str(buffer);
+    const auto result =
+        std::to_chars(buffer, buffer + sizeof(buffer), value,
+                      std::chars_format::fixed, precision);
+    std::string_view str(buffer, result.ptr - buffer);
+    if (result.ec != std::errc()) {
+        str = "0";
+    }
 
-    size_t dot_pos = str.find('.');
-    if (dot_pos != std::string::npos) {
-        str.erase(str.find_last_not_of('0') + 1, std::string::npos);
+    if (str.find('.') != std::string_view::npos) {
+        str.remove_suffix(str.size() - (str.find_last_not_of('0') + 1));
         if (str.back() == '.') {
-            str.pop_back();
+            str.remove_suffix(1);
         }
     }
+    out += str;
+}
+
+std::string format_double_with_precision(double value, int precision) {
+    std::string str;
+    append_double_with_precision(str, value, precision);
     return str;
 }
 
@@ -20,7 +20,10 @@ char difficulty_int_to_char(int index);
 
 int hardware_concurrency();
 
+// Formats value with at most precision decimals, dropping trailing zeros.
 std::string format_double_with_precision(double value, int precision);
+void append_double_with_precision(std::string& out, double value,
+                                  int precision);
 
 uint64_t get_current_time();
 
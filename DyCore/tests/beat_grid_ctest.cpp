@@ -0,0 +1,88 @@
+#include <doctest/doctest.h>
+
+#include <vector>
+
+#include "beatGrid.h"
+#include "timing.h"
+
+extern "C" double DyCore_insert_timing_point(const char* timingPointObject);
+extern "C" double DyCore_timing_points_reset();
+
+namespace {
+
+constexpr size_t BYTES_PER_QUAD = 120;
+
+BeatGridStyle make_test_style() {
+    return {
+        .colors = {0, 0xFFFFFF, 0x3643F4, 0xB0279C, 0xF39621},
+        .lengthOffsets = {0, 0, -30, -30, -60},
+        .length = 1440.0,
+        .hardLength = 1728.0,
+        .longLength = 1696.0,
+        .height = 873.0,
+        .hardHeight = 921.0,
+        .sideInfoX = 1824.0,
+        .sideInfoWidth = 100.0,
+    };
+}
+
+BeatGridView make_view(double nowTime, std::vector<int> divisions) {
+    return {.nowTime = nowTime,
+            .noteSpeed = 1.0,
+            .divisions = std::move(divisions),
+            .sideAlpha = {1.0, 0.0, 0.0},
+            .musicLength = 100000.0};
+}
+
+}  // namespace
+
+TEST_CASE("BeatGridDrawsVisibleDivisions") {
+    DyCore_timing_points_reset();
+    REQUIRE(DyCore_insert_timing_point(
+                R"({"time":0.0,"beatLength":500.0,"meter":4})") == 0);
+    set_beat_grid_style(make_test_style());
+
+    // Only the beats at 0 and 500 ms lie between the judge line and the top
+    // edge. The first is a bar line; the second also gets a side tick.
+    const auto beats = render_beat_grid(make_view(-100.0, {1}));
+    const size_t beatBytes = beats.size();
+    CHECK(beatBytes == 3 * BYTES_PER_QUAD);
+
+    // 1/4 adds the quarter and three-quarter lines of each beat.
+    const auto quarters = render_beat_grid(make_view(-100.0, {1, 4}));
+    CHECK(quarters.size() > beatBytes);
+    CHECK(quarters.size() % BYTES_PER_QUAD == 0);
+
+    DyCore_timing_points_reset();
+}
+
+TEST_CASE("BeatGridReusesLinesAndVertices") {
+    DyCore_timing_points_reset();
+    REQUIRE(DyCore_insert_timing_point(
+                R"({"time":0.0,"beatLength":500.0,"meter":4})") == 0);
+    set_beat_grid_style(make_test_style());
+
+    (void)render_beat_grid(make_view(100.0, {1, 2}));
+    const auto first = get_beat_grid_stats();
+
+    // Same view: nothing is rebuilt.
+    (void)render_beat_grid(make_view(100.0, {1, 2}));
+    auto stats = get_beat_grid_stats();
+    CHECK(stats.lineBuilds == first.lineBuilds);
+    CHECK(stats.vertexBuilds == first.vertexBuilds);
+
+    // Playback inside the enumerated window only moves the vertices.
+    (void)render_beat_grid(make_view(116.0, {1, 2}));
+    stats = get_beat_grid_stats();
+    CHECK(stats.lineBuilds == first.lineBuilds);
+    CHECK(stats.vertexBuilds == first.vertexBuilds + 1);
+
+    // A timing edit invalidates the lines.
+    REQUIRE(DyCore_insert_timing_point(
+                R"({"time":700.0,"beatLength":400.0,"meter":3})") == 0);
+    (void)render_beat_grid(make_view(116.0, {1, 2}));
+    stats = get_beat_grid_stats();
+    CHECK(stats.lineBuilds == first.lineBuilds + 1);
+
+    DyCore_timing_points_reset();
+}
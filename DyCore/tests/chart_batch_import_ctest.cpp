@@ -0,0 +1,235 @@
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chartBatchImport.h"
+#include "gm.h"
+#include "journal.h"
+#include "note.h"
+#include "project.h"
+#include "projectManager.h"
+#include "timing.h"
+
+extern "C" double DyCore_chart_import_batch(const char* pathsJson,
+                                            double append);
+extern "C" double DyCore_has_async_event();
+extern "C" const char* DyCore_get_async_event();
+
+namespace {
+
+std::filesystem::path write_chart_file(const char* name, const char* content) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+    return path;
+}
+
+}  // namespace
+
+TEST_CASE("ChartBatchImportReadsFilesWithoutTouchingTheCurrentChart") {
+    namespace fs = std::filesystem;
+
+    const auto dyPath = write_chart_file("dynode_batch_import.dy", R"({
+        "CMap": {
+            "m_path": "batch dy", "m_barPerMin": 40, "m_timeOffset": 0,
+            "m_leftRegion": "PAD", "m_rightRegion": "MIXER",
+            "m_mapID": "_map_batch_H",
+            "m_notes": {"m_notes": {"CMapNoteAsset": [
+                {"m_id": 0, "m_type": "HOLD", "m_time": 1, "m_position": 1,
+                 "m_width": 1, "m_subId": 1},
+                {"m_id": 1, "m_type": "SUB", "m_time": 3, "m_position": 1,
+                 "m_width": 1, "m_subId": -1},
+                {"m_id": 2, "m_type": "NORMAL", "m_time": 4,
+                 "m_position": 1, "m_width": 1, "m_subId": -1}
+            ]}},
+            "m_argument": {"m_bpmchange": {"CBpmchange": [
+                {"m_time": 0, "m_value": 40}, {"m_time": 2, "m_value": 60}
+            ]}}
+        }
+    })");
+    const auto xmlPath = write_chart_file(
+        "dynode_batch_import.XML",
+        R"(<?xml version="1.0"?>
+<CMap>
+  <m_path>batch xml</m_path>
+  <m_barPerMin>30</m_barPerMin>
+  <m_timeOffset>0</m_timeOffset>
+  <m_leftRegion>PAD</m_leftRegion>
+  <m_rightRegion>PAD</m_rightRegion>
+  <m_mapID>_map_batch_N</m_mapID>
+  <m_notes><m_notes>
+    <CMapNoteAsset><m_id>0</m_id><m_type>NORMAL</m_type><m_time>2</m_time>
+      <m_position>1</m_position><m_width>1</m_width><m_subId>-1</m_subId>
+    </CMapNoteAsset>
+  </m_notes></m_notes>
+</CMap>)");
+    const auto otherPath =
+        write_chart_file("dynode_batch_import.txt", "not a chart");
+
+    clear_notes();
+    get_timing_manager().clear();
+    Note editing{};
+    editing.time = 123.0;
+    editing.width = 1.0;
+    REQUIRE(create_note(editing) == 0);
+
+    const std::vector<std::string> paths = {
+        dyPath.string(), xmlPath.string(), otherPath.string(),
+        (fs::temp_directory_path() / "dynode_batch_missing.dy").string()};
+    const auto results = import_chart_files(paths);
+    REQUIRE(results.size() == 4);
+
+    CHECK(results[0].error.empty());
+    CHECK(results[0].chart.metadata.title == "batch dy");
+    CHECK(results[0].stats.noteCount == 2);
+    CHECK(results[0].stats.holdCount == 1);
+    // The BPM doubles at bar 2, so bar 4 is at 3000 + 2 * 1000 ms.
+    CHECK(std::abs(results[0].stats.duration - 5000.0) <= 0.01);
+    CHECK(std::abs(results[0].stats.minBpm - 160.0) <= 0.01);
+    CHECK(std::abs(results[0].stats.maxBpm - 240.0) <= 0.01);
+
+    CHECK(results[1].error.empty());
+    CHECK(results[1].chart.metadata.title == "batch xml");
+    CHECK(results[1].stats.noteCount == 1);
+
+    CHECK_FALSE(results[2].error.empty());
+    CHECK_FALSE(results[3].error.empty());
+    CHECK(results[3].path == paths[3]);
+
+    // The charts being edited are left alone.
+    std::vector<Note> notes;
+    get_notes_array(notes);
+    REQUIRE(notes.size() == 1);
+    CHECK(notes[0].time == 123.0);
+    CHECK(get_timing_manager().count() == 0);
+
+    auto& manager = ProjectManager::inst();
+    const int chartCount = manager.get_chart_count();
+    std::vector<Chart> charts;
+    charts.push_back(results[0].chart);
+    CHECK(manager.append_charts(std::move(charts)) == chartCount);
+    CHECK(manager.get_chart_count() == chartCount + 1);
+    get_notes_array(notes);
+    CHECK(notes.size() == 1);
+
+    std::error_code ec;
+    fs::remove(dyPath, ec);
+    fs::remove(xmlPath, ec);
+    fs::remove(otherPath, ec);
+    manager.setup_default_chart();
+}
+
+TEST_CASE("ChartBatchImportReadsBinaryProjects") {
+    namespace fs = std::filesystem;
+
+    const auto savedPath =
+        fs::temp_directory_path() / "dynode_batch_import_saved.dynb";
+    // The extension is matched in any case.
+    const auto importPath =
+        fs::temp_directory_path() / "dynode_batch_import.DYNB";
+    std::error_code ec;
+    fs::remove(savedPath, ec);
+
+    auto& manager = ProjectManager::inst();
+    manager.setup_default_chart();
+    chart_set_metadata({.title = "batch dynb",
+                        .artist = "artist",
+                        .charter = "charter",
+                        .sideType = {"PAD", "PAD"},
+                        .difficulty = 2});
+    clear_notes();
+    get_timing_manager().clear();
+    get_timing_manager().add_timing_point({0.0, 500.0, 4});
+    for (int i = 0; i < 5; ++i) {
+        Note note{};
+        note.time = 100.0 * (i + 1);
+        note.width = 1.0;
+        note.position = 2.0;
+        REQUIRE(create_note(note) == 0);
+    }
+    __async_save_project({savedPath.string(), 3});
+    REQUIRE(fs::exists(savedPath));
+    fs::copy_file(savedPath, importPath, fs::copy_options::overwrite_existing);
+
+    const std::vector<std::string> paths = {importPath.string()};
+    const auto results = import_chart_files(paths);
+    REQUIRE(results.size() == 1);
+    CHECK(results[0].error.empty());
+    CHECK(results[0].chart.metadata.title == "batch dynb");
+    CHECK(results[0].stats.noteCount == 5);
+
+    // Saving opened the journal of the saved file.
+    ProjectJournal::inst().close(true);
+    fs::remove(savedPath, ec);
+    fs::remove(importPath, ec);
+    manager.setup_default_chart();
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ChartBatchImportApiAppendsChartsWhenTheEventIsTaken") {
+    namespace fs = std::filesystem;
+
+    const auto xmlPath = write_chart_file("dynode_batch_api.xml",
+                                          R"(<?xml version="1.0"?>
+<CMap>
+  <m_path>batch api</m_path>
+  <m_barPerMin>30</m_barPerMin>
+  <m_timeOffset>0</m_timeOffset>
+  <m_leftRegion>PAD</m_leftRegion>
+  <m_rightRegion>PAD</m_rightRegion>
+  <m_mapID>_map_batch_N</m_mapID>
+  <m_notes><m_notes>
+    <CMapNoteAsset><m_id>0</m_id><m_type>NORMAL</m_type><m_time>2</m_time>
+      <m_position>1</m_position><m_width>1</m_width><m_subId>-1</m_subId>
+    </CMapNoteAsset>
+  </m_notes></m_notes>
+</CMap>)");
+    auto& manager = ProjectManager::inst();
+    manager.setup_default_chart();
+    const int chartCount = manager.get_chart_count();
+
+    const nlohmann::json paths = {
+        xmlPath.string(),
+        (fs::temp_directory_path() / "dynode_batch_api_missing.xml").string()};
+    const double batchId = DyCore_chart_import_batch(paths.dump().c_str(), 1);
+    REQUIRE(batchId > 0);
+    CHECK(DyCore_chart_import_batch("not json", 1) == -1);
+
+    // The charts are read in the background and added when the event is
+    // taken.
+    nlohmann::json done;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (done.is_null() && std::chrono::steady_clock::now() < deadline) {
+        if (DyCore_has_async_event() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        const auto event = nlohmann::json::parse(DyCore_get_async_event());
+        if (event["type"] == CHART_IMPORT_BATCH) {
+            done = event;
+        }
+    }
+    REQUIRE_FALSE(done.is_null());
+    CHECK(done["status"] == batchId);
+    const auto list = nlohmann::json::parse(done["content"].get<std::string>());
+    REQUIRE(list.size() == 2);
+    CHECK(list[0]["error"] == "");
+    CHECK(list[0]["title"] == "batch api");
+    CHECK(list[0]["chartIndex"] == chartCount);
+    CHECK(list[1]["error"] != "");
+    CHECK_FALSE(list[1].contains("chartIndex"));
+    CHECK(manager.get_chart_count() == chartCount + 1);
+
+    std::error_code ec;
+    fs::remove(xmlPath, ec);
+    manager.setup_default_chart();
+}
@@ -0,0 +1,105 @@
+#include <doctest/doctest.h>
+#include <zstd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "compress.h"
+
+namespace {
+
+// Enough text to take several stream output blocks.
+std::string make_text() {
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "{\"side\":" + std::to_string(i % 3) +
+                ",\"time\":" + std::to_string(i * 37) + "}\n";
+    }
+    return text;
+}
+
+// Compressed without recording the content size, as streams do.
+std::string compress_unsized(const std::string& text) {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    REQUIRE(cctx != nullptr);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_contentSizeFlag, 0);
+    std::string frame(ZSTD_compressBound(text.size()), '\0');
+    const size_t size = ZSTD_compress2(cctx, frame.data(), frame.size(),
+                                       text.data(), text.size());
+    ZSTD_freeCCtx(cctx);
+    REQUIRE_FALSE(ZSTD_isError(size));
+    frame.resize(size);
+    return frame;
+}
+
+std::string compress_sized(const std::string& text) {
+    std::string frame(ZSTD_compressBound(text.size()), '\0');
+    const size_t size =
+        ZSTD_compress(frame.data(), frame.size(), text.data(), text.size(), 3);
+    REQUIRE_FALSE(ZSTD_isError(size));
+    frame.resize(size);
+    return frame;
+}
+
+}  // namespace
+
+TEST_CASE("DecompressReadsFramesWithoutContentSize") {
+    const std::string text = make_text();
+    const std::string frame = compress_unsized(text);
+    REQUIRE(ZSTD_getFrameContentSize(frame.data(), frame.size()) ==
+            ZSTD_CONTENTSIZE_UNKNOWN);
+
+    CHECK(check_compressed(frame.c_str(), frame.size()));
+    CHECK(decompress_to_string(frame) == text);
+    CHECK(decompress_string(frame) == text);
+
+    std::string streamed;
+    size_t pieces = 0;
+    CHECK(decompress_stream(frame, [&](const char* data, size_t size) {
+              streamed.append(data, size);
+              ++pieces;
+          }) == text.size());
+    CHECK(streamed == text);
+    CHECK(pieces > 1);
+
+    CHECK(DyCore_get_decompressed_size(frame.data(), frame.size()) == -2);
+    std::vector<char> buffer(text.size());
+    REQUIRE(DyCore_decompress_to_buffer(frame.data(), frame.size(),
+                                        buffer.data(), buffer.size()) ==
+            text.size());
+    CHECK(std::memcmp(buffer.data(), text.data(), text.size()) == 0);
+
+    // A frame cut short is an error, not a shorter content.
+    const std::string cut = frame.substr(0, frame.size() - 4);
+    CHECK_THROWS(decompress_stream(cut, [](const char*, size_t) {}));
+    CHECK_THROWS(decompress_to_string(cut));
+}
+
+TEST_CASE("DecompressIntoBufferChecksItsCapacity") {
+    const std::string text = make_text();
+    std::string file = compress_sized(text);
+    // A trailing skippable frame, like the checksum frame of saves.
+    const uint32_t skippable[] = {ZSTD_MAGIC_SKIPPABLE_START, 4, 0};
+    file.append(reinterpret_cast<const char*>(skippable), sizeof(skippable));
+
+    CHECK(DyCore_get_decompressed_size(file.data(), file.size()) ==
+          text.size());
+    std::vector<char> buffer(text.size());
+    CHECK(DyCore_decompress_to_buffer(file.data(), file.size(), buffer.data(),
+                                      buffer.size() - 1) == -2);
+    CHECK_THROWS_AS(decompress_into(file, buffer.data(), buffer.size() - 1),
+                    std::length_error);
+    REQUIRE(decompress_into(file, buffer.data(), buffer.size()) ==
+            text.size());
+    CHECK(std::memcmp(buffer.data(), text.data(), text.size()) == 0);
+    CHECK(decompress_to_string(file) == text);
+
+    const std::string cut = file.substr(0, file.size() / 2);
+    CHECK(DyCore_decompress_to_buffer(cut.data(), cut.size(), buffer.data(),
+                                      buffer.size()) == -1);
+    CHECK(DyCore_get_decompressed_size("not zstd", 8) == -1);
+    CHECK_FALSE(check_compressed("not zstd", 8));
+}
@@ -0,0 +1,119 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <json.hpp>
+#include <string>
+#include <vector>
+
+#include "note.h"
+#include "project.h"
+#include "project/format/dy.h"
+#include "timing.h"
+
+namespace {
+
+std::filesystem::path write_dy_file(const char* name, const char* content) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+    return path;
+}
+
+}  // namespace
+
+TEST_CASE("DyImportReadsNotesTimingAndRemix") {
+    namespace fs = std::filesystem;
+
+    // Numbers are stored both as JSON numbers and as strings, and unknown
+    // members are skipped.
+    constexpr const char* dyContent = R"({
+        "CMap": {
+            "m_path": "dy test",
+            "m_barPerMin": "40",
+            "m_timeOffset": 0,
+            "m_leftRegion": "PAD",
+            "m_rightRegion": "MIXER",
+            "m_mapID": "_map_dytest_H",
+            "m_notes": {"m_notes": {"CMapNoteAsset": [
+                {"m_id": 0, "m_type": "NORMAL", "m_time": "0.5",
+                 "m_position": 1, "m_width": 1, "m_subId": -1},
+                {"m_id": "1", "m_type": "HOLD", "m_time": 1,
+                 "m_position": 2, "m_width": 1.5, "m_subId": 2,
+                 "m_unknown": {"nested": [1, 2]}},
+                {"m_id": 2, "m_type": "SUB", "m_time": "3",
+                 "m_position": 2, "m_width": 1.5, "m_subId": -1}
+            ]}},
+            "m_notesLeft": {"m_notes": {"CMapNoteAsset": [
+                {"m_id": 0, "m_type": "CHAIN", "m_time": 2,
+                 "m_position": 0, "m_width": 1}
+            ]}},
+            "m_notesRight": {"m_notes": {}},
+            "m_argument": {"m_bpmchange": {"CBpmchange": [
+                {"m_time": 0, "m_value": "40"}
+            ]}}
+        },
+        "remix": {"music": "bXVzaWM=", "bg": ""}
+    })";
+
+    const auto path = write_dy_file("dynode_dy_import_test.dy", dyContent);
+    clear_notes();
+    get_timing_manager().clear();
+
+    CHECK(chart_import_dy(path.string().c_str(), true, true) ==
+          IMPORT_DY_RESULT_STATES::SUCCESS);
+
+    const auto metadata = chart_get_metadata();
+    CHECK(metadata.title == "dy test");
+    CHECK(metadata.sideType[0] == "PAD");
+    CHECK(metadata.sideType[1] == "MIXER");
+
+    REQUIRE(get_timing_manager().count() == 1);
+    CHECK(std::abs(get_timing_manager()[0].get_bpm() - 160.0) <= 0.01);
+
+    std::vector<Note> notes;
+    get_notes_array(notes);
+    REQUIRE(notes.size() == 3);
+    std::sort(notes.begin(), notes.end(),
+              [](const Note& a, const Note& b) { return a.time < b.time; });
+    CHECK(std::abs(notes[0].time - 750.0) <= 0.01);
+    // DY positions are the left edge of the note.
+    CHECK(std::abs(notes[0].position - 1.5) <= 1e-9);
+    CHECK(notes[1].type == 2);
+    CHECK(std::abs(notes[1].lastTime - 3000.0) <= 0.01);
+    CHECK(notes[2].type == 1);
+    CHECK(notes[2].side == 1);
+
+    const auto remix = nlohmann::json::parse(get_dy_remix());
+    CHECK(remix["music"] == "bXVzaWM=");
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_CASE("DyImportRejectsOldAndIncompleteFiles") {
+    namespace fs = std::filesystem;
+
+    const auto oldPath = write_dy_file("dynode_dy_import_old.dy",
+                                       R"({"DynamixMap": {"m_notes": []}})");
+    CHECK(chart_import_dy(oldPath.string().c_str(), false, false) ==
+          IMPORT_DY_RESULT_STATES::OLD_FORMAT);
+
+    // The note has no time.
+    const auto brokenPath = write_dy_file(
+        "dynode_dy_import_broken.dy",
+        R"({"CMap": {"m_path": "x", "m_barPerMin": 40, "m_timeOffset": 0,
+            "m_leftRegion": "PAD", "m_rightRegion": "PAD",
+            "m_mapID": "_map_x_N",
+            "m_notes": {"m_notes": {"CMapNoteAsset": [
+                {"m_id": 0, "m_type": "NORMAL", "m_position": 0,
+                 "m_width": 1}]}}}})");
+    CHECK(chart_import_dy(brokenPath.string().c_str(), false, false) ==
+          IMPORT_DY_RESULT_STATES::FAILURE);
+
+    std::error_code ec;
+    fs::remove(oldPath, ec);
+    fs::remove(brokenPath, ec);
+}
@@ -0,0 +1,321 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "note.h"
+#include "project.h"
+#include "project/format/dyn.h"
+#include "project/format/dynb.h"
+#include "snap.h"
+#include "timing.h"
+
+namespace {
+
+Project make_dynb_test_project() {
+    Project project{.version = "v0.2.0",
+                    .metadata = {{"stats", {{"projectTime", 42}}}}};
+    for (int chartIndex = 0; chartIndex < 2; ++chartIndex) {
+        Chart chart{.metadata = {.title = "Chart " + std::to_string(chartIndex),
+                                 .artist = "artist",
+                                 .charter = "charter",
+                                 .sideType = {"MIXER", "PAD"},
+                                 .difficulty = chartIndex + 2},
+                    .path = {.music = "music.ogg"}};
+        chart.timingPoints = {{-12.5, 60000.0 / 172.0, 4},
+                              {10000.0, 60000.0 / 86.0, 3}};
+        for (int i = 0; i < 2000; ++i) {
+            Note note{};
+            note.side = i % 3;
+            note.type = i % 5 == 0 ? 2 : i % 2;
+            // Out of time order, to check notes come back sorted. Values are
+            // the doubles nearest to three-decimal numbers.
+            note.time =
+                ((i * 7919 % 2000) * 87209 + chartIndex * 1000) / 1000.0;
+            note.width = 0.75 + (i % 8) * 0.125;
+            note.position = (i % 51) / 10.0;
+            note.lastTime = note.type == 2 ? 348.837 : 0.0;
+            chart.notes.push_back(note);
+        }
+        project.charts.push_back(chart);
+    }
+    return project;
+}
+
+std::string export_to_string(const Project& project, int level, bool binary) {
+    std::string bytes;
+    const auto writer = [&](const char* data, size_t size) {
+        bytes.append(data, size);
+    };
+    const auto snapshot = make_project_snapshot(project);
+    if (binary) {
+        project_export_dynb(snapshot, {.level = level}, writer);
+    } else {
+        project_export_dyn(snapshot, {.level = level}, writer);
+    }
+    return bytes;
+}
+
+void write_bytes(const std::filesystem::path& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    REQUIRE(out.is_open());
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+void sort_by_time(std::vector<Note>& notes) {
+    std::stable_sort(notes.begin(), notes.end(),
+                     [](const Note& a, const Note& b) {
+                         return a.time < b.time;
+                     });
+}
+
+}  // namespace
+
+TEST_CASE("DynbRoundTripsThroughJsonDyn") {
+    namespace fs = std::filesystem;
+
+    const auto dir = fs::temp_directory_path();
+    const auto jsonPath = dir / "dynode_dynb_test.dyn";
+    const auto binaryPath = dir / "dynode_dynb_test.dynb";
+    const Project original = make_dynb_test_project();
+
+    for (const int level : {0, 3}) {
+        CAPTURE(level);
+        write_bytes(binaryPath, export_to_string(original, level, true));
+        CHECK(is_dynb_file(binaryPath.string().c_str()));
+
+        // Both containers are read through the .dyn entry point.
+        Project loaded;
+        REQUIRE(project_import_dyn(binaryPath.string().c_str(), loaded) == 0);
+        REQUIRE(loaded.charts.size() == original.charts.size());
+        CHECK(loaded.version == original.version);
+        CHECK(loaded.metadata == original.metadata);
+        for (size_t c = 0; c < original.charts.size(); ++c) {
+            const auto& expected = original.charts[c];
+            const auto& chart = loaded.charts[c];
+            CHECK(chart.metadata.title == expected.metadata.title);
+            CHECK(chart.metadata.difficulty == expected.metadata.difficulty);
+            CHECK(chart.path.music == expected.path.music);
+            REQUIRE(chart.timingPoints.size() == 2);
+            CHECK(chart.timingPoints[1].beatLength ==
+                  expected.timingPoints[1].beatLength);
+            CHECK(chart.timingPoints[1].meter == 3);
+
+            auto notes = expected.notes;
+            sort_by_time(notes);
+            REQUIRE(chart.notes.size() == notes.size());
+            for (size_t i = 0; i < notes.size(); ++i) {
+                CHECK(chart.notes[i].side == notes[i].side);
+                CHECK(chart.notes[i].type == notes[i].type);
+                // Values with up to three decimals come back exactly.
+                CHECK(chart.notes[i].time == notes[i].time);
+                CHECK(chart.notes[i].width == notes[i].width);
+                CHECK(chart.notes[i].position == notes[i].position);
+                CHECK(chart.notes[i].lastTime == notes[i].lastTime);
+            }
+        }
+
+        // Converting back to JSON gives the sorted original.
+        Project sortedOriginal = original;
+        for (auto& chart : sortedOriginal.charts) {
+            sort_by_time(chart.notes);
+        }
+        CHECK(export_to_string(loaded, level, false) ==
+              export_to_string(sortedOriginal, level, false));
+
+        // And binary again gives the same file.
+        write_bytes(jsonPath, export_to_string(loaded, level, false));
+        Project reloaded;
+        REQUIRE(project_import_dyn(jsonPath.string().c_str(), reloaded) == 0);
+        CHECK(export_to_string(reloaded, level, true) ==
+              export_to_string(original, level, true));
+    }
+
+    std::error_code ec;
+    fs::remove(jsonPath, ec);
+    fs::remove(binaryPath, ec);
+}
+
+TEST_CASE("DynbRoundTripKeepsNotesOnTheGrid") {
+    namespace fs = std::filesystem;
+
+    // Grid lines at 172 BPM fall between microseconds, so the times read
+    // back are off the grid by up to half a tick.
+    const std::vector<TimingPoint> timingPoints = {{-12.5, 60000.0 / 172.0, 4}};
+    const TimingIndex index(timingPoints);
+    const int divsPerBeat = 16;
+    const double division = timingPoints[0].beatLength / divsPerBeat;
+    Project project{.version = "v0.2.0"};
+    Chart chart{.metadata = {.title = "Grid", .sideType = {"MIXER", "PAD"}}};
+    chart.timingPoints = timingPoints;
+    for (int i = 0; i < 500; ++i) {
+        Note note{};
+        note.side = i % 3;
+        note.width = 1.0;
+        note.time = -12.5 + i * 3 * division;
+        if (i % 4 == 0) {
+            note.type = 2;
+            note.lastTime = (i % 7 + 1) * division;
+        }
+        chart.notes.push_back(note);
+    }
+    project.charts.push_back(chart);
+
+    const auto path = fs::temp_directory_path() / "dynode_dynb_grid.dynb";
+    write_bytes(path, export_to_string(project, 3, true));
+    Project loaded;
+    REQUIRE(project_import_dynb(path.string().c_str(), loaded) == 0);
+    std::error_code ec;
+    fs::remove(path, ec);
+    REQUIRE(loaded.charts.size() == 1);
+
+    std::vector<double> expected, times;
+    for (size_t i = 0; i < chart.notes.size(); ++i) {
+        const auto& saved = chart.notes[i];
+        const auto& note = loaded.charts[0].notes[i];
+        expected.push_back(saved.time);
+        times.push_back(note.time);
+        if (saved.type == 2) {
+            expected.push_back(saved.time + saved.lastTime);
+            times.push_back(note.time + note.lastTime);
+        }
+    }
+    std::vector<double> snapped(times.size());
+    for (const auto mode :
+         {SNAP_MODE::AROUND, SNAP_MODE::PRE, SNAP_MODE::POST}) {
+        snap_times_to_grid(index, times, snapped, divsPerBeat, mode);
+        for (size_t i = 0; i < times.size(); ++i) {
+            CAPTURE(i);
+            CHECK(snapped[i] == doctest::Approx(expected[i]).epsilon(1e-12));
+        }
+    }
+}
+
+TEST_CASE("DynbSmallSectionsUseDictionary") {
+    namespace fs = std::filesystem;
+
+    // A project with one empty chart is all JSON sections.
+    Project project{.version = "v0.2.0",
+                    .metadata = {{"stats", {{"projectTime", 7}}}}};
+    project.charts.push_back(Chart{.metadata = {.title = "Empty",
+                                                .sideType = {"MIXER", "MIXER"},
+                                                .difficulty = 1}});
+    const auto snapshot = make_project_snapshot(project);
+    std::string plain, withDictionary;
+    project_export_dynb(snapshot, {.level = 3, .smallDataDictionary = false},
+                        [&](const char* data, size_t size) {
+                            plain.append(data, size);
+                        });
+    project_export_dynb(snapshot, {.level = 3},
+                        [&](const char* data, size_t size) {
+                            withDictionary.append(data, size);
+                        });
+    CHECK(withDictionary.size() < plain.size());
+
+    const auto path = fs::temp_directory_path() / "dynode_dynb_dict.dynb";
+    write_bytes(path, withDictionary);
+    Project loaded;
+    REQUIRE(project_import_dynb(path.string().c_str(), loaded) == 0);
+    CHECK(loaded.metadata == project.metadata);
+    REQUIRE(loaded.charts.size() == 1);
+    CHECK(loaded.charts[0].metadata.title == "Empty");
+    CHECK(loaded.charts[0].metadata.sideType[1] == "MIXER");
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_CASE("DynbRejectsCorruptedSections") {
+    namespace fs = std::filesystem;
+
+    const auto path = fs::temp_directory_path() / "dynode_dynb_corrupt.dynb";
+    const std::string bytes =
+        export_to_string(make_dynb_test_project(), 0, true);
+
+    // Flip a byte in the last section, the second chart's timing points.
+    std::string corrupted = bytes;
+    corrupted[corrupted.size() - 3] ^= 0x40;
+    write_bytes(path, corrupted);
+    Project project;
+    CHECK_THROWS(project_import_dynb(path.string().c_str(), project));
+
+    // Save verification finds the same damage without decoding the charts.
+    const auto result = project_export_dynb(
+        make_project_snapshot(make_dynb_test_project()), {.level = 0},
+        [](const char*, size_t) {});
+    CHECK_NOTHROW(verify_dynb_file(bytes, result));
+    CHECK_THROWS(verify_dynb_file(corrupted, result));
+
+    write_bytes(path, bytes.substr(0, bytes.size() / 2));
+    CHECK_THROWS(project_import_dynb(path.string().c_str(), project));
+
+    CHECK(project_import_dynb(
+              (fs::temp_directory_path() / "dynode_dynb_missing.dynb")
+                  .string()
+                  .c_str(),
+              project) == -1);
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_CASE("LazyChartLoadMatchesEagerLoad") {
+    namespace fs = std::filesystem;
+
+    const auto path = fs::temp_directory_path() / "dynode_lazy_test.dyn";
+    const Project original = make_dynb_test_project();
+
+    for (const auto& [level, binary] :
+         {std::pair{0, false}, std::pair{3, false}, std::pair{3, true}}) {
+        CAPTURE(level);
+        CAPTURE(binary);
+        write_bytes(path, export_to_string(original, level, binary));
+
+        Project eager, lazy;
+        REQUIRE(project_import_dyn(path.string().c_str(), eager) == 0);
+        REQUIRE(project_import_dyn(path.string().c_str(), lazy, true) == 0);
+        REQUIRE(lazy.charts.size() == eager.charts.size());
+        CHECK(lazy.metadata == eager.metadata);
+
+        // Snapshots read the charts that were never decoded.
+        CHECK(export_to_string(lazy, level, binary) ==
+              export_to_string(eager, level, binary));
+
+        for (size_t c = 0; c < eager.charts.size(); ++c) {
+            const auto& chart = lazy.charts[c];
+            CHECK(chart.metadata.title == eager.charts[c].metadata.title);
+            CHECK(chart.notes.empty());
+            REQUIRE(chart.lazyContent);
+            const auto& content = chart.lazyContent->get();
+            const auto& notes = eager.charts[c].notes;
+            REQUIRE(content.notes.size() == notes.size());
+            for (size_t i = 0; i < notes.size(); ++i) {
+                CHECK(content.notes[i].side == notes[i].side);
+                CHECK(content.notes[i].type == notes[i].type);
+                CHECK(content.notes[i].time == notes[i].time);
+                CHECK(content.notes[i].width == notes[i].width);
+                CHECK(content.notes[i].position == notes[i].position);
+                CHECK(content.notes[i].lastTime == notes[i].lastTime);
+            }
+            REQUIRE(content.timingPoints.size() == 2);
+            CHECK(content.timingPoints[1].beatLength ==
+                  eager.charts[c].timingPoints[1].beatLength);
+        }
+    }
+
+    // Damage in a chart left in the file shows when it is decoded.
+    std::string corrupted = export_to_string(original, 0, true);
+    corrupted[corrupted.size() - 3] ^= 0x40;
+    write_bytes(path, corrupted);
+    Project lazy;
+    REQUIRE(project_import_dyn(path.string().c_str(), lazy, true) == 0);
+    CHECK_NOTHROW(lazy.charts[0].lazyContent->get());
+    CHECK_THROWS(lazy.charts[1].lazyContent->get());
+    CHECK_THROWS(lazy.charts[1].lazyContent->get());
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
@@ -1,6 +1,9 @@
 #include <doctest/doctest.h>
 
+#include <vector>
+
 #include "note.h"
+#include "notePoolManager.h"
 
 extern "C" double DyCore_clear_notes();
 extern "C" double DyCore_get_note_index_lower_bound(double time);
@@ -75,3 +78,49 @@ TEST_CASE("NoteIndexOnSideAfterIndex") {
 
     DyCore_clear_notes();
 }
+
+TEST_CASE("NoteBulkLoadLinksHoldsAndSorts") {
+    DyCore_clear_notes();
+
+    Note existing{};
+    existing.time = 250.0;
+    existing.width = 1.0;
+    existing.noteID = "existing";
+    REQUIRE(insert_note(existing) == 0);
+
+    std::vector<Note> notes(3);
+    notes[0].time = 300.0;
+    notes[0].type = 0;
+    notes[1].time = 100.0;
+    notes[1].type = 2;
+    notes[1].lastTime = 400.0;
+    notes[1].position = 2.5;
+    notes[2].time = 200.0;
+    notes[2].type = 1;
+    CHECK(create_notes(notes) == 4);
+
+    auto& pool = get_note_pool_manager();
+    CHECK(pool.get_note_count() == 5);
+    CHECK_FALSE(pool.is_ooo());
+
+    // Sorted by time, the sub note last at the end of the hold.
+    const std::vector<double> times = {100.0, 200.0, 250.0, 300.0, 500.0};
+    for (int i = 0; i < 5; ++i) {
+        CHECK(pool.get_note(i).time == times[i]);
+        CHECK(pool.get_index(pool.get_note(i).noteID) == i);
+    }
+    const Note& hold = pool.get_note(0);
+    const Note& sub = pool.get_note(4);
+    CHECK(hold.get_note_type() == NOTE_TYPE::HOLD);
+    CHECK(sub.get_note_type() == NOTE_TYPE::SUB);
+    CHECK(hold.subNoteID == sub.noteID);
+    CHECK(sub.subNoteID == hold.noteID);
+    CHECK(sub.beginTime == 100.0);
+    CHECK(sub.position == 2.5);
+
+    // Pairs stay linked through edits.
+    pool.access_note(sub.noteID, [](Note& note) { note.time = 700.0; });
+    CHECK(pool.get_note(hold.noteID).lastTime == 600.0);
+
+    DyCore_clear_notes();
+}
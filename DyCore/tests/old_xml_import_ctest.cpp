@@ -1,8 +1,10 @@
 #include <doctest/doctest.h>
 
+#include <algorithm>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <string>
 #include <vector>
 
 #include "note.h"
@@ -92,3 +94,205 @@ TEST_CASE("OldXmlImport") {
         fs::remove(tempPath, ec);
     }
 }
+
+TEST_CASE("XmlRoundTripKeepsNoteTimesAcrossBpmChanges") {
+    namespace fs = std::filesystem;
+
+    clear_notes();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({100.0, 500.0, 4});
+    timing.add_timing_point({1100.0, 250.0, 4});
+    timing.add_timing_point({1850.0, 750.0, 3});
+    timing.add_timing_point({4100.0, 400.0, 4});
+
+    const std::vector<double> times = {0.0,    100.0,  600.0,  1100.0,
+                                       1400.0, 1850.0, 3000.0, 4500.0};
+    for (const double time : times) {
+        Note note{};
+        note.side = 0;
+        note.type = 0;
+        note.time = time;
+        note.width = 1.0;
+        note.position = 2.5;
+        REQUIRE(create_note(note) == 0);
+    }
+
+    const auto tempPath =
+        fs::temp_directory_path() / "dynode_xml_round_trip_test.xml";
+    chart_export_xml(tempPath.string().c_str(), true, 0.0);
+    clear_notes();
+    timing.clear();
+    CHECK(chart_import_xml(tempPath.string().c_str(), false, true) ==
+          IMPORT_XML_RESULT_STATES::SUCCESS);
+    std::error_code ec;
+    fs::remove(tempPath, ec);
+
+    CHECK(timing.count() == 4);
+    CHECK(timing.get_index().time_to_beat(4100.0) == doctest::Approx(8.0));
+
+    std::vector<Note> notes;
+    get_notes_array(notes);
+    REQUIRE(notes.size() == times.size());
+    std::sort(notes.begin(), notes.end(),
+              [](const Note& a, const Note& b) { return a.time < b.time; });
+    for (size_t i = 0; i < times.size(); ++i) {
+        CHECK(notes[i].time == doctest::Approx(times[i]).epsilon(1e-6));
+    }
+
+    clear_notes();
+    timing.clear();
+}
+
+TEST_CASE("LargeXmlImportConvertsEveryNote") {
+    namespace fs = std::filesystem;
+
+    // Many notes, with holds on every side and a speed change every bar.
+    const int noteCount = 32768;
+    std::string xml =
+        "<?xml version=\"1.0\"?>\n<CMap><m_path>large</m_path>"
+        "<m_barPerMin>50</m_barPerMin><m_timeOffset>0</m_timeOffset>"
+        "<m_leftRegion>PAD</m_leftRegion><m_rightRegion>MIXER</m_rightRegion>"
+        "<m_mapID>_map_large_G</m_mapID>";
+    int id = 0;
+    for (const char* side : {"m_notes", "m_notesLeft", "m_notesRight"}) {
+        xml += "<" + std::string(side) + "><m_notes>";
+        for (int i = 0; i < noteCount / 3; ++i, ++id) {
+            const bool hold = i % 10 == 0;
+            const std::string time = std::to_string(i / 4.0);
+            xml += "<CMapNoteAsset><m_id>" + std::to_string(id) +
+                   "</m_id><m_type>" + (hold ? "HOLD" : "NORMAL") +
+                   "</m_type><m_time>" + time +
+                   "</m_time><m_position> 1.5</m_position><m_width>1"
+                   "</m_width><m_subId>" +
+                   (hold ? std::to_string(id + 1) : "-1") +
+                   "</m_subId></CMapNoteAsset>";
+            if (hold) {
+                ++id;
+                xml += "<CMapNoteAsset><m_id>" + std::to_string(id) +
+                       "</m_id><m_type>SUB</m_type><m_time>" +
+                       std::to_string(i / 4.0 + 0.5) +
+                       "</m_time><m_position>1.5</m_position><m_width>1"
+                       "</m_width><m_subId>-1</m_subId></CMapNoteAsset>";
+            }
+        }
+        xml += "</m_notes></" + std::string(side) + ">";
+    }
+    xml += "<m_argument><m_bpmchange>";
+    const int barCount = noteCount / 12;
+    for (int bar = 0; bar < barCount; ++bar) {
+        xml += "<CBpmchange><m_time>" + std::to_string(bar) +
+               "</m_time><m_value>" + (bar % 2 ? "50" : "25") +
+               "</m_value></CBpmchange>";
+    }
+    xml += "</m_bpmchange></m_argument></CMap>";
+
+    const auto tempPath =
+        fs::temp_directory_path() / "dynode_large_xml_import_test.xml";
+    const auto write_xml = [&](const std::string& content) {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        REQUIRE(out.is_open());
+        out << content;
+    };
+    write_xml(xml);
+
+    clear_notes();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    REQUIRE(chart_import_xml(tempPath.string().c_str(), true, true) ==
+            IMPORT_XML_RESULT_STATES::SUCCESS);
+    CHECK(chart_get_metadata().title == "large");
+    CHECK(timing.count() == barCount);
+
+    std::vector<Note> notes;
+    get_notes_array(notes);
+    CHECK(notes.size() == static_cast<size_t>(noteCount / 3 * 3));
+    const auto& index = timing.get_index();
+    size_t holdCount = 0;
+    for (const auto& note : notes) {
+        CHECK(note.position == 2.0);
+        if (note.type == 2) {
+            ++holdCount;
+            // Each hold ends two beats after it starts.
+            CHECK(index.time_to_beat(note.time + note.lastTime) -
+                      index.time_to_beat(note.time) ==
+                  doctest::Approx(2.0));
+        }
+    }
+    CHECK(holdCount == static_cast<size_t>((noteCount / 3 + 9) / 10 * 3));
+
+    // A bad number in any note fails the whole import.
+    const auto bad = xml.rfind("<m_width>1");
+    write_xml(xml.substr(0, bad) + "<m_width>x" + xml.substr(bad + 10));
+    clear_notes();
+    CHECK(chart_import_xml(tempPath.string().c_str(), false, false) ==
+          IMPORT_XML_RESULT_STATES::FAILURE);
+    get_notes_array(notes);
+    CHECK(notes.empty());
+
+    std::error_code ec;
+    fs::remove(tempPath, ec);
+    clear_notes();
+    timing.clear();
+}
+
+TEST_CASE("XmlExportEscapesTextAndKeepsHoldsPaired") {
+    namespace fs = std::filesystem;
+
+    chart_set_metadata({.title = "A&B <C>",
+                        .sideType = {"PAD", "MIXER"},
+                        .difficulty = 2});
+    clear_notes();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({0.0, 500.0, 4});
+
+    // Holds on the left side only, ending out of start order.
+    for (int i = 0; i < 4; ++i) {
+        Note note{};
+        note.side = 1;
+        note.type = 2;
+        note.time = i * 100.0;
+        note.width = 1.0;
+        note.position = 2.5;
+        note.lastTime = 1000.0 - i * 200.0;
+        REQUIRE(create_note(note) == 0);
+    }
+
+    const auto tempPath =
+        fs::temp_directory_path() / "dynode_xml_export_test.xml";
+    chart_export_xml(tempPath.string().c_str(), false, 0.0);
+    std::string xml;
+    {
+        std::ifstream in(tempPath);
+        REQUIRE(in.is_open());
+        xml.assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+    }
+    CHECK(xml.find("<m_path>A&amp;B &lt;C&gt;</m_path>") != std::string::npos);
+    CHECK(xml.find("<m_notes>\n\t\t<m_notes />\n\t</m_notes>") !=
+          std::string::npos);
+
+    clear_notes();
+    timing.clear();
+    REQUIRE(chart_import_xml(tempPath.string().c_str(), true, true) ==
+            IMPORT_XML_RESULT_STATES::SUCCESS);
+    std::error_code ec;
+    fs::remove(tempPath, ec);
+    CHECK(chart_get_metadata().title == "A&B <C>");
+
+    std::vector<Note> notes;
+    get_notes_array(notes);
+    REQUIRE(notes.size() == 4);
+    std::sort(notes.begin(), notes.end(),
+              [](const Note& a, const Note& b) { return a.time < b.time; });
+    for (int i = 0; i < 4; ++i) {
+        CHECK(notes[i].side == 1);
+        CHECK(notes[i].type == 2);
+        CHECK(notes[i].time == doctest::Approx(i * 100.0));
+        CHECK(notes[i].lastTime == doctest::Approx(1000.0 - i * 200.0));
+    }
+
+    clear_notes();
+    timing.clear();
+}
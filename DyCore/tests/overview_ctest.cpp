@@ -0,0 +1,99 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <format>
+
+#include "note.h"
+#include "notePoolManager.h"
+#include "overview.h"
+
+extern "C" double DyCore_clear_notes();
+
+namespace {
+
+// 10 columns per side, 10 rows of 10 ms per tile.
+OverviewSettings make_test_settings() {
+    return {.width = 30,
+            .rowsPerTile = 10,
+            .msPerRow = 10.0,
+            .duration = 0.0,
+            .saturation = 1.0};
+}
+
+void insert_down_note(int index, double time, double position) {
+    Note note{};
+    note.side = 0;
+    note.type = 0;
+    note.time = time;
+    note.width = 1.0;
+    note.position = position;
+    note.noteID = std::format("ov{:07}", index);
+    REQUIRE(create_note(note, false) == 0);
+}
+
+uint8_t alpha_at(std::span<const uint8_t> image, int width, size_t x,
+                 size_t y) {
+    return image[(y * width + x) * 4 + 3];
+}
+
+}  // namespace
+
+TEST_CASE("OverviewBinsNotesIntoSideBandsAndTiles") {
+    DyCore_clear_notes();
+    insert_down_note(0, 55.0, 2.5);
+    insert_down_note(1, 150.0, 0.5);
+
+    const auto settings = make_test_settings();
+    const auto image = render_overview(settings);
+    const auto stats = get_overview_stats();
+    REQUIRE(stats.tileCount == 2);
+    REQUIRE(image.size() == 30 * 20 * 4);
+
+    // Row 5 of the bottom tile, columns 4 and 5 of the down band.
+    const size_t firstRow = 10 + (9 - 5);
+    CHECK(alpha_at(image, 30, 14, firstRow) == 255);
+    CHECK(alpha_at(image, 30, 15, firstRow) == 255);
+    CHECK(alpha_at(image, 30, 13, firstRow) == 0);
+    CHECK(alpha_at(image, 30, 16, firstRow) == 0);
+    // Row 5 of the top tile, columns 0 and 1 of the down band.
+    CHECK(alpha_at(image, 30, 10, 9 - 5) == 255);
+    CHECK(alpha_at(image, 30, 11, 9 - 5) == 255);
+
+    size_t covered = 0;
+    for (size_t index = 3; index < image.size(); index += 4) {
+        covered += image[index] != 0;
+    }
+    CHECK(covered == 4);
+
+    DyCore_clear_notes();
+}
+
+TEST_CASE("OverviewRerendersOnlyEditedTiles") {
+    DyCore_clear_notes();
+    for (int index = 0; index < 50; ++index) {
+        insert_down_note(index, index * 10.0 + 5.0, 1.0 + index % 3);
+    }
+
+    const auto settings = make_test_settings();
+    (void)render_overview(settings);
+    auto stats = get_overview_stats();
+    REQUIRE(stats.tileCount == 5);
+    CHECK(stats.lastRenderedTiles == 5);
+    const auto version = stats.version;
+
+    // Nothing changed.
+    (void)render_overview(settings);
+    stats = get_overview_stats();
+    CHECK(stats.lastRenderedTiles == 0);
+    CHECK(stats.version == version);
+
+    // Moving a note inside the third tile only touches that tile.
+    get_note_pool_manager().access_note(
+        "ov0000023", [](Note& note) { note.position = 4.0; });
+    (void)render_overview(settings);
+    stats = get_overview_stats();
+    CHECK(stats.lastRenderedTiles == 1);
+    CHECK(stats.version == version + 1);
+
+    DyCore_clear_notes();
+}
@@ -3,9 +3,14 @@
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <random>
 #include <string>
 
+#include "backupStore.h"
+#include "compress.h"
 #include "project.h"
+#include "project/format/dyn.h"
+#include "project/format/dynb.h"
 
 namespace {
 
@@ -32,18 +37,20 @@ std::string read_text(const std::filesystem::path& path) {
             std::istreambuf_iterator<char>()};
 }
 
-std::filesystem::path backup_path(const std::filesystem::path& finalPath,
-                                  int version) {
-    std::filesystem::path backupName = finalPath.stem();
-    backupName += ".bak.";
-    backupName += std::to_string(version);
-    backupName += finalPath.extension();
-    return finalPath.parent_path() / "backups" / backupName;
+// Lines that look like saved notes.
+std::string make_note_lines(std::mt19937& random, size_t count) {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        text += "{\"side\":" + std::to_string(random() % 3) +
+                ",\"time\":" + std::to_string(random() % 600000) +
+                ",\"width\":" + std::to_string(1 + random() % 4) + "}\n";
+    }
+    return text;
 }
 
 }  // namespace
 
-TEST_CASE("ProjectBackupRotate") {
+TEST_CASE("ProjectBackupStoreKeepsEveryVersion") {
     namespace fs = std::filesystem;
 
     const fs::path dir = make_temp_dir();
@@ -53,37 +60,41 @@ TEST_CASE("ProjectBackupRotate") {
         CHECK_FALSE(fs::exists(dir / "backups"));
 
         const fs::path projectPath = dir / "X File.dyn";
-
-        write_text(projectPath, "current0");
-        backup_existing_project_file(projectPath);
-        CHECK(read_text(projectPath) == "current0");
-        CHECK(read_text(backup_path(projectPath, 0)) == "current0");
-        CHECK_FALSE(fs::exists(backup_path(projectPath, 1)));
-
-        write_text(projectPath, "current1");
-        backup_existing_project_file(projectPath);
-        CHECK(read_text(projectPath) == "current1");
-        CHECK(read_text(backup_path(projectPath, 0)) == "current1");
-        CHECK(read_text(backup_path(projectPath, 1)) == "current0");
-
-        write_text(projectPath, "current2");
+        std::mt19937 random(7);
+        std::string text = make_note_lines(random, 8000);
+        std::vector<std::string> saved;
+        for (int version = 0; version < 20; ++version) {
+            // Each save edits a few notes somewhere in the file.
+            for (int edit = 0; edit < 3; ++edit) {
+                const size_t at = text.find('\n', random() % text.size());
+                text.insert(at + 1, make_note_lines(random, 1));
+            }
+            write_text(projectPath, text);
+            backup_existing_project_file(projectPath);
+            saved.push_back(text);
+        }
+        // The same content again adds no version.
         backup_existing_project_file(projectPath);
-        CHECK(read_text(projectPath) == "current2");
-        CHECK(read_text(backup_path(projectPath, 0)) == "current2");
-        CHECK(read_text(backup_path(projectPath, 1)) == "current1");
-        CHECK(read_text(backup_path(projectPath, 2)) == "current0");
+        CHECK(read_text(projectPath) == text);
 
-        write_text(projectPath, "current3");
-        backup_existing_project_file(projectPath);
-        CHECK(read_text(projectPath) == "current3");
-        CHECK(read_text(backup_path(projectPath, 0)) == "current3");
-        CHECK(read_text(backup_path(projectPath, 1)) == "current2");
-        CHECK(read_text(backup_path(projectPath, 2)) == "current1");
-        CHECK_FALSE(fs::exists(backup_path(projectPath, 3)));
+        const ProjectBackupStore store(projectPath);
+        const auto versions = store.versions();
+        REQUIRE(versions.size() == saved.size());
+        const fs::path restored = dir / "restored.dyn";
+        for (size_t i = 0; i < versions.size(); ++i) {
+            CAPTURE(i);
+            CHECK(versions[i].id == i + 1);
+            CHECK(versions[i].size == saved[i].size());
+            store.restore(versions[i].id, restored);
+            CHECK(read_text(restored) == saved[i]);
+        }
+        // Twenty versions take less room than one uncompressed copy.
+        CHECK(store.stored_size() < text.size());
+        CHECK_THROWS(store.restore(versions.back().id + 1, restored));
     } catch (...) {
         std::error_code ec;
         fs::remove_all(dir, ec);
-        FAIL("exception thrown during project backup rotation test");
+        FAIL("exception thrown during project backup store test");
     }
 
     std::error_code ec;
@@ -101,7 +112,10 @@ TEST_CASE("ProjectBackupPreservesSource") {
         backup_existing_project_file(projectPath);
 
         CHECK(read_text(projectPath) == "original project");
-        CHECK(read_text(backup_path(projectPath, 0)) == "original project");
+        const ProjectBackupStore store(projectPath);
+        REQUIRE(store.versions().size() == 1);
+        store.restore(store.versions()[0].id, dir / "restored.dyn");
+        CHECK(read_text(dir / "restored.dyn") == "original project");
     } catch (...) {
         std::error_code ec;
         fs::remove_all(dir, ec);
@@ -111,3 +125,285 @@ TEST_CASE("ProjectBackupPreservesSource") {
     std::error_code ec;
     fs::remove_all(dir, ec);
 }
+
+TEST_CASE("ProjectBackupStoreImportsOldBackupSlots") {
+    namespace fs = std::filesystem;
+
+    const fs::path dir = make_temp_dir();
+    try {
+        const fs::path projectPath = dir / "Old Slots.dyn";
+        fs::create_directories(dir / "backups");
+        // Slot 0 is the newest.
+        write_text(dir / "backups" / "Old Slots.bak.2.dyn", "oldest");
+        write_text(dir / "backups" / "Old Slots.bak.0.dyn", "newest slot");
+        write_text(projectPath, "current");
+        backup_existing_project_file(projectPath);
+        // Only a new store imports them.
+        write_text(dir / "backups" / "Old Slots.bak.1.dyn", "late slot");
+        write_text(projectPath, "edited");
+        backup_existing_project_file(projectPath);
+
+        const ProjectBackupStore store(projectPath);
+        const auto versions = store.versions();
+        REQUIRE(versions.size() == 4);
+        const std::string expected[] = {"oldest", "newest slot", "current",
+                                        "edited"};
+        // Restoring replaces the file, leaving no temporary file behind.
+        const fs::path restored = dir / "restored.dyn";
+        write_text(restored, "to be replaced");
+        for (size_t i = 0; i < versions.size(); ++i) {
+            CAPTURE(i);
+            store.restore(versions[i].id, restored);
+            CHECK(read_text(restored) == expected[i]);
+        }
+        size_t fileCount = 0;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            fileCount += entry.is_regular_file();
+        }
+        CHECK(fileCount == 2);
+    } catch (...) {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        FAIL("exception thrown during old backup import test");
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
+
+TEST_CASE("ProjectBackupStoreRestoresCompressedProjects") {
+    namespace fs = std::filesystem;
+
+    const fs::path dir = make_temp_dir();
+    try {
+        ProjectSnapshot project{.version = "v0.2.0"};
+        auto& chart = project.charts.emplace_back();
+        chart.metadata = {.title = "Backup", .sideType = {"MIXER", "PAD"}};
+        chart.timingPoints = {{0.0, 500.0, 4}};
+        for (int i = 0; i < 5000; ++i) {
+            chart.notes.push_back(
+                {.side = i % 3, .time = i * 25.0, .width = 1.5});
+        }
+        const fs::path projectPath = dir / "Compressed.dyn";
+        {
+            std::ofstream out(projectPath, std::ios::binary);
+            project_export_dyn(project, {.level = 9},
+                               [&](const char* data, size_t size) {
+                                   out.write(data, size);
+                               });
+        }
+        backup_existing_project_file(projectPath);
+
+        const ProjectBackupStore store(projectPath);
+        REQUIRE(store.versions().size() == 1);
+        const fs::path restored = dir / "Restored.dyn";
+        store.restore(store.versions()[0].id, restored);
+
+        // Compressed again, so only the content is the same.
+        const std::string file = read_text(restored);
+        REQUIRE(check_compressed(file.c_str(), file.size()));
+        CHECK(decompress_string(file) ==
+              decompress_string(read_text(projectPath)));
+        Project loaded;
+        REQUIRE(project_import_dyn(restored.string().c_str(), loaded) == 0);
+        REQUIRE(loaded.charts.size() == 1);
+        CHECK(loaded.charts[0].notes.size() == 5000);
+    } catch (...) {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        FAIL("exception thrown during compressed project backup test");
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
+
+TEST_CASE("ProjectBackupStoreSharesChunksOfBinaryProjects") {
+    namespace fs = std::filesystem;
+
+    const fs::path dir = make_temp_dir();
+    try {
+        ProjectSnapshot project{.version = "v0.2.0"};
+        auto& chart = project.charts.emplace_back();
+        chart.metadata = {.title = "Binary", .sideType = {"MIXER", "PAD"}};
+        chart.timingPoints = {{0.0, 500.0, 4}};
+        std::mt19937 random(5);
+        for (int i = 0; i < 20000; ++i) {
+            chart.notes.push_back({.side = static_cast<int>(random() % 3),
+                                   .time = i * 25.0,
+                                   .width = 1.0 + random() % 4,
+                                   .position = (random() % 500) / 100.0});
+        }
+        const fs::path projectPath = dir / "Binary.dynb";
+        std::vector<std::string> saved;
+        for (int version = 0; version < 10; ++version) {
+            // Each save moves a note near the end of the chart.
+            chart.notes[chart.notes.size() - 1 - version].position += 0.5;
+            {
+                std::ofstream out(projectPath,
+                                  std::ios::binary | std::ios::trunc);
+                project_export_dynb(project, {.level = 9},
+                                    [&](const char* data, size_t size) {
+                                        out.write(data, size);
+                                    });
+            }
+            backup_existing_project_file(projectPath);
+            saved.push_back(read_text(projectPath));
+        }
+
+        const ProjectBackupStore store(projectPath);
+        const auto versions = store.versions();
+        REQUIRE(versions.size() == saved.size());
+        // The versions share the chunks of their decompressed sections.
+        CHECK(store.stored_size() < 2 * saved.back().size());
+
+        // Compressed again at the default level, so only the content is
+        // the same.
+        const fs::path restored = dir / "Restored.dynb";
+        for (size_t i = 0; i < versions.size(); ++i) {
+            CAPTURE(i);
+            store.restore(versions[i].id, restored);
+            std::string expected, actual;
+            const auto append_to = [](std::string& text) {
+                return [&text](const char* data, size_t size) {
+                    text.append(data, size);
+                };
+            };
+            project_export_dynb_content(saved[i], {.level = 0},
+                                        append_to(expected));
+            project_export_dynb_content(read_text(restored), {.level = 0},
+                                        append_to(actual));
+            CHECK(actual == expected);
+        }
+    } catch (...) {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        FAIL("exception thrown during binary project backup test");
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
+
+TEST_CASE("ProjectBackupStoreKeepsRecordsAfterDamagedOnes") {
+    namespace fs = std::filesystem;
+
+    const fs::path dir = make_temp_dir();
+    try {
+        const fs::path projectPath = dir / "Damaged.dyn";
+        const fs::path storeDir =
+            dir / "backups" /
+            ("Damaged.dyn" + std::string(PROJECT_BACKUP_STORE_EXTENSION));
+        std::mt19937 random(3);
+        std::vector<std::string> saved;
+        for (int version = 0; version < 3; ++version) {
+            saved.push_back(make_note_lines(random, 200));
+            write_text(projectPath, saved.back());
+            backup_existing_project_file(projectPath);
+        }
+
+        // Damages the first record of the pack and of the versions file.
+        for (const char* name : {"pack", "versions"}) {
+            std::fstream file(storeDir / name,
+                              std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(0);
+            file.put('X');
+        }
+        const auto packSize = fs::file_size(storeDir / "pack");
+
+        ProjectBackupStore store(projectPath);
+        auto versions = store.versions();
+        REQUIRE(versions.size() == 2);
+        CHECK(versions.front().id == 2);
+
+        // Adding a version keeps the records after the damaged ones.
+        write_text(projectPath, "after the damage");
+        CHECK(store.add(projectPath));
+        CHECK(fs::file_size(storeDir / "pack") > packSize);
+
+        // Without the index, the pack is scanned instead.
+        fs::remove(storeDir / "index");
+        const ProjectBackupStore reopened(projectPath);
+        versions = reopened.versions();
+        REQUIRE(versions.size() == 3);
+        const fs::path restored = dir / "restored.dyn";
+        reopened.restore(versions[0].id, restored);
+        CHECK(read_text(restored) == saved[1]);
+        reopened.restore(versions[1].id, restored);
+        CHECK(read_text(restored) == saved[2]);
+        reopened.restore(versions[2].id, restored);
+        CHECK(read_text(restored) == "after the damage");
+    } catch (...) {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        FAIL("exception thrown during damaged backup store test");
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
+
+TEST_CASE("ProjectBackupStoreDropsOldVersionsAndDamagedTails") {
+    namespace fs = std::filesystem;
+
+    const fs::path dir = make_temp_dir();
+    try {
+        const fs::path projectPath = dir / "Many Saves.dynb";
+        std::mt19937 random(11);
+        const size_t saveCount = 2 * PROJECT_BACKUP_VERSION_LIMIT + 1;
+        std::string newest, oldestKept;
+        {
+            ProjectBackupStore store(projectPath);
+            for (size_t i = 0; i < saveCount; ++i) {
+                newest = make_note_lines(random, 40);
+                write_text(projectPath, newest);
+                CHECK(store.add(projectPath));
+                if (i == saveCount - PROJECT_BACKUP_VERSION_LIMIT) {
+                    oldestKept = newest;
+                }
+            }
+            CHECK(store.versions().size() == PROJECT_BACKUP_VERSION_LIMIT);
+        }
+
+        // Unfinished records at the ends of both files are ignored.
+        const fs::path storeDir =
+            dir / "backups" /
+            ("Many Saves.dynb" + std::string(PROJECT_BACKUP_STORE_EXTENSION));
+        for (const char* name : {"pack", "versions"}) {
+            std::ofstream out(storeDir / name,
+                              std::ios::binary | std::ios::app);
+            out << "DYB";
+        }
+
+        ProjectBackupStore store(projectPath);
+        auto versions = store.versions();
+        REQUIRE(versions.size() == PROJECT_BACKUP_VERSION_LIMIT);
+        CHECK(versions.front().id ==
+              saveCount - PROJECT_BACKUP_VERSION_LIMIT + 1);
+        CHECK(versions.back().id == saveCount);
+        // The pack was rewritten without the dropped versions.
+        CHECK(store.stored_size() <
+              PROJECT_BACKUP_VERSION_LIMIT * 2 * newest.size());
+
+        const fs::path restored = dir / "restored.dynb";
+        store.restore(versions.front().id, restored);
+        CHECK(read_text(restored) == oldestKept);
+        store.restore(versions.back().id, restored);
+        CHECK(read_text(restored) == newest);
+
+        write_text(projectPath, "after the damage");
+        CHECK(store.add(projectPath));
+        const ProjectBackupStore reopened(projectPath);
+        versions = reopened.versions();
+        REQUIRE(versions.size() == PROJECT_BACKUP_VERSION_LIMIT);
+        reopened.restore(versions.back().id, restored);
+        CHECK(read_text(restored) == "after the damage");
+    } catch (...) {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        FAIL("exception thrown during project backup pruning test");
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
@@ -0,0 +1,278 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "journal.h"
+#include "note.h"
+#include "project.h"
+#include "projectManager.h"
+#include "timing.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Saves a small chart to path, which opens its journal.
+void save_journal_test_project(const fs::path& path) {
+    install_project_journal();
+    ProjectJournal::inst().close(true);
+
+    clear_notes();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({0.0, 500.0, 4});
+
+    for (int i = 0; i < 40; ++i) {
+        Note note{};
+        note.side = i % 3;
+        note.type = i % 8 == 0 ? 2 : i % 2;
+        note.time = i * 125.0;
+        note.width = 1.0 + (i % 4) * 0.25;
+        note.position = 2.5 - (i % 5) * 0.5;
+        note.lastTime = note.type == 2 ? 250.0 : 0.0;
+        REQUIRE(create_note(note) == 0);
+    }
+
+    std::error_code ec;
+    fs::remove(path, ec);
+    fs::remove(project_journal_path(path), ec);
+    __async_save_project({path.string(), 3});
+    REQUIRE(fs::exists(path));
+    REQUIRE(ProjectJournal::inst().is_open());
+}
+
+// Edits the chart: moves, deletes and adds notes and changes the timing.
+void make_journal_test_edits() {
+    std::vector<Note> notes;
+    get_notes_array(notes, true);
+    REQUIRE(notes.size() > 10);
+
+    Note moved = notes[3];
+    moved.time += 40.0;
+    moved.position = 4.0;
+    REQUIRE(modify_note(moved) == 0);
+    REQUIRE(delete_note(notes[5].noteID) == 0);
+
+    Note hold{};
+    hold.side = 1;
+    hold.type = 2;
+    hold.time = 7000.0;
+    hold.width = 2.0;
+    hold.position = 1.5;
+    hold.lastTime = 500.0;
+    REQUIRE(create_note(hold) == 0);
+
+    get_timing_manager().add_timing_point({3000.0, 60000.0 / 180.0, 3});
+}
+
+std::vector<Note> sorted_notes() {
+    std::vector<Note> notes;
+    get_notes_array(notes, false);
+    std::sort(notes.begin(), notes.end(), [](const Note& a, const Note& b) {
+        return a.time != b.time ? a.time < b.time : a.type < b.type;
+    });
+    return notes;
+}
+
+void check_same_notes(const std::vector<Note>& expected) {
+    const auto notes = sorted_notes();
+    REQUIRE(notes.size() == expected.size());
+    for (size_t i = 0; i < notes.size(); ++i) {
+        CHECK(notes[i].side == expected[i].side);
+        CHECK(notes[i].type == expected[i].type);
+        CHECK(notes[i].time == doctest::Approx(expected[i].time));
+        CHECK(notes[i].width == doctest::Approx(expected[i].width));
+        CHECK(notes[i].position == doctest::Approx(expected[i].position));
+        CHECK(notes[i].lastTime == doctest::Approx(expected[i].lastTime));
+    }
+}
+
+}  // namespace
+
+TEST_CASE("ProjectJournalReplaysUnsavedEdits") {
+    const auto path = fs::temp_directory_path() / "dynode_journal_test.dyn";
+    save_journal_test_project(path);
+    make_journal_test_edits();
+    const auto expected = sorted_notes();
+
+    // Closing without discarding leaves the journal as a crash would.
+    ProjectJournal::inst().close(false);
+    REQUIRE(fs::exists(project_journal_path(path)));
+
+    load_project(path.string().c_str());
+    check_same_notes(expected);
+    std::vector<TimingPoint> points;
+    get_timing_manager().get_timing_points(points);
+    REQUIRE(points.size() == 2);
+    CHECK(points[1].meter == 3);
+
+    // Saving drops the records the file now holds.
+    __async_save_project({path.string(), 3});
+    ProjectJournal::inst().close(false);
+    load_project(path.string().c_str());
+    check_same_notes(expected);
+
+    ProjectJournal::inst().close(true);
+    CHECK_FALSE(fs::exists(project_journal_path(path)));
+
+    std::error_code ec;
+    fs::remove(path, ec);
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectJournalIgnoresDamagedRecords") {
+    const auto path = fs::temp_directory_path() / "dynode_journal_tail.dyn";
+    save_journal_test_project(path);
+    make_journal_test_edits();
+    const auto expected = sorted_notes();
+    ProjectJournal::inst().close(false);
+
+    // A torn write at the end loses only the torn record.
+    const auto journalPath = project_journal_path(path);
+    {
+        std::ofstream out(journalPath, std::ios::binary | std::ios::app);
+        out.write("\x01\x00\x00\x00\xff\x00\x00\x00garbage", 15);
+    }
+    load_project(path.string().c_str());
+    check_same_notes(expected);
+    ProjectJournal::inst().close(false);
+
+    // A journal written against another version of the file is not
+    // replayed, or the edits it holds would be applied twice.
+    const auto stalePath = fs::temp_directory_path() / "dynode_journal.stale";
+    fs::copy_file(journalPath, stalePath,
+                  fs::copy_options::overwrite_existing);
+    __async_save_project({path.string(), 3});
+    ProjectJournal::inst().close(false);
+    fs::copy_file(stalePath, journalPath,
+                  fs::copy_options::overwrite_existing);
+    load_project(path.string().c_str());
+    check_same_notes(expected);
+
+    ProjectJournal::inst().close(true);
+    std::error_code ec;
+    fs::remove(path, ec);
+    fs::remove(stalePath, ec);
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectJournalLogsBulkLoadsAsOneRecord") {
+    const auto path = fs::temp_directory_path() / "dynode_journal_bulk.dyn";
+    save_journal_test_project(path);
+    const auto journalPath = project_journal_path(path);
+    const auto emptySize = fs::file_size(journalPath);
+
+    std::vector<Note> imported(2000);
+    for (size_t i = 0; i < imported.size(); ++i) {
+        auto& note = imported[i];
+        note.side = static_cast<int>(i % 3);
+        note.type = i % 10 == 0 ? 2 : 0;
+        note.time = 10000.0 + i * 50.0;
+        note.width = 1.0;
+        note.position = 0.5 + (i % 5);
+        note.lastTime = note.type == 2 ? 100.0 : 0.0;
+    }
+    // Every tenth note is a hold and gets a sub note.
+    REQUIRE(create_notes(imported) == imported.size() + imported.size() / 10);
+    ProjectJournal::inst().sync();
+    // About 90 bytes a note plus a record header each before.
+    CHECK(fs::file_size(journalPath) - emptySize < imported.size() * 40);
+
+    // Editing a loaded hold names the sub note the load created.
+    std::vector<Note> notes;
+    get_notes_array(notes, true);
+    const auto hold = std::find_if(notes.begin(), notes.end(), [](const Note& n) {
+        return n.time >= 10000.0 && n.get_note_type() == NOTE_TYPE::HOLD;
+    });
+    REQUIRE(hold != notes.end());
+    Note longer = *hold;
+    longer.lastTime = 300.0;
+    REQUIRE(modify_note(longer) == 0);
+    const auto expected = sorted_notes();
+    ProjectJournal::inst().close(false);
+
+    load_project(path.string().c_str());
+    check_same_notes(expected);
+
+    ProjectJournal::inst().close(true);
+    std::error_code ec;
+    fs::remove(path, ec);
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectJournalReplaysEditsOnTheirChart") {
+    const auto path = fs::temp_directory_path() / "dynode_journal_charts.dyn";
+    save_journal_test_project(path);
+    auto& manager = ProjectManager::inst();
+    Chart second;
+    second.metadata.title = "second";
+    second.timingPoints.push_back({0.0, 400.0, 4});
+    std::vector<Chart> charts;
+    charts.push_back(second);
+    REQUIRE(manager.append_charts(std::move(charts)) == 1);
+    __async_save_project({path.string(), 3});
+
+    make_journal_test_edits();
+    const auto firstExpected = sorted_notes();
+
+    manager.update_current_chart();
+    manager.set_current_chart(1);
+    Note note{};
+    note.time = 800.0;
+    note.width = 1.0;
+    note.position = 2.0;
+    REQUIRE(create_note(note) == 0);
+    const auto secondExpected = sorted_notes();
+
+    // Charts added after the save are not in the file, so the journal
+    // brings them back along with their edits.
+    Chart third;
+    third.metadata.title = "third";
+    third.timingPoints.push_back({0.0, 300.0, 3});
+    third.notes.push_back(note);
+    charts.clear();
+    charts.push_back(third);
+    REQUIRE(manager.append_charts(std::move(charts)) == 2);
+    manager.update_current_chart();
+    manager.set_current_chart(2);
+    note.time = 1600.0;
+    REQUIRE(create_note(note) == 0);
+    const auto thirdExpected = sorted_notes();
+    REQUIRE(thirdExpected.size() == 2);
+    ProjectJournal::inst().close(false);
+
+    load_project(path.string().c_str());
+    REQUIRE(manager.get_chart_count() == 3);
+    CHECK(manager.get_current_chart_index() == 0);
+    check_same_notes(firstExpected);
+    manager.update_current_chart();
+    manager.set_current_chart(1);
+    check_same_notes(secondExpected);
+    manager.update_current_chart();
+    manager.set_current_chart(2);
+    CHECK(chart_get_metadata().title == "third");
+    check_same_notes(thirdExpected);
+    std::vector<TimingPoint> points;
+    get_timing_manager().get_timing_points(points);
+    REQUIRE(points.size() == 1);
+    CHECK(points[0].meter == 3);
+
+    // A project that already has the chart does not get it twice.
+    ProjectJournal::inst().close(false);
+    load_project(path.string().c_str());
+    CHECK(manager.get_chart_count() == 3);
+
+    ProjectJournal::inst().close(true);
+    std::error_code ec;
+    fs::remove(path, ec);
+    manager.setup_default_chart();
+    clear_notes();
+    get_timing_manager().clear();
+}
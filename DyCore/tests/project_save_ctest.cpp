@@ -0,0 +1,475 @@
+#include <doctest/doctest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compress.h"
+#include "gm.h"
+#include "journal.h"
+#include "note.h"
+#include "project.h"
+#include "project/format/dyn.h"
+#include "project/format/dynb.h"
+#include "projectManager.h"
+#include "saveQueue.h"
+#include "timing.h"
+
+extern "C" double DyCore_has_async_event();
+extern "C" const char* DyCore_get_async_event();
+
+namespace {
+
+std::vector<nlohmann::json> take_async_events() {
+    std::vector<nlohmann::json> events;
+    while (DyCore_has_async_event() > 0) {
+        events.push_back(nlohmann::json::parse(DyCore_get_async_event()));
+    }
+    return events;
+}
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    REQUIRE(in.is_open());
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+void setup_save_test_chart() {
+    chart_set_metadata({.title = "Quote \" and \\ and\nnewline \x01",
+                        .artist = "\xe8\x89\xba\xe6\x9c\xaf\xe5\xae\xb6",
+                        .charter = "charter",
+                        .sideType = {"MIXER", "PAD"},
+                        .difficulty = 4});
+
+    clear_notes();
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({0.0, 500.0, 4});
+    timing.add_timing_point({1000.0, 60000.0 / 175.5, 3});
+
+    for (int i = 0; i < 300; ++i) {
+        Note note{};
+        note.side = i % 3;
+        note.type = i % 7 == 0 ? 2 : i % 2;
+        note.time = i * 37.25;
+        note.width = 1.0 + (i % 4) * 0.1;
+        note.position = 2.5 - (i % 5) * 0.3;
+        note.lastTime = note.type == 2 ? 120.0 : 0.0;
+        REQUIRE(create_note(note) == 0);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("ProjectSaveStreamsTheSameProjectAsTheJsonDump") {
+    namespace fs = std::filesystem;
+
+    setup_save_test_chart();
+    const auto path =
+        fs::temp_directory_path() / "dynode_project_save_test.dyn";
+    std::error_code ec;
+    fs::remove(path, ec);
+
+    __async_save_project({path.string(), 5});
+    REQUIRE(fs::exists(path));
+
+    const std::string file = read_file(path);
+    REQUIRE(check_compressed(file.c_str(), file.size()));
+    const auto saved = nlohmann::json::parse(decompress_string(file));
+
+    ProjectManager::inst().update_current_chart();
+    CHECK(saved == nlohmann::json::parse(ProjectManager::inst().dump()));
+
+    Project project;
+    REQUIRE(project_import_dyn(path.string().c_str(), project) == 0);
+    REQUIRE(project.charts.size() == 1);
+    const auto& chart = project.charts[0];
+    CHECK(chart.metadata.title == chart_get_metadata().title);
+    CHECK(chart.metadata.artist == chart_get_metadata().artist);
+    REQUIRE(chart.timingPoints.size() == 2);
+    CHECK(chart.timingPoints[1].beatLength ==
+          doctest::Approx(60000.0 / 175.5));
+
+    std::vector<Note> notes;
+    get_notes_array(notes);
+    REQUIRE(chart.notes.size() == notes.size());
+    for (size_t i = 0; i < notes.size(); ++i) {
+        CHECK(chart.notes[i].time == notes[i].time);
+        CHECK(chart.notes[i].position == notes[i].position);
+        CHECK(chart.notes[i].width == notes[i].width);
+        CHECK(chart.notes[i].lastTime == notes[i].lastTime);
+    }
+
+    fs::remove(path, ec);
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectExportDynWritesNumbersAsTheJsonDumpDoes") {
+    setup_save_test_chart();
+    // Large integral times, where the shortest form is exponent notation,
+    // and values around the dump's notation switches.
+    const double times[] = {600000.0, 1200000.0, 3e6,     1e15,   1e16,
+                            123456789012345.0,   0.0001,  1e-5,   0.5,
+                            1234.5678,           1e21,    2.5e-7, 0.0};
+    int index = 0;
+    for (const double time : times) {
+        Note note{};
+        note.noteID = "numbers" + std::to_string(index++);
+        note.time = time;
+        note.width = 1.0;
+        note.position = time / 3;
+        REQUIRE(create_note(note) == 0);
+    }
+    ProjectManager::inst().update_current_chart();
+
+    std::string plain;
+    project_export_dyn(ProjectManager::inst().snapshot(), {.level = 0},
+                       [&](const char* data, size_t size) {
+                           plain.append(data, size);
+                       });
+    CHECK(plain == ProjectManager::inst().dump());
+
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectExportDynWritesChecksummedChunks") {
+    setup_save_test_chart();
+    const auto snapshot = ProjectManager::inst().snapshot();
+
+    std::string plain;
+    const auto plainResult =
+        project_export_dyn(snapshot, {.level = 0},
+                           [&](const char* data, size_t size) {
+                               plain.append(data, size);
+                           });
+    CHECK(plainResult.contentSize == plain.size());
+    CHECK(plainResult.fileSize == plain.size());
+    CHECK(plainResult.checksum == XXH3_64bits(plain.data(), plain.size()));
+    CHECK_FALSE(check_compressed(plain.c_str(), plain.size()));
+
+    std::string compressed;
+    const auto result =
+        project_export_dyn(snapshot, {.level = 3},
+                           [&](const char* data, size_t size) {
+                               compressed.append(data, size);
+                           });
+    CHECK(result.contentSize == plain.size());
+    CHECK(result.fileSize == compressed.size());
+    CHECK(result.checksum ==
+          XXH3_64bits(compressed.data(), compressed.size()));
+    CHECK(decompress_string(compressed) == plain);
+
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectSaveVerifiesEmbeddedChecksums") {
+    setup_save_test_chart();
+    const auto snapshot = ProjectManager::inst().snapshot();
+
+    std::string file;
+    const auto result =
+        project_export_dyn(snapshot, {.level = 3},
+                           [&](const char* data, size_t size) {
+                               file.append(data, size);
+                           });
+    const std::string plain = decompress_string(file);
+    CHECK(result.contentChecksum == XXH3_64bits(plain.data(), plain.size()));
+    CHECK_NOTHROW(verify_dyn_file(file, result));
+
+    // Damage inside the zstd frame and in the trailing checksum frame.
+    std::string corrupted = file;
+    corrupted[corrupted.size() / 2] ^= 0x10;
+    CHECK_THROWS(verify_dyn_file(corrupted, result));
+    corrupted = file;
+    corrupted[corrupted.size() - 1] ^= 0x10;
+    CHECK_THROWS(verify_dyn_file(corrupted, result));
+    CHECK_THROWS(verify_dyn_file(
+        std::string_view(file).substr(0, file.size() - 40), result));
+
+    // A safe save also decodes the file before it replaces the old one.
+    namespace fs = std::filesystem;
+    const auto path = fs::temp_directory_path() / "dynode_project_safe.dyn";
+    std::error_code ec;
+    fs::remove(path, ec);
+    __async_save_project(
+        {.filePath = path.string(), .compressionLevel = 3, .safeSave = true});
+    CHECK(fs::exists(path));
+
+    // DYNB rounds notes to its ticks, which the comparison allows.
+    Note offTick{};
+    offTick.time = 123.45678;
+    offTick.width = 1.23456;
+    offTick.position = 0.00049;
+    REQUIRE(create_note(offTick) == 0);
+    const auto binaryPath =
+        fs::temp_directory_path() / "dynode_project_safe.dynb";
+    fs::remove(binaryPath, ec);
+    (void)take_async_events();
+    __async_save_project({.filePath = binaryPath.string(),
+                          .compressionLevel = 3,
+                          .safeSave = true});
+    CHECK(fs::exists(binaryPath));
+    for (const auto& event : take_async_events()) {
+        if (event.at("type") == PROJECT_SAVING) {
+            CHECK(event.at("status") == 0);
+        }
+    }
+
+    // The extension is matched in any case.
+    const auto upperPath =
+        fs::temp_directory_path() / "dynode_project_upper.DYNB";
+    __async_save_project({.filePath = upperPath.string(),
+                          .compressionLevel = 3,
+                          .safeSave = true});
+    CHECK(is_dynb_file(upperPath.string().c_str()));
+
+    fs::remove(path, ec);
+    fs::remove(binaryPath, ec);
+    fs::remove(upperPath, ec);
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectLoadDecodesOtherChartsWhenSelected") {
+    namespace fs = std::filesystem;
+
+    Project project{.version = "v0.2.0"};
+    for (int c = 0; c < 3; ++c) {
+        Chart chart{.metadata = {.title = "Chart " + std::to_string(c),
+                                 .sideType = {"MIXER", "MIXER"},
+                                 .difficulty = c}};
+        chart.timingPoints = {{0.0, 500.0, 4}};
+        for (int i = 0; i < 100 * (c + 1); ++i) {
+            Note note{};
+            note.side = i % 3;
+            note.time = i * 50.0;
+            note.width = 1.0;
+            note.position = 2.5;
+            chart.notes.push_back(note);
+        }
+        project.charts.push_back(chart);
+    }
+
+    const auto path = fs::temp_directory_path() / "dynode_project_lazy.dyn";
+    for (const bool binary : {false, true}) {
+        CAPTURE(binary);
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            const auto snapshot = make_project_snapshot(project);
+            const auto writer = [&](const char* data, size_t size) {
+                out.write(data, static_cast<std::streamsize>(size));
+            };
+            if (binary) {
+                project_export_dynb(snapshot, {.level = 3}, writer);
+            } else {
+                project_export_dyn(snapshot, {.level = 3}, writer);
+            }
+        }
+
+        auto& manager = ProjectManager::inst();
+        manager.load_project_from_file(path.string().c_str());
+        std::vector<Note> notes;
+        get_notes_array(notes, false);
+        CHECK(notes.size() == 100);
+
+        LazyChartScratch scratch;
+        const auto note_count = [&](const ChartSnapshot& chart) {
+            return resolve_chart_snapshot(chart, scratch).notes->size();
+        };
+
+        // A snapshot holds the charts that were never selected, and saving
+        // it does not leave them decoded.
+        auto snapshot = manager.snapshot();
+        REQUIRE(snapshot.charts.size() == 3);
+        REQUIRE(snapshot.charts[2].lazyContent);
+        CHECK(note_count(snapshot.charts[2]) == 300);
+        std::string saved;
+        project_export_dyn(snapshot, {.level = 0},
+                           [&](const char* data, size_t size) {
+                               saved.append(data, size);
+                           });
+        CHECK(saved.find("\"title\":\"Chart 2\"") != std::string::npos);
+        CHECK_FALSE(snapshot.charts[1].lazyContent->is_decoded());
+        CHECK_FALSE(snapshot.charts[2].lazyContent->is_decoded());
+
+        manager.update_current_chart();
+        manager.set_current_chart(2);
+        get_notes_array(notes, false);
+        CHECK(notes.size() == 300);
+        CHECK(chart_get_metadata().title == "Chart 2");
+
+        snapshot = manager.snapshot();
+        CHECK(note_count(snapshot.charts[0]) == 100);
+        CHECK(note_count(snapshot.charts[1]) == 200);
+        CHECK(note_count(snapshot.charts[2]) == 300);
+    }
+
+    std::error_code ec;
+    fs::remove(path, ec);
+    // Later tests expect the single default chart.
+    ProjectManager::inst().setup_default_chart();
+    clear_notes();
+    get_timing_manager().clear();
+}
+
+TEST_CASE("ProjectSaveQueueRunsOnlyTheLatestSaveOfAFile") {
+    struct Run {
+        std::string filePath;
+        int compressionLevel;
+        bool cancelled;
+    };
+    std::vector<Run> runs;
+    std::promise<void> started, release;
+    auto releaseFuture = release.get_future().share();
+    ProjectSaveQueue queue([&](SaveProjectParams params) {
+        if (runs.empty()) {
+            started.set_value();
+            releaseFuture.wait();
+        }
+        runs.push_back({params.filePath, params.compressionLevel,
+                        params.cancelled && *params.cancelled});
+    });
+    (void)take_async_events();
+
+    // The first save runs and holds the worker while the others queue.
+    queue.push({"a.dyn", 0});
+    started.get_future().wait();
+    for (int i = 1; i < 50; ++i) {
+        queue.push({"a.dyn", i});
+        if (i == 25) {
+            queue.push({"b.dyn", i});
+        }
+    }
+    release.set_value();
+    queue.wait_idle();
+
+    REQUIRE(runs.size() == 3);
+    CHECK(runs[0].filePath == "a.dyn");
+    CHECK(runs[0].cancelled);
+    CHECK(runs[1].filePath == "b.dyn");
+    CHECK_FALSE(runs[1].cancelled);
+    CHECK(runs[2].filePath == "a.dyn");
+    CHECK(runs[2].compressionLevel == 49);
+    CHECK_FALSE(runs[2].cancelled);
+
+    // Every dropped save is reported once.
+    const auto events = take_async_events();
+    CHECK(events.size() == 48);
+    for (const auto& event : events) {
+        CHECK(event.at("type") == PROJECT_SAVING);
+        CHECK(event.at("status") == PROJECT_SAVE_STATUS_SUPERSEDED);
+    }
+}
+
+TEST_CASE("ProjectSaveQueueReportsCancelledSaves") {
+    std::vector<int> statuses;
+    std::promise<void> started, release;
+    auto releaseFuture = release.get_future().share();
+    ProjectSaveQueue queue([&](SaveProjectParams params) {
+        started.set_value();
+        releaseFuture.wait();
+        statuses.push_back(params.cancelled->load());
+    });
+    (void)take_async_events();
+
+    queue.push({"a.dyn", 0});
+    started.get_future().wait();
+    queue.push({"a.dyn", 1});
+    queue.push({"b.dyn", 2});
+    // Nothing replaces the saves cancelled here, so none is superseded.
+    queue.cancel_all();
+    release.set_value();
+    queue.wait_idle();
+
+    REQUIRE(statuses.size() == 1);
+    CHECK(statuses[0] == PROJECT_SAVE_STATUS_CANCELLED);
+    const auto events = take_async_events();
+    CHECK(events.size() == 2);
+    for (const auto& event : events) {
+        CHECK(event.at("type") == PROJECT_SAVING);
+        CHECK(event.at("status") == PROJECT_SAVE_STATUS_CANCELLED);
+    }
+}
+
+TEST_CASE("RapidProjectSavesWriteTheLatestProject") {
+    namespace fs = std::filesystem;
+
+    setup_save_test_chart();
+    const auto path = fs::temp_directory_path() / "dynode_project_rapid.dyn";
+    std::error_code ec;
+    fs::remove(path, ec);
+    (void)take_async_events();
+
+    // The first save waits until all are queued, as a slow save would.
+    std::promise<void> release;
+    auto releaseFuture = release.get_future().share();
+    ProjectSaveQueue queue([&](SaveProjectParams params) {
+        releaseFuture.wait();
+        __async_save_project(std::move(params));
+    });
+    constexpr int SAVE_COUNT = 20;
+    for (int i = 0; i < SAVE_COUNT; ++i) {
+        auto metadata = chart_get_metadata();
+        metadata.title = "Save " + std::to_string(i);
+        chart_set_metadata(metadata);
+        queue.push({.filePath = path.string(),
+                    .compressionLevel = 3,
+                    .snapshot = ProjectManager::inst().snapshot(),
+                    .journalMark = ProjectJournal::inst().mark()});
+    }
+    release.set_value();
+    queue.wait_idle();
+
+    int saved = 0, superseded = 0, replaced = 0;
+    for (const auto& event : take_async_events()) {
+        if (event.at("type") == PROJECT_SAVE_PROGRESS) {
+            const auto progress = nlohmann::json::parse(
+                event.at("content").get_ref<const std::string&>());
+            if (progress.at("phase") == "replacing") {
+                ++replaced;
+                CHECK(progress.at("written") == fs::file_size(path));
+            }
+            continue;
+        }
+        REQUIRE(event.at("type") == PROJECT_SAVING);
+        const int status = event.at("status");
+        CHECK(status >= 0);
+        (status == PROJECT_SAVE_STATUS_SUPERSEDED ? superseded : saved)++;
+    }
+    // Only the last save writes the file.
+    CHECK(saved == 1);
+    CHECK(superseded == SAVE_COUNT - 1);
+    CHECK(replaced == 1);
+
+    Project project;
+    REQUIRE(project_import_dyn(path.string().c_str(), project) == 0);
+    REQUIRE(project.charts.size() == 1);
+    CHECK(project.charts[0].metadata.title ==
+          "Save " + std::to_string(SAVE_COUNT - 1));
+
+    // A cancelled save leaves the file alone.
+    const std::string before = read_file(path);
+    chart_set_metadata({.title = "Cancelled"});
+    __async_save_project(
+        {.filePath = path.string(),
+         .compressionLevel = 3,
+         .cancelled = std::make_shared<std::atomic<int>>(
+             PROJECT_SAVE_STATUS_CANCELLED)});
+    CHECK(read_file(path) == before);
+    const auto events = take_async_events();
+    REQUIRE(events.size() == 1);
+    CHECK(events[0].at("status") == PROJECT_SAVE_STATUS_CANCELLED);
+
+    ProjectJournal::inst().close(true);
+    fs::remove(path, ec);
+    clear_notes();
+    get_timing_manager().clear();
+}
@@ -27,7 +27,8 @@ TEST_CASE("RenderBenchmarkOptionsParseArguments") {
     const auto options =
         parse({"render_benchmark", "--notes", "42", "--iterations", "7",
                "--warmup", "3", "--scenario", "normal", "--chart", "chart.dyn",
-               "--speed", "1.75", "--workers", "4"});
+               "--speed", "1.75", "--workers", "4", "--schedule", "both",
+               "--lod", "always", "--offline-frames", "120"});
 
     CHECK(options.noteCount == 42);
     CHECK(options.iterations == 7);
@@ -36,6 +37,9 @@ TEST_CASE("RenderBenchmarkOptionsParseArguments") {
     CHECK(options.chartPath == "chart.dyn");
     CHECK(options.noteSpeed == doctest::Approx(1.75));
     CHECK(options.workerCount == 4);
+    CHECK(options.schedule == "both");
+    CHECK(options.lod == "always");
+    CHECK(options.offlineFrames == 120);
 }
 
 TEST_CASE("RenderBenchmarkOptionsValidateArguments") {
@@ -52,6 +56,19 @@ TEST_CASE("RenderBenchmarkOptionsValidateArguments") {
                          "scenario must be normal, holds, mixed, or clustered",
                          std::invalid_argument);
 
+    const auto invalidSchedule = [] {
+        (void)parse({"render_benchmark", "--schedule", "fastest"});
+    };
+    CHECK_THROWS_WITH_AS(invalidSchedule(),
+                         "schedule must be static, auto, or both",
+                         std::invalid_argument);
+
+    const auto invalidLod = [] {
+        (void)parse({"render_benchmark", "--lod", "high"});
+    };
+    CHECK_THROWS_WITH_AS(invalidLod(), "lod must be off, auto, or always",
+                         std::invalid_argument);
+
     const auto chartScenario = parse(
         {"render_benchmark", "--chart", "chart.dyn", "--scenario", "custom"});
     CHECK(chartScenario.scenario == "custom");
@@ -0,0 +1,473 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "activation.h"
+#include "note.h"
+#include "notePoolManager.h"
+#include "offline.h"
+#include "render.h"
+
+extern "C" double DyCore_clear_notes();
+
+namespace {
+
+SpriteData make_test_sprite(std::string name, glm::vec2 size,
+                            SPRITE_DRAW_TYPE type,
+                            std::initializer_list<int> data = {}) {
+    SpriteData sprite{
+        .name = std::move(name),
+        .size = size,
+        .uv0 = {0.0f, 0.0f},
+        .uv1 = {1.0f, 1.0f},
+        .paddingLR = 30,
+        .paddingTop = 13,
+        .paddingBottom = 26,
+        .drawSetting = {.type = type, .data = {}},
+    };
+    std::copy(data.begin(), data.end(), sprite.drawSetting.data);
+    sprite.caculate_uv_values();
+    return sprite;
+}
+
+void add_test_sprites() {
+    auto& sprites = get_sprite_manager();
+    sprites.add_sprite(make_test_sprite("sprNote", {45.0f, 28.0f},
+                                        SPRITE_DRAW_TYPE::SEG_3, {22, 22}));
+    sprites.add_sprite(make_test_sprite("sprChain", {120.0f, 77.0f},
+                                        SPRITE_DRAW_TYPE::SEG_5, {21, 78, 19}));
+    sprites.add_sprite(make_test_sprite("sprHoldEdge", {67.0f, 106.0f},
+                                        SPRITE_DRAW_TYPE::SLICE_9,
+                                        {32, 33, 53, 52}));
+    sprites.add_sprite(make_test_sprite("sprHold", {512.0f, 256.0f},
+                                        SPRITE_DRAW_TYPE::REPEAT_VERT));
+    sprites.add_sprite(make_test_sprite("sprHoldGrey", {512.0f, 256.0f},
+                                        SPRITE_DRAW_TYPE::NORMAL));
+}
+
+void insert_test_notes() {
+    for (int index = 0; index < 60; ++index) {
+        Note note{};
+        note.side = index % 3;
+        note.type = index % 4 == 0 ? 2 : index % 4 == 1 ? 1 : 0;
+        note.time = 100.0 + index * 20.0;
+        note.width = 1.0 + (index % 3) * 0.5;
+        note.position = 0.5 + (index % 5);
+        note.lastTime = note.type == 2 ? 300.0 : 0.0;
+        note.noteID = std::format("rp{:07}", index);
+        REQUIRE(create_note(note, false) == 0);
+    }
+}
+
+std::vector<char> render_sync(double nowTime, double noteSpeed, int state) {
+    auto& activation = get_note_activation_manager();
+    activation.set_range(nowTime, noteSpeed);
+    activation.recalculate();
+    std::vector<char> buffer(get_vertex_buffer_bound());
+    buffer.resize(
+        render_active_notes(buffer.data(), nowTime, noteSpeed, state));
+    return buffer;
+}
+
+std::vector<char> render_collected(double nowTime, double noteSpeed,
+                                   int state, double tolerance = 0.5) {
+    auto& activation = get_note_activation_manager();
+    activation.set_range(nowTime, noteSpeed);
+    activation.recalculate();
+    std::vector<char> buffer(get_vertex_buffer_bound());
+    buffer.resize(collect_async_render(buffer.data(), buffer.size(), nowTime,
+                                       noteSpeed, tolerance, state));
+    return buffer;
+}
+
+float read_vertex_float(const std::vector<char>& buffer, size_t offset) {
+    float value;
+    std::memcpy(&value, buffer.data() + offset, sizeof(float));
+    return value;
+}
+
+}  // namespace
+
+TEST_CASE("AsyncRenderMatchesSynchronousRender") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    insert_test_notes();
+
+    const double noteSpeed = 1.5;
+    request_async_render(400.0, noteSpeed);
+    request_async_render(416.0, noteSpeed);
+    for (const double nowTime : {400.0, 416.0}) {
+        for (const int state : {1, 0, 2}) {
+            const auto expected = render_sync(nowTime, noteSpeed, state);
+            CHECK(render_collected(nowTime, noteSpeed, state) == expected);
+        }
+    }
+
+    reset_async_render();
+    DyCore_clear_notes();
+}
+
+TEST_CASE("AsyncRenderFallsBackOnSeekAndEdit") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    insert_test_notes();
+
+    const double noteSpeed = 1.5;
+    request_async_render(400.0, noteSpeed);
+    // A seek far from the predicted time must not reuse the stale frame.
+    CHECK(render_collected(900.0, noteSpeed, 2) ==
+          render_sync(900.0, noteSpeed, 2));
+
+    request_async_render(400.0, noteSpeed);
+    get_note_pool_manager().access_note(
+        "rp0000030", [](Note& note) { note.position += 1.0; });
+    CHECK(render_collected(400.0, noteSpeed, 2) ==
+          render_sync(400.0, noteSpeed, 2));
+
+    reset_async_render();
+    DyCore_clear_notes();
+}
+
+TEST_CASE("AsyncRenderScrollsFramesWithinTolerance") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    for (int index = 0; index < 20; ++index) {
+        Note note{};
+        note.type = index % 2;
+        note.time = 500.0 + index * 10.0;
+        note.width = 1.0;
+        note.position = 0.5 + (index % 5);
+        note.noteID = std::format("rs{:07}", index);
+        REQUIRE(create_note(note, false) == 0);
+    }
+
+    const double noteSpeed = 1.5;
+    reset_async_render_stats();
+    request_async_render(400.0, noteSpeed);
+    const auto shifted = render_collected(404.0, noteSpeed, 2, 20.0);
+    const auto expected = render_sync(404.0, noteSpeed, 2);
+    REQUIRE(shifted.size() == expected.size());
+    REQUIRE_FALSE(expected.empty());
+    // Only the y coordinate of each vertex moves; uvs and colors are kept.
+    for (size_t offset = 0; offset < expected.size(); offset += 20) {
+        CHECK(read_vertex_float(shifted, offset) ==
+              doctest::Approx(read_vertex_float(expected, offset)));
+        CHECK(read_vertex_float(shifted, offset + 4) ==
+              doctest::Approx(read_vertex_float(expected, offset + 4))
+                  .epsilon(1e-4));
+        CHECK(std::memcmp(shifted.data() + offset + 8,
+                          expected.data() + offset + 8, 12) == 0);
+    }
+
+    CHECK(render_collected(900.0, noteSpeed, 2, 20.0) ==
+          render_sync(900.0, noteSpeed, 2));
+    const auto stats = get_async_render_stats();
+    CHECK(stats.shiftedCollects == 1);
+    CHECK(stats.missedCollects == 1);
+    CHECK(stats.lastShift == doctest::Approx(4.0));
+
+    reset_async_render();
+    DyCore_clear_notes();
+}
+
+TEST_CASE("AsyncRenderScrollsSideNotesWithTheirFade") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    for (int index = 0; index < 20; ++index) {
+        Note note{};
+        note.side = 1 + index % 2;
+        note.type = index % 2;
+        note.time = 500.0 + index * 40.0;
+        note.width = 1.0;
+        note.position = 0.5 + (index % 5);
+        note.noteID = std::format("rf{:07}", index);
+        REQUIRE(create_note(note, false) == 0);
+    }
+
+    const double noteSpeed = 1.5;
+    reset_async_render_stats();
+    request_async_render(400.0, noteSpeed);
+    const auto shifted = render_collected(412.0, noteSpeed, 2, 20.0);
+    const auto expected = render_sync(412.0, noteSpeed, 2);
+    REQUIRE(shifted.size() == expected.size());
+    REQUIRE_FALSE(expected.empty());
+    for (size_t offset = 0; offset < expected.size(); offset += 20) {
+        CHECK(read_vertex_float(shifted, offset) ==
+              doctest::Approx(read_vertex_float(expected, offset))
+                  .epsilon(1e-4));
+        // Rounding may differ by one step of alpha.
+        const auto alpha = [&](const std::vector<char>& vertices) {
+            return static_cast<int>(
+                static_cast<uint8_t>(vertices[offset + 19]));
+        };
+        CHECK(std::abs(alpha(shifted) - alpha(expected)) <= 1);
+    }
+    CHECK(get_async_render_stats().shiftedCollects == 1);
+
+    reset_async_render();
+    DyCore_clear_notes();
+}
+
+TEST_CASE("AsyncRenderRendersHoldsAtTheJudgeLineAgain") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    // One hold already pinned to the judge line and one whose head reaches
+    // it between the predicted and the actual time.
+    for (const auto& [index, time] : {std::pair{0, 300.0}, {1, 402.0}}) {
+        Note note{};
+        note.side = index;
+        note.type = 2;
+        note.time = time;
+        note.width = 1.0;
+        note.position = 2.5;
+        note.lastTime = 400.0;
+        note.noteID = std::format("rh{:07}", index);
+        REQUIRE(create_note(note, false) == 0);
+    }
+
+    const double noteSpeed = 1.5;
+    for (const int state : {0, 1, 2}) {
+        CAPTURE(state);
+        reset_async_render_stats();
+        request_async_render(400.0, noteSpeed);
+        CHECK(render_collected(404.0, noteSpeed, state, 20.0) ==
+              render_sync(404.0, noteSpeed, state));
+        const auto stats = get_async_render_stats();
+        CHECK(stats.shiftedCollects == 0);
+        CHECK(stats.missedCollects == 1);
+    }
+
+    reset_async_render();
+    DyCore_clear_notes();
+}
+
+TEST_CASE("RenderSchedulesAreKeptPerRenderer") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    insert_test_notes();
+
+    const double noteSpeed = 1.5;
+    reset_render_schedule_stats();
+    const int context = create_render_context();
+    request_context_render(context, 400.0, noteSpeed);
+    wait_context_render(context);
+    request_async_render(400.0, noteSpeed);
+    reset_async_render();
+
+    // Neither the context nor the pipeline feeds the editor's measurements.
+    const auto before = get_render_schedule_stats(2);
+    CHECK(before.serialRuns + before.parallelRuns == 0);
+    const auto pipeline = get_async_render_schedule_stats(2);
+    CHECK(pipeline.serialRuns + pipeline.parallelRuns == 1);
+
+    (void)render_sync(400.0, noteSpeed, 2);
+    const auto after = get_render_schedule_stats(2);
+    CHECK(after.serialRuns + after.parallelRuns == 1);
+    CHECK(after.sharedRuns == 0);
+
+    destroy_render_context(context);
+    DyCore_clear_notes();
+}
+
+TEST_CASE("RenderContextsRenderIndependentViews") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    insert_test_notes();
+
+    const double noteSpeed = 1.5;
+    auto& mainActivation = get_note_activation_manager();
+    mainActivation.set_range(1200.0, noteSpeed);
+    mainActivation.recalculate();
+    const auto mainActive = mainActivation.get_active_notes();
+
+    const int preview = create_render_context();
+    const int exporter = create_render_context();
+    request_context_render(preview, 400.0, noteSpeed);
+    request_context_render(exporter, 700.0, noteSpeed);
+
+    // Both frames are in flight at once; the editor window is untouched.
+    CHECK(mainActivation.get_active_notes() == mainActive);
+    CHECK(get_context_active_note_count(preview) !=
+          get_context_active_note_count(exporter));
+
+    for (const auto& [context, nowTime] :
+         {std::pair{preview, 400.0}, std::pair{exporter, 700.0}}) {
+        for (const int state : {0, 1, 2}) {
+            std::vector<char> buffer(get_context_render_size(context, state));
+            CHECK(collect_context_render(context, buffer.data(),
+                                         buffer.size(), state) ==
+                  buffer.size());
+            CHECK(buffer == render_sync(nowTime, noteSpeed, state));
+        }
+    }
+
+    destroy_render_context(preview);
+    destroy_render_context(exporter);
+    CHECK_THROWS_AS(request_context_render(preview, 400.0, noteSpeed),
+                    std::out_of_range);
+    DyCore_clear_notes();
+}
+
+TEST_CASE("OfflineRendererRasterizesFramesInOrder") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    insert_test_notes();
+    set_offline_render_atlas(2, 2, std::vector<uint8_t>(2 * 2 * 4, 0xFF));
+
+    const OfflineRenderSettings settings{.startTime = 400.0,
+                                         .endTime = 450.0,
+                                         .fps = 100,
+                                         .width = 192,
+                                         .height = 108,
+                                         .noteSpeed = 1.5,
+                                         .background = 0x102030,
+                                         .framesInFlight = 2};
+    std::vector<std::vector<uint8_t>> frames;
+    OfflineChartRenderer renderer(settings, [&](std::span<const uint8_t> f) {
+        frames.emplace_back(f.begin(), f.end());
+        return 0;
+    });
+    CHECK(renderer.step(2));
+    CHECK(frames.size() == 2);
+    renderer.run();
+    CHECK(renderer.get_progress() == 1.0);
+    CHECK(renderer.get_stats().framesDelivered == 6);
+    REQUIRE(frames.size() == 6);
+
+    const auto isBackground = [](std::span<const uint8_t> pixel) {
+        return pixel[0] == 0x30 && pixel[1] == 0x20 && pixel[2] == 0x10 &&
+               pixel[3] == 0xFF;
+    };
+    for (const auto& frame : frames) {
+        REQUIRE(frame.size() == 192 * 108 * 4);
+        CHECK(isBackground(std::span(frame).first(4)));
+        size_t notePixels = 0;
+        for (size_t index = 0; index < frame.size(); index += 4) {
+            notePixels += !isBackground(std::span(frame).subspan(index, 4));
+        }
+        CHECK(notePixels > 0);
+    }
+    // Notes move between frames.
+    CHECK(frames.front() != frames.back());
+
+    // Frames only depend on their time.
+    std::vector<uint8_t> again;
+    OfflineChartRenderer single(
+        {.startTime = 450.0,
+         .endTime = 450.0,
+         .fps = 100,
+         .width = 192,
+         .height = 108,
+         .noteSpeed = 1.5,
+         .background = 0x102030},
+        [&](std::span<const uint8_t> f) {
+            again.assign(f.begin(), f.end());
+            return 0;
+        });
+    single.run();
+    CHECK(again == frames.back());
+
+    OfflineChartRenderer aborted(settings,
+                                 [](std::span<const uint8_t>) { return 1; });
+    CHECK_THROWS_AS(aborted.run(), std::runtime_error);
+    DyCore_clear_notes();
+}
+
+TEST_CASE("RenderLodCoalescesOverlappingNotes") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    for (int index = 0; index < 30; ++index) {
+        Note note{};
+        note.type = 0;
+        note.time = 500.0;
+        note.width = 1.0;
+        note.position = 2.0 + (index % 3) * 0.1;
+        note.noteID = std::format("lod{:05}", index);
+        REQUIRE(create_note(note, false) == 0);
+    }
+
+    const double noteSpeed = 1.5;
+    const auto full = render_sync(400.0, noteSpeed, 2);
+    CHECK(full.size() == 30 * 3 * 120);
+
+    set_render_lod_mode(RENDER_LOD_MODE::ALWAYS);
+    const auto coalesced = render_sync(400.0, noteSpeed, 2);
+    // One stretched SEG_3 sprite covering all three lateral positions.
+    CHECK(coalesced.size() == 3 * 120);
+    const auto stats = get_render_lod_stats(2);
+    CHECK(stats.active);
+    CHECK(stats.inputItems == 30);
+    CHECK(stats.outputItems == 1);
+
+    set_render_lod_mode(RENDER_LOD_MODE::OFF);
+    DyCore_clear_notes();
+}
+
+TEST_CASE("RenderLodRespectsVertexCap") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    insert_test_notes();
+
+    const double noteSpeed = 1.5;
+    const size_t vertexCap = 12 * 120;
+    set_render_lod_mode(RENDER_LOD_MODE::AUTO);
+    set_render_lod_vertex_cap(vertexCap);
+    for (const int state : {1, 0, 2}) {
+        CHECK(render_sync(400.0, noteSpeed, state).size() <= vertexCap);
+    }
+    const auto stats = get_render_lod_stats(2);
+    CHECK(stats.active);
+    CHECK(stats.rowPixels > 1.0);
+    CHECK(stats.outputItems + stats.droppedItems <= stats.inputItems);
+
+    set_render_lod_vertex_cap(RENDER_LOD_DEFAULT_VERTEX_CAP);
+    set_render_lod_mode(RENDER_LOD_MODE::OFF);
+    DyCore_clear_notes();
+}
+
+TEST_CASE("RenderLodStatsAreKeptPerRendererAndExportsStayFull") {
+    DyCore_clear_notes();
+    add_test_sprites();
+    for (int index = 0; index < 30; ++index) {
+        Note note{};
+        note.type = 0;
+        note.time = 500.0;
+        note.width = 1.0;
+        note.position = 2.0 + (index % 3) * 0.1;
+        note.noteID = std::format("lodctx{:05}", index);
+        REQUIRE(create_note(note, false) == 0);
+    }
+
+    const double noteSpeed = 1.5;
+    (void)render_sync(400.0, noteSpeed, 2);
+    CHECK_FALSE(get_render_lod_stats(2).active);
+
+    set_render_lod_mode(RENDER_LOD_MODE::ALWAYS);
+    const int preview = create_render_context();
+    const int exporter = create_render_context(true);
+    request_context_render(preview, 400.0, noteSpeed);
+    request_context_render(exporter, 400.0, noteSpeed);
+    request_async_render(400.0, noteSpeed);
+    reset_async_render();
+
+    CHECK(get_context_render_size(preview, 2) == 3 * 120);
+    CHECK(get_context_render_lod_stats(preview, 2).active);
+    CHECK(get_context_render_size(exporter, 2) == 30 * 3 * 120);
+    CHECK_FALSE(get_context_render_lod_stats(exporter, 2).active);
+    CHECK(get_async_render_lod_stats(2).active);
+    // None of them touches the editor's stats.
+    CHECK_FALSE(get_render_lod_stats(2).active);
+
+    destroy_render_context(exporter);
+    destroy_render_context(preview);
+    set_render_lod_mode(RENDER_LOD_MODE::OFF);
+    DyCore_clear_notes();
+}
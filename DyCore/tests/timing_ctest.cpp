@@ -2,6 +2,12 @@
 
 #include <json.hpp>
 #include <string>
+#include <vector>
+
+#include "note.h"
+#include "notePoolManager.h"
+#include "snap.h"
+#include "timing.h"
 
 extern "C" double DyCore_insert_timing_point(const char* timingPointObject);
 extern "C" const char* DyCore_get_timing_point_at(double time);
@@ -44,3 +50,169 @@ TEST_CASE("TimingPointAtTime") {
 
     DyCore_timing_points_reset();
 }
+
+TEST_CASE("TimingIndexConvertsAcrossSegments") {
+    // Two beats of 500 ms, 2.4 beats of 250 ms in 3/4, then 1000 ms beats.
+    const TimingIndex index({{0.0, 500.0, 4}, {1000.0, 250.0, 3},
+                             {1600.0, 1000.0, 4}});
+    const auto& segments = index.get_segments();
+    REQUIRE(segments.size() == 3);
+    CHECK(segments[1].beat == doctest::Approx(2.0));
+    CHECK(segments[1].bar == doctest::Approx(1.0));
+    CHECK(segments[2].beat == doctest::Approx(4.4));
+    CHECK(segments[2].bar == doctest::Approx(2.0));
+
+    CHECK(index.time_to_beat(500.0) == doctest::Approx(1.0));
+    CHECK(index.time_to_beat(-500.0) == doctest::Approx(-1.0));
+    CHECK(index.time_to_beat(1250.0) == doctest::Approx(3.0));
+    CHECK(index.time_to_bar(1250.0) == doctest::Approx(1.0 + 1.0 / 3.0));
+    CHECK(index.time_to_beat(2600.0) == doctest::Approx(5.4));
+    CHECK(index.beat_to_time(4.4) == doctest::Approx(1600.0));
+    CHECK(index.bar_to_time(2.0) == doctest::Approx(1600.0));
+    CHECK(index.bar_to_time(2.5) == doctest::Approx(3600.0));
+
+    const std::vector<double> times = {-100.0, 0.0,    400.0,  1000.0,
+                                       1300.0, 1600.0, 1700.0, 9000.0};
+    for (const bool sorted : {true, false}) {
+        std::vector<double> values = times;
+        if (!sorted) {
+            std::swap(values[0], values[6]);
+            std::swap(values[2], values[7]);
+        }
+        std::vector<double> beats(values.size());
+        index.convert(values, beats, TIMING_UNIT::MS, TIMING_UNIT::BEAT);
+        for (size_t i = 0; i < values.size(); ++i) {
+            CHECK(beats[i] == doctest::Approx(index.time_to_beat(values[i])));
+        }
+    }
+
+    CHECK_THROWS_AS((void)TimingIndex().time_to_beat(0.0), std::logic_error);
+}
+
+TEST_CASE("TimingManagerRebuildsIndexOnModification") {
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({0.0, 500.0, 4});
+    CHECK(timing.get_index().time_to_beat(2000.0) == doctest::Approx(4.0));
+
+    timing.add_timing_point({1000.0, 250.0, 4});
+    CHECK(timing.get_index().time_to_beat(2000.0) == doctest::Approx(6.0));
+
+    timing.add_offset(1000.0);
+    CHECK(timing.get_index().time_to_beat(2000.0) == doctest::Approx(2.0));
+
+    timing.clear();
+    CHECK(timing.get_index().empty());
+}
+
+TEST_CASE("SnapTimesToGridHonoursModesAndSegments") {
+    // Quarter divisions are 125 ms before 1000 and 62.5 ms after.
+    const TimingIndex index({{0.0, 500.0, 4}, {1000.0, 250.0, 4}});
+    const std::vector<double> times = {-130.0, 0.0, 140.0, 190.0, 990.0,
+                                       1040.0};
+    std::vector<double> out(times.size());
+
+    snap_times_to_grid(index, times, out, 4, SNAP_MODE::AROUND);
+    CHECK(out == std::vector<double>{-125.0, 0.0, 125.0, 250.0, 1000.0 - 125.0,
+                                     1062.5});
+
+    snap_times_to_grid(index, times, out, 4, SNAP_MODE::PRE);
+    CHECK(out == std::vector<double>{-250.0, 0.0, 125.0, 125.0, 875.0, 1000.0});
+
+    // 990 cannot snap forward onto the next timing point's grid line.
+    snap_times_to_grid(index, times, out, 4, SNAP_MODE::POST);
+    CHECK(out == std::vector<double>{-125.0, 0.0, 250.0, 250.0, 875.0, 1062.5});
+
+    // Unsorted input gives the same result per value.
+    const std::vector<double> shuffled = {1040.0, -130.0, 190.0, 0.0};
+    std::vector<double> shuffledOut(shuffled.size());
+    snap_times_to_grid(index, shuffled, shuffledOut, 4, SNAP_MODE::POST);
+    CHECK(shuffledOut == std::vector<double>{1062.5, -125.0, 250.0, 0.0});
+
+    // A value already on the grid stays there despite rounding error.
+    const std::vector<double> onGrid = {1000.0 + 62.5 * 3 - 1e-10};
+    std::vector<double> onGridOut(1);
+    snap_times_to_grid(index, onGrid, onGridOut, 4, SNAP_MODE::PRE);
+    CHECK(onGridOut[0] == doctest::Approx(1187.5));
+}
+
+TEST_CASE("SnapNotesAppliesOneBatchedEdit") {
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({0.0, 500.0, 4});
+    clear_notes();
+
+    Note note{};
+    note.side = 0;
+    note.type = 0;
+    note.width = 1.0;
+    note.position = 2.5;
+    note.time = 130.0;
+    note.noteID = "snapNormal";
+    REQUIRE(create_note(note, false) == 0);
+    note.type = 2;
+    note.time = 370.0;
+    note.lastTime = 400.0;
+    note.noteID = "snapHold";
+    REQUIRE(create_note(note, false) == 0);
+
+    auto& pool = get_note_pool_manager();
+    const auto generation = pool.get_last_modified_time();
+    // Sub notes and unknown IDs are skipped.
+    const std::vector<std::string> ids = {
+        "snapNormal", "snapHold", pool.get_note("snapHold").subNoteID,
+        "missing"};
+    CHECK(snap_notes_to_grid(ids, 4, SNAP_MODE::AROUND) == 2);
+    CHECK(pool.get_last_modified_time() == generation + 1);
+
+    CHECK(pool.get_note("snapNormal").time == doctest::Approx(125.0));
+    const Note hold = pool.get_note("snapHold");
+    CHECK(hold.time == doctest::Approx(375.0));
+    CHECK(hold.lastTime == doctest::Approx(375.0));
+    CHECK(pool.get_note(hold.subNoteID).time == doctest::Approx(750.0));
+
+    clear_notes();
+    timing.clear();
+}
+
+TEST_CASE("TimingManagerEditsByNearestTime") {
+    auto& timing = get_timing_manager();
+    timing.clear();
+    timing.add_timing_point({300.0, 750.0, 3});
+    timing.add_timing_point({100.0, 500.0, 4});
+    timing.add_timing_point({200.0, 600.0, 5});
+    CHECK(timing[0].time == 100.0);
+    CHECK(timing[2].time == 300.0);
+
+    CHECK(timing.has_timing_point_at(200.4));
+    CHECK_FALSE(timing.has_timing_point_at(201.5));
+
+    // Lookups tolerate rounding; moving a point keeps the order.
+    timing.change_timing_point_at_time(100.2, {400.0, 250.0, 4});
+    std::vector<TimingPoint> points;
+    timing.get_timing_points(points);
+    REQUIRE(points.size() == 3);
+    CHECK(points[0].time == 200.0);
+    CHECK(points[2].time == 400.0);
+    CHECK(points[2].beatLength == 250.0);
+
+    // Nothing within the tolerance leaves the points untouched.
+    const auto modified = timing.get_last_modified_time();
+    timing.delete_timing_point_at_time(350.0);
+    CHECK(timing.count() == 3);
+    CHECK(timing.get_last_modified_time() == modified);
+    timing.delete_timing_point_at_time(299.5);
+    CHECK(timing.count() == 2);
+
+    timing.add_timing_point({600.0, 500.0, 4});
+    timing.add_timing_point({800.0, 500.0, 4});
+    timing.get_timing_points_in_window(450.0, 700.0, points);
+    REQUIRE(points.size() == 2);
+    CHECK(points[0].time == 400.0);
+    CHECK(points[1].time == 600.0);
+    timing.get_timing_points_in_window(0.0, 100.0, points);
+    REQUIRE(points.size() == 1);
+    CHECK(points[0].time == 200.0);
+
+    timing.clear();
+}
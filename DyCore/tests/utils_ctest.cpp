@@ -7,8 +7,10 @@
 #include <iomanip>
 #include <regex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 
+#include "mappedFile.h"
 #include "utils.h"
 
 namespace {
@@ -92,3 +94,25 @@ TEST_CASE("FileModificationTimeFallbackUsesRecentCurrentTime") {
     CHECK(parsed >= before - std::chrono::seconds(5));
     CHECK(parsed <= after);
 }
+
+TEST_CASE("CopyOnWriteMappedFilesLeaveTheFileAlone") {
+    const auto path = make_temp_file();
+    {
+        MappedFile readOnly(path);
+        CHECK_THROWS_AS(readOnly.writable_data(), std::logic_error);
+
+        MappedFile file(path, MappedFile::Access::COPY_ON_WRITE);
+        const auto view = file.writable_data();
+        REQUIRE(view.size() == 16);
+        view[0] = 'T';
+        CHECK(std::string(file.data().data(), file.size()) ==
+              "Timestamp source");
+        CHECK(std::string(readOnly.data().data(), readOnly.size()) ==
+              "timestamp source");
+    }
+    std::ifstream in(path, std::ios::binary);
+    CHECK(std::string(std::istreambuf_iterator<char>(in), {}) ==
+          "timestamp source");
+    in.close();
+    std::filesystem::remove(path);
+}
@@ -27,12 +27,17 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_compress_string","argCount":0,"args":[1,1,2,],"documentation":"","externalName":"DyCore_compress_string","help":"DyCore_compress_string(str, targetBuffer, compressionLevel)","hidden":false,"kind":1,"name":"DyCore_compress_string","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_is_compressed","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_is_compressed","help":"DyCore_is_compressed(str, sSize)","hidden":false,"kind":1,"name":"DyCore_is_compressed","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_decompress_string","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_decompress_string","help":"DyCore_decompress_string(str, sSize)","hidden":false,"kind":1,"name":"DyCore_decompress_string","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_get_decompressed_size","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_get_decompressed_size","help":"DyCore_get_decompressed_size(src, srcSize)","hidden":false,"kind":1,"name":"DyCore_get_decompressed_size","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_decompress_to_buffer","argCount":0,"args":[1,2,1,2,],"documentation":"","externalName":"DyCore_decompress_to_buffer","help":"DyCore_decompress_to_buffer(src, srcSize, dst, dstCapacity)","hidden":false,"kind":1,"name":"DyCore_decompress_to_buffer","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_buffer_copy","argCount":0,"args":[1,1,2,],"documentation":"","externalName":"DyCore_buffer_copy","help":"DyCore_buffer_copy(dst, src, size)","hidden":false,"kind":1,"name":"DyCore_buffer_copy","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_file_modification_time","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_get_file_modification_time","help":"DyCore_get_file_modification_time(filepath)","hidden":false,"kind":1,"name":"DyCore_get_file_modification_time","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_insert_note","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_insert_note","help":"DyCore_insert_note(noteProp)","hidden":false,"kind":1,"name":"DyCore_insert_note","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_delete_note","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_delete_note","help":"DyCore_delete_note(noteID)","hidden":false,"kind":1,"name":"DyCore_delete_note","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_clear_notes","argCount":0,"args":[],"documentation":"","externalName":"DyCore_clear_notes","help":"DyCore_clear_notes()","hidden":false,"kind":1,"name":"DyCore_clear_notes","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
-        {"$GMExtensionFunction":"","%Name":"DyCore_save_project","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_save_project","help":"DyCore_save_project(filePath, compressionLevel)","hidden":false,"kind":1,"name":"DyCore_save_project","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_save_project","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_save_project","help":"DyCore_save_project(filePath, compressionLevel, safeSave)","hidden":false,"kind":1,"name":"DyCore_save_project","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_project_save_cancel","argCount":0,"args":[],"documentation":"","externalName":"DyCore_project_save_cancel","help":"DyCore_project_save_cancel()","hidden":false,"kind":1,"name":"DyCore_project_save_cancel","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_project_backup_list","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_project_backup_list","help":"DyCore_project_backup_list(projectPath)","hidden":false,"kind":1,"name":"DyCore_project_backup_list","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_project_backup_restore","argCount":0,"args":[1,2,1,],"documentation":"","externalName":"DyCore_project_backup_restore","help":"DyCore_project_backup_restore(projectPath, versionId, targetPath)","hidden":false,"kind":1,"name":"DyCore_project_backup_restore","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_has_async_event","argCount":0,"args":[],"documentation":"","externalName":"DyCore_has_async_event","help":"DyCore_has_async_event()","hidden":false,"kind":1,"name":"DyCore_has_async_event","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_async_event","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_async_event","help":"DyCore_get_async_event()","hidden":false,"kind":1,"name":"DyCore_get_async_event","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_index_sort","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_index_sort","help":"DyCore_index_sort(data, size)","hidden":false,"kind":1,"name":"DyCore_index_sort","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
@@ -58,6 +63,8 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_get_timing_array_string","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_timing_array_string","help":"DyCore_get_timing_array_string()","hidden":false,"kind":1,"name":"DyCore_get_timing_array_string","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_chart_metadata","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_chart_metadata","help":"DyCore_get_chart_metadata()","hidden":false,"kind":1,"name":"DyCore_get_chart_metadata","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_project_load","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_project_load","help":"DyCore_project_load(filePath)","hidden":false,"kind":1,"name":"DyCore_project_load","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_project_journal_close","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_project_journal_close","help":"DyCore_project_journal_close(discard)","hidden":false,"kind":1,"name":"DyCore_project_journal_close","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_project_set_chart_prefetch","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_project_set_chart_prefetch","help":"DyCore_project_set_chart_prefetch(enabled)","hidden":false,"kind":1,"name":"DyCore_project_set_chart_prefetch","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_chart_path","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_chart_path","help":"DyCore_get_chart_path()","hidden":false,"kind":1,"name":"DyCore_get_chart_path","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_project_metadata","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_project_metadata","help":"DyCore_get_project_metadata()","hidden":false,"kind":1,"name":"DyCore_get_project_metadata","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_project_version","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_project_version","help":"DyCore_get_project_version()","hidden":false,"kind":1,"name":"DyCore_get_project_version","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
@@ -67,6 +74,8 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_set_project_version","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_set_project_version","help":"DyCore_set_project_version(version)","hidden":false,"kind":1,"name":"DyCore_set_project_version","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_insert_timing_point","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_insert_timing_point","help":"DyCore_insert_timing_point(timingPointObject)","hidden":false,"kind":1,"name":"DyCore_insert_timing_point","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_timing_points_count","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_timing_points_count","help":"DyCore_get_timing_points_count()","hidden":false,"kind":1,"name":"DyCore_get_timing_points_count","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_prepare_timing_points","argCount":0,"args":[2,2,],"documentation":"","externalName":"DyCore_prepare_timing_points","help":"DyCore_prepare_timing_points(begin, end)","hidden":false,"kind":1,"name":"DyCore_prepare_timing_points","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_copy_timing_points","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_copy_timing_points","help":"DyCore_copy_timing_points(buffer)","hidden":false,"kind":1,"name":"DyCore_copy_timing_points","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_timing_points_sort","argCount":0,"args":[],"documentation":"","externalName":"DyCore_timing_points_sort","help":"DyCore_timing_points_sort()","hidden":false,"kind":1,"name":"DyCore_timing_points_sort","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_timing_points_reset","argCount":0,"args":[],"documentation":"","externalName":"DyCore_timing_points_reset","help":"DyCore_timing_points_reset()","hidden":false,"kind":1,"name":"DyCore_timing_points_reset","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_delete_timing_point_at_time","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_delete_timing_point_at_time","help":"DyCore_delete_timing_point_at_time(time)","hidden":false,"kind":1,"name":"DyCore_delete_timing_point_at_time","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
@@ -77,6 +86,7 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_chart_import_dyn","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_chart_import_dyn","help":"DyCore_chart_import_dyn(filePath, importInfo, importTiming)","hidden":false,"kind":1,"name":"DyCore_chart_import_dyn","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_chart_import_dy","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_chart_import_dy","help":"DyCore_chart_import_dy(filePath, importInfo, importTiming)","hidden":false,"kind":1,"name":"DyCore_chart_import_dy","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_chart_import_dy_get_remix","argCount":0,"args":[],"documentation":"","externalName":"DyCore_chart_import_dy_get_remix","help":"DyCore_chart_import_dy_get_remix()","hidden":false,"kind":1,"name":"DyCore_chart_import_dy_get_remix","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_chart_import_batch","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_chart_import_batch","help":"DyCore_chart_import_batch(pathsJson, append)","hidden":false,"kind":1,"name":"DyCore_chart_import_batch","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_chart_export_xml","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_chart_export_xml","help":"DyCore_chart_export_xml(filePath, isDym, fixError)","hidden":false,"kind":1,"name":"DyCore_chart_export_xml","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_chart_metadata_last_modified_time","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_chart_metadata_last_modified_time","help":"DyCore_get_chart_metadata_last_modified_time()","hidden":false,"kind":1,"name":"DyCore_get_chart_metadata_last_modified_time","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_cac_active_notes","argCount":0,"args":[2,2,],"documentation":"","externalName":"DyCore_cac_active_notes","help":"DyCore_cac_active_notes(nowTime, nowSpeed)","hidden":false,"kind":1,"name":"DyCore_cac_active_notes","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
@@ -84,6 +94,22 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_add_sprite_data","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_add_sprite_data","help":"DyCore_add_sprite_data(spriteData)","hidden":false,"kind":1,"name":"DyCore_add_sprite_data","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_note_rendering_vertex_buffer_bound","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_note_rendering_vertex_buffer_bound","help":"DyCore_get_note_rendering_vertex_buffer_bound()","hidden":false,"kind":1,"name":"DyCore_get_note_rendering_vertex_buffer_bound","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_render_active_notes","argCount":0,"args":[1,2,2,2,],"documentation":"","externalName":"DyCore_render_active_notes","help":"DyCore_render_active_notes(vertBuff, nowTime, noteSpeed, state)","hidden":false,"kind":1,"name":"DyCore_render_active_notes","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_async_request","argCount":0,"args":[2,2,2,],"documentation":"","externalName":"DyCore_render_async_request","help":"DyCore_render_async_request(nowTime, noteSpeed, tolerance)","hidden":false,"kind":1,"name":"DyCore_render_async_request","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_async_collect","argCount":0,"args":[1,2,2,2,],"documentation":"","externalName":"DyCore_render_async_collect","help":"DyCore_render_async_collect(vertBuff, nowTime, noteSpeed, state)","hidden":false,"kind":1,"name":"DyCore_render_async_collect","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_context_create","argCount":0,"args":[],"documentation":"","externalName":"DyCore_render_context_create","help":"DyCore_render_context_create()","hidden":false,"kind":1,"name":"DyCore_render_context_create","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_context_destroy","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_render_context_destroy","help":"DyCore_render_context_destroy(context)","hidden":false,"kind":1,"name":"DyCore_render_context_destroy","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_context_request","argCount":0,"args":[2,2,2,],"documentation":"","externalName":"DyCore_render_context_request","help":"DyCore_render_context_request(context, nowTime, noteSpeed)","hidden":false,"kind":1,"name":"DyCore_render_context_request","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_context_get_size","argCount":0,"args":[2,2,],"documentation":"","externalName":"DyCore_render_context_get_size","help":"DyCore_render_context_get_size(context, state)","hidden":false,"kind":1,"name":"DyCore_render_context_get_size","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_render_context_collect","argCount":0,"args":[2,1,2,2,],"documentation":"","externalName":"DyCore_render_context_collect","help":"DyCore_render_context_collect(context, vertBuff, bufferSize, state)","hidden":false,"kind":1,"name":"DyCore_render_context_collect","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_set_offline_render_atlas","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_set_offline_render_atlas","help":"DyCore_set_offline_render_atlas(rgba, width, height)","hidden":false,"kind":1,"name":"DyCore_set_offline_render_atlas","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_set_render_schedule_mode","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_set_render_schedule_mode","help":"DyCore_set_render_schedule_mode(mode)","hidden":false,"kind":1,"name":"DyCore_set_render_schedule_mode","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_set_render_lod","argCount":0,"args":[2,2,],"documentation":"","externalName":"DyCore_set_render_lod","help":"DyCore_set_render_lod(mode, vertexCap)","hidden":false,"kind":1,"name":"DyCore_set_render_lod","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_set_beat_grid_style","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_set_beat_grid_style","help":"DyCore_set_beat_grid_style(style)","hidden":false,"kind":1,"name":"DyCore_set_beat_grid_style","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_prepare_beat_grid","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_prepare_beat_grid","help":"DyCore_prepare_beat_grid(view, nowTime, noteSpeed)","hidden":false,"kind":1,"name":"DyCore_prepare_beat_grid","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_copy_beat_grid","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_copy_beat_grid","help":"DyCore_copy_beat_grid(vertBuff)","hidden":false,"kind":1,"name":"DyCore_copy_beat_grid","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_prepare_overview","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_prepare_overview","help":"DyCore_prepare_overview(settings)","hidden":false,"kind":1,"name":"DyCore_prepare_overview","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_copy_overview","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_copy_overview","help":"DyCore_copy_overview(buffer)","hidden":false,"kind":1,"name":"DyCore_copy_overview","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_get_overview_version","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_overview_version","help":"DyCore_get_overview_version()","hidden":false,"kind":1,"name":"DyCore_get_overview_version","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_note_index_lower_bound","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_get_note_index_lower_bound","help":"DyCore_get_note_index_lower_bound(time)","hidden":false,"kind":1,"name":"DyCore_get_note_index_lower_bound","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_note_index_upper_bound","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_get_note_index_upper_bound","help":"DyCore_get_note_index_upper_bound(time)","hidden":false,"kind":1,"name":"DyCore_get_note_index_upper_bound","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_note_index_on_side_after_index","argCount":0,"args":[2,2,2,],"documentation":"","externalName":"DyCore_get_note_index_on_side_after_index","help":"DyCore_get_note_index_on_side_after_index(side, index, untilTime)","hidden":false,"kind":1,"name":"DyCore_get_note_index_on_side_after_index","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
@@ -99,6 +125,10 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_random_range","argCount":0,"args":[2,2,],"documentation":"","externalName":"DyCore_random_range","help":"DyCore_random_range(min, max)","hidden":false,"kind":1,"name":"DyCore_random_range","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_irandom_range","argCount":0,"args":[2,2,],"documentation":"","externalName":"DyCore_irandom_range","help":"DyCore_irandom_range(min, max)","hidden":false,"kind":1,"name":"DyCore_irandom_range","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_has_timing_point_at_time","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_has_timing_point_at_time","help":"DyCore_has_timing_point_at_time(time)","hidden":false,"kind":1,"name":"DyCore_has_timing_point_at_time","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_timing_convert","argCount":0,"args":[2,2,2,],"documentation":"","externalName":"DyCore_timing_convert","help":"DyCore_timing_convert(value, from, to)","hidden":false,"kind":1,"name":"DyCore_timing_convert","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_timing_convert_buffer","argCount":0,"args":[1,2,2,2,],"documentation":"","externalName":"DyCore_timing_convert_buffer","help":"DyCore_timing_convert_buffer(buffer, count, from, to)","hidden":false,"kind":1,"name":"DyCore_timing_convert_buffer","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_snap_times","argCount":0,"args":[1,2,2,2,],"documentation":"","externalName":"DyCore_snap_times","help":"DyCore_snap_times(buffer, count, divsPerBeat, mode)","hidden":false,"kind":1,"name":"DyCore_snap_times","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_snap_notes","argCount":0,"args":[1,2,2,],"documentation":"","externalName":"DyCore_snap_notes","help":"DyCore_snap_notes(noteIDs, divsPerBeat, mode)","hidden":false,"kind":1,"name":"DyCore_snap_notes","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_get_version","argCount":0,"args":[],"documentation":"","externalName":"DyCore_get_version","help":"DyCore_get_version()","hidden":false,"kind":1,"name":"DyCore_get_version","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_is_release_build","argCount":0,"args":[],"documentation":"","externalName":"DyCore_is_release_build","help":"DyCore_is_release_build()","hidden":false,"kind":1,"name":"DyCore_is_release_build","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_is_debug_build","argCount":0,"args":[],"documentation":"","externalName":"DyCore_is_debug_build","help":"DyCore_is_debug_build()","hidden":false,"kind":1,"name":"DyCore_is_debug_build","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
@@ -109,6 +139,10 @@
         {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_push_frame","argCount":0,"args":[1,2,],"documentation":"","externalName":"DyCore_ffmpeg_push_frame","help":"DyCore_ffmpeg_push_frame(frameData, size)","hidden":false,"kind":1,"name":"DyCore_ffmpeg_push_frame","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_finish_recording","argCount":0,"args":[],"documentation":"","externalName":"DyCore_ffmpeg_finish_recording","help":"DyCore_ffmpeg_finish_recording()","hidden":false,"kind":1,"name":"DyCore_ffmpeg_finish_recording","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_get_using_decoder","argCount":0,"args":[],"documentation":"","externalName":"DyCore_ffmpeg_get_using_decoder","help":"DyCore_ffmpeg_get_using_decoder()","hidden":false,"kind":1,"name":"DyCore_ffmpeg_get_using_decoder","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_offline_start","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_ffmpeg_offline_start","help":"DyCore_ffmpeg_offline_start(parameter)","hidden":false,"kind":1,"name":"DyCore_ffmpeg_offline_start","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_offline_step","argCount":0,"args":[2,],"documentation":"","externalName":"DyCore_ffmpeg_offline_step","help":"DyCore_ffmpeg_offline_step(maxFrames)","hidden":false,"kind":1,"name":"DyCore_ffmpeg_offline_step","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_offline_abort","argCount":0,"args":[],"documentation":"","externalName":"DyCore_ffmpeg_offline_abort","help":"DyCore_ffmpeg_offline_abort()","hidden":false,"kind":1,"name":"DyCore_ffmpeg_offline_abort","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
+        {"$GMExtensionFunction":"","%Name":"DyCore_ffmpeg_offline_get_stats","argCount":0,"args":[],"documentation":"","externalName":"DyCore_ffmpeg_offline_get_stats","help":"DyCore_ffmpeg_offline_get_stats()","hidden":false,"kind":1,"name":"DyCore_ffmpeg_offline_get_stats","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":1,},
         {"$GMExtensionFunction":"","%Name":"DyCore_video_open","argCount":0,"args":[1,],"documentation":"","externalName":"DyCore_video_open","help":"DyCore_video_open(filePath)","hidden":false,"kind":1,"name":"DyCore_video_open","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_video_close","argCount":0,"args":[],"documentation":"","externalName":"DyCore_video_close","help":"DyCore_video_close()","hidden":false,"kind":1,"name":"DyCore_video_close","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
         {"$GMExtensionFunction":"","%Name":"DyCore_video_is_loaded","argCount":0,"args":[],"documentation":"","externalName":"DyCore_video_is_loaded","help":"DyCore_video_is_loaded()","hidden":false,"kind":1,"name":"DyCore_video_is_loaded","resourceType":"GMExtensionFunction","resourceVersion":"2.0","returnType":2,},
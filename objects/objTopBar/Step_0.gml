@@ -33,6 +33,17 @@ if(keycheck_down(vk_tab)) {
             }
         );
         _inst.set_wh(layoutBar.w / 2,layoutBar.h + 10);
+        _inst = new Button(
+            "recordoffline",
+            _nw, layout.fromTop + layout.paddingH,
+            i18n_get("recording_offline_button"), function() {
+                recording_export_offline();
+            },
+            function() {
+                return !global.recordManager.is_recording() && !global.recordManager.offlineExporting;
+            }
+        );
+        _inst.set_wh(layoutBar.w / 2,layoutBar.h + 10);
     }
     else {
         gui_manager_destroy();
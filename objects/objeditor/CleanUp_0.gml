@@ -1,3 +1,5 @@
 
 timing_point_reset();
+vertex_delete_buffer(beatGridVertBuff);
+buffer_delete(beatGridBuff);
 dyc_editor_set_ready(false);
\ No newline at end of file
@@ -164,6 +164,32 @@ beatlineAlphaMul = 0;
 beatlineSideInfoX = resor_to_x(0.5)+beatlineHardLength/2;
 beatlineSideInfoDivWidth = 100;
 
+// Beat lines are generated by DyCore into this buffer.
+beatGridBuff = buffer_create(64 * 1024, buffer_fast, 1);
+beatGridVertBuff = vertex_create_buffer_from_buffer(beatGridBuff, global.noteRenderer.vertFormat);
+
+/// Send the beatline appearance to DyCore. Call again whenever the style changes.
+function beatline_sync_style() {
+	var _mono = beatlineStyleCurrent == BeatlineStyles.BS_MONO || beatlineStyleCurrent == BeatlineStyles.BS_MONOLONG;
+	var _long = beatlineStyleCurrent == BeatlineStyles.BS_LONG || beatlineStyleCurrent == BeatlineStyles.BS_MONOLONG;
+	DyCore_set_beat_grid_style(json_stringify({
+		colors: beatlineColors,
+		lengthOffsets: beatlineLengthOffset,
+		width: beatlineWidth,
+		hardWidth: beatlineHardWidth,
+		length: beatlineLength,
+		hardLength: beatlineHardLength,
+		longLength: beatlineLengthLong,
+		height: beatlineHeight,
+		hardHeight: beatlineHardHeight,
+		sideInfoX: beatlineSideInfoX,
+		sideInfoWidth: beatlineSideInfoDivWidth,
+		mono: _mono ? 1 : 0,
+		long: _long ? 1 : 0
+	}));
+}
+beatline_sync_style();
+
 animSpeed = 0.4;
 animBeatlineTargetAlpha = [0.7, 0, 0];
 animBeatlineTargetAlphaM = 0;
@@ -32,12 +32,8 @@
         var _nowTpTime = _nowTp.time;
         var _nextTpTime = (_nowat + 1 == _pointscount ? objMain.musicLength:timingPoints[_nowat+1].time)
         
-        var _nowhard = false, _noww, _nowl, _nowh;
-        var _ny, _nyl, _nyr;
-        var _shortestLengthOffset = 0;
-        for(var _offsetIndex = 1; _offsetIndex < array_length(beatlineLengthOffset); _offsetIndex++)
-            _shortestLengthOffset = min(_shortestLengthOffset, beatlineLengthOffset[_offsetIndex]);
-        _shortestLengthOffset -= 10; // Extra offset for very short beatlines (e.g. 1/64)
+        var _nowhard = false;
+        var _ny;
         
             // Background Glow
             with(objMain) {
@@ -45,125 +41,74 @@
                     animCurvFaintChan, frac(frac((nowTime - _nowTp.time) / _nowTp.beatLength / _nowTp.meter)+1));
                 animCurvFaintEval = lerp(0.5, 1.0, animCurvFaintEval);
             }
-            
-        if(beatlineVisible)
+        
+        // Beat, bar and sub-division lines are generated by DyCore in one vertex buffer.
+        if(beatlineVisible && beatlineAlphaMul > 0.01) {
+            var _divs = [];
+            for(var j = 1; j <= beatlineMaxDiv; j++)
+                if(j == get_div() || beatlineEnabled[j])
+                    array_push(_divs, j);
+            var _gridSize = DyCore_prepare_beat_grid(json_stringify({
+                    divisions: _divs,
+                    alpha: beatlineAlpha,
+                    musicLength: objMain.musicLength
+                }), nowTime, playbackSpeed);
+            if(_gridSize > 0) {
+                if(buffer_get_size(beatGridBuff) < _gridSize)
+                    buffer_resize(beatGridBuff, _gridSize);
+                DyCore_copy_beat_grid(buffer_get_address(beatGridBuff));
+                vertex_update_buffer_from_buffer(beatGridVertBuff, 0, beatGridBuff, 0, _gridSize);
+                vertex_submit_ext(beatGridVertBuff, pr_trianglelist, -1, 0, _gridSize / 20);
+            }
+        }
+        
+        // Labels for bars and beats, which sit on the division 1 lines.
+        var _beatsVisible = get_div() == 1 || beatlineEnabled[1];
+        if(beatlineVisible && _beatsVisible && beatlineAlpha[0] > 0.01)
         while(((_nowTpTime - nowTime) * playbackSpeed <= _nh || _nowat == 0) && beatlineAlphaMul > 0.01) {
             for(var i = _nowBeats; i * _nowTp.beatLength + _nowTpTime + 1 < _nextTpTime && (i * _nowTp.beatLength + _nowTpTime - nowTime) * playbackSpeed <= _nh; i++) {
-                for(var j = beatlineMaxDiv; j >= 1; j--) if(j == get_div() || beatlineEnabled[j]) {
-                    for(var k = (j == 1? 0:1/j); k < 1 && (i + k) * _nowTp.beatLength + _nowTpTime < _nextTpTime; k += ((j&1)? 1:2)/j) {
-                        _ny =  note_time_to_y(_nowTpTime + (i + k) * _nowTp.beatLength, 0);
-                        _nyl = note_time_to_y(_nowTpTime + (i + k) * _nowTp.beatLength, 1);
-                        _nyr = note_time_to_y(_nowTpTime + (i + k) * _nowTp.beatLength, 2);
-                        _nowhard = (k == 0 && i % _nowTp.meter == 0);
-                        _noww = _nowhard ? beatlineHardWidth : beatlineWidth;
-                        _nowl = _nowhard ? beatlineHardLength : beatlineLength;
-                        _nowh = _nowhard ? beatlineHardHeight : beatlineHeight;
-                        _noww = _noww * 3;
-                        if(j<=array_length(beatlineLengthOffset)-1)
-                        	_nowl += beatlineLengthOffset[j];
-                        else
-                            _nowl += _shortestLengthOffset - j;
-                        if(_ny < 0 && _nyl > _nw / 2)
-                            break;
-                        
-                        var _defaultNonTrivialCol = c_grey;
-                        var _ncol = (j <= array_length(beatlineColors)-1 && beatlineColors[j] != 0)
-                            ? beatlineColors[j]
-                            : _defaultNonTrivialCol;
-                        /// If beatline style is mono
-                        if(beatlineStyleCurrent == BeatlineStyles.BS_MONO ||
-                           beatlineStyleCurrent == BeatlineStyles.BS_MONOLONG) {
-                           		_ncol = _nowhard ? c_white:c_ltgrey;
-                           }
-                        /// If beatline style is long
-                        if(beatlineStyleCurrent == BeatlineStyles.BS_LONG ||
-                           beatlineStyleCurrent == BeatlineStyles.BS_MONOLONG) {
-                           		_nowl = _nowhard ? beatlineHardLength : beatlineLengthLong;
-                           }
-                        
-                        // draw_set_color(beatlineColors[j]);
-                        // LR
-                        if(_nyl > targetLineBeside && _nyl <= _nw / 2) {
-                            if(beatlineAlpha[1]>0.01) {
-                                CleanLine(_nyl, _nh - targetLineBelow - _nowh, _nyl, _nh - targetLineBelow)
-                                    .Blend(_ncol, beatlineAlpha[1])
-                                    .Thickness(_noww)
-                                    .Cap("round", "round")
-                                    .Draw();
-                                    
-                                // draw_set_alpha(beatlineAlpha[1]);
-                                // draw_line_width(_nyl, _nh - targetLineBelow - _nowh, _nyl, _nh - targetLineBelow, _noww);
-                                
-                            }
-                                
-                            if(beatlineAlpha[2]>0.01) {
-                                CleanLine(_nyr, _nh - targetLineBelow - _nowh, _nyr, _nh - targetLineBelow)
-                                    .Blend(_ncol, beatlineAlpha[2])
-                                    .Thickness(_noww)
-                                    .Cap("round", "round")
-                                    .Draw();
-                                
-                                // draw_set_alpha(beatlineAlpha[2]);
-                                // draw_line_width(_nyr, _nh - targetLineBelow - _nowh, _nyr, _nh - targetLineBelow, _noww);
-                            }
-                                
-                        }
-                        // Down
-                        if(_ny <= _nh - targetLineBelow && _ny >= 0 && beatlineAlpha[0]>0.01) {
-                            CleanLine(_nw / 2 - _nowl / 2, _ny, _nw / 2 + _nowl / 2, _ny)
-                                .Blend(_ncol, beatlineAlpha[0])
-                                .Thickness(_noww)
-                                .Cap("round", "round")
-                                .Draw();
-                            
-                            // draw_set_alpha(beatlineAlpha[0]);
-                            // draw_line_width(_nw / 2 - _nowl / 2, _ny, _nw / 2 + _nowl / 2, _ny, _noww);
-                            
-                            if(i == 0 && k == 0) {
-                                scribble("BPM "+string_format(mspb_to_bpm(_nowTp.beatLength), 1, 2)+" "+string(_nowTp.meter)+"/4")
-                                    .starting_format("mDynamix", c_white)
-                                    .msdf_border(c_dkgrey, 2)
-                                    .align(fa_center, fa_top)
-                                    .scale(0.9, 0.9)
-                                    .blend(c_white, beatlineAlpha[0])
-                                    .draw(_nw/2, _ny+3);
-                            }
-                            
-                            if(_nowhard) {
-                            	scribble(string_format(_totalBeats + round(i/_nowTp.meter) + 1, 1, 0))
-                            		.align(fa_left, fa_center)
-                            		.starting_format("mDynamix", c_white)
-                            		.msdf_border(c_dkgrey, 2)
-                            		.scale(0.9, 0.9)
-                            		.blend(c_white, beatlineAlpha[0])
-                            		.draw(beatlineSideInfoX + 20, _ny);
-                            }
-                            else if(j==1) {
-                            	scribble(string_format(_totalBeats + floor(i/_nowTp.meter) + 1, 1, 0))
-                            		.align(fa_left, fa_bottom)
-                            		.starting_format("mDynamix", c_ltgrey)
-                            		.msdf_border(c_dkgrey, 1)
-                            		.scale(0.75, 0.75)
-                            		.blend(c_white, beatlineAlpha[0])
-                            		.draw(beatlineSideInfoX + 10, _ny - 3);
-                            		
-                            	CleanLine(beatlineSideInfoX, _ny, beatlineSideInfoX+beatlineSideInfoDivWidth, _ny)
-                            		.Blend(c_ltgrey, beatlineAlpha[0])
-                            		.Thickness(7)
-                            		.Cap("round", "round")
-                            		.Draw();
-                            	
-                            	scribble(string_format(i - floor(i/_nowTp.meter)*_nowTp.meter, 1, 0)+"/4")
-                            		.align(fa_left, fa_top)
-                            		.starting_format("mDynamix", c_ltgrey)
-                            		.msdf_border(c_dkgrey, 1)
-                            		.scale(0.75, 0.75)
-                            		.blend(c_white, beatlineAlpha[0])
-                            		.draw(beatlineSideInfoX + 10, _ny + 3);
-                            }
-                        }
-                    }
-                    
+                _ny = note_time_to_y(_nowTpTime + i * _nowTp.beatLength, 0);
+                if(_ny < 0)
+                    break;
+                if(_ny > _nh - targetLineBelow)
+                    continue;
+                _nowhard = (i % _nowTp.meter == 0);
+                
+                if(i == 0) {
+                    scribble("BPM "+string_format(mspb_to_bpm(_nowTp.beatLength), 1, 2)+" "+string(_nowTp.meter)+"/4")
+                        .starting_format("mDynamix", c_white)
+                        .msdf_border(c_dkgrey, 2)
+                        .align(fa_center, fa_top)
+                        .scale(0.9, 0.9)
+                        .blend(c_white, beatlineAlpha[0])
+                        .draw(_nw/2, _ny+3);
+                }
+                
+                if(_nowhard) {
+                	scribble(string_format(_totalBeats + round(i/_nowTp.meter) + 1, 1, 0))
+                		.align(fa_left, fa_center)
+                		.starting_format("mDynamix", c_white)
+                		.msdf_border(c_dkgrey, 2)
+                		.scale(0.9, 0.9)
+                		.blend(c_white, beatlineAlpha[0])
+                		.draw(beatlineSideInfoX + 20, _ny);
+                }
+                else {
+                	scribble(string_format(_totalBeats + floor(i/_nowTp.meter) + 1, 1, 0))
+                		.align(fa_left, fa_bottom)
+                		.starting_format("mDynamix", c_ltgrey)
+                		.msdf_border(c_dkgrey, 1)
+                		.scale(0.75, 0.75)
+                		.blend(c_white, beatlineAlpha[0])
+                		.draw(beatlineSideInfoX + 10, _ny - 3);
+                	
+                	scribble(string_format(i - floor(i/_nowTp.meter)*_nowTp.meter, 1, 0)+"/4")
+                		.align(fa_left, fa_top)
+                		.starting_format("mDynamix", c_ltgrey)
+                		.msdf_border(c_dkgrey, 1)
+                		.scale(0.75, 0.75)
+                		.blend(c_white, beatlineAlpha[0])
+                		.draw(beatlineSideInfoX + 10, _ny + 3);
                 }
             }
             _totalBeats += ceil((_nextTpTime - _nowTpTime) / (_nowTp.beatLength * _nowTp.meter));
@@ -105,6 +105,7 @@ editorSelectMultiple = editorSelectCount > 1;
     	beatlineStyleCurrent ++;
     	beatlineStyleCurrent %= BEATLINE_STYLES_COUNT;
     	global.beatlineStyle = beatlineStyleCurrent;
+    	beatline_sync_style();
     	announcement_set("beatline_style", beatlineStylesName[beatlineStyleCurrent]);
     }
     
@@ -217,6 +217,8 @@ call_later(1, time_source_units_frames, function() {
 	initWithProject = false;
 	
 	autosaving = false;
+	// Saves started that have not reported back yet.
+	pendingSaves = 0;
 	tsAutosave = time_source_create(time_source_game, AUTOSAVE_TIME, time_source_units_seconds, project_auto_save, [], -1);
 	if(global.autosave) {
 		global.autosave = false;
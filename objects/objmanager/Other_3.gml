@@ -4,6 +4,7 @@ save_config();
 
 if(global.recordManager.is_recording())
     global.recordManager.finish_recording();
+global.recordManager.abort_offline_export();
 
 if(global.analytics) {
     aptabase_track("AppClose");
@@ -14,6 +14,9 @@ if(global.__DyCore_Manager != undefined) {
 	global.__DyCore_Manager.step();
 }
 
+// Offline export Update
+global.recordManager.step_offline_export();
+
 // Window resolution Update
 if(!global.recordManager.is_recording()) {
 	var ww = window_get_width(), wh = window_get_height();
@@ -379,6 +379,8 @@ function CommandSnap():CommandSignature("snap", []) constructor {
 
         var processedCount = 0;
         var skippedSubCount = 0;
+        var noteIDs = [];
+        var origProps = [];
 
         for(var i = 0, l = array_length(noteProps); i < l; i++) {
             var curProp = noteProps[i];
@@ -386,20 +388,20 @@ function CommandSnap():CommandSignature("snap", []) constructor {
                 skippedSubCount++;
             }
             else {
-                var originalStartTime = curProp.time;
-                var originalEndTime = curProp.time + curProp.lastTime;
-
-                var snappedStart = editor_snap_to_grid_time(originalStartTime, curProp.side, true, true, snapMode).time;
-                curProp.time = snappedStart;
-
-                if(curProp.noteType == NOTE_TYPE.HOLD) {
-                    var snappedEnd = editor_snap_to_grid_time(originalEndTime, curProp.side, true, true, snapMode).time;
-                    curProp.lastTime = max(1, snappedEnd - snappedStart);
-                }
-
-                dyc_update_note(curProp, true);
+                array_push(noteIDs, curProp.noteID);
+                array_push(origProps, curProp);
+            }
+        }
 
-                processedCount++;
+        // Snap every note in one batched edit, then record it for undo.
+        if(array_length(noteIDs) > 0) {
+            processedCount = max(0, dyc_snap_notes(noteIDs, objEditor.get_div(), snapMode));
+            for(var i = 0, l = array_length(noteIDs); i < l; i++) {
+                var newProp = dyc_get_note(noteIDs[i]);
+                if(is_undefined(newProp)) continue;
+                operation_step_add(OPERATION_TYPE.MOVE, origProps[i], newProp);
+                if(note_is_activated(noteIDs[i]))
+                    note_get_instance(noteIDs[i]).pull_prop();
             }
         }
 
@@ -1,6 +1,7 @@
 /// DyCore Interface.
 
-enum DYCORE_ASYNC_EVENT_TYPE { PROJECT_SAVING, GENERAL_ERROR, GM_ANNOUNCEMENT, ON_FILES_DROPPED };
+enum DYCORE_ASYNC_EVENT_TYPE { PROJECT_SAVING, GENERAL_ERROR, GM_ANNOUNCEMENT, ON_FILES_DROPPED, PROJECT_SAVE_PROGRESS, CHART_IMPORT_BATCH };
+enum TIMING_UNIT { MS, BEAT, BAR };
 function DyCoreManager() constructor {
     // DyCore Step function.
     static step = function() {
@@ -61,6 +62,12 @@ function DyCoreManager() constructor {
             case DYCORE_ASYNC_EVENT_TYPE.ON_FILES_DROPPED:
                 window_on_files_dropped(event[$ "content"]);
                 break;
+            case DYCORE_ASYNC_EVENT_TYPE.PROJECT_SAVE_PROGRESS:
+                // Logged above; nothing shows it yet.
+                break;
+            case DYCORE_ASYNC_EVENT_TYPE.CHART_IMPORT_BATCH:
+                // Taking the event appended the charts; the list is logged above.
+                break;
             default:
                 show_debug_message("!Warning: Unknown dycore async event type.");
                 break;
@@ -495,20 +502,33 @@ function dyc_get_timingpoints() {
     var _lastModified = DyCore_get_timing_points_last_modified_time();
     if (_lastModified != _lastModifiedTime) {
         _lastModifiedTime = _lastModified;
-        try {
-            _timingpoints = json_parse(DyCore_get_timing_array_string());
-            for(var i=0, l=array_length(_timingpoints); i<l; i++) {
-                var data = _timingpoints[i];
-                _timingpoints[i] = build_timingpoint_from_data(data);
-                delete data;
-            }
-        } catch (e) {
-            show_debug_message("Error parsing timing points: " + string(e));
-        }
+        _timingpoints = dyc_get_timingpoints_in_window(-infinity, infinity);
     }
     return _timingpoints;
 }
 
+/// @description Get the timing points in effect between two times: the one in effect at the start, then every one up to the end.
+/// @param {Real} beginTime Window start.
+/// @param {Real} endTime Window end.
+/// @returns {Array<Struct.sTimingPoint>} 
+function dyc_get_timingpoints_in_window(beginTime, endTime) {
+    static _buffer = buffer_create(1024, buffer_grow, 1);
+    var _count = DyCore_prepare_timing_points(beginTime, endTime);
+    var _result = array_create(_count);
+    if (_count == 0) return _result;
+    // Records are time (f64), beat length (f64) and meter (s32).
+    buffer_resize(_buffer, max(buffer_get_size(_buffer), _count * 20));
+    DyCore_copy_timing_points(buffer_get_address(_buffer));
+    buffer_seek(_buffer, buffer_seek_start, 0);
+    for (var i = 0; i < _count; i++) {
+        var _time = buffer_read(_buffer, buffer_f64);
+        var _beatLength = buffer_read(_buffer, buffer_f64);
+        var _meter = buffer_read(_buffer, buffer_s32);
+        _result[i] = new sTimingPoint(_time, _beatLength, _meter);
+    }
+    return _result;
+}
+
 /// @description Get the timing point containing the specified time.
 /// @param {Real} time Time to query.
 /// @returns {Struct.sTimingPoint} 
@@ -742,6 +762,64 @@ function dyc_has_timing_point_at_time(time) {
     return DyCore_has_timing_point_at_time(time) > 0;
 }
 
+/// @description Convert between milliseconds, beats and bars. Beat and bar 0 are on the first timing point; bars restart at every timing point.
+/// @param {Real} value Value to convert.
+/// @param {Enum.TIMING_UNIT} from Unit of the value.
+/// @param {Enum.TIMING_UNIT} to Unit to convert to.
+function dyc_timing_convert(value, from, to) {
+    return DyCore_timing_convert(value, from, to);
+}
+
+/// @description Convert an array of values at once. Sorted arrays convert in linear time.
+/// @param {Array<Real>} values Values to convert.
+/// @param {Enum.TIMING_UNIT} from Unit of the values.
+/// @param {Enum.TIMING_UNIT} to Unit to convert to.
+/// @returns {Array<Real>}
+function dyc_timing_convert_array(values, from, to) {
+    var _count = array_length(values);
+    var _result = array_create(_count, 0);
+    if (_count == 0) return _result;
+    var _buffer = buffer_create(_count * 8, buffer_fixed, 8);
+    for (var i = 0; i < _count; i++)
+        buffer_write(_buffer, buffer_f64, values[i]);
+    if (DyCore_timing_convert_buffer(buffer_get_address(_buffer), _count, from, to) >= 0) {
+        buffer_seek(_buffer, buffer_seek_start, 0);
+        for (var i = 0; i < _count; i++)
+            _result[i] = buffer_read(_buffer, buffer_f64);
+    }
+    buffer_delete(_buffer);
+    return _result;
+}
+
+/// @description Snap an array of times to the timing grid at once.
+/// @param {Array<Real>} times Times to snap.
+/// @param {Real} divsPerBeat Grid divisions per beat.
+/// @param {Enum.SNAP_MODE} mode Which grid line to prefer.
+/// @returns {Array<Real>}
+function dyc_snap_times(times, divsPerBeat, mode = SNAP_MODE.SNAP_AROUND) {
+    var _count = array_length(times);
+    var _result = array_create(_count, 0);
+    if (_count == 0) return _result;
+    var _buffer = buffer_create(_count * 8, buffer_fixed, 8);
+    for (var i = 0; i < _count; i++)
+        buffer_write(_buffer, buffer_f64, times[i]);
+    DyCore_snap_times(buffer_get_address(_buffer), _count, divsPerBeat, mode);
+    buffer_seek(_buffer, buffer_seek_start, 0);
+    for (var i = 0; i < _count; i++)
+        _result[i] = buffer_read(_buffer, buffer_f64);
+    buffer_delete(_buffer);
+    return _result;
+}
+
+/// @description Snap notes and hold ends to the timing grid as a single edit. Sub notes are skipped.
+/// @param {Array<String>} noteIDs IDs of the notes to snap.
+/// @param {Real} divsPerBeat Grid divisions per beat.
+/// @param {Enum.SNAP_MODE} mode Which grid line to prefer.
+/// @returns {Real} The number of notes snapped, or -1 on error.
+function dyc_snap_notes(noteIDs, divsPerBeat, mode = SNAP_MODE.SNAP_AROUND) {
+    return DyCore_snap_notes(json_stringify(noteIDs), divsPerBeat, mode);
+}
+
 function dyc_ffmpeg_start_recording(filename, musicPath, width, height, fps, muiscOffset) {
     return DyCore_ffmpeg_start_recording(json_stringify(
         {
@@ -3,6 +3,8 @@
 #macro RECORDING_FPS_MAX 600
 #macro RECORDING_RESOLUTION_W 1920
 #macro RECORDING_RESOLUTION_H 1080
+// Frames DyCore renders per step during an offline export.
+#macro RECORDING_OFFLINE_FRAMES_PER_STEP 30
 
 enum FFmpegPushFrameError {
     INVALID_ARGUMENT = -1,
@@ -45,6 +47,7 @@ function RecordManager() constructor {
     frameBuffer = -1;
     originalFPS = game_get_speed(gamespeed_fps);
     targetFilePath = "";
+    offlineExporting = false;
 
     static _get_surface_buffer_size = function(w, h) {
         return w * h * 4;
@@ -159,6 +162,63 @@ function RecordManager() constructor {
         return recording || prepareRecording;
     }
 
+    /// @description Renders the chart headlessly in DyCore and pipes it to FFmpeg, faster than real time.
+    static start_offline_export = function(filename) {
+        if(is_recording() || offlineExporting) {
+            show_debug_message("-- Already recording!");
+            return;
+        }
+
+        recording_sync_offline_atlas();
+        var musicPath = get_absolute_path(filename_path(objManager.projectPath), objManager.musicPath);
+        var err = DyCore_ffmpeg_offline_start(json_stringify({
+            filename: filename,
+            musicPath: musicPath,
+            musicOffset: PLAYBACK_EMPTY_TIME / 1000,
+            width: int64(RECORDING_RESOLUTION_W),
+            height: int64(RECORDING_RESOLUTION_H),
+            fps: int64(RECORDING_FPS),
+            startTime: -PLAYBACK_EMPTY_TIME,
+            endTime: objMain.musicLength,
+            noteSpeed: objMain.playbackSpeed
+        }));
+        if(err != 0) {
+            show_debug_message("-- Failed to start offline export. Error code: " + string(err));
+            return;
+        }
+        offlineExporting = true;
+        targetFilePath = filename;
+    }
+
+    static step_offline_export = function() {
+        if(!offlineExporting) return;
+
+        var progress = DyCore_ffmpeg_offline_step(RECORDING_OFFLINE_FRAMES_PER_STEP);
+        if(progress < 0) {
+            offlineExporting = false;
+            announcement_task(i18n_get("recording_failed", [""]), 5000, "recording", ANNO_STATE.ERROR);
+            return;
+        }
+        if(progress >= 1) {
+            offlineExporting = false;
+            var stats = json_parse(DyCore_ffmpeg_offline_get_stats());
+            show_debug_message($"-- Offline export finished: {stats.framesDelivered} frames at {stats.fps} frames/s");
+            announcement_task(i18n_get("recording_complete", [targetFilePath]), 5000, "recording", ANNO_STATE.COMPLETE);
+            return;
+        }
+        announcement_task(
+            i18n_get("recording_processing",
+                [RECORDING_RESOLUTION_W, RECORDING_RESOLUTION_H, RECORDING_FPS, 100 * progress,
+                DyCore_ffmpeg_get_using_decoder()]
+            ), 5000, "recording");
+    }
+
+    static abort_offline_export = function() {
+        if(!offlineExporting) return;
+        DyCore_ffmpeg_offline_abort();
+        offlineExporting = false;
+    }
+
 }
 
 function recording_default_filename() {
@@ -189,6 +249,46 @@ function recording_start(filename = "") {
     }));
 }
 
+/// @description Uploads the note texture page, which DyCore's offline renderer samples sprites from.
+function recording_sync_offline_atlas() {
+    var texture = texturegroup_get_textures("texNotes")[0];
+    var w = round(1 / texture_get_texel_width(texture));
+    var h = round(1 / texture_get_texel_height(texture));
+
+    var surf = surface_create(w, h);
+    surface_set_target(surf);
+    draw_clear_alpha(c_black, 0);
+    gpu_push_state();
+    gpu_set_blendmode_ext(bm_one, bm_zero);
+    draw_primitive_begin_texture(pr_trianglestrip, texture);
+    draw_vertex_texture(0, 0, 0, 0);
+    draw_vertex_texture(w, 0, 1, 0);
+    draw_vertex_texture(0, h, 0, 1);
+    draw_vertex_texture(w, h, 1, 1);
+    draw_primitive_end();
+    gpu_pop_state();
+    surface_reset_target();
+
+    var buff = buffer_create(w * h * 4, buffer_fixed, 1);
+    buffer_get_surface(buff, surf, 0);
+    DyCore_set_offline_render_atlas(buffer_get_address(buff), w, h);
+    buffer_delete(buff);
+    surface_free(surf);
+}
+
+function recording_export_offline(filename = "") {
+    if(!DyCore_ffmpeg_is_available()) {
+        announcement_warning("recording_no_ffmpeg");
+        return;
+    }
+    if(filename == "") {
+        filename = dyc_get_save_filename("Video File (*.mp4)|*.mp4", recording_default_filename(), objManager.projectPath, i18n_get("recording_savefile_dlg_title"));
+    }
+    if(filename == "") return;
+
+    global.recordManager.start_offline_export(filename);
+}
+
 function _debug_start_record() {
     playview_start_replay(function() {
         global.recordManager.start_recording("test114514.mp4");
@@ -1,4 +1,8 @@
 
+// Max deviation (ms) between the predicted and the actual frame time that a
+// pipelined frame is scrolled over. Larger gaps are seeks and render again.
+#macro RENDER_ASYNC_TIME_TOLERANCE (20)
+
 /// @description This singleton handles note rendering under playback mode.
 function NoteRenderer() constructor {
 
@@ -13,13 +17,20 @@ function NoteRenderer() constructor {
     cacheBuff = buffer_create(20 * 1024, buffer_fast, 1);
     vertBuff = vertex_create_buffer_from_buffer(cacheBuff, vertFormat);
 
+    // Let DyCore tune render parallelism from measured frame costs.
+    DyCore_set_render_schedule_mode(1);
+
+    // Coalesce overlapping notes when zoomed out or in dense streams.
+    DyCore_set_render_lod(1, 0);
+
     // Hold Particles timer.
     holdParticlesTimer = 0;
     tempAdditionSurface = -1;
 
     static render_state = function(state) {
+        // Takes the frame requested last step, scrolled to the current time, if it still matches. Otherwise renders synchronously.
         /// @type {Real} 
-        var size = DyCore_render_active_notes(
+        var size = DyCore_render_async_collect(
             buffer_get_address(cacheBuff), objMain.nowTime, objMain.playbackSpeed, state);
 
 		if(size < 0) return;
@@ -31,6 +42,14 @@ function NoteRenderer() constructor {
         vertex_submit_ext(vertBuff, pr_trianglelist, texture, 0, size / 20);
     }
 
+    static predict_next_time = function() {
+        if(!objMain.nowPlaying) return objMain.nowTime;
+        var dT = global.timeManager.get_delta(-1, false) / 1000;
+        if(!global.recordManager.is_recording())
+            dT *= objMain.musicSpeed;
+        return objMain.nowTime + dT;
+    }
+
     static render = function() {
         gpu_push_state();
         gpu_set_tex_repeat(true);
@@ -61,6 +80,9 @@ function NoteRenderer() constructor {
 
         gpu_pop_state();
 
+        // Let DyCore prepare the next frame while GameMaker does the rest of its work.
+        DyCore_render_async_request(predict_next_time(), objMain.playbackSpeed, RENDER_ASYNC_TIME_TOLERANCE);
+
         // Emit holds particles.
         holdParticlesTimer += global.timeManager.get_delta() / 1000;
         holdParticlesTimer = min(holdParticlesTimer, 5 * PARTICLE_HOLD_DELAY);
@@ -78,4 +100,4 @@ function NoteRenderer() constructor {
     }
 }
 
-global.noteRenderer = new NoteRenderer();
\ No newline at end of file
+global.noteRenderer = new NoteRenderer();
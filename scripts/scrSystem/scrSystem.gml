@@ -17,6 +17,7 @@ function map_close() {
 		surface_free_f(shadowPingSurf);
 		surface_free_f(shadowPongSurf);
 		
+		DyCore_project_journal_close(1);
 		note_delete_all();
 		instance_destroy(objScoreBoard);
 		instance_destroy(objPerfectIndc);
@@ -74,7 +75,7 @@ function map_load(_file = "") {
 	}
 	var _direct = _file != "";
 	if(_file == "")
-	    _file = dyc_get_open_filename(i18n_get("fileformat_chart") + " (*.xml;*.dyn;*dy;*.osu)|*.xml;*.dyn;*dy;*.osu", "", 
+	    _file = dyc_get_open_filename(i18n_get("fileformat_chart") + " (*.xml;*.dyn;*.dynb;*dy;*.osu)|*.xml;*.dyn;*.dynb;*dy;*.osu", "", 
 	        program_directory, "Load Dynamix Chart File 加载谱面文件");
         
     if(_file == "") return;
@@ -97,7 +98,7 @@ function map_load(_file = "") {
     	timing_point_reset();
     
 	try {
-		switch filename_ext(_file) {
+		switch string_lower(filename_ext(_file)) {
 			case ".xml":
 			case ".dy":
 				map_import_dym(_file, _direct);
@@ -106,6 +107,7 @@ function map_load(_file = "") {
 				map_import_osu(_file);
 				break;
 			case ".dyn":
+			case ".dynb":
 				map_import_dyn(_file);
 				break;
 		}
@@ -578,7 +580,7 @@ function project_sideload(_file) {
 
 function project_load(_file = "") {
 	if(_file == "") 
-		_file = dyc_get_open_filename("DyNode File / Chart Files (*.dyn;*.xml;*.dy)|*.dyn;*.xml;*.dy", map_get_alt_title() + ".dyn", program_directory, 
+		_file = dyc_get_open_filename("DyNode File / Chart Files (*.dyn;*.dynb;*.xml;*.dy)|*.dyn;*.dynb;*.xml;*.dy", map_get_alt_title() + ".dyn", program_directory, 
         "Load Project 打开项目");
     
     if(_file == "") return 0;
@@ -595,7 +597,8 @@ function project_load(_file = "") {
 
 	map_reset();
 
-	if(string_lower(filename_ext(_file)) != ".dyn") {
+	var _ext = string_lower(filename_ext(_file));
+	if(_ext != ".dyn" && _ext != ".dynb") {
 		return project_sideload(_file);
 	}
     
@@ -677,19 +680,24 @@ function project_save() {
 }
 
 function project_save_as(_file = "") {
-
-	if(global.isSaving) {
-		show_debug_message("Save operation is already in progress.");
-		return 0;
-	}
 	
 	if(_file == "")
-		_file = dyc_get_save_filename("DyNode File (*.dyn)|*.dyn", map_get_alt_title() + ".dyn", program_directory, 
+		_file = dyc_get_save_filename("DyNode File (*.dyn)|*.dyn|DyNode Binary File (*.dynb)|*.dynb", map_get_alt_title() + ".dyn", program_directory, 
 	        "Project save as 项目另存为");
 	
 	if(_file == "") return 0;
 
+	// A newer save supersedes the one in progress. DyCore replaces a save of
+	// the same file by itself; a save of another file is cancelled here.
+	if(global.isSaving) {
+		if(_file != objManager.nextProjectPath)
+			DyCore_project_save_cancel();
+		// Autosaves skip while saving, so this one was asked for.
+		objManager.autosaving = false;
+	}
+
 	global.isSaving = true;
+	objManager.pendingSaves++;
 
 	DyCore_set_project_version(VERSION);
 	DyCore_set_project_metadata(json_stringify({
@@ -725,15 +733,27 @@ function project_save_as(_file = "") {
 		video: objManager.videoPath
 	}));
 
-	// Trigger an async saving project event.
-	DyCore_save_project(_file, DYCORE_COMPRESSION_LEVEL);
+	// Trigger an async saving project event. Saves the user asked for also
+	// decode the saved file to check it; autosaves only check checksums.
+	DyCore_save_project(_file, DYCORE_COMPRESSION_LEVEL, !objManager.autosaving);
 	objManager.nextProjectPath = _file;
 
 	return 1;
 }
 
 function project_save_callback(event) {
+	// Every save reports once. While a newer save is still running, it
+	// reports the result instead.
+	objManager.pendingSaves = max(objManager.pendingSaves - 1, 0);
+	if(objManager.pendingSaves > 0 || event[$ "status"] == 1)
+		return;
 	global.isSaving = false;
+	// Cancelled with no newer save; the file is left as it was.
+	if(event[$ "status"] == 2) {
+		objManager.nextProjectPath = "";
+		objManager.autosaving = false;
+		return;
+	}
 	if(event[$ "status"] < 0) {
 		announcement_error(i18n_get("anno_project_save_failed", event[$ "content"]));
 		objManager.nextProjectPath = "";
@@ -1051,6 +1071,7 @@ function parameter_is_filename(str) {
 	// Only treat known, droppable resource types as valid; other files are ignored.
 	switch (ext) {
 		case ".dyn":
+		case ".dynb":
 		case ".dy":
 		case ".xml":
 		case ".jpg":
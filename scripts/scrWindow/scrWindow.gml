@@ -14,10 +14,11 @@ function window_on_files_dropped(fileList) {
 
     for(var i = 0; i < array_length(files); i++) {
         var file = files[i];
-        var filext = filename_ext(file);
+        var filext = string_lower(filename_ext(file));
 
         switch (filext) {
             case ".dyn":
+            case ".dynb":
             case ".dy":
             case ".xml":
                 project_load(file);